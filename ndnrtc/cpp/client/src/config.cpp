@@ -6,6 +6,7 @@
 //
 
 #include <stdio.h>
+#include <algorithm>
 #include <libconfig.h++>
 
 #include "config.hpp"
@@ -14,6 +15,13 @@
 #define CONSUMER_KEY "consume"
 #define PRODUCER_KEY "produce"
 #define PRODUCER_FRESHNESS_KEY "freshness"
+#define PRODUCER_FEC_KEY "fec"
+#define PRODUCER_SIGNING_KEY "signing"
+#define PRODUCER_MANIFEST_KEY "manifest"
+#define PRODUCER_PIPELINE_KEY "pipeline"
+#define PRODUCER_RATE_CONTROL_KEY "rate_control"
+#define PRODUCER_DEMAND_KEY "demand"
+#define PRODUCER_SAMPLE_CACHE_KEY "sample_cache"
 #define SECTION_BASIC_KEY "basic"
 #define SECTION_AUDIO_KEY "audio"
 #define SECTION_VIDEO_KEY "video"
@@ -41,6 +49,20 @@ int loadGeneralSettings(const Setting &general, GeneralParams &generalParams);
 int loadConsumerSettings(const Setting &root, ConsumerClientParams &params);
 int loadFreshnessSettings(const Setting &producer, 
                           GeneralProducerParams::FreshnessPeriodParams &freshnessParams);
+int loadFecSettings(const Setting &producer,
+                    GeneralProducerParams::FecParams &fecParams);
+int loadSigningSettings(const Setting &producer,
+                        GeneralProducerParams::SigningParams &signingParams);
+int loadManifestSettings(const Setting &producer,
+                         GeneralProducerParams::ManifestParams &manifestParams);
+int loadPipelineSettings(const Setting &producer,
+                         GeneralProducerParams::PipelineParams &pipelineParams);
+int loadRateControlSettings(const Setting &producer,
+                            GeneralProducerParams::RateControlParams &rateControlParams);
+int loadDemandSettings(const Setting &producer,
+                       GeneralProducerParams::DemandParams &demandParams);
+int loadSampleCacheSettings(const Setting &producer,
+                            GeneralProducerParams::SampleCacheParams &sampleCacheParams);
 int loadProducerSettings(const Setting &root, ProducerClientParams &params,
                          const std::string &identity);
 int loadStreamParams(const Setting &s, ConsumerStreamParams &params);
@@ -407,6 +429,7 @@ int loadStreamParams(const Setting &s, ClientMediaStreamParams &params)
 
         s.lookupValue("base_prefix", params.sessionPrefix_);                // consumer
         s.lookupValue("segment_size", params.producerParams_.segmentSize_); // producer
+        s.lookupValue("send_nacks", params.producerParams_.sendNacks_);     // producer
 
 
         try 
@@ -419,6 +442,27 @@ int loadStreamParams(const Setting &s, ClientMediaStreamParams &params)
             // might've been consumer settings. continue
         }
 
+        if (s.exists(PRODUCER_FEC_KEY) && loadFecSettings(s, params.producerParams_.fec_) == EXIT_FAILURE)
+            LogError("") << "couldn't load FEC parameters for producer" << std::endl;
+
+        if (s.exists(PRODUCER_SIGNING_KEY) && loadSigningSettings(s, params.producerParams_.signing_) == EXIT_FAILURE)
+            LogError("") << "couldn't load signing parameters for producer" << std::endl;
+
+        if (s.exists(PRODUCER_MANIFEST_KEY) && loadManifestSettings(s, params.producerParams_.manifest_) == EXIT_FAILURE)
+            LogError("") << "couldn't load manifest parameters for producer" << std::endl;
+
+        if (s.exists(PRODUCER_PIPELINE_KEY) && loadPipelineSettings(s, params.producerParams_.pipeline_) == EXIT_FAILURE)
+            LogError("") << "couldn't load pipeline parameters for producer" << std::endl;
+
+        if (s.exists(PRODUCER_RATE_CONTROL_KEY) && loadRateControlSettings(s, params.producerParams_.rateControl_) == EXIT_FAILURE)
+            LogError("") << "couldn't load rate control parameters for producer" << std::endl;
+
+        if (s.exists(PRODUCER_DEMAND_KEY) && loadDemandSettings(s, params.producerParams_.demand_) == EXIT_FAILURE)
+            LogError("") << "couldn't load demand parameters for producer" << std::endl;
+
+        if (s.exists(PRODUCER_SAMPLE_CACHE_KEY) && loadSampleCacheSettings(s, params.producerParams_.sampleCache_) == EXIT_FAILURE)
+            LogError("") << "couldn't load sample cache parameters for producer" << std::endl;
+
         try
         { // audio streams do not have thread configurations
             if (s.exists("threads"))
@@ -489,6 +533,120 @@ int loadFreshnessSettings(const Setting &s,
 
 }
 
+int loadFecSettings(const Setting &s,
+                    GeneralProducerParams::FecParams &params)
+{
+    const Setting &fecSettings = s[PRODUCER_FEC_KEY];
+    fecSettings.lookupValue("adaptive", params.adaptive_);
+    fecSettings.lookupValue("lazy", params.lazy_);
+    fecSettings.lookupValue("group_size", params.groupSize_);
+    lookupNumber(fecSettings, "delta_parity", params.deltaParityRatio_);
+    lookupNumber(fecSettings, "key_parity", params.keyParityRatio_);
+    lookupNumber(fecSettings, "max_parity", params.maxParityRatio_);
+
+    if (params.deltaParityRatio_ < 0 || params.keyParityRatio_ < 0 ||
+        params.maxParityRatio_ < std::max(params.deltaParityRatio_, params.keyParityRatio_))
+    {
+        LogError("") << "invalid parity ratios" << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
+
+int loadSigningSettings(const Setting &s,
+                        GeneralProducerParams::SigningParams &params)
+{
+    const Setting &signingSettings = s[PRODUCER_SIGNING_KEY];
+    signingSettings.lookupValue("threads", params.threads_);
+    signingSettings.lookupValue("sign_samples", params.signSamples_);
+
+    return EXIT_SUCCESS;
+}
+
+int loadManifestSettings(const Setting &s,
+                         GeneralProducerParams::ManifestParams &params)
+{
+    const Setting &manifestSettings = s[PRODUCER_MANIFEST_KEY];
+    manifestSettings.lookupValue("window", params.window_);
+    manifestSettings.lookupValue("per_frame", params.perFrame_);
+
+    return EXIT_SUCCESS;
+}
+
+int loadPipelineSettings(const Setting &s,
+                         GeneralProducerParams::PipelineParams &params)
+{
+    const Setting &pipelineSettings = s[PRODUCER_PIPELINE_KEY];
+    std::string drop;
+
+    pipelineSettings.lookupValue("depth", params.depth_);
+    if (pipelineSettings.lookupValue("drop", drop))
+    {
+        if (drop != "oldest" && drop != "newest")
+        {
+            LogError("") << "unknown pipeline drop policy: " << drop << std::endl;
+            return EXIT_FAILURE;
+        }
+        params.dropOldest_ = (drop == "oldest");
+    }
+
+    return EXIT_SUCCESS;
+}
+
+int loadRateControlSettings(const Setting &s,
+                            GeneralProducerParams::RateControlParams &params)
+{
+    const Setting &rateControlSettings = s[PRODUCER_RATE_CONTROL_KEY];
+
+    rateControlSettings.lookupValue("enabled", params.enabled_);
+    rateControlSettings.lookupValue("min_bitrate_ratio", params.minBitrateRatio_);
+    rateControlSettings.lookupValue("min_frame_rate", params.minFrameRate_);
+    rateControlSettings.lookupValue("interval", params.intervalMs_);
+
+    if (params.minBitrateRatio_ <= 0 || params.minBitrateRatio_ > 1)
+    {
+        LogError("") << "minimal bitrate ratio must be in (0;1]: " << params.minBitrateRatio_ << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
+
+int loadDemandSettings(const Setting &s,
+                       GeneralProducerParams::DemandParams &params)
+{
+    const Setting &demandSettings = s[PRODUCER_DEMAND_KEY];
+
+    demandSettings.lookupValue("enabled", params.enabled_);
+    demandSettings.lookupValue("idle_window", params.idleWindowMs_);
+
+    if (params.idleWindowMs_ == 0)
+    {
+        LogError("") << "demand idle window must be positive" << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
+
+int loadSampleCacheSettings(const Setting &s,
+                            GeneralProducerParams::SampleCacheParams &params)
+{
+    const Setting &sampleCacheSettings = s[PRODUCER_SAMPLE_CACHE_KEY];
+
+    sampleCacheSettings.lookupValue("lifetime", params.lifetimeMs_);
+    sampleCacheSettings.lookupValue("budget", params.budgetMb_);
+
+    if (params.lifetimeMs_ == 0 || params.budgetMb_ == 0)
+    {
+        LogError("") << "sample cache lifetime and budget must be positive" << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
+
 int loadThreadParams(const Setting &s, VideoThreadParams &params)
 {
     if (!s.lookupValue("name", params.threadName_))
@@ -502,7 +660,7 @@ int loadThreadParams(const Setting &s, VideoThreadParams &params)
     lookupNumber(s, "average_segnum_delta_parity", params.segInfo_.deltaAvgParitySegNum_);
     lookupNumber(s, "average_segnum_key", params.segInfo_.keyAvgSegNum_);
     lookupNumber(s, "average_segnum_key_parity", params.segInfo_.keyAvgParitySegNum_);
-
+    s.lookupValue("cpu_core", params.cpuCore_);
 
     if (s.exists("coder"))
     {
@@ -516,6 +674,8 @@ int loadThreadParams(const Setting &s, VideoThreadParams &params)
         lookupNumber(coderSettings, "encode_height", params.coderParams_.encodeHeight_);
         lookupNumber(coderSettings, "encode_width", params.coderParams_.encodeWidth_);
         coderSettings.lookupValue("drop_frames", params.coderParams_.dropFramesOn_);
+        coderSettings.lookupValue("temporal_layers", params.coderParams_.temporalLayers_);
+        coderSettings.lookupValue("encoder_threads", params.coderParams_.encoderThreads_);
 
 
     }
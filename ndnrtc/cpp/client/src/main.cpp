@@ -38,6 +38,7 @@ struct Args
     unsigned int runTimeSec_, samplePeriod_;
     std::string configFile_, identity_, instance_, policy_;
     ndnlog::NdnLoggerDetailLevel logLevel_;
+    bool ecdsaInstanceKey_;
 };
 
 int run(const struct Args &);
@@ -70,10 +71,11 @@ int main(int argc, char **argv)
     int c;
     unsigned int runTimeSec = 0;           // default app run time (sec)
     unsigned int statSamplePeriodMs = 100; // default statistics sample interval (ms)
+    bool ecdsaInstanceKey = false;
     ndnlog::NdnLoggerDetailLevel logLevel = ndnlog::NdnLoggerDetailLevelDefault;
 
     opterr = 0;
-    while ((c = getopt(argc, argv, "vn:i:t:c:s:p:")) != -1)
+    while ((c = getopt(argc, argv, "ven:i:t:c:s:p:")) != -1)
         switch (c)
         {
         case 'c':
@@ -88,6 +90,9 @@ int main(int argc, char **argv)
         case 'v':
             logLevel = ndnlog::NdnLoggerDetailLevelAll;
             break;
+        case 'e':
+            ecdsaInstanceKey = true;
+            break;
         case 'n':
             statSamplePeriodMs = (unsigned int)atoi(optarg);
             break;
@@ -116,7 +121,7 @@ int main(int argc, char **argv)
         std::cout << "usage: " << argv[0] << " -c <config file> -s <signing identity> "
                                              "-p <verification policy file> "
                                              "-t <app run time in seconds> [-n <statistics sample interval in milliseconds> "
-                                             "-i <instance name> -v <verbose mode>]"
+                                             "-i <instance name> -v <verbose mode> -e <use ECDSA instance key>]"
                   << std::endl;
         exit(1);
     }
@@ -129,6 +134,7 @@ int main(int argc, char **argv)
     args.identity_ = std::string(identity);
     args.policy_ = std::string(policy);
     args.instance_ = (instance ? std::string(instance) : "client0");
+    args.ecdsaInstanceKey_ = ecdsaInstanceKey;
 
     return run(args);
 }
@@ -149,6 +155,7 @@ int run(const struct Args &args)
                 << "\n\tpolicy file: " << args.policy_
                 << "\n\tstatistics sampling: " << args.samplePeriod_
                 << "\n\tinstance name: " << args.instance_
+                << "\n\tinstance key: " << (args.ecdsaInstanceKey_ ? "ECDSA" : "RSA")
                 << std::endl;
 
     boost::asio::io_service io;
@@ -181,7 +188,8 @@ int run(const struct Args &args)
     KeyChainManager keyChainManager(face, boost::make_shared<ndn::KeyChain>(),
                                     args.identity_, args.instance_,
                                     args.policy_, args.runTimeSec_,
-                                    ndnlog::new_api::Logger::getLoggerPtr(""));
+                                    ndnlog::new_api::Logger::getLoggerPtr(""),
+                                    (args.ecdsaInstanceKey_ ? KEY_TYPE_EC : KEY_TYPE_RSA));
     ClientParams params;
 
     LogInfo("") << "Run time is set to " << args.runTimeSec_ << " seconds, loading "
@@ -15,16 +15,23 @@
 #include <ndn-cpp/security/policy/self-verify-policy-manager.hpp>
 
 #include <boost/thread.hpp>
+#include <boost/chrono.hpp>
 #include <boost/algorithm/string/split.hpp>
 #include <boost/algorithm/string/classification.hpp>
+#include <webrtc/common_video/libyuv/include/webrtc_libyuv.h>
 
 #include "gtest/gtest.h"
 #include "../tests/tests-helpers.hpp"
 #include "include/local-stream.hpp"
 #include "include/name-components.hpp"
 #include "client/src/video-source.hpp"
+#include "client/src/frame-io.hpp"
 #include "../tests/mock-objects/external-capturer-mock.hpp"
+#include "../tests/mock-objects/encoder-delegate-mock.hpp"
 #include "statistics.hpp"
+#include "src/video-coder.hpp"
+#include "src/video-decoder.hpp"
+#include "src/frame-converter.hpp"
 
 std::string test_path = "";
 
@@ -133,7 +140,94 @@ void runProducer(std::string sourceFile, boost::shared_ptr<RawFrame> frame,
               stat[Indicator::EncodedNum]/runTimeSec);
 }
 
+// encodes and decodes frames of the test source, reports encoding speed,
+// frame size and quality
+void runEncoder(std::string sourceFile, unsigned int width, unsigned int height,
+                const VideoCoderParams &vcp, int nFrames = 30 * 3)
+{
+    FileFrameSource source(sourceFile);
+    ArgbFrame argb(width, height);
+    std::vector<WebRtcVideoFrame> frames;
+    RawFrameConverter conv;
+
+    while ((int)frames.size() < nFrames)
+    {
+        source >> argb;
+        if (source.isEof() || source.isError())
+            break;
+        frames.push_back(conv << ArgbRawFrameWrapper({width, height, argb.getBuffer().get(),
+                                                      (unsigned int)argb.getFrameSizeInBytes(), true}));
+    }
+    ASSERT_LT(0, frames.size());
+
+    MockEncoderDelegate coderDelegate;
+    coderDelegate.setDefaults();
+    VideoCoder vc(vcp, &coderDelegate);
+
+    int frameIdx = 0, nEncoded = 0, nDecoded = 0;
+    size_t nBytes = 0;
+    double psnr = 0;
+    VideoDecoder vdc(vcp, [&](const FrameInfo &fi, const WebRtcVideoFrame &f) {
+        // encoding and decoding are synchronous - decoded frame
+        // corresponds to the one that is being encoded
+        nDecoded++;
+        psnr += webrtc::I420PSNR(&frames[frameIdx], &f);
+    });
+
+    FrameInfo phony = {0, 0, "/phony/name"};
+    EXPECT_CALL(coderDelegate, onEncodedFrame(_))
+        .WillRepeatedly(Invoke([&vdc, &nEncoded, &nBytes, &phony](const webrtc::EncodedImage &img) {
+            nEncoded++;
+            nBytes += img._length;
+            vdc.processFrame(phony, img);
+        }));
+    EXPECT_CALL(coderDelegate, onEncodingStarted())
+        .Times(AtLeast(0));
+    EXPECT_CALL(coderDelegate, onDroppedFrame())
+        .Times(AtLeast(0));
+
+    boost::chrono::high_resolution_clock::time_point t1 = boost::chrono::high_resolution_clock::now();
+    for (frameIdx = 0; frameIdx < frames.size(); ++frameIdx)
+        vc.onRawFrame(frames[frameIdx]);
+    double durationMs = (double)boost::chrono::duration_cast<boost::chrono::milliseconds>(boost::chrono::high_resolution_clock::now() - t1).count();
+
+    ASSERT_LT(0, nDecoded);
+    GT_PRINTF("%dx%d, %d encoder threads: %.2f FPS (encoding and decoding), "
+              "avg frame size %.2f bytes, avg PSNR %.2f dB\n",
+              width, height, vcp.encoderThreads_,
+              (double)frames.size() / durationMs * 1000.,
+              (double)nBytes / (double)nEncoded, psnr / (double)nDecoded);
+}
+
+void runEncoders(std::string sourceFile, unsigned int width, unsigned int height,
+                 unsigned int bitrate)
+{
+    for (unsigned int nThreads : {1, 2, 4})
+    {
+        VideoCoderParams vcp(sampleVideoCoderParams());
+        vcp.startBitrate_ = bitrate;
+        vcp.maxBitrate_ = bitrate;
+        vcp.encodeWidth_ = width;
+        vcp.encodeHeight_ = height;
+        vcp.dropFramesOn_ = false;
+        vcp.encoderThreads_ = nThreads;
+
+        runEncoder(sourceFile, width, height, vcp);
+    }
+}
+
 unsigned int runtime = 5000;
+
+TEST(BenchmarkLocalStream, Encoder320x240)
+{
+    runEncoders(test_path + "/../res/test-source-320x240.argb", 320, 240, 500);
+}
+
+TEST(BenchmarkLocalStream, Encoder1280x720)
+{
+    runEncoders(test_path + "/../res/test-source-1280x720.argb", 1280, 720, 2000);
+}
+
 #if 0
 TEST(BenchmarkLocalStream, VideoStream320x240_300)
 {
@@ -0,0 +1,105 @@
+//
+// benchmark-network-data.cc
+//
+//  Copyright 2013-2016 Regents of the University of California
+//
+
+#include <stdlib.h>
+#include <boost/chrono.hpp>
+#include <ndn-cpp/c/common.h>
+
+#include "gtest/gtest.h"
+#include "../tests/tests-helpers.hpp"
+#include "src/network-data.hpp"
+
+using namespace ::testing;
+using namespace ndnrtc;
+
+class DataPacketTest : public DataPacket
+{
+  public:
+    DataPacketTest(const std::vector<uint8_t> &payload, size_t headroom = 0) : DataPacket(payload, headroom) {}
+
+    void addBlob(uint16_t dataLength, const uint8_t *data) { DataPacket::addBlob(dataLength, data); }
+};
+
+// builds data packet the way it was done before packets had headroom:
+// every blob is inserted in front of the payload
+std::vector<uint8_t> buildWithInsert(const std::vector<uint8_t> &payload,
+                                     const std::vector<std::vector<uint8_t>> &blobs)
+{
+    std::vector<uint8_t> packet(payload);
+    packet.insert(packet.begin(), 0);
+    size_t payloadBegin = 1;
+
+    for (auto &b : blobs)
+    {
+        packet[0]++;
+        uint8_t size[] = {(uint8_t)(b.size() & 0x00ff), (uint8_t)((b.size() & 0xff00) >> 8)};
+        packet.insert(packet.begin() + payloadBegin, size, size + 2);
+        packet.insert(packet.begin() + payloadBegin + 2, b.begin(), b.end());
+        payloadBegin += 2 + b.size();
+    }
+
+    return packet;
+}
+
+TEST(BenchmarkDataPacket, AddBlob)
+{
+    int nRuns = 100;
+    {
+        // 1080p key frame with sync list for 3 threads
+        std::vector<uint8_t> payload(300000, 0xaa);
+        std::vector<std::vector<uint8_t>> blobs;
+        blobs.push_back(std::vector<uint8_t>(31, 1));
+        for (int i = 0; i < 3; ++i)
+        {
+            blobs.push_back(std::vector<uint8_t>(3, 'a' + i));
+            blobs.push_back(std::vector<uint8_t>(sizeof(PacketNumber), i));
+        }
+        blobs.push_back(std::vector<uint8_t>(sizeof(CommonHeader), 2));
+
+        boost::chrono::high_resolution_clock::time_point t1 = boost::chrono::high_resolution_clock::now();
+        for (int i = 0; i < nRuns; ++i)
+            buildWithInsert(payload, blobs);
+        boost::chrono::high_resolution_clock::time_point t2 = boost::chrono::high_resolution_clock::now();
+        for (int i = 0; i < nRuns; ++i)
+        {
+            DataPacketTest dp(payload, DataPacket::wireLength(std::vector<size_t>(blobs.size(), 31)));
+            for (auto &b : blobs)
+                dp.addBlob(b.size(), b.data());
+        }
+        boost::chrono::high_resolution_clock::time_point t3 = boost::chrono::high_resolution_clock::now();
+
+        GT_PRINTF("1080p key frame packet (%d bytes, %d blobs): insert %.2fus, headroom %.2fus\n",
+                  (int)payload.size(), (int)blobs.size(),
+                  (double)boost::chrono::duration_cast<boost::chrono::microseconds>(t2 - t1).count() / (double)nRuns,
+                  (double)boost::chrono::duration_cast<boost::chrono::microseconds>(t3 - t2).count() / (double)nRuns);
+    }
+    {
+        // manifest of 100 SHA-256 digests
+        std::vector<std::vector<uint8_t>> blobs(100, std::vector<uint8_t>(ndn_SHA256_DIGEST_SIZE, 0x55));
+
+        boost::chrono::high_resolution_clock::time_point t1 = boost::chrono::high_resolution_clock::now();
+        for (int i = 0; i < nRuns; ++i)
+            buildWithInsert(std::vector<uint8_t>(), blobs);
+        boost::chrono::high_resolution_clock::time_point t2 = boost::chrono::high_resolution_clock::now();
+        for (int i = 0; i < nRuns; ++i)
+        {
+            DataPacketTest dp((std::vector<uint8_t>()));
+            for (auto &b : blobs)
+                dp.addBlob(b.size(), b.data());
+        }
+        boost::chrono::high_resolution_clock::time_point t3 = boost::chrono::high_resolution_clock::now();
+
+        GT_PRINTF("100-digest manifest: insert %.2fus, headroom %.2fus\n",
+                  (double)boost::chrono::duration_cast<boost::chrono::microseconds>(t2 - t1).count() / (double)nRuns,
+                  (double)boost::chrono::duration_cast<boost::chrono::microseconds>(t3 - t2).count() / (double)nRuns);
+    }
+}
+
+int main(int argc, char **argv)
+{
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
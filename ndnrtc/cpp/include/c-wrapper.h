@@ -102,6 +102,42 @@ extern "C" {
 			const unsigned char* yBuffer,
 			const unsigned char* uvBuffer);
 
+	// external frames: planes are not copied and must stay valid until
+	// releasedFunc is called (possibly on another thread)
+	typedef void (*FrameReleased) (void* userData);
+
+	int ndnrtc_LocalVideoStream_incomingExternalI420Frame(ndnrtc::LocalVideoStream *stream,
+			const unsigned int width,
+			const unsigned int height,
+			const unsigned int strideY,
+			const unsigned int strideU,
+			const unsigned int strideV,
+			const unsigned char* yBuffer,
+			const unsigned char* uBuffer,
+			const unsigned char* vBuffer,
+			FrameReleased releasedFunc,
+			void* userData);
+
+	int ndnrtc_LocalVideoStream_incomingExternalNV12Frame(ndnrtc::LocalVideoStream *stream,
+			const unsigned int width,
+			const unsigned int height,
+			const unsigned int strideY,
+			const unsigned int strideUV,
+			const unsigned char* yBuffer,
+			const unsigned char* uvBuffer,
+			FrameReleased releasedFunc,
+			void* userData);
+
+	int ndnrtc_LocalVideoStream_incomingExternalNV21Frame(ndnrtc::LocalVideoStream *stream,
+			const unsigned int width,
+			const unsigned int height,
+			const unsigned int strideY,
+			const unsigned int strideUV,
+			const unsigned char* yBuffer,
+			const unsigned char* uvBuffer,
+			FrameReleased releasedFunc,
+			void* userData);
+
 	int ndnrtc_LocalVideoStream_incomingArgbFrame(ndnrtc::LocalVideoStream *stream,
 			const unsigned int width,
 			const unsigned int height,
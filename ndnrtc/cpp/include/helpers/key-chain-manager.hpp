@@ -10,6 +10,8 @@
 #ifndef __keychain_manager_hpp__
 #define __keychain_manager_hpp__
 
+#include <ndn-cpp/security/security-common.hpp>
+
 #include "../simple-log.hpp"
 
 namespace ndn {
@@ -34,7 +36,8 @@ namespace ndnrtc {
                 const std::string& instanceName,
                 const std::string& configPolicy,
                 unsigned int instanceCertLifetime,
-                boost::shared_ptr<ndnlog::new_api::Logger> logger);
+                boost::shared_ptr<ndnlog::new_api::Logger> logger,
+                ndn::KeyType instanceKeyType = ndn::KEY_TYPE_RSA);
             ~KeyChainManager() {}
 
             boost::shared_ptr<ndn::KeyChain> defaultKeyChain() { return defaultKeyChain_; }
@@ -69,6 +72,7 @@ namespace ndnrtc {
             std::string signingIdentity_, instanceName_,
             configPolicy_, instanceIdentity_;
             unsigned int runTime_;
+            ndn::KeyType instanceKeyType_;
 
             boost::shared_ptr<ndn::PolicyManager> configPolicyManager_;
             boost::shared_ptr<ndn::KeyChain> defaultKeyChain_, instanceKeyChain_;
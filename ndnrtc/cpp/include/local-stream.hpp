@@ -13,6 +13,8 @@
 #include "stream.hpp"
 
 #include <boost/asio.hpp>
+#include <boost/function.hpp>
+#include <vector>
 
 namespace ndn {
 	class KeyChain;
@@ -44,6 +46,9 @@ namespace ndnrtc {
 		ndn::Face* face_;
 		MediaStreamParams params_;
         std::string storagePath_; // do not use storage if this string is empty
+        // optional key chains for signing threads, one per thread; threads
+        // without own key chain share keyChain_ and sign one at a time
+        std::vector<ndn::KeyChain*> signingKeyChains_;
 	};
 
 	class VideoStreamImpl;
@@ -173,7 +178,11 @@ namespace ndnrtc {
 		 * publishes encoded data according to NDN-RTC namespace. 
 		 * Call is asynchronous: returns immediately. Publishing is performed
 		 * on Face thread to avoid data races.
-		 * @return playback number of a frame, if is was published, -1 if it wasn't
+		 * If producer pipeline is enabled (see GeneralProducerParams), frame is
+		 * queued for encoding on a separate thread.
+		 * @return playback number of a frame, if is was published, -1 if it wasn't;
+		 *		with pipeline enabled - playback number of the last published
+		 *		frame, if frame was queued, -1 if it was dropped
 		 */
 		int incomingArgbFrame(const unsigned int width,
 			const unsigned int height,
@@ -223,6 +232,81 @@ namespace ndnrtc {
 			const unsigned char* yBuffer,
 			const unsigned char* uvBuffer) override;
 
+		typedef boost::function<void(void)> OnFrameReleased;
+
+		/**
+		 * Encode and publish I420 frame without copying its data.
+		 * Planes remain owned by the caller (e.g. mmap'ed capture buffers)
+		 * and must stay valid until onReleased is called. This happens once
+		 * the library is done with the frame: after it was encoded or
+		 * dropped. Callback may be called on any thread, including the
+		 * calling one, before this call returns.
+		 */
+		int incomingExternalI420Frame(const unsigned int width,
+			const unsigned int height,
+			const unsigned int strideY,
+			const unsigned int strideU,
+			const unsigned int strideV,
+			const unsigned char* yBuffer,
+			const unsigned char* uBuffer,
+			const unsigned char* vBuffer,
+			OnFrameReleased onReleased);
+
+		/**
+		 * Encode and publish NV12 frame. Encoders accept I420 only, thus
+		 * frame is converted to I420 straight from caller's planes (which 
+		 * may have arbitrary strides) and is never retained: onReleased is
+		 * called on the calling thread before this call returns.
+		 */
+		int incomingExternalNV12Frame(const unsigned int width,
+			const unsigned int height,
+			const unsigned int strideY,
+			const unsigned int strideUV,
+			const unsigned char* yBuffer,
+			const unsigned char* uvBuffer,
+			OnFrameReleased onReleased);
+
+		/**
+		 * Same as incomingExternalNV12Frame, but for NV21 frame.
+		 */
+		int incomingExternalNV21Frame(const unsigned int width,
+			const unsigned int height,
+			const unsigned int strideY,
+			const unsigned int strideUV,
+			const unsigned char* yBuffer,
+			const unsigned char* uvBuffer,
+			OnFrameReleased onReleased);
+
+		/**
+		 * Publish frame, which was encoded elsewhere (e.g. hardware encoder,
+		 * transcoder or a recording), bypassing encoding. Frame must be
+		 * VP9-encoded with the resolution of the given thread; it is copied,
+		 * thus frameData can be released once this call returns.
+		 * Delta frames, given before the first key frame, are dropped;
+		 * otherwise, frames are never dropped, as it would break decoding of
+		 * the following ones. Threads used for pre-encoded frames should not
+		 * be fed with raw frames.
+		 * Throws if thread does not exist or frame resolution does not match.
+		 * @param threadName Thread to publish frame in
+		 * @param timestamp RTP timestamp of the frame (90kHz clock)
+		 * @param captureTimeMs Capture timestamp of the frame
+		 * @param temporalLayer Temporal layer of the frame, if the thread has
+		 *                      several (see VideoCoderParams::temporalLayers_);
+		 *                      delta frames must follow GOP pattern of layers
+		 *                      (see NameComponents::temporalLayer), otherwise
+		 *                      this call throws
+		 * @return playback number of a frame, if is was published, -1 if it wasn't
+		 */
+		int incomingEncodedFrame(const std::string& threadName,
+			const unsigned int width,
+			const unsigned int height,
+			bool isKey,
+			uint32_t timestamp,
+			int64_t captureTimeMs,
+			const unsigned char* frameData,
+			unsigned int frameSize,
+			unsigned int temporalLayer = 0);
+
         /**
          * Returns information about last published frames, per thread. 
          */
@@ -65,18 +65,21 @@ namespace ndnrtc {
     class NamespaceInfo {
     public:
         NamespaceInfo():apiVersion_(0), isMeta_(false), isParity_(false), 
-            isDelta_(false), hasSeqNo_(false), class_(SampleClass::Unknown),
-            segmentClass_(SegmentClass::Unknown), sampleNo_(0), segNo_(0), metaVersion_(0){}
+            isDelta_(false), hasSeqNo_(false), hasTemporalLayer_(false), 
+            class_(SampleClass::Unknown), segmentClass_(SegmentClass::Unknown), 
+            sampleNo_(0), segNo_(0), temporalLayer_(0), metaVersion_(0){}
 
         ndn::Name basePrefix_;
         unsigned int apiVersion_;
         MediaStreamParams::MediaStreamType streamType_;
         std::string streamName_, threadName_;
         bool isMeta_, isParity_, isDelta_, hasSeqNo_, hasSegNo_;
+        bool hasTemporalLayer_; // delta frames of threads with several temporal layers
         SampleClass class_;
         SegmentClass segmentClass_;
         PacketNumber sampleNo_;
         unsigned int segNo_;
+        unsigned int temporalLayer_;
         unsigned int metaVersion_;
         uint64_t streamTimestamp_;
 
@@ -114,6 +117,15 @@ namespace ndnrtc {
         videoStreamPrefix(std::string basePrefix);
 
         static bool extractInfo(const ndn::Name& name, NamespaceInfo& info);
+
+        /**
+         * Returns temporal layer of the frame at given GOP position (key 
+         * frame has position 0) for the thread with given number of temporal
+         * layers. Layers follow fixed pattern: 0-1 for two layers and 0-2-1-2
+         * for three layers, restarted by every key frame. Delta frames of 
+         * threads with several layers are named <thread>/d/<layer>/<seq>.
+         */
+        static unsigned int temporalLayer(unsigned int gopPos, unsigned int nLayers);
     };
 }
 
@@ -151,9 +151,13 @@ namespace ndnrtc
         unsigned int startBitrate_, maxBitrate_;
         unsigned int encodeWidth_, encodeHeight_;
         bool dropFramesOn_;
+        unsigned int temporalLayers_;   // number of temporal (SVC) layers, 1..3
+        unsigned int encoderThreads_;   // CPU cores encoder may use (0 - all cores
+                                        // or stream's share of them)
         
         VideoCoderParams():codecFrameRate_(30),gop_(30),startBitrate_(1000),
-        maxBitrate_(5000),encodeWidth_(1280),encodeHeight_(720),dropFramesOn_(false){}
+        maxBitrate_(5000),encodeWidth_(1280),encodeHeight_(720),dropFramesOn_(false),
+        temporalLayers_(1),encoderThreads_(0){}
         
         void write(std::ostream& os) const
         {
@@ -164,6 +168,10 @@ namespace ndnrtc
             << maxBitrate_ << " Kbit/s; "
             << encodeWidth_ << "x" << encodeHeight_ << "; Drop: "
             << (dropFramesOn_?"YES":"NO");
+            if (temporalLayers_ > 1)
+                os << "; Temporal layers: " << temporalLayers_;
+            if (encoderThreads_)
+                os << "; Encoder threads: " << encoderThreads_;
         }
         
         bool operator==(const VideoCoderParams& rhs) const
@@ -174,7 +182,9 @@ namespace ndnrtc
             this->maxBitrate_ == rhs.maxBitrate_ &&
             this->encodeWidth_ == rhs.encodeWidth_ &&
             this->encodeHeight_ == rhs.encodeHeight_ &&
-            this->dropFramesOn_ == rhs.dropFramesOn_;
+            this->dropFramesOn_ == rhs.dropFramesOn_ &&
+            this->temporalLayers_ == rhs.temporalLayers_ &&
+            this->encoderThreads_ == rhs.encoderThreads_;
         }
         
         bool operator!=(const VideoCoderParams& rhs) const
@@ -185,22 +195,25 @@ namespace ndnrtc
     
     class VideoThreadParams : public MediaThreadParams {
     public:
-        VideoThreadParams():MediaThreadParams(){}
-        VideoThreadParams(std::string threadName):MediaThreadParams(threadName){}
+        VideoThreadParams():MediaThreadParams(), cpuCore_(-1){}
+        VideoThreadParams(std::string threadName):MediaThreadParams(threadName), cpuCore_(-1){}
         VideoThreadParams(std::string threadName, FrameSegmentsInfo segInfo):
-        MediaThreadParams(threadName, segInfo){}
+        MediaThreadParams(threadName, segInfo), cpuCore_(-1){}
         VideoThreadParams(std::string threadName, VideoCoderParams vcp):
-        MediaThreadParams(threadName),coderParams_(vcp){}
+        MediaThreadParams(threadName),coderParams_(vcp), cpuCore_(-1){}
         VideoThreadParams(std::string threadName, FrameSegmentsInfo segInfo, VideoCoderParams vcp):
-        MediaThreadParams(threadName, segInfo), coderParams_(vcp){}
+        MediaThreadParams(threadName, segInfo), coderParams_(vcp), cpuCore_(-1){}
         
         VideoCoderParams coderParams_;
+        int cpuCore_;   // CPU core encoder worker is pinned to (-1 - not pinned)
         
         void write(std::ostream& os) const
         {
             MediaThreadParams::write(os);
             
             os << "; " << coderParams_;
+            if (cpuCore_ >= 0)
+                os << "; core " << cpuCore_;
         }
         
         MediaThreadParams*
@@ -221,10 +234,82 @@ namespace ndnrtc
             unsigned int sampleKeyMs_;
         } FreshnessPeriodParams;
 
-        GeneralProducerParams():segmentSize_(8000), freshness_({10, 15, 900}){}
+        // FEC parity ratio is the number of parity segments per one data 
+        // segment of a frame
+        typedef struct _FecParams {
+            bool adaptive_;             // whether ratios follow observed loss
+            double deltaParityRatio_;   // fixed ratio or lower bound for 
+            double keyParityRatio_;     // adaptive ratio
+            double maxParityRatio_;     // upper bound for adaptive ratio
+            bool lazy_;                 // compute parity only when it's requested
+            unsigned int groupSize_;    // number of consecutive delta frames
+                                        // protected together (0 - per-frame)
+        } FecParams;
+
+        typedef struct _SigningParams {
+            unsigned int threads_;      // number of signing threads (0 - sign
+                                        // on face thread)
+            bool signSamples_;          // sign every segment of video frames
+        } SigningParams;
+
+        typedef struct _ManifestParams {
+            unsigned int window_;       // number of consecutive delta frames
+                                        // covered by one manifest (0 - per-frame)
+            bool perFrame_;             // publish per-frame manifests for delta
+                                        // frames along with aggregated ones
+        } ManifestParams;
+
+        // captured frames are passed to encoding and encoded frames to 
+        // publishing through bounded queues
+        typedef struct _PipelineParams {
+            unsigned int depth_;        // queue depth in frames (0 - frames are
+                                        // dropped while previous are published)
+            bool dropOldest_;           // when queue is full, drop the oldest
+                                        // queued frame rather than the new one
+        } PipelineParams;
+
+        // encoders' bitrate and frame rate follow producer's load: encoding
+        // time, publishing backlog, dropped frames and consumers' demand
+        typedef struct _RateControlParams {
+            bool enabled_;
+            double minBitrateRatio_;    // lower bound for bitrate, as a fraction
+                                        // of thread's start bitrate
+            double minFrameRate_;       // lower bound for frame rate (FPS)
+            unsigned int intervalMs_;   // how often load is evaluated
+        } RateControlParams;
+
+        // threads nobody requests are not encoded; encoding resumes with a
+        // key frame once interests for the thread arrive
+        typedef struct _DemandParams {
+            bool enabled_;
+            unsigned int idleWindowMs_; // thread becomes dormant if there were
+                                        // no interests for it during this time
+        } DemandParams;
+
+        // segments of video frames are kept in producer's sample cache
+        typedef struct _SampleCacheParams {
+            unsigned int lifetimeMs_;   // how long frames are kept in cache
+            unsigned int budgetMb_;     // cache size limit, the oldest frames
+                                        // are evicted once it's exceeded
+        } SampleCacheParams;
+
+        GeneralProducerParams():segmentSize_(8000), freshness_({10, 15, 900}),
+        fec_({false, 0.2, 0.2, 1., false, 0}), signing_({0, false}),
+        manifest_({0, false}), pipeline_({0, true}),
+        rateControl_({false, 0.3, 5., 1000}), demand_({false, 5000}),
+        sampleCache_({4000, 64}), sendNacks_(false){}
 
         unsigned int segmentSize_;
         FreshnessPeriodParams freshness_;
+        FecParams fec_;
+        SigningParams signing_;
+        ManifestParams manifest_;
+        PipelineParams pipeline_;
+        RateControlParams rateControl_;
+        DemandParams demand_;
+        SampleCacheParams sampleCache_;
+        bool sendNacks_;            // answer interests for samples that won't be
+                                    // published with application NACKs
         
         void write(std::ostream& os) const
         {
@@ -233,6 +233,15 @@ namespace ndnrtc {
          */
         void start(const FetchingRuleSet& ruleset,
             IExternalRenderer* renderer);
+
+        /**
+         * Limits fetching to the given temporal layer (inclusive) for threads
+         * that are encoded with several temporal layers. Frames of higher 
+         * layers are not requested, reducing frame rate and bandwidth. Has no
+         * effect on single-layer threads. Can be called while fetching.
+         * @param layer Highest temporal layer to fetch (0 - base layer only)
+         */
+        void setMaxTemporalLayer(unsigned int layer);
 	};
     
     /**
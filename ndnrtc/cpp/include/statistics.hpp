@@ -38,6 +38,8 @@ namespace ndnrtc {
                 RecoveredKeyNum,                // VideoPlayout
                 RescuedNum,                     // VideoPlayout
                 RescuedKeyNum,                  // VideoPlayout
+                FecGroupFetchedNum,             // FecGroupRecovery
+                FecGroupRecoveredNum,           // FecGroupRecovery
                 IncompleteNum,                  // Buffer
                 IncompleteKeyNum,               // Buffer
                 BufferTargetSize,               // RemoteStreamImpl
@@ -46,6 +48,8 @@ namespace ndnrtc {
                 CurrentProducerFramerate,       // BufferControl
                 VerifySuccess,                  // SampleValidator
                 VerifyFailure,                  // SampleValidator
+                VerifyRecovered,                // SampleValidator
+                ManifestWindowFetchedNum,       // ManifestValidator
                 LatencyControlStable,           // LatencyControl
                 LatencyControlCommand,          // LatencyControl
                 FrameFetchAvgDelta,             // Buffer
@@ -100,13 +104,33 @@ namespace ndnrtc {
                 PublishedKeyNum,
                 InterestsReceivedNum,
                 SignNum,
+                ParityDeferredNum,
+                ParityLazyNum,
+                ParityFailedNum,
+                FecGroupPublishedNum,
+                ManifestWindowPublishedNum,
+
+                // producer pipeline
+                PipelineCaptureQueueSize,
+                PipelinePublishQueueSize,
+                PipelineDroppedNum,
+                PipelineQueueDelay,
+                PipelineEncodeDelay,
+                PipelinePublishDelay,
                 
                 // encoder
                 // DroppedNum, // borrowed from buffer (above)
                 EncodedNum,
+                EncoderBitrateRatio,
+                EncoderFrameRateRatio,
+                RateControlSkippedNum,
                 
                 // capturer
-                CapturedNum
+                CapturedNum,
+                // frame buffer pool is shared by all streams, these are
+                // process-wide figures
+                FramePoolHitNum,
+                FramePoolMissNum
         };
         
         class StatisticsStorage {
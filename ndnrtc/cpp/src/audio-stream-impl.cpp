@@ -26,15 +26,18 @@ AudioStreamImpl::AudioStreamImpl(const std::string &basePrefix,
     if (settings_.params_.type_ == MediaStreamParams::MediaStreamType::MediaStreamTypeVideo)
         throw runtime_error("Wrong media stream parameters type supplied (video instead of audio)");
 
-    PublisherSettings ps;
+    SamplePublisherSettings ps;
     ps.sign_ = true;
+    ps.signingPool_ = signingPool_.get();
+    ps.faceIo_ = &settings_.faceIo_;
     ps.keyChain_ = settings_.keyChain_;
-    ps.memoryCache_ = cache_.get();
+    ps.memoryCache_ = sampleCache_.get();
     ps.segmentWireLength_ = settings_.params_.producerParams_.segmentSize_;
     ps.freshnessPeriodMs_ = settings.params_.producerParams_.freshness_.sampleMs_;
+    ps.sendNacks_ = settings_.params_.producerParams_.sendNacks_;
     ps.statStorage_ = statStorage_.get();
 
-    samplePublisher_ = boost::make_shared<CommonPacketPublisher>(ps);
+    samplePublisher_ = boost::make_shared<CommonSamplePublisher>(ps);
     samplePublisher_->setDescription("sample-publisher-" + settings_.params_.streamName_);
 
     description_ = "astream-" + settings_.params_.streamName_;
@@ -196,7 +199,8 @@ void AudioStreamImpl::onSampleBundle(std::string threadName, uint64_t bundleNo,
             packetHdr.publishUnixTimestamp_ = clock::unixTimestamp();
             bundle->setHeader(packetHdr);
 
-            me->samplePublisher_->publish(n, *bundle);
+            // bundle is copied into segments before returning
+            me->samplePublisher_->publishAsync(n, *bundle, -1, false, false);
             (*statStorage_)[Indicator::PublishedNum]++;
 
             {
@@ -222,7 +226,7 @@ bool AudioStreamImpl::updateMeta()
             // TODO: appendVersion() should probably be gone once SegemntFetcher
             // is updated to work without version number
             metaName.append(it.first).append(NameComponents::NameComponentMeta).appendVersion(0);
-            metadataPublisher_->publish(metaName, it.second->getMeta());
+            metadataPublisher_->publishAsync(metaName, it.second->getMeta(), -1, false, false);
         }
     }
     return streamRunning_;
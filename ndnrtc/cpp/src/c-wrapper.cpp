@@ -297,6 +297,66 @@ int ndnrtc_LocalVideoStream_incomingNV21Frame(ndnrtc::LocalVideoStream *stream,
 	return -1;
 }
 
+int ndnrtc_LocalVideoStream_incomingExternalI420Frame(ndnrtc::LocalVideoStream *stream,
+			const unsigned int width,
+			const unsigned int height,
+			const unsigned int strideY,
+			const unsigned int strideU,
+			const unsigned int strideV,
+			const unsigned char* yBuffer,
+			const unsigned char* uBuffer,
+			const unsigned char* vBuffer,
+			FrameReleased releasedFunc,
+			void* userData)
+{
+	if (stream)
+		return stream->incomingExternalI420Frame(width, height, strideY, strideU, strideV, 
+			yBuffer, uBuffer, vBuffer, 
+			[releasedFunc, userData](){ if (releasedFunc) releasedFunc(userData); });
+
+	if (releasedFunc)
+		releasedFunc(userData);
+	return -1;
+}
+
+int ndnrtc_LocalVideoStream_incomingExternalNV12Frame(ndnrtc::LocalVideoStream *stream,
+			const unsigned int width,
+			const unsigned int height,
+			const unsigned int strideY,
+			const unsigned int strideUV,
+			const unsigned char* yBuffer,
+			const unsigned char* uvBuffer,
+			FrameReleased releasedFunc,
+			void* userData)
+{
+	if (stream)
+		return stream->incomingExternalNV12Frame(width, height, strideY, strideUV, yBuffer, uvBuffer,
+			[releasedFunc, userData](){ if (releasedFunc) releasedFunc(userData); });
+
+	if (releasedFunc)
+		releasedFunc(userData);
+	return -1;
+}
+
+int ndnrtc_LocalVideoStream_incomingExternalNV21Frame(ndnrtc::LocalVideoStream *stream,
+			const unsigned int width,
+			const unsigned int height,
+			const unsigned int strideY,
+			const unsigned int strideUV,
+			const unsigned char* yBuffer,
+			const unsigned char* uvBuffer,
+			FrameReleased releasedFunc,
+			void* userData)
+{
+	if (stream)
+		return stream->incomingExternalNV21Frame(width, height, strideY, strideUV, yBuffer, uvBuffer,
+			[releasedFunc, userData](){ if (releasedFunc) releasedFunc(userData); });
+
+	if (releasedFunc)
+		releasedFunc(userData);
+	return -1;
+}
+
 int ndnrtc_LocalVideoStream_incomingArgbFrame(ndnrtc::LocalVideoStream *stream,
 			const unsigned int width,
 			const unsigned int height,
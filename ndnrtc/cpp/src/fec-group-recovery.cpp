@@ -0,0 +1,204 @@
+//
+// fec-group-recovery.cpp
+//
+//  Copyright 2013-2018 Regents of the University of California
+//
+
+#include "fec-group-recovery.hpp"
+
+#include <set>
+#include <ndn-cpp/data.hpp>
+#include <ndn-cpp/interest.hpp>
+
+#include "frame-data.hpp"
+#include "name-components.hpp"
+#include "meta-fetcher.hpp"
+
+using namespace ndnrtc;
+using namespace ndnrtc::statistics;
+using namespace ndn;
+
+static const size_t MAX_PENDING_FRAMES = 64;
+static const size_t MAX_GROUPS = 16;
+
+FecGroupRecovery::FecGroupRecovery(boost::asio::io_service &io,
+                                   const boost::shared_ptr<ndn::Face> &face,
+                                   const boost::shared_ptr<ndn::KeyChain> &keyChain,
+                                   const boost::shared_ptr<IBuffer> &buffer,
+                                   const Name &threadPrefix, const std::string &threadName,
+                                   unsigned int groupSize,
+                                   const boost::shared_ptr<StatisticsStorage> &storage)
+    : StatObject(storage), io_(io), face_(face), keyChain_(keyChain), buffer_(buffer),
+      threadPrefix_(threadPrefix), threadName_(threadName), groupSize_(groupSize)
+{
+    description_ = "fec-group-recovery";
+}
+
+void FecGroupRecovery::onNewData(const BufferReceipt &receipt)
+{
+    const NamespaceInfo &info = receipt.segment_->getInfo();
+    if (!isDeltaData(info))
+        return;
+
+    boost::shared_ptr<WireData<VideoFrameSegmentHeader>> wd =
+        boost::dynamic_pointer_cast<WireData<VideoFrameSegmentHeader>>(receipt.segment_->getData());
+    if (wd)
+        decoder_.segmentArrived(info.sampleNo_, info.segNo_,
+                                wd->segment().getPayload().data(),
+                                wd->segment().getPayload().size());
+
+    std::map<PacketNumber, PendingSegments>::iterator it = pending_.find(info.sampleNo_);
+    if (it != pending_.end())
+    {
+        it->second.erase(info.segNo_);
+        if (it->second.empty())
+            pending_.erase(it);
+    }
+}
+
+void FecGroupRecovery::onReset()
+{
+    decoder_.reset();
+    pending_.clear();
+    groups_.clear();
+}
+
+void FecGroupRecovery::onRetransmissionRequired(const std::vector<boost::shared_ptr<const ndn::Interest>> &interests)
+{
+    std::set<PacketNumber> groups;
+    for (auto &i : interests)
+    {
+        NamespaceInfo info;
+        if (NameComponents::extractInfo(i->getName(), info) && isDeltaData(info))
+        {
+            pending_[info.sampleNo_][info.segNo_] = i;
+            groups.insert(FecGroupPacket::groupNo(info.sampleNo_, groupSize_));
+        }
+    }
+
+    while (pending_.size() > MAX_PENDING_FRAMES)
+        pending_.erase(pending_.begin());
+
+    for (auto groupNo : groups)
+        if (groups_.find(groupNo) == groups_.end())
+        {
+            groups_[groupNo] = boost::shared_ptr<FecGroupPacket>();
+            while (groups_.size() > MAX_GROUPS)
+                groups_.erase(groups_.begin());
+
+            fetchGroup(groupNo);
+        }
+        else if (groups_[groupNo])
+        {
+            // rtx is checked while buffer notifies its' observers, so
+            // recovered segments can't be passed to the buffer right away
+            boost::shared_ptr<FecGroupRecovery> me =
+                boost::dynamic_pointer_cast<FecGroupRecovery>(shared_from_this());
+            boost::shared_ptr<FecGroupPacket> groupPacket = groups_[groupNo];
+            io_.post([me, groupPacket]() { me->recover(*groupPacket); });
+        }
+}
+
+void FecGroupRecovery::fetchGroup(PacketNumber groupNo)
+{
+    boost::shared_ptr<FecGroupRecovery> me =
+        boost::dynamic_pointer_cast<FecGroupRecovery>(shared_from_this());
+    boost::shared_ptr<MetaFetcher> fetcher = boost::make_shared<MetaFetcher>(face_, keyChain_);
+    Name groupName = FecGroupPacket::groupName(threadPrefix_, groupNo);
+
+    LogDebugC << "fetch FEC group " << groupNo << " " << groupName << std::endl;
+
+    fetcher->fetch(groupName,
+                   [me, fetcher, groupNo, this](NetworkData &nd,
+                                                const std::vector<ValidationErrorInfo> info,
+                                                const std::vector<boost::shared_ptr<ndn::Data>> &) {
+                       boost::shared_ptr<FecGroupPacket> groupPacket =
+                           boost::make_shared<FecGroupPacket>(boost::move(nd));
+
+                       if (info.size() || !groupPacket->isValid())
+                       {
+                           LogWarnC << "invalid FEC group " << groupNo << std::endl;
+                           groupPacket.reset();
+                       }
+
+                       onGroupFetched(groupNo, groupPacket);
+                   },
+                   [me, fetcher, groupNo, this](const std::string &msg) {
+                       LogWarnC << "couldn't fetch FEC group " << groupNo << ": " << msg << std::endl;
+                       onGroupFetched(groupNo, boost::shared_ptr<FecGroupPacket>());
+                   });
+}
+
+void FecGroupRecovery::onGroupFetched(PacketNumber groupNo,
+                                      const boost::shared_ptr<FecGroupPacket> &groupPacket)
+{
+    if (!groupPacket)
+    {
+        groups_.erase(groupNo);
+        return;
+    }
+
+    (*statStorage_)[Indicator::FecGroupFetchedNum]++;
+    if (groups_.find(groupNo) != groups_.end())
+        groups_[groupNo] = groupPacket;
+    recover(*groupPacket);
+}
+
+bool FecGroupRecovery::isDeltaData(const NamespaceInfo &info) const
+{
+    return info.isDelta_ && info.segmentClass_ == SegmentClass::Data &&
+           info.threadName_ == threadName_;
+}
+
+void FecGroupRecovery::recover(const FecGroupPacket &groupPacket)
+{
+    std::map<PacketNumber, FecGroupDecoder::FrameSegments> recovered = decoder_.recover(groupPacket);
+
+    for (auto &m : groupPacket.getMembers())
+    {
+        if (recovered.find(m.seqNo_) == recovered.end() ||
+            pending_.find(m.seqNo_) == pending_.end())
+            continue;
+
+        // pending Interests are moved out, as they're satisfied now
+        PendingSegments interests;
+        interests.swap(pending_[m.seqNo_]);
+        pending_.erase(m.seqNo_);
+
+        unsigned int nSegments = FecGroupPacket::symbolsNum(m.length_, groupPacket.getSymbolLength());
+        VideoFrameSegmentHeader hdr;
+        hdr.totalSegmentsNum_ = nSegments;
+        hdr.playbackNo_ = m.playbackNo_;
+        hdr.pairedSequenceNo_ = m.pairedSequenceNo_;
+
+        int nDelivered = 0;
+        for (auto &it : recovered[m.seqNo_])
+        {
+            if (interests.find(it.first) == interests.end())
+                continue;
+
+            VideoFrameSegment segment(it.second.begin(), it.second.end());
+            segment.setHeader(hdr);
+            boost::shared_ptr<NetworkData> segmentData = segment.getNetworkData();
+            boost::shared_ptr<ndn::Data> data = boost::make_shared<ndn::Data>(interests[it.first]->getName());
+            data->getMetaInfo().setFinalBlockId(Name::Component::fromSegment(nSegments - 1));
+            data->setContent(segmentData->getData(), segmentData->getLength());
+
+            boost::shared_ptr<WireSegment> wireSegment =
+                boost::make_shared<WireData<VideoFrameSegmentHeader>>(data, interests[it.first]);
+            wireSegment->setRecovered();
+            if (wireSegment->isValid() && buffer_->isRequested(wireSegment))
+            {
+                buffer_->received(wireSegment);
+                nDelivered++;
+            }
+        }
+
+        if (nDelivered)
+        {
+            (*statStorage_)[Indicator::FecGroupRecoveredNum]++;
+            LogDebugC << "recovered " << m.seqNo_ << "d x" << nDelivered
+                      << " (group " << groupPacket.getGroupNo() << ")" << std::endl;
+        }
+    }
+}
@@ -0,0 +1,92 @@
+//
+// fec-group-recovery.hpp
+//
+//  Copyright 2013-2018 Regents of the University of California
+//
+
+#ifndef __fec_group_recovery_h__
+#define __fec_group_recovery_h__
+
+#include <map>
+#include <boost/asio.hpp>
+#include <ndn-cpp/name.hpp>
+
+#include "frame-buffer.hpp"
+#include "rtx-controller.hpp"
+#include "fec-group.hpp"
+#include "statistics.hpp"
+
+namespace ndn
+{
+class Face;
+class KeyChain;
+class Interest;
+}
+
+namespace ndnrtc
+{
+/**
+ * Recovers delta frames of a thread, which are protected by FEC groups (see
+ * fec-group.hpp). Data segments of recent delta frames are kept for decoding.
+ * Group packet is fetched once retransmission is required for any frame of the
+ * group. Recovered segments are passed to the buffer as if they have arrived
+ * from the network, with the Interests that are pending for them, and are
+ * marked as recovered (see WireSegment::isRecovered()): they are not listed in
+ * frame manifests, but group packets are verified upon fetching.
+ */
+class FecGroupRecovery : public NdnRtcComponent,
+                         public IBufferObserver,
+                         public IRtxObserver,
+                         public statistics::StatObject
+{
+  public:
+    FecGroupRecovery(boost::asio::io_service &io,
+                     const boost::shared_ptr<ndn::Face> &face,
+                     const boost::shared_ptr<ndn::KeyChain> &keyChain,
+                     const boost::shared_ptr<IBuffer> &buffer,
+                     const ndn::Name &threadPrefix, const std::string &threadName,
+                     unsigned int groupSize,
+                     const boost::shared_ptr<statistics::StatisticsStorage> &storage);
+
+    // IBufferObserver
+    void onNewRequest(const boost::shared_ptr<BufferSlot> &) {}
+    void onNewData(const BufferReceipt &receipt);
+    void onReset();
+
+    // IRtxObserver
+    void onRetransmissionRequired(const std::vector<boost::shared_ptr<const ndn::Interest>> &interests);
+
+  protected:
+    /**
+     * Fetches group packet and passes it to onGroupFetched() on face thread.
+     */
+    virtual void fetchGroup(PacketNumber groupNo);
+
+    /**
+     * Recovers frames of the group, which have pending Interests.
+     * @param groupPacket Fetched group packet or nullptr, if fetching failed
+     */
+    void onGroupFetched(PacketNumber groupNo, const boost::shared_ptr<FecGroupPacket> &groupPacket);
+
+  private:
+    // Interests of missing segments, keyed by segment numbers
+    typedef std::map<unsigned int, boost::shared_ptr<const ndn::Interest>> PendingSegments;
+
+    boost::asio::io_service &io_;
+    boost::shared_ptr<ndn::Face> face_;
+    boost::shared_ptr<ndn::KeyChain> keyChain_;
+    boost::shared_ptr<IBuffer> buffer_;
+    ndn::Name threadPrefix_;
+    std::string threadName_;
+    unsigned int groupSize_;
+    FecGroupDecoder decoder_;
+    std::map<PacketNumber, PendingSegments> pending_;
+    // fetched (or being fetched, if nullptr) group packets
+    std::map<PacketNumber, boost::shared_ptr<FecGroupPacket>> groups_;
+
+    bool isDeltaData(const NamespaceInfo &info) const;
+    void recover(const FecGroupPacket &groupPacket);
+};
+}
+
+#endif
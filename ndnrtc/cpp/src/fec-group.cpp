@@ -0,0 +1,206 @@
+//
+// fec-group.cpp
+//
+//  Copyright 2013-2018 Regents of the University of California
+//
+
+#include <algorithm>
+#include <cmath>
+
+#include "fec-group.hpp"
+#include "fec.hpp"
+
+// Reed-Solomon code over GF(2^8) can't have more symbols
+#define FEC_GROUP_MAX_SYMBOLS 255
+
+using namespace ndnrtc;
+using namespace ndn;
+
+FecGroupPacket::FecGroupPacket(PacketNumber groupNo, unsigned int symbolLength,
+                               const std::vector<Member> &members,
+                               const std::vector<uint8_t> &parityData)
+    : DataPacket(parityData)
+{
+    GroupInfo info({groupNo, symbolLength});
+    addBlob(sizeof(info), (uint8_t *)&info);
+    for (auto &m : members)
+        addBlob(sizeof(m), (uint8_t *)&m);
+}
+
+FecGroupPacket::FecGroupPacket(NetworkData &&data) : DataPacket(boost::move(data))
+{
+    bool membersValid = true;
+    for (int i = 1; i < blobs_.size(); ++i)
+        membersValid &= (blobs_[i].size() == sizeof(Member));
+
+    isValid_ = (blobs_.size() > 1 && blobs_[0].size() == sizeof(GroupInfo) && membersValid &&
+                getSymbolLength() > 0 && getPayload().size() > 0 &&
+                getPayload().size() % getSymbolLength() == 0);
+}
+
+PacketNumber FecGroupPacket::getGroupNo() const
+{
+    return ((GroupInfo *)blobs_[0].data())->groupNo_;
+}
+
+unsigned int FecGroupPacket::getSymbolLength() const
+{
+    return ((GroupInfo *)blobs_[0].data())->symbolLength_;
+}
+
+unsigned int FecGroupPacket::getParitySymbolsNum() const
+{
+    return getPayload().size() / getSymbolLength();
+}
+
+std::vector<FecGroupPacket::Member> FecGroupPacket::getMembers() const
+{
+    std::vector<Member> members;
+    for (int i = 1; i < blobs_.size(); ++i)
+        members.push_back(*(Member *)blobs_[i].data());
+    return members;
+}
+
+Name FecGroupPacket::groupName(const Name &threadPrefix, PacketNumber groupNo)
+{
+    return Name(threadPrefix)
+        .append(NameComponents::NameComponentDelta)
+        .append(NameComponents::NameComponentParity)
+        .appendSequenceNumber(groupNo);
+}
+
+//******************************************************************************
+FecGroupEncoder::FecGroupEncoder(unsigned int groupSize, size_t symbolLength)
+    : groupSize_(groupSize), symbolLength_(symbolLength), groupNo_(-1)
+{
+    if (groupSize_ == 0 || symbolLength_ == 0)
+        throw std::runtime_error("FEC group size and symbol length must be positive");
+}
+
+boost::shared_ptr<FecGroupPacket>
+FecGroupEncoder::addFrame(PacketNumber seqNo, PacketNumber playbackNo, PacketNumber pairedSeqNo,
+                          const NetworkData &frame, double parityRatio)
+{
+    PacketNumber groupNo = FecGroupPacket::groupNo(seqNo, groupSize_);
+
+    if (groupNo != groupNo_ || (members_.size() && seqNo <= members_.back().seqNo_))
+        reset(groupNo);
+
+    size_t nSymbols = data_.size() / symbolLength_ + FecGroupPacket::symbolsNum(frame.getLength(), symbolLength_);
+    data_.insert(data_.end(), frame.getData(), frame.getData() + frame.getLength());
+    data_.resize(nSymbols * symbolLength_, 0);
+    members_.push_back({seqNo, playbackNo, pairedSeqNo, (uint32_t)frame.getLength()});
+
+    if ((seqNo + 1) % groupSize_)
+        return boost::shared_ptr<FecGroupPacket>();
+
+    boost::shared_ptr<FecGroupPacket> groupPacket;
+    size_t nParitySymbols = std::max(1., std::ceil(parityRatio * nSymbols));
+
+    if (nSymbols < FEC_GROUP_MAX_SYMBOLS)
+    {
+        nParitySymbols = std::min(nParitySymbols, FEC_GROUP_MAX_SYMBOLS - nSymbols);
+
+        std::vector<uint8_t> parityData(nParitySymbols * symbolLength_, 0);
+        fec::Rs28Encoder enc(nSymbols, nParitySymbols, symbolLength_);
+        if (enc.encode(data_.data(), parityData.data()) >= 0)
+            groupPacket = boost::make_shared<FecGroupPacket>(groupNo_, symbolLength_, members_, parityData);
+    }
+
+    reset(-1);
+    return groupPacket;
+}
+
+void FecGroupEncoder::reset(PacketNumber groupNo)
+{
+    groupNo_ = groupNo;
+    members_.clear();
+    data_.clear();
+}
+
+//******************************************************************************
+FecGroupDecoder::FecGroupDecoder(size_t capacity) : capacity_(capacity)
+{
+}
+
+void FecGroupDecoder::segmentArrived(PacketNumber seqNo, unsigned int segNo,
+                                     const uint8_t *payload, size_t length)
+{
+    frames_[seqNo][segNo] = std::vector<uint8_t>(payload, payload + length);
+
+    while (frames_.size() > capacity_)
+        frames_.erase(frames_.begin());
+}
+
+std::map<PacketNumber, FecGroupDecoder::FrameSegments>
+FecGroupDecoder::recover(const FecGroupPacket &groupPacket)
+{
+    std::map<PacketNumber, FrameSegments> recovered;
+
+    if (!groupPacket.isValid())
+        return recovered;
+
+    std::vector<FecGroupPacket::Member> members = groupPacket.getMembers();
+    size_t symbolLength = groupPacket.getSymbolLength();
+    size_t nParitySymbols = groupPacket.getParitySymbolsNum();
+    size_t nSymbols = 0;
+
+    for (auto &m : members)
+        nSymbols += FecGroupPacket::symbolsNum(m.length_, symbolLength);
+
+    if (nSymbols == 0 || nSymbols + nParitySymbols > FEC_GROUP_MAX_SYMBOLS)
+        return recovered;
+
+    std::vector<uint8_t> data(nSymbols * symbolLength, 0);
+    std::vector<uint8_t> parityData(groupPacket.getPayload().begin(), groupPacket.getPayload().end());
+    std::vector<uint8_t> rList(nSymbols + nParitySymbols, FEC_RLIST_SYMREADY);
+    size_t symbolNo = 0, nMissing = 0;
+
+    for (auto &m : members)
+    {
+        size_t nFrameSymbols = FecGroupPacket::symbolsNum(m.length_, symbolLength);
+        std::map<PacketNumber, FrameSegments>::const_iterator frame = frames_.find(m.seqNo_);
+
+        for (unsigned int segNo = 0; segNo < nFrameSymbols; ++segNo, ++symbolNo)
+        {
+            FrameSegments::const_iterator segment;
+
+            if (frame != frames_.end() &&
+                (segment = frame->second.find(segNo)) != frame->second.end())
+                std::copy(segment->second.begin(),
+                          segment->second.begin() + std::min(segment->second.size(), symbolLength),
+                          data.begin() + symbolNo * symbolLength);
+            else
+            {
+                rList[symbolNo] = FEC_RLIST_SYMEMPTY;
+                nMissing++;
+            }
+        }
+    }
+
+    if (nMissing == 0 || nMissing > nParitySymbols)
+        return recovered;
+
+    fec::Rs28Decoder dec(nSymbols, nParitySymbols, symbolLength);
+    if (dec.decode(data.data(), parityData.data(), rList.data()) < 0)
+        return recovered;
+
+    symbolNo = 0;
+    for (auto &m : members)
+    {
+        size_t nFrameSymbols = FecGroupPacket::symbolsNum(m.length_, symbolLength);
+
+        for (unsigned int segNo = 0; segNo < nFrameSymbols; ++segNo, ++symbolNo)
+            if (rList[symbolNo] == FEC_RLIST_SYMREPAIRED)
+            {
+                // last segment of a frame is shorter than the symbol
+                size_t length = (segNo + 1 < nFrameSymbols ? symbolLength : m.length_ - segNo * symbolLength);
+                std::vector<uint8_t>::iterator begin = data.begin() + symbolNo * symbolLength;
+
+                recovered[m.seqNo_][segNo] = std::vector<uint8_t>(begin, begin + length);
+                segmentArrived(m.seqNo_, segNo, &(*begin), length);
+            }
+    }
+
+    return recovered;
+}
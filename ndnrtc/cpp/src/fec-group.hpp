@@ -0,0 +1,148 @@
+//
+// fec-group.hpp
+//
+//  Copyright 2013-2018 Regents of the University of California
+//
+
+#ifndef __fec_group_h__
+#define __fec_group_h__
+
+#include <map>
+#include <ndn-cpp/name.hpp>
+
+#include "network-data.hpp"
+
+namespace ndnrtc
+{
+/**
+ * FEC group packet carries parity data, computed over a group of consecutive
+ * delta frames of a video thread. Delta frame with sequence number N belongs
+ * to the group number N / <group size>. Frames are split into symbols the same
+ * way they are split into data segments, thus every data segment of a frame
+ * is one symbol of the group. Besides parity, packet describes all frames of
+ * the group, so that consumer could restore segments (including their headers)
+ * of a frame, even if the frame was lost completely.
+ * Group packets are published under <thread>/d/_parity/<group number>.
+ */
+class FecGroupPacket : public DataPacket
+{
+  public:
+    typedef struct _Member
+    {
+        PacketNumber seqNo_;
+        PacketNumber playbackNo_;
+        PacketNumber pairedSequenceNo_;
+        uint32_t length_; // frame packet length in bytes
+    } __attribute__((packed)) Member;
+
+    FecGroupPacket(PacketNumber groupNo, unsigned int symbolLength,
+                   const std::vector<Member> &members,
+                   const std::vector<uint8_t> &parityData);
+    FecGroupPacket(NetworkData &&data);
+
+    PacketNumber getGroupNo() const;
+    unsigned int getSymbolLength() const;
+    unsigned int getParitySymbolsNum() const;
+    std::vector<Member> getMembers() const;
+
+    /**
+     * Number of symbols of given length data of given length is split into
+     */
+    static size_t symbolsNum(size_t length, size_t symbolLength)
+    {
+        return length / symbolLength + (length % symbolLength ? 1 : 0);
+    }
+
+    static PacketNumber groupNo(PacketNumber seqNo, unsigned int groupSize)
+    {
+        return seqNo / groupSize;
+    }
+
+    static ndn::Name groupName(const ndn::Name &threadPrefix, PacketNumber groupNo);
+
+  private:
+    typedef struct _GroupInfo
+    {
+        PacketNumber groupNo_;
+        uint32_t symbolLength_;
+    } __attribute__((packed)) GroupInfo;
+};
+
+/**
+ * FEC group encoder is used by producer for computing group parity. Delta
+ * frames must be added in the order of their sequence numbers. Parity is
+ * computed once the last frame of a group is added. If sequence numbers jump
+ * to a different group (for instance, when thread is reset), incomplete group
+ * is discarded.
+ * Reed-Solomon code over GF(2^8) can't have more than 255 symbols, thus groups
+ * that are too large (with parity) are not protected.
+ */
+class FecGroupEncoder
+{
+  public:
+    FecGroupEncoder(unsigned int groupSize, size_t symbolLength);
+
+    /**
+     * Adds delta frame to the current group.
+     * @param seqNo Delta frame sequence number
+     * @param playbackNo Frame playback number
+     * @param pairedSeqNo Sequence number of paired key frame
+     * @param frame Frame packet
+     * @param parityRatio Number of parity symbols per one data symbol
+     * @return Group packet if this frame completes the group, or nullptr
+     */
+    boost::shared_ptr<FecGroupPacket>
+    addFrame(PacketNumber seqNo, PacketNumber playbackNo, PacketNumber pairedSeqNo,
+             const NetworkData &frame, double parityRatio);
+
+    unsigned int getGroupSize() const { return groupSize_; }
+
+  private:
+    unsigned int groupSize_;
+    size_t symbolLength_;
+    PacketNumber groupNo_;
+    std::vector<FecGroupPacket::Member> members_;
+    std::vector<uint8_t> data_;
+
+    void reset(PacketNumber groupNo);
+};
+
+/**
+ * FEC group decoder is used by consumer for recovering segments of delta
+ * frames with the help of group packets. It keeps data segments of recent
+ * delta frames, which are needed for decoding, since frames of the group are
+ * usually played out (and their buffer slots are freed) by the time group
+ * packet arrives.
+ */
+class FecGroupDecoder
+{
+  public:
+    // segment payloads, keyed by segment number
+    typedef std::map<unsigned int, std::vector<uint8_t>> FrameSegments;
+
+    FecGroupDecoder(size_t capacity = 64);
+
+    /**
+     * Stores payload of delta frame data segment.
+     */
+    void segmentArrived(PacketNumber seqNo, unsigned int segNo,
+                        const uint8_t *payload, size_t length);
+
+    /**
+     * Recovers missing segments of the frames of a group. Recovered segments
+     * are stored as if they have arrived.
+     * @return Recovered segments, keyed by frame sequence number or empty map
+     *          if nothing can be recovered
+     */
+    std::map<PacketNumber, FrameSegments> recover(const FecGroupPacket &groupPacket);
+
+    void reset() { frames_.clear(); }
+    size_t size() const { return frames_.size(); }
+
+  private:
+    size_t capacity_;
+    std::map<PacketNumber, FrameSegments> frames_;
+};
+}
+
+#endif
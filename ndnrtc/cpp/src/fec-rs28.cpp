@@ -0,0 +1,459 @@
+//
+//  fec-rs28.cpp
+//  ndnrtc
+//
+//  Copyright 2013-2018 Regents of the University of California
+//  For licensing details see the LICENSE file.
+//
+
+#include <atomic>
+#include <map>
+#include <cstring>
+#include <boost/make_shared.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/lock_guard.hpp>
+
+#include "fec-rs28.hpp"
+
+#if (defined(__x86_64__) || defined(__i386__)) && (defined(__GNUC__) || defined(__clang__))
+#define RS28_X86 1
+#include <immintrin.h>
+#endif
+
+using namespace fec::rs28;
+
+namespace
+{
+    /**
+     * GF(2^8) arithmetic tables. Field is generated by the same primitive
+     * polynomial x^8+x^4+x^3+x^2+1 as OpenFEC uses.
+     */
+    class GaloisField
+    {
+    public:
+        GaloisField()
+        {
+            unsigned int x = 1;
+            for (int i = 0; i < 255; ++i)
+            {
+                exp_[i] = exp_[i + 255] = (uint8_t)x;
+                log_[x] = i;
+                x <<= 1;
+                if (x & 0x100)
+                    x ^= 0x11d;
+            }
+            log_[0] = 255; // never used
+
+            inverse_[0] = 0;
+            for (int i = 1; i < 256; ++i)
+                inverse_[i] = exp_[255 - log_[i]];
+
+            for (int a = 0; a < 256; ++a)
+                for (int b = 0; b < 256; ++b)
+                    mul_[a][b] = (a && b ? exp_[log_[a] + log_[b]] : 0);
+        }
+
+        uint8_t exp(unsigned int power) const { return exp_[power % 255]; }
+        uint8_t mul(uint8_t a, uint8_t b) const { return mul_[a][b]; }
+        uint8_t inverse(uint8_t a) const { return inverse_[a]; }
+        // products of c and all field elements
+        const uint8_t *mulRow(uint8_t c) const { return mul_[c]; }
+
+    private:
+        uint8_t exp_[2 * 255];
+        unsigned int log_[256];
+        uint8_t inverse_[256];
+        uint8_t mul_[256][256];
+    };
+
+    const GaloisField &gf()
+    {
+        static const GaloisField galoisField;
+        return galoisField;
+    }
+
+    void mulAddRegionScalar(uint8_t *dst, const uint8_t *src, uint8_t c, size_t length)
+    {
+        const uint8_t *mulRow = gf().mulRow(c);
+        for (size_t i = 0; i < length; ++i)
+            dst[i] ^= mulRow[src[i]];
+    }
+
+#ifdef RS28_X86
+    // split-nibble multiplication: c*x = c*(x & 0x0f) ^ c*(x & 0xf0), both
+    // looked up in 16-entry tables with a byte shuffle
+    void buildNibbleTables(uint8_t c, uint8_t *lo, uint8_t *hi)
+    {
+        const uint8_t *mulRow = gf().mulRow(c);
+        for (int i = 0; i < 16; ++i)
+        {
+            lo[i] = mulRow[i];
+            hi[i] = mulRow[i << 4];
+        }
+    }
+
+    __attribute__((target("ssse3"))) void
+    mulAddRegionSsse3(uint8_t *dst, const uint8_t *src, uint8_t c, size_t length)
+    {
+        uint8_t lo[16], hi[16];
+        buildNibbleTables(c, lo, hi);
+
+        const __m128i tableLo = _mm_loadu_si128((const __m128i *)lo);
+        const __m128i tableHi = _mm_loadu_si128((const __m128i *)hi);
+        const __m128i mask = _mm_set1_epi8(0x0f);
+        size_t i = 0;
+
+        for (; i + 16 <= length; i += 16)
+        {
+            __m128i s = _mm_loadu_si128((const __m128i *)(src + i));
+            __m128i d = _mm_loadu_si128((const __m128i *)(dst + i));
+            __m128i pLo = _mm_shuffle_epi8(tableLo, _mm_and_si128(s, mask));
+            __m128i pHi = _mm_shuffle_epi8(tableHi, _mm_and_si128(_mm_srli_epi64(s, 4), mask));
+            _mm_storeu_si128((__m128i *)(dst + i), _mm_xor_si128(d, _mm_xor_si128(pLo, pHi)));
+        }
+
+        mulAddRegionScalar(dst + i, src + i, c, length - i);
+    }
+
+    __attribute__((target("avx2"))) void
+    mulAddRegionAvx2(uint8_t *dst, const uint8_t *src, uint8_t c, size_t length)
+    {
+        uint8_t lo[16], hi[16];
+        buildNibbleTables(c, lo, hi);
+
+        const __m256i tableLo = _mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i *)lo));
+        const __m256i tableHi = _mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i *)hi));
+        const __m256i mask = _mm256_set1_epi8(0x0f);
+        size_t i = 0;
+
+        for (; i + 32 <= length; i += 32)
+        {
+            __m256i s = _mm256_loadu_si256((const __m256i *)(src + i));
+            __m256i d = _mm256_loadu_si256((const __m256i *)(dst + i));
+            __m256i pLo = _mm256_shuffle_epi8(tableLo, _mm256_and_si256(s, mask));
+            __m256i pHi = _mm256_shuffle_epi8(tableHi, _mm256_and_si256(_mm256_srli_epi64(s, 4), mask));
+            _mm256_storeu_si256((__m256i *)(dst + i), _mm256_xor_si256(d, _mm256_xor_si256(pLo, pHi)));
+        }
+
+        mulAddRegionScalar(dst + i, src + i, c, length - i);
+    }
+#endif
+
+    std::atomic<SimdLevel> &currentSimdLevel()
+    {
+        static std::atomic<SimdLevel> simdLevel(detectSimdLevel());
+        return simdLevel;
+    }
+
+    /**
+     * Multiplies matrices: c = a*b, where a is n x k and b is k x m
+     */
+    void matmul(const uint8_t *a, const uint8_t *b, uint8_t *c,
+                unsigned int n, unsigned int k, unsigned int m)
+    {
+        for (unsigned int row = 0; row < n; ++row)
+            for (unsigned int col = 0; col < m; ++col)
+            {
+                uint8_t acc = 0;
+                for (unsigned int i = 0; i < k; ++i)
+                    acc ^= gf().mul(a[row * k + i], b[col + i * m]);
+                c[row * m + col] = acc;
+            }
+    }
+
+    /**
+     * Inverts Vandermonde matrix in place, exactly as OpenFEC does it.
+     * Matrix rows are powers of points p_i, which are taken from the
+     * second column.
+     */
+    void invertVandermonde(uint8_t *src, unsigned int k)
+    {
+        if (k == 1)
+            return;
+
+        std::vector<uint8_t> c(k, 0), b(k, 0), p(k, 0);
+
+        for (unsigned int i = 0, j = 1; i < k; ++i, j += k)
+            p[i] = src[j];
+
+        // coefficients of P(x) = Prod(x - p_i), c[k] = 1 is implicit
+        c[k - 1] = p[0];
+        for (unsigned int i = 1; i < k; ++i)
+        {
+            uint8_t p_i = p[i];
+            for (unsigned int j = k - 1 - (i - 1); j < k - 1; ++j)
+                c[j] ^= gf().mul(p_i, c[j + 1]);
+            c[k - 1] ^= p_i;
+        }
+
+        for (unsigned int row = 0; row < k; ++row)
+        {
+            // synthetic division
+            uint8_t xx = p[row], t = 1;
+            b[k - 1] = 1;
+            for (int i = k - 2; i >= 0; --i)
+            {
+                b[i] = c[i + 1] ^ gf().mul(xx, b[i + 1]);
+                t = gf().mul(xx, t) ^ b[i];
+            }
+            for (unsigned int col = 0; col < k; ++col)
+                src[col * k + row] = gf().mul(gf().inverse(t), b[col]);
+        }
+    }
+
+    /**
+     * Inverts k x k matrix in place using Gauss-Jordan elimination.
+     * Returns false if matrix is singular.
+     */
+    bool invertMatrix(uint8_t *m, unsigned int k)
+    {
+        std::vector<uint8_t> inv(k * k, 0);
+        for (unsigned int i = 0; i < k; ++i)
+            inv[i * k + i] = 1;
+
+        for (unsigned int col = 0; col < k; ++col)
+        {
+            unsigned int pivot = col;
+            while (pivot < k && m[pivot * k + col] == 0)
+                ++pivot;
+            if (pivot == k)
+                return false;
+
+            if (pivot != col)
+                for (unsigned int i = 0; i < k; ++i)
+                {
+                    std::swap(m[pivot * k + i], m[col * k + i]);
+                    std::swap(inv[pivot * k + i], inv[col * k + i]);
+                }
+
+            uint8_t pivotInverse = gf().inverse(m[col * k + col]);
+            for (unsigned int i = 0; i < k; ++i)
+            {
+                m[col * k + i] = gf().mul(m[col * k + i], pivotInverse);
+                inv[col * k + i] = gf().mul(inv[col * k + i], pivotInverse);
+            }
+
+            for (unsigned int row = 0; row < k; ++row)
+            {
+                uint8_t factor = m[row * k + col];
+                if (row == col || factor == 0)
+                    continue;
+
+                for (unsigned int i = 0; i < k; ++i)
+                {
+                    m[row * k + i] ^= gf().mul(factor, m[col * k + i]);
+                    inv[row * k + i] ^= gf().mul(factor, inv[col * k + i]);
+                }
+            }
+        }
+
+        memcpy(m, inv.data(), k * k);
+        return true;
+    }
+
+    void mulRegion(uint8_t *dst, const uint8_t *src, uint8_t c, size_t length)
+    {
+        if (c == 1)
+            memcpy(dst, src, length);
+        else
+        {
+            memset(dst, 0, length);
+            if (c)
+                mulAddRegion(dst, src, c, length);
+        }
+    }
+}
+
+namespace fec
+{
+namespace rs28
+{
+    SimdLevel detectSimdLevel()
+    {
+#ifdef RS28_X86
+        __builtin_cpu_init();
+        if (__builtin_cpu_supports("avx2"))
+            return SimdLevel::Avx2;
+        if (__builtin_cpu_supports("ssse3"))
+            return SimdLevel::Ssse3;
+#endif
+        return SimdLevel::None;
+    }
+
+    SimdLevel getSimdLevel()
+    {
+        return currentSimdLevel();
+    }
+
+    void setSimdLevel(SimdLevel level)
+    {
+        if ((int)level > (int)detectSimdLevel())
+            level = detectSimdLevel();
+        currentSimdLevel() = level;
+    }
+
+    const char *toString(SimdLevel level)
+    {
+        switch (level)
+        {
+        case SimdLevel::Avx2:
+            return "avx2";
+        case SimdLevel::Ssse3:
+            return "ssse3";
+        default:
+            return "none";
+        }
+    }
+
+    void mulAddRegion(uint8_t *dst, const uint8_t *src, uint8_t c, size_t length)
+    {
+        if (c == 0)
+            return;
+
+        if (c == 1)
+        {
+            for (size_t i = 0; i < length; ++i)
+                dst[i] ^= src[i];
+            return;
+        }
+
+        switch (getSimdLevel())
+        {
+#ifdef RS28_X86
+        case SimdLevel::Avx2:
+            mulAddRegionAvx2(dst, src, c, length);
+            break;
+        case SimdLevel::Ssse3:
+            mulAddRegionSsse3(dst, src, c, length);
+            break;
+#endif
+        default:
+            mulAddRegionScalar(dst, src, c, length);
+            break;
+        }
+    }
+
+    //******************************************************************************
+    Code::Code(unsigned int nSourceSymbols, unsigned int nRepairSymbols)
+        : k_(nSourceSymbols), n_(nSourceSymbols + nRepairSymbols),
+          encodingMatrix_(n_ * k_, 0)
+    {
+        if (!isSupported(nSourceSymbols, nRepairSymbols))
+            throw std::runtime_error("Unsupported Reed-Solomon code parameters");
+
+        // same construction as in OpenFEC: fill n x k matrix with powers
+        // of field elements (first row is special), invert top k x k part
+        // and multiply bottom rows by the inverse
+        std::vector<uint8_t> tmp(n_ * k_, 0);
+        tmp[0] = 1;
+        for (unsigned int row = 0; row < n_ - 1; ++row)
+            for (unsigned int col = 0; col < k_; ++col)
+                tmp[(row + 1) * k_ + col] = gf().exp(row * col);
+
+        invertVandermonde(tmp.data(), k_);
+        matmul(tmp.data() + k_ * k_, tmp.data(), encodingMatrix_.data() + k_ * k_, n_ - k_, k_, k_);
+
+        for (unsigned int i = 0; i < k_; ++i)
+            encodingMatrix_[i * k_ + i] = 1;
+    }
+
+    boost::shared_ptr<const Code>
+    Code::get(unsigned int nSourceSymbols, unsigned int nRepairSymbols)
+    {
+        static const size_t MaxCachedCodes = 512;
+        static boost::mutex mutex;
+        static std::map<std::pair<unsigned int, unsigned int>, boost::shared_ptr<const Code>> codes;
+
+        if (!isSupported(nSourceSymbols, nRepairSymbols))
+            return boost::shared_ptr<const Code>();
+
+        std::pair<unsigned int, unsigned int> key(nSourceSymbols, nRepairSymbols);
+        {
+            boost::lock_guard<boost::mutex> scopedLock(mutex);
+            auto it = codes.find(key);
+            if (it != codes.end())
+                return it->second;
+        }
+
+        // building code may take a while, so do it outside of the lock
+        boost::shared_ptr<const Code> code = boost::make_shared<const Code>(nSourceSymbols, nRepairSymbols);
+        {
+            boost::lock_guard<boost::mutex> scopedLock(mutex);
+            if (codes.size() >= MaxCachedCodes)
+                codes.clear();
+            codes[key] = code;
+        }
+
+        return code;
+    }
+
+    bool
+    Code::isSupported(unsigned int nSourceSymbols, unsigned int nRepairSymbols)
+    {
+        return nSourceSymbols > 0 && nSourceSymbols + nRepairSymbols <= MaxSymbols;
+    }
+
+    void
+    Code::encode(const uint8_t *data, uint8_t *parityData, size_t symbolLength) const
+    {
+        for (unsigned int r = k_; r < n_; ++r)
+        {
+            const uint8_t *coefficients = &encodingMatrix_[r * k_];
+            uint8_t *repairSymbol = parityData + (r - k_) * symbolLength;
+
+            mulRegion(repairSymbol, data, coefficients[0], symbolLength);
+            for (unsigned int i = 1; i < k_; ++i)
+                mulAddRegion(repairSymbol, data + i * symbolLength, coefficients[i], symbolLength);
+        }
+    }
+
+    bool
+    Code::decode(uint8_t *data, const uint8_t *parityData, size_t symbolLength,
+                 const std::vector<bool> &received) const
+    {
+        std::vector<unsigned int> missing, available;
+
+        for (unsigned int i = 0; i < n_ && available.size() < k_; ++i)
+            if (i < received.size() && received[i])
+                available.push_back(i);
+
+        for (unsigned int i = 0; i < k_; ++i)
+            if (i >= received.size() || !received[i])
+                missing.push_back(i);
+
+        if (missing.empty())
+            return true;
+        if (available.size() < k_)
+            return false;
+
+        // rows of encoding matrix for received symbols give a system,
+        // solution of which are the source symbols
+        std::vector<uint8_t> decodingMatrix(k_ * k_);
+        for (unsigned int i = 0; i < k_; ++i)
+            memcpy(&decodingMatrix[i * k_], &encodingMatrix_[available[i] * k_], k_);
+
+        if (!invertMatrix(decodingMatrix.data(), k_))
+            return false;
+
+        std::vector<uint8_t> recovered(missing.size() * symbolLength);
+        for (unsigned int m = 0; m < missing.size(); ++m)
+        {
+            const uint8_t *coefficients = &decodingMatrix[missing[m] * k_];
+            uint8_t *symbol = recovered.data() + m * symbolLength;
+
+            memset(symbol, 0, symbolLength);
+            for (unsigned int i = 0; i < k_; ++i)
+            {
+                const uint8_t *src = (available[i] < k_ ? data + available[i] * symbolLength
+                                                        : parityData + (available[i] - k_) * symbolLength);
+                mulAddRegion(symbol, src, coefficients[i], symbolLength);
+            }
+        }
+
+        for (unsigned int m = 0; m < missing.size(); ++m)
+            memcpy(data + missing[m] * symbolLength, recovered.data() + m * symbolLength, symbolLength);
+
+        return true;
+    }
+}
+}
@@ -0,0 +1,116 @@
+//
+//  fec-rs28.hpp
+//  ndnrtc
+//
+//  Copyright 2013-2018 Regents of the University of California
+//  For licensing details see the LICENSE file.
+//
+
+#ifndef __ndnrtc__fec_rs28__
+#define __ndnrtc__fec_rs28__
+
+#include <stdint.h>
+#include <vector>
+#include <boost/shared_ptr.hpp>
+
+namespace fec
+{
+namespace rs28
+{
+    /**
+     * SIMD instruction sets that native Reed-Solomon coder can use for
+     * GF(2^8) region multiplications.
+     */
+    enum class SimdLevel
+    {
+        None = 0,
+        Ssse3 = 1,
+        Avx2 = 2
+    };
+
+    /**
+     * Detects best SIMD instruction set supported by the CPU at runtime.
+     */
+    SimdLevel detectSimdLevel();
+
+    /**
+     * Returns SIMD instruction set currently used by the coder. By default,
+     * it's the one returned by detectSimdLevel().
+     */
+    SimdLevel getSimdLevel();
+
+    /**
+     * Overrides SIMD instruction set used by the coder. Level can't be
+     * higher than the one returned by detectSimdLevel(). Used for testing
+     * and benchmarking.
+     */
+    void setSimdLevel(SimdLevel level);
+
+    const char *toString(SimdLevel level);
+
+    /**
+     * Adds product of region src and constant c to region dst:
+     *      dst[i] ^= c * src[i], i = 0..length-1
+     */
+    void mulAddRegion(uint8_t *dst, const uint8_t *src, uint8_t c, size_t length);
+
+    /**
+     * Systematic Reed-Solomon code over GF(2^8) for given number of source
+     * and repair symbols. Encoding matrix is built the same way as OpenFEC's
+     * OF_CODEC_REED_SOLOMON_GF_2_8_STABLE codec does it (Vandermonde matrix
+     * from L.Rizzo's FEC code), so generated repair symbols are bit-exact
+     * with OpenFEC's.
+     * Code objects are immutable and can be shared between threads.
+     */
+    class Code
+    {
+    public:
+        // GF(2^8) limits total number of symbols
+        static const unsigned int MaxSymbols = 255;
+
+        Code(unsigned int nSourceSymbols, unsigned int nRepairSymbols);
+
+        /**
+         * Returns code for given parameters from the cache of codes, creating
+         * new code if needed. Returns nullptr if parameters are not supported.
+         */
+        static boost::shared_ptr<const Code>
+        get(unsigned int nSourceSymbols, unsigned int nRepairSymbols);
+
+        static bool
+        isSupported(unsigned int nSourceSymbols, unsigned int nRepairSymbols);
+
+        /**
+         * Builds repair symbols from source symbols.
+         * @param data Source symbols, nSourceSymbols*symbolLength bytes
+         * @param parityData Buffer for repair symbols,
+         *          nRepairSymbols*symbolLength bytes
+         */
+        void
+        encode(const uint8_t *data, uint8_t *parityData, size_t symbolLength) const;
+
+        /**
+         * Recovers missing source symbols in place.
+         * @param data Source symbols, nSourceSymbols*symbolLength bytes
+         * @param parityData Repair symbols, nRepairSymbols*symbolLength bytes
+         * @param received Flags for each of nSourceSymbols+nRepairSymbols
+         *          symbols, whether it was received or not
+         * @return true if all source symbols are available after decoding,
+         *          false if there were not enough symbols received
+         */
+        bool
+        decode(uint8_t *data, const uint8_t *parityData, size_t symbolLength,
+               const std::vector<bool> &received) const;
+
+        unsigned int getSourceSymbolsNum() const { return k_; }
+        unsigned int getRepairSymbolsNum() const { return n_ - k_; }
+
+    private:
+        unsigned int k_, n_;
+        // n_ x k_ matrix, top k_ rows are identity
+        std::vector<uint8_t> encodingMatrix_;
+    };
+}
+}
+
+#endif /* defined(__ndnrtc__fec_rs28__) */
@@ -10,7 +10,9 @@
 
 #include <iostream>
 #include <string.h>
+#include <atomic>
 #include "fec.hpp"
+#include "fec-rs28.hpp"
 
 using namespace fec;
 
@@ -20,6 +22,100 @@ namespace fec
     {
         return 0.5;
     }
+
+    static std::atomic<bool>& nativeRs28Enabled()
+    {
+        static std::atomic<bool> enabled(rs28::detectSimdLevel() != rs28::SimdLevel::None);
+        return enabled;
+    }
+
+    bool isNativeRs28Enabled()
+    {
+        return nativeRs28Enabled();
+    }
+
+    void setNativeRs28Enabled(bool enabled)
+    {
+        nativeRs28Enabled() = enabled;
+    }
+}
+
+//******************************************************************************
+#pragma mark - construction/destruction
+CoderSessionCache::CoderSessionCache(size_t capacity):
+capacity_(capacity)
+{
+}
+
+CoderSessionCache::~CoderSessionCache()
+{
+    clear();
+}
+
+CoderSessionCache*
+CoderSessionCache::getSharedInstance()
+{
+    static CoderSessionCache sessionCache;
+    return &sessionCache;
+}
+
+#pragma mark - public
+of_session_t*
+CoderSessionCache::pop(of_codec_id_t codecId, uint32_t nSourceSymbols,
+                       uint32_t nRepairSymbols, uint32_t symbolLength)
+{
+    boost::lock_guard<boost::mutex> scopedLock(mutex_);
+    
+    for (std::list<Entry>::iterator it = sessions_.begin(); it != sessions_.end(); ++it)
+        if (it->codecId_ == codecId &&
+            it->nSourceSymbols_ == nSourceSymbols &&
+            it->nRepairSymbols_ == nRepairSymbols &&
+            it->symbolLength_ == symbolLength)
+        {
+            of_session_t* session = it->session_;
+            sessions_.erase(it);
+            return session;
+        }
+    
+    return nullptr;
+}
+
+void
+CoderSessionCache::push(of_codec_id_t codecId, uint32_t nSourceSymbols,
+                        uint32_t nRepairSymbols, uint32_t symbolLength,
+                        of_session_t* session)
+{
+    of_session_t* evicted = nullptr;
+    {
+        boost::lock_guard<boost::mutex> scopedLock(mutex_);
+        
+        sessions_.push_front({codecId, nSourceSymbols, nRepairSymbols, symbolLength, session});
+        if (sessions_.size() > capacity_)
+        {
+            evicted = sessions_.back().session_;
+            sessions_.pop_back();
+        }
+    }
+    
+    if (evicted)
+        of_release_codec_instance(evicted);
+}
+
+size_t
+CoderSessionCache::size()
+{
+    boost::lock_guard<boost::mutex> scopedLock(mutex_);
+    return sessions_.size();
+}
+
+void
+CoderSessionCache::clear()
+{
+    boost::lock_guard<boost::mutex> scopedLock(mutex_);
+    
+    for (auto& e:sessions_)
+        of_release_codec_instance(e.session_);
+    sessions_.clear();
 }
 
 //******************************************************************************
@@ -31,24 +127,41 @@ Rs28Coder(nSourceSymbols, nRepairSymbols, symbolLength)
 {
 }
 
+Rs28Encoder::~Rs28Encoder()
+{
+    // base class destructor can't dispatch to our releaseCoder()
+    releaseCoder();
+}
+
 int
 Rs28Encoder::encode(unsigned char* data, unsigned char* parityData)
 {
-    initCoder();
+    if (isNativeRs28Enabled())
+    {
+        boost::shared_ptr<const rs28::Code> code = rs28::Code::get(nSourceSymbols_, nRepairSymbols_);
+        
+        if (code)
+        {
+            code->encode(data, parityData, symbolLength_);
+            return 0;
+        }
+    }
+    
+    if (!Rs28Coder<OF_ENCODER>::isCoderReady_)
+        initCoder();
     
     if (!Rs28Coder<OF_ENCODER>::isCoderReady_)
         return -1;
     
     int ret = 0;
     unsigned char** encodingSymbolTable = buildSymbolTable(data, parityData);
-    of_parameters_t* params = Rs28Coder<OF_ENCODER>::coderParameters_;
     of_session_t* session = Rs28Coder<OF_ENCODER>::coderSession_;
     
-    for (UINT32 esi = params->nb_source_symbols;
-         esi < params->nb_source_symbols + params->nb_repair_symbols && ret >= 0;
+    for (UINT32 esi = nSourceSymbols_;
+         esi < nSourceSymbols_ + nRepairSymbols_ && ret >= 0;
          esi++)
     {
-				memset(encodingSymbolTable[esi], 0, params->encoding_symbol_length);
+				memset(encodingSymbolTable[esi], 0, symbolLength_);
         
 				if (of_build_repair_symbol(session, (void**)encodingSymbolTable, esi) != OF_STATUS_OK)
 				{
@@ -61,6 +174,34 @@ Rs28Encoder::encode(unsigned char* data, unsigned char* parityData)
     return ret;
 }
 
+#pragma mark - protected
+void
+Rs28Encoder::initCoder()
+{
+    coderSession_ = CoderSessionCache::getSharedInstance()->pop(OF_CODEC_REED_SOLOMON_GF_2_8_STABLE,
+                                                                nSourceSymbols_, nRepairSymbols_,
+                                                                symbolLength_);
+    if (coderSession_)
+        isCoderCreated_ = isCoderReady_ = true;
+    else
+        Rs28Coder<OF_ENCODER>::initCoder();
+}
+
+void
+Rs28Encoder::releaseCoder()
+{
+    if (isCoderReady_)
+    {
+        CoderSessionCache::getSharedInstance()->push(OF_CODEC_REED_SOLOMON_GF_2_8_STABLE,
+                                                     nSourceSymbols_, nRepairSymbols_,
+                                                     symbolLength_, coderSession_);
+        coderSession_ = nullptr;
+        isCoderCreated_ = false;
+    }
+    
+    Rs28Coder<OF_ENCODER>::releaseCoder();
+}
+
 //******************************************************************************
 #pragma mark - construction/destruction
 Rs28Decoder::Rs28Decoder(unsigned int nSourceSymbols,
@@ -74,6 +215,14 @@ int
 Rs28Decoder::decode(unsigned char* data, unsigned char* parityData,
                     unsigned char* rList)
 {
+    if (isNativeRs28Enabled())
+    {
+        boost::shared_ptr<const rs28::Code> code = rs28::Code::get(nSourceSymbols_, nRepairSymbols_);
+        
+        if (code)
+            return decodeNative(code.get(), data, parityData, rList);
+    }
+    
     initCoder();
     
     if (!Rs28Coder<OF_DECODER>::isCoderReady_)
@@ -117,3 +266,34 @@ Rs28Decoder::decode(unsigned char* data, unsigned char* parityData,
     
     return ret;
 }
+
+#pragma mark - private
+int
+Rs28Decoder::decodeNative(const rs28::Code* code, unsigned char* data,
+                          unsigned char* parityData, unsigned char* rList)
+{
+    std::vector<bool> received(nSourceSymbols_+nRepairSymbols_, false);
+    
+    for (unsigned int i = 0; i < nSourceSymbols_+nRepairSymbols_; i++)
+    {
+        if (rList[i] == FEC_RLIST_SYMREADY)
+            received[i] = true;
+        else
+            rList[i] = FEC_RLIST_INPROCESS;
+    }
+    
+    if (!code->decode(data, parityData, symbolLength_, received))
+        return -1;
+    
+    // as OpenFEC does, missing repair symbols are reported repaired too,
+    // although only source symbols are actually rebuilt
+    int ret = 0;
+    for (unsigned int i = 0; i < nSourceSymbols_+nRepairSymbols_; i++)
+        if (rList[i] == FEC_RLIST_INPROCESS)
+        {
+            rList[i] = FEC_RLIST_SYMREPAIRED;
+            ret++;
+        }
+    
+    return ret;
+}
@@ -12,6 +12,9 @@
 #define __ndnrtc__fec__
 
 #include <cstdlib>
+#include <list>
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/lock_guard.hpp>
 
 #define FEC_RLIST_SYMREADY '1'
 #define FEC_RLIST_SYMEMPTY '0'
@@ -32,6 +35,10 @@ typedef struct {
 
 namespace fec
 {
+    namespace rs28 {
+        class Code;
+    }
+
     /**
      * This returns a "weight" of parity segment in relation to normal
      * data segment. For example, if weight is 0.5, it means
@@ -41,6 +48,67 @@ namespace fec
      */
     double parityWeight();
 
+    /**
+     * Native Reed-Solomon coder (see fec-rs28.hpp) is used instead of OpenFEC
+     * by Rs28Encoder and Rs28Decoder when enabled. It is enabled by default,
+     * if CPU supports SIMD instructions needed for fast GF(2^8) arithmetic.
+     * Both coders produce identical repair symbols.
+     */
+    bool isNativeRs28Enabled();
+    void setNativeRs28Enabled(bool enabled);
+
+    /**
+     * Thread-safe cache of initialized OpenFEC coder sessions. Sessions are
+     * keyed by codec, number of source and repair symbols and symbol length.
+     * A session is handed out exclusively (see pop()) and must be returned
+     * back to the cache (see push()) when coder is done with it. Least
+     * recently used sessions are released once cache exceeds its capacity.
+     * Only encoder sessions can be reused - OpenFEC decoder sessions keep 
+     * received symbols and can't be reset.
+     */
+    class CoderSessionCache
+    {
+    public:
+        static CoderSessionCache *getSharedInstance();
+
+        CoderSessionCache(size_t capacity = 64);
+        ~CoderSessionCache();
+
+        /**
+         * Returns cached session for given parameters or nullptr, if there 
+         * is no such session in the cache.
+         */
+        of_session_t*
+        pop(of_codec_id_t codecId, uint32_t nSourceSymbols,
+            uint32_t nRepairSymbols, uint32_t symbolLength);
+
+        /**
+         * Returns session back to the cache.
+         */
+        void
+        push(of_codec_id_t codecId, uint32_t nSourceSymbols,
+             uint32_t nRepairSymbols, uint32_t symbolLength,
+             of_session_t* session);
+
+        size_t size();
+        size_t capacity() const { return capacity_; }
+        void clear();
+
+    private:
+        typedef struct _Entry {
+            of_codec_id_t codecId_;
+            uint32_t nSourceSymbols_, nRepairSymbols_, symbolLength_;
+            of_session_t* session_;
+        } Entry;
+
+        CoderSessionCache(const CoderSessionCache&) = delete;
+
+        size_t capacity_;
+        boost::mutex mutex_;
+        // most recently used sessions go first
+        std::list<Entry> sessions_;
+    };
+
     /**
      * This is the base class for Encoder/Decoder derived classes
      */
@@ -57,6 +125,7 @@ namespace fec
         coderSession_(nullptr),
         coderParameters_(nullptr),
         isCoderCreated_(false),
+        isCoderReady_(false),
         coderId_(CoderID),
         coderType_(CoderType)
         {
@@ -106,8 +175,9 @@ namespace fec
                 isCoderCreated_ = !(of_release_codec_instance(coderSession_) == OF_STATUS_OK);
             }
             
-            if (isCoderReady_)
-                free(coderParameters_);
+            free(coderParameters_);
+            coderParameters_ = nullptr;
+            isCoderReady_ = false;
         }
         
         unsigned char**
@@ -168,11 +238,15 @@ namespace fec
                     unsigned int nRepairSymbols,
                     unsigned int symbolLength);
         
+        ~Rs28Encoder();
+
         int
         encode(unsigned char* data, unsigned char* parityData);
         
-    private:
-        
+    protected:
+        // encoder sessions are taken from (and returned to) the shared cache
+        void initCoder();
+        void releaseCoder();
     };
     
     class Rs28Decoder : public Rs28Coder<OF_DECODER>
@@ -187,6 +261,9 @@ namespace fec
                unsigned char* rList);
         
     private:
+        int
+        decodeNative(const rs28::Code* code, unsigned char* data,
+                     unsigned char* parityData, unsigned char* rList);
     };
     
 }
@@ -41,6 +41,17 @@ isVerified_(false)
     }
 }
 
+SlotSegment::SlotSegment(const boost::shared_ptr<const ndn::Interest>& i,
+                         const NamespaceInfo& info):
+interest_(i),
+interestInfo_(info),
+requestTimeUsec_(clock::microsecondTimestamp()),
+arrivalTimeUsec_(0),
+requestNo_(1),
+isVerified_(false)
+{
+}
+
 const NamespaceInfo&
 SlotSegment::getInfo() const
 {
@@ -111,34 +122,47 @@ BufferSlot::BufferSlot(){ clear(); }
 
 void
 BufferSlot::segmentsRequested(const std::vector<boost::shared_ptr<const ndn::Interest>>& interests)
+{
+    std::vector<boost::shared_ptr<SlotSegment>> segments;
+
+    for (auto i:interests)
+        segments.push_back(boost::make_shared<SlotSegment>(i));
+    segmentsRequested(segments);
+}
+
+void
+BufferSlot::segmentsRequested(const std::vector<boost::shared_ptr<SlotSegment>>& segments)
 {
     if (state_ == Ready || state_ == Locked) 
         throw std::runtime_error("Can't add more segments because slot is ready or locked");
 
-    for (auto i:interests)
+    for (auto segment:segments)
     {
-        boost::shared_ptr<SlotSegment> segment(boost::make_shared<SlotSegment>(i));
-        
-        if (!segment->getInfo().hasSeqNo_ || !segment->getInfo().hasSegNo_)
+        const NamespaceInfo& info = segment->getInfo();
+
+        if (!info.hasSeqNo_ || !info.hasSegNo_)
             throw std::runtime_error("No rightmost interests allowed: Interest should have segment-level info");
         
         if (name_.size() == 0) 
         {
-            nameInfo_ = segment->getInfo();
+            nameInfo_ = info;
             name_ = nameInfo_.getPrefix(prefix_filter::Sample);
             requestTimeUsec_ = segment->getRequestTimeUsec();
         }
-        else if (!name_.match(i->getName()))
+        else if (info.sampleNo_ != nameInfo_.sampleNo_ || info.class_ != nameInfo_.class_ ||
+                 info.threadName_ != nameInfo_.threadName_)
             throw std::runtime_error("Interest names should differ only after sample sequence number");
 
-        Name segmentKey = segment->getInfo().getSuffix(suffix_filter::Segment);
+        SegmentArray& requested = requested_[segmentIdx(info)];
+        if (requested.size() <= info.segNo_)
+            requested.resize(info.segNo_+1);
         
-        if (requested_.find(segmentKey) != requested_.end())
+        if (requested[info.segNo_])
         {
             nRtx_++;
-            requested_[segmentKey]->incrementRequestNum();
+            requested[info.segNo_]->incrementRequestNum();
         }
-        else requested_[segmentKey] = segment;
+        else requested[info.segNo_] = segment;
 
         if (state_ == Free) state_ = New;
     }
@@ -149,8 +173,12 @@ BufferSlot::clear()
 {
     name_.clear();
     nameInfo_ = NamespaceInfo();
-    requested_.clear();
-    fetched_.clear();
+    for (int i = 0; i < 2; ++i)
+    {
+        requested_[i].clear();
+        fetched_[i].clear();
+        nFetched_[i] = 0;
+    }
     consistency_ = Inconsistent;
     requestTimeUsec_ = 0;
     assembledSize_ = 0;
@@ -177,23 +205,30 @@ BufferSlot::segmentReceived(const boost::shared_ptr<WireSegment>& segment)
     if (state_ == Locked)
         return boost::shared_ptr<SlotSegment>();
     
-    if (!name_.match(segment->getData()->getName()))
-        throw std::runtime_error("Attempt to add data segment with incorrect name");
+    const NamespaceInfo& info = segment->getInfo();
 
-    Name segmentKey = segment->getInfo().getSuffix(suffix_filter::Segment);
+    if (info.sampleNo_ != nameInfo_.sampleNo_ || info.class_ != nameInfo_.class_ ||
+        info.threadName_ != nameInfo_.threadName_)
+        throw std::runtime_error("Attempt to add data segment with incorrect name");
 
-    if (!segment->getInfo().hasSeqNo_ || 
-        requested_.find(segmentKey) == requested_.end())
+    int idx = segmentIdx(info);
+    if (!info.hasSeqNo_ || 
+        requested_[idx].size() <= info.segNo_ || !requested_[idx][info.segNo_])
         throw std::runtime_error("Adding segment that was not previously requested");
     
-    if (fetched_.find(segmentKey) == fetched_.end())
+    SegmentArray& fetched = fetched_[idx];
+    if (fetched.size() <= info.segNo_)
+        fetched.resize(info.segNo_+1);
+
+    if (!fetched[info.segNo_])
     {
-        lastFetched_ = fetched_[segmentKey] = requested_[segmentKey];
-        fetched_[segmentKey]->setData(segment);
-        updateConsistencyState(fetched_[segmentKey]);
+        lastFetched_ = fetched[info.segNo_] = requested_[idx][info.segNo_];
+        nFetched_[idx]++;
+        fetched[info.segNo_]->setData(segment);
+        updateConsistencyState(fetched[info.segNo_]);
     }
 
-    return fetched_[segmentKey];
+    return fetched[info.segNo_];
 }
 
 std::vector<ndn::Name>
@@ -204,17 +239,12 @@ BufferSlot::getMissingSegments() const
     if (getFetchedNum() > 0)
     {
         for (unsigned int segNo = 0; segNo < nDataSegments_; ++segNo)
-        {
-            Name segKey = Name().appendSegment(segNo);
-            if (requested_.find(segKey) == requested_.end())
-                missing.push_back(Name(getPrefix()).append(segKey));
-        }
+            if (requested_[0].size() <= segNo || !requested_[0][segNo])
+                missing.push_back(Name(getPrefix()).appendSegment(segNo));
+
         for (unsigned int segNo = 0; segNo < nParitySegments_; ++segNo)
-        {
-            Name segKey = Name(NameComponents::NameComponentParity).appendSegment(segNo);
-            if (requested_.find(segKey) == requested_.end())
-                missing.push_back(Name(getPrefix()).append(segKey));
-        }
+            if (requested_[1].size() <= segNo || !requested_[1][segNo])
+                missing.push_back(Name(getPrefix()).append(NameComponents::NameComponentParity).appendSegment(segNo));
     }
     
     return missing;
@@ -225,9 +255,11 @@ BufferSlot::getPendingInterests() const
 {
     std::vector<boost::shared_ptr<const ndn::Interest>> pendingInterests;
 
-    for (auto it:requested_)
-        if (fetched_.find(it.first) == fetched_.end())
-            pendingInterests.push_back(it.second->getInterest());
+    for (int i = 0; i < 2; ++i)
+        for (size_t segNo = 0; segNo < requested_[i].size(); ++segNo)
+            if (requested_[i][segNo] && 
+                (fetched_[i].size() <= segNo || !fetched_[i][segNo]))
+                pendingInterests.push_back(requested_[i][segNo]->getInterest());
 
     return pendingInterests;
 }
@@ -237,8 +269,9 @@ BufferSlot::getFetchedSegments() const
 {
     std::vector<boost::shared_ptr<const SlotSegment>> segments;
     
-    for (auto it:fetched_)
-        segments.push_back(it.second);
+    for (int i = 0; i < 2; ++i)
+        for (auto& s:fetched_[i])
+            if (s) segments.push_back(s);
 
     return segments;
 }
@@ -249,14 +282,22 @@ BufferSlot::getRtxNum(const ndn::Name& segmentName)
     NamespaceInfo info;
     if (NameComponents::extractInfo(segmentName, info))
     {
-        Name segmentKey = info.getSuffix(suffix_filter::Segment);
-        if (requested_.find(segmentKey) != requested_.end())
-           return requested_[segmentKey]->getRequestNum()-1;
+        SegmentArray& requested = requested_[segmentIdx(info)];
+        if (requested.size() > info.segNo_ && requested[info.segNo_])
+           return requested[info.segNo_]->getRequestNum()-1;
     }
 
     return -1;
 }
 
+boost::shared_ptr<SlotSegment>
+BufferSlot::firstSegment(const SegmentArray& segments)
+{
+    for (auto& s:segments)
+        if (s) return s;
+    return boost::shared_ptr<SlotSegment>();
+}
+
 std::string
 BufferSlot::dump(bool showLastSegment) const
 {
@@ -268,7 +309,7 @@ BufferSlot::dump(bool showLastSegment) const
     << nameInfo_.sampleNo_
     << (verified_ == Verification::Verified ? "☆" : (verified_ == Verification::Unknown? "?" : "✕")) << ", "
     << toString(getConsistencyState()) << ", "
-    // << std::setw(7) << getPlaybackNumber() << ", "
+    << std::setw(7) << getPlaybackNumber() << ", "
     // << std::setw(10) << getProducerTimestamp() << ", "
     << std::setw(3) << asmLevel_*100 << "% "//"("
     // << ((double)nSegmentsParityReady_/(double)nSegmentsParity_)*100 << "%), "
@@ -297,7 +338,20 @@ BufferSlot::getHeader() const
     if (!consistency_&HeaderMeta)
         throw std::runtime_error("Packet header is not available");
 
-    return fetched_.at(nameInfo_.getSuffix(suffix_filter::Segment))->getData()->packetHeader();
+    if (fetched_[0].size() == 0 || !fetched_[0][0])
+        throw std::runtime_error("Packet header is not available");
+
+    return fetched_[0][0]->getData()->packetHeader();
+}
+
+PacketNumber
+BufferSlot::getPlaybackNumber() const
+{
+    boost::shared_ptr<SlotSegment> segment = firstSegment(fetched_[0]);
+
+    if (!segment)
+        return -1;
+    return segment->getData()->getPlaybackNo();
 }
 
 void
@@ -338,7 +392,9 @@ void BufferSlot::updateAssembledLevel()
     if (consistency_&SegmentMeta)
     {
         asmLevel_ = 0;
-        for (auto& it:fetched_) asmLevel_ += it.second->getData()->getShareSize(nDataSegments_);
+        for (int i = 0; i < 2; ++i)
+            for (auto& s:fetched_[i])
+                if (s) asmLevel_ += s->getData()->getShareSize(nDataSegments_);
     }
 }
 
@@ -372,40 +428,40 @@ VideoFrameSlot::readPacket(const BufferSlot& slot, bool& recovered)
             "packet from audio slot");
 
     // check if recovery is possible
-    Name parityKey(NameComponents::NameComponentParity);
-    std::map<ndn::Name, boost::shared_ptr<SlotSegment>> 
-        dataSegments(slot.fetched_.begin(), slot.fetched_.lower_bound(parityKey));
-    std::map<ndn::Name, boost::shared_ptr<SlotSegment>> 
-        paritySegments(slot.fetched_.upper_bound(parityKey), slot.fetched_.end());
+    const BufferSlot::SegmentArray& dataSegments = slot.fetched_[0];
+    const BufferSlot::SegmentArray& paritySegments = slot.fetched_[1];
+    size_t nDataFetched = slot.nFetched_[0], nParityFetched = slot.nFetched_[1];
 
-    if ((!paritySegments.size() && 
-        dataSegments.size() < dataSegments.begin()->second->getData()->getSlicesNum()) ||
-        dataSegments.size() == 0)
+    if (nDataFetched == 0 ||
+        (!nParityFetched && 
+         nDataFetched < BufferSlot::firstSegment(dataSegments)->getData()->getSlicesNum()))
     {
         recovered = false;
         return boost::shared_ptr<ImmutableVideoFramePacket>();
     }
 
     boost::shared_ptr<WireData<VideoFrameSegmentHeader>> firstSeg = 
-            boost::dynamic_pointer_cast<WireData<VideoFrameSegmentHeader>>(dataSegments.begin()->second->getData());
+            boost::dynamic_pointer_cast<WireData<VideoFrameSegmentHeader>>(BufferSlot::firstSegment(dataSegments)->getData());
     boost::shared_ptr<WireData<VideoFrameSegmentHeader>> firstParitySeg;
 
-    if (paritySegments.size()) 
-        firstParitySeg = boost::dynamic_pointer_cast<WireData<VideoFrameSegmentHeader>>(paritySegments.begin()->second->getData());
+    if (nParityFetched) 
+        firstParitySeg = boost::dynamic_pointer_cast<WireData<VideoFrameSegmentHeader>>(BufferSlot::firstSegment(paritySegments)->getData());
 
     size_t segmentSize = firstSeg->segment().getPayload().size();
-    size_t paritySegSize = (paritySegments.size() ? firstParitySeg->segment().getPayload().size() : 0);
+    size_t paritySegSize = (nParityFetched ? firstParitySeg->segment().getPayload().size() : 0);
     unsigned int nDataSegmentsExpected = firstSeg->getSlicesNum();
-    unsigned int nParitySegmentsExpected = (paritySegments.size() ? paritySegments.begin()->second->getData()->getSlicesNum() : 0);
+    unsigned int nParitySegmentsExpected = (nParityFetched ? firstParitySeg->getSlicesNum() : 0);
 
     fecList_.assign(nDataSegmentsExpected+nParitySegmentsExpected, FEC_RLIST_SYMEMPTY);
     storage_->resize(segmentSize*(nDataSegmentsExpected+nParitySegmentsExpected));
 
     int segNo = 0;
-    for (auto it:dataSegments)
+    for (auto& s:dataSegments)
     {
+        if (!s) continue;
+
         const boost::shared_ptr<WireData<VideoFrameSegmentHeader>> wd = 
-            boost::dynamic_pointer_cast<WireData<VideoFrameSegmentHeader>>(it.second->getData());
+            boost::dynamic_pointer_cast<WireData<VideoFrameSegmentHeader>>(s->getData());
         
         while (segNo != wd->getSegNo() && segNo < nDataSegmentsExpected)
             storage_->insert(storage_->begin()+segmentSize*segNo++, segmentSize, 0);
@@ -421,13 +477,15 @@ VideoFrameSlot::readPacket(const BufferSlot& slot, bool& recovered)
     }
 
     bool frameExtracted = false;
-    if (dataSegments.size() < nDataSegmentsExpected)
+    if (nDataFetched < nDataSegmentsExpected)
     {
         segNo = 0;
-        for (auto it:paritySegments)
+        for (auto& s:paritySegments)
         {
+            if (!s) continue;
+
             const boost::shared_ptr<WireData<VideoFrameSegmentHeader>> wd =
-            boost::dynamic_pointer_cast<WireData<VideoFrameSegmentHeader>>(it.second->getData());
+            boost::dynamic_pointer_cast<WireData<VideoFrameSegmentHeader>>(s->getData());
 
             while (segNo != wd->getSegNo() && segNo < nParitySegmentsExpected)
                 storage_->insert(storage_->begin()+nDataSegmentsExpected*segmentSize + paritySegSize*segNo++, segmentSize, 0);
@@ -447,7 +505,7 @@ VideoFrameSlot::readPacket(const BufferSlot& slot, bool& recovered)
         int nRecovered = dec.decode(storage_->data(),
             storage_->data()+nDataSegmentsExpected*segmentSize,
             fecList_.data());
-        recovered = (nRecovered+dataSegments.size() >= nDataSegmentsExpected);
+        recovered = (nRecovered+nDataFetched >= nDataSegmentsExpected);
         frameExtracted = recovered;
     }
     else 
@@ -467,14 +525,11 @@ VideoFrameSlot::readSegmentHeader(const BufferSlot& slot)
         throw std::runtime_error("Wrong slot supplied: can not read video "
             "packet from audio slot");
 
-    std::map<ndn::Name, boost::shared_ptr<SlotSegment>> 
-        dataSegments(slot.fetched_.begin(), slot.fetched_.lower_bound(Name(NameComponents::NameComponentParity)));
-
-    if (!dataSegments.size())
+    if (!slot.nFetched_[0])
         return VideoFrameSegmentHeader();
 
     boost::shared_ptr<WireData<VideoFrameSegmentHeader>> seg = 
-            boost::dynamic_pointer_cast<WireData<VideoFrameSegmentHeader>>(dataSegments.begin()->second->getData());
+            boost::dynamic_pointer_cast<WireData<VideoFrameSegmentHeader>>(BufferSlot::firstSegment(slot.fetched_[0])->getData());
 
     return seg->segment().getHeader();
 }
@@ -498,16 +553,18 @@ AudioBundleSlot::readBundle(const BufferSlot& slot)
         return boost::shared_ptr<ImmutableAudioBundlePacket>();
 
     boost::shared_ptr<WireData<DataSegmentHeader>> firstSeg = 
-            boost::dynamic_pointer_cast<WireData<DataSegmentHeader>>(slot.fetched_.begin()->second->getData());
+            boost::dynamic_pointer_cast<WireData<DataSegmentHeader>>(BufferSlot::firstSegment(slot.fetched_[0])->getData());
     size_t segmentSize = firstSeg->segment().getPayload().size();
     unsigned int nDataSegmentsExpected = firstSeg->getSlicesNum();
 
     storage_->resize(segmentSize*nDataSegmentsExpected);
 
-    for (auto it:slot.fetched_)
+    for (auto& s:slot.fetched_[0])
     {
+        if (!s) continue;
+
         const boost::shared_ptr<WireData<DataSegmentHeader>> wd = 
-            boost::dynamic_pointer_cast<WireData<DataSegmentHeader>>(it.second->getData());
+            boost::dynamic_pointer_cast<WireData<DataSegmentHeader>>(s->getData());
         storage_->insert(storage_->begin(), 
                 wd->segment().getPayload().begin(),
                 wd->segment().getPayload().end());
@@ -549,9 +606,100 @@ SlotPool::push(const boost::shared_ptr<BufferSlot>& slot)
     return false;
 }
 
+//******************************************************************************
+SlotTable::SlotTable(size_t capacity):
+size_(0)
+{
+    size_t n = 1;
+    while (n < capacity) n <<= 1;
+    entries_.resize(n);
+    mask_ = n - 1;
+}
+
+boost::shared_ptr<BufferSlot>
+SlotTable::find(Key key) const
+{
+    size_t i = lookup(key);
+    return entries_[i].slot_;
+}
+
+void
+SlotTable::insert(Key key, const boost::shared_ptr<BufferSlot>& slot)
+{
+    assert(slot.get());
+    if (2*(size_+1) > entries_.size())
+        grow();
+
+    size_t i = lookup(key);
+    if (!entries_[i].slot_)
+        size_++;
+    entries_[i].key_ = key;
+    entries_[i].slot_ = slot;
+}
+
+boost::shared_ptr<BufferSlot>
+SlotTable::erase(Key key)
+{
+    size_t i = lookup(key);
+    boost::shared_ptr<BufferSlot> slot = entries_[i].slot_;
+
+    if (!slot)
+        return slot;
+
+    size_--;
+    // shift entries of the same probe sequence back to the freed entry
+    for (size_t j = i;;)
+    {
+        entries_[i].slot_.reset();
+        j = (j+1) & mask_;
+        if (!entries_[j].slot_)
+            break;
+
+        size_t h = home(entries_[j].key_);
+        // entry stays if its' home lies cyclically in (i, j]
+        if ((i <= j) ? (i < h && h <= j) : (i < h || h <= j))
+            continue;
+
+        entries_[i] = entries_[j];
+        i = j;
+    }
+
+    return slot;
+}
+
+void
+SlotTable::clear()
+{
+    for (auto& e:entries_) e.slot_.reset();
+    size_ = 0;
+}
+
+size_t
+SlotTable::lookup(Key key) const
+{
+    // table is never full, thus there's always a free entry to stop at
+    size_t i = home(key);
+    while (entries_[i].slot_ && entries_[i].key_ != key)
+        i = (i+1) & mask_;
+    return i;
+}
+
+void
+SlotTable::grow()
+{
+    std::vector<Entry> entries(entries_.size()*2);
+    entries.swap(entries_);
+    mask_ = entries_.size() - 1;
+    size_ = 0;
+
+    for (auto& e:entries)
+        if (e.slot_) insert(e.key_, e.slot_);
+}
+
 //******************************************************************************
 Buffer::Buffer(boost::shared_ptr<StatisticsStorage> storage,
                boost::shared_ptr<SlotPool> pool):pool_(pool),
+nPending_(0),
 sstorage_(storage)
 {
     assert(sstorage_.get());
@@ -563,9 +711,11 @@ Buffer::reset()
 {   
     boost::lock_guard<boost::recursive_mutex> scopedLock(mutex_);
     
-    for (auto s:activeSlots_)
-        pool_->push(s.second);
+    activeSlots_.forEach([this](SlotTable::Key, const boost::shared_ptr<BufferSlot>& slot){
+        pool_->push(slot);
+    });
     activeSlots_.clear();
+    nPending_ = 0;
  
      LogDebugC << "slot pool capacity " << pool_->capacity()
         << " pool size " << pool_->size() << " "
@@ -577,7 +727,8 @@ Buffer::reset()
 bool
 Buffer::requested(const std::vector<boost::shared_ptr<const ndn::Interest>>& interests)
 {
-    std::map<Name, std::vector<boost::shared_ptr<const Interest>>> slotInterests;
+    // interests are usually issued for one or few samples at a time
+    std::vector<std::pair<SlotTable::Key, std::vector<boost::shared_ptr<SlotSegment>>>> slotSegments;
     for (auto i:interests)
     {
         NamespaceInfo nameInfo;
@@ -589,14 +740,28 @@ Buffer::requested(const std::vector<boost::shared_ptr<const ndn::Interest>>& int
             throw std::runtime_error(ss.str());
         }
 
-        slotInterests[nameInfo.getPrefix(prefix_filter::Sample)].push_back(i);
+        SlotTable::Key key;
+        {
+            boost::lock_guard<boost::recursive_mutex> scopedLock(mutex_);
+            key = addKey(nameInfo);
+        }
+        auto it = std::find_if(slotSegments.begin(), slotSegments.end(),
+            [&key](const std::pair<SlotTable::Key, std::vector<boost::shared_ptr<SlotSegment>>>& p){
+                return p.first == key;
+            });
+        if (it == slotSegments.end())
+            it = slotSegments.insert(slotSegments.end(), 
+                std::make_pair(key, std::vector<boost::shared_ptr<SlotSegment>>()));
+        it->second.push_back(boost::make_shared<SlotSegment>(i, nameInfo));
     }
 
-    for (auto it:slotInterests)
+    for (auto& it:slotSegments)
     {
         bool newRequest = false;
         boost::lock_guard<boost::recursive_mutex> scopedLock(mutex_);
-        if (activeSlots_.find(it.first) == activeSlots_.end())
+        boost::shared_ptr<BufferSlot> slot = activeSlots_.find(it.first);
+
+        if (!slot)
         {
             if (pool_->size() == 0)
             {
@@ -605,17 +770,29 @@ Buffer::requested(const std::vector<boost::shared_ptr<const ndn::Interest>>& int
             }
             else
             {
-                activeSlots_[it.first] = pool_->pop();
+                slot = pool_->pop();
+                activeSlots_.insert(it.first, slot);
                 newRequest = true;
             }
         }
         
-        activeSlots_[it.first]->segmentsRequested(it.second);
+        BufferSlot::State oldState = slot->getState();
+        try
+        {
+            slot->segmentsRequested(it.second);
+        }
+        catch (std::exception &e)
+        {
+            // slot may have changed its state before throwing
+            slotStateChanged(oldState, slot->getState());
+            throw;
+        }
+        slotStateChanged(oldState, slot->getState());
         
         if (newRequest) 
-            for (auto o:observers_) o->onNewRequest(activeSlots_[it.first]);
+            for (auto o:observers_) o->onNewRequest(slot);
 
-        LogTraceC << "▷▷▷" << activeSlots_[it.first]->dump()
+        LogTraceC << "▷▷▷" << slot->dump()
         << " x" << it.second.size() << std::endl;
         //LogDebugC << shortdump() << std::endl;
         LogTraceC << dump() << std::endl;
@@ -630,20 +807,25 @@ Buffer::received(const boost::shared_ptr<WireSegment>& segment)
     boost::lock_guard<boost::recursive_mutex> scopedLock(mutex_);
     
     BufferReceipt receipt;
-    Name key = segment->getInfo().getPrefix(prefix_filter::Sample);
-    
-    if (activeSlots_.find(key) == activeSlots_.end())
+    SlotTable::Key key;
+    boost::shared_ptr<BufferSlot> slot;
+
+    if (findKey(segment->getInfo(), key))
+        slot = activeSlots_.find(key);
+
+    if (!slot)
     {
         stringstream ss;
         ss << "Received data that was not previously requested: "
-        << key;
+        << segment->getInfo().getPrefix(prefix_filter::Sample);
         throw std::runtime_error(ss.str());
     }
     
-    BufferSlot::State oldState = activeSlots_[key]->getState();
-    receipt.segment_ = activeSlots_[key]->segmentReceived(segment);
-    receipt.slot_ = activeSlots_[key];
+    BufferSlot::State oldState = slot->getState();
+    receipt.segment_ = slot->segmentReceived(segment);
+    receipt.slot_ = slot;
     receipt.oldState_ = oldState;
+    slotStateChanged(oldState, receipt.slot_->getState());
     
     if (receipt.slot_->getState() == BufferSlot::Ready)
     {
@@ -684,9 +866,8 @@ bool
 Buffer::isRequested(const boost::shared_ptr<WireSegment>& segment) const
 {
     boost::lock_guard<boost::recursive_mutex> scopedLock(mutex_);
-    Name key = segment->getInfo().getPrefix(prefix_filter::Sample);
-
-    return (activeSlots_.find(key) != activeSlots_.end());
+    SlotTable::Key key;
+    return (findKey(segment->getInfo(), key) && activeSlots_.find(key));
 }
 
 unsigned int 
@@ -695,9 +876,10 @@ Buffer::getSlotsNum(const ndn::Name& prefix, int stateMask) const
     boost::lock_guard<boost::recursive_mutex> scopedLock(mutex_);
     unsigned int nSlots = 0;
 
-    for (auto it:activeSlots_)
-        if (prefix.match(it.first) && it.second->getState()&stateMask)
+    activeSlots_.forEach([&nSlots, &prefix, stateMask](SlotTable::Key, const boost::shared_ptr<BufferSlot>& slot){
+        if (slot->getState()&stateMask && prefix.match(slot->getPrefix()))
             nSlots++;
+    });
 
     return nSlots;
 }
@@ -723,14 +905,66 @@ Buffer::detach(IBufferObserver* observer)
     }
 }
 
+bool
+Buffer::findKey(const NamespaceInfo& info, SlotTable::Key& key) const
+{
+    // there are only few threads per stream
+    for (size_t i = 0; i < threads_.size(); ++i)
+        if (threads_[i] == info.threadName_)
+        {
+            key = SlotTable::makeKey(i, info.class_, info.sampleNo_);
+            return true;
+        }
+
+    return false;
+}
+
+SlotTable::Key
+Buffer::addKey(const NamespaceInfo& info)
+{
+    SlotTable::Key key;
+
+    if (!findKey(info, key))
+    {
+        threads_.push_back(info.threadName_);
+        key = SlotTable::makeKey(threads_.size()-1, info.class_, info.sampleNo_);
+    }
+
+    return key;
+}
+
 void
-Buffer::invalidate(const Name& slotPrefix)
+Buffer::invalidate(SlotTable::Key key)
 {
     boost::lock_guard<boost::recursive_mutex> scopedLock(mutex_);
-    assert(activeSlots_.find(slotPrefix) != activeSlots_.end());
+    boost::shared_ptr<BufferSlot> slot = activeSlots_.erase(key);
 
-    boost::shared_ptr<BufferSlot> slot = activeSlots_.find(slotPrefix)->second;
-    activeSlots_.erase(activeSlots_.find(slotPrefix));
+    assert(slot.get());
+    dropSlot(slot);
+}
+
+void
+Buffer::invalidatePrevious(const boost::shared_ptr<const BufferSlot>& slot)
+{
+    boost::lock_guard<boost::recursive_mutex> scopedLock(mutex_);
+    PacketNumber sampleNo = slot->getNameInfo().sampleNo_;
+
+    // slots are not ordered, but there are only as many of them as samples
+    // in flight
+    std::vector<SlotTable::Key> previous;
+    activeSlots_.forEach([&previous, sampleNo](SlotTable::Key key, const boost::shared_ptr<BufferSlot>& s){
+        if (s->getNameInfo().isDelta_ && s->getNameInfo().sampleNo_ < sampleNo)
+            previous.push_back(key);
+    });
+
+    for (auto key:previous)
+        dropSlot(activeSlots_.erase(key));
+}
+
+void
+Buffer::dropSlot(const boost::shared_ptr<BufferSlot>& slot)
+{
+    LogDebugC << "invalidate " << slot->getPrefix() << std::endl;
     
     (*sstorage_)[Indicator::DroppedNum]++;
     if (slot->getState() <= BufferSlot::Assembling)
@@ -742,36 +976,10 @@ Buffer::invalidate(const Name& slotPrefix)
             (*sstorage_)[Indicator::IncompleteKeyNum]++;
     }
     
+    slotStateChanged(slot->getState(), BufferSlot::Free);
     pool_->push(slot);
 }
 
-void
-Buffer::invalidatePrevious(const Name& slotPrefix)
-{
-    boost::lock_guard<boost::recursive_mutex> scopedLock(mutex_);
-    std::map<ndn::Name, boost::shared_ptr<BufferSlot>>::iterator lower = 
-        activeSlots_.lower_bound(slotPrefix);
-
-    while (activeSlots_.begin() != lower)
-    {
-        LogDebugC << "invalidate " << activeSlots_.begin()->first << std::endl;
-        boost::shared_ptr<BufferSlot> slot = activeSlots_.begin()->second;
-        
-        (*sstorage_)[Indicator::DroppedNum]++;
-        if (slot->getState() <= BufferSlot::Assembling)
-            (*sstorage_)[Indicator::IncompleteNum]++;
-        if (slot->getNameInfo().class_ == SampleClass::Key)
-        {
-            (*sstorage_)[Indicator::DroppedKeyNum]++;
-            if (slot->getState() <= BufferSlot::Assembling)
-                (*sstorage_)[Indicator::IncompleteKeyNum]++;
-        }
-        
-        pool_->push(activeSlots_.begin()->second);
-        activeSlots_.erase(activeSlots_.begin());
-    }
-}
-
 #if 0
 void
 Buffer::invalidateOldKey(const Name& slotPrefix)
@@ -784,14 +992,16 @@ void
 Buffer::reserveSlot(const boost::shared_ptr<const BufferSlot>& slot)
 {
     boost::lock_guard<boost::recursive_mutex> scopedLock(mutex_);
-    std::map<ndn::Name, boost::shared_ptr<BufferSlot>>::iterator it =
-    activeSlots_.find(slot->getPrefix());
+    SlotTable::Key key;
     
-    if (it != activeSlots_.end())
+    if (findKey(slot->getNameInfo(), key))
     {
-        reservedSlots_[slot->getPrefix()] = activeSlots_[slot->getPrefix()];
-        activeSlots_.erase(it);
-        reservedSlots_[slot->getPrefix()]->toggleLock();
+        boost::shared_ptr<BufferSlot> reserved = activeSlots_.erase(key);
+        if (reserved)
+        {
+            reservedSlots_.insert(key, reserved);
+            reserved->toggleLock();
+        }
     }
 }
 
@@ -799,16 +1009,26 @@ void
 Buffer::releaseSlot(const boost::shared_ptr<const BufferSlot>& slot)
 {
     boost::lock_guard<boost::recursive_mutex> scopedLock(mutex_);
-    std::map<ndn::Name, boost::shared_ptr<BufferSlot>>::iterator it =
-    reservedSlots_.find(slot->getPrefix());
+    SlotTable::Key key;
     
-    if (it != reservedSlots_.end())
+    if (findKey(slot->getNameInfo(), key))
     {
-        pool_->push(it->second);
-        reservedSlots_.erase(it);
+        boost::shared_ptr<BufferSlot> reserved = reservedSlots_.erase(key);
+        if (reserved)
+            pool_->push(reserved);
     }
 }
 
+void
+Buffer::slotStateChanged(BufferSlot::State oldState, BufferSlot::State newState)
+{
+    static const int PendingStates = BufferSlot::New|BufferSlot::Assembling;
+    bool wasPending = (oldState & PendingStates), isPending = (newState & PendingStates);
+
+    if (wasPending && !isPending) nPending_--;
+    if (!wasPending && isPending) nPending_++;
+}
+
 std::string
 Buffer::dump() const
 {
@@ -817,8 +1037,9 @@ Buffer::dump() const
     stringstream ss;
     ss << "buffer dump:";
 
-    for (auto& s:activeSlots_)
-        ss << std::endl << ++i << " " << s.second->dump();
+    activeSlots_.forEach([&ss, &i](SlotTable::Key, const boost::shared_ptr<BufferSlot>& slot){
+        ss << std::endl << ++i << " " << slot->dump();
+    });
 
     return ss.str();
 }
@@ -839,37 +1060,47 @@ Buffer::shortdump() const
 }
 
 void
-Buffer::dumpSlotDictionary(stringstream& ss, 
-    const map<ndn::Name, boost::shared_ptr<BufferSlot>> &slotDict) const
+Buffer::dumpSlotDictionary(stringstream& ss, const SlotTable &slotDict) const
 {
+    // slot table is unordered, dump slots in sample order
+    std::vector<boost::shared_ptr<BufferSlot>> slots;
+    slotDict.forEach([&slots](SlotTable::Key, const boost::shared_ptr<BufferSlot>& slot){
+        slots.push_back(slot);
+    });
+    std::sort(slots.begin(), slots.end(),
+        [](const boost::shared_ptr<BufferSlot>& s1, const boost::shared_ptr<BufferSlot>& s2){
+            if (s1->getNameInfo().class_ != s2->getNameInfo().class_)
+                return s1->getNameInfo().class_ > s2->getNameInfo().class_;
+            return s1->getNameInfo().sampleNo_ < s2->getNameInfo().sampleNo_;
+        });
+
     int i = 0;
-    for (auto& s:slotDict)
+    for (auto& s:slots)
     {
-        if ((i++ % 10 == 0) || !s.second->getNameInfo().isDelta_ )
+        if ((i++ % 10 == 0) || !s->getNameInfo().isDelta_ )
         {
-            ss << s.second->getNameInfo().sampleNo_; 
-            ss << (s.second->getNameInfo().isDelta_ ? "" : "K");
+            ss << s->getNameInfo().sampleNo_; 
+            ss << (s->getNameInfo().isDelta_ ? "" : "K");
         }
 
-        ss << (s.second->getAssembledLevel() >= 1 ? "■" :
-            (s.second->getAssembledLevel() > 0 ? "◘" : "☐" ));
+        ss << (s->getAssembledLevel() >= 1 ? "■" :
+            (s->getAssembledLevel() > 0 ? "◘" : "☐" ));
     }
 }
 
 //******************************************************************************
-int64_t
-PlaybackQueue::Sample::timestamp() const
-{ 
-    return slot_->getHeader().publishTimestampMs_; 
-}
-
 PlaybackQueue::PlaybackQueue(const ndn::Name& streamPrefix, 
-    const boost::shared_ptr<Buffer>& buffer):
+    const boost::shared_ptr<Buffer>& buffer, unsigned int ringSize):
 streamPrefix_(streamPrefix),
 buffer_(buffer),
 packetRate_(0),
+ring_(ringSize),
+head_(0), tail_(0),
+nSamples_(0),
+size_(0),
 sstorage_(buffer->sstorage_)
 {
+    assert(ringSize);
     description_ = "pqueue";
     buffer_->attach(this);
 }
@@ -882,50 +1113,52 @@ PlaybackQueue::~PlaybackQueue()
 void
 PlaybackQueue::pop(ExtractSlot extract)
 {
-    if (queue_.size())
-    {
-        boost::shared_ptr<const BufferSlot> slot;
-        
-        { 
-            boost::lock_guard<boost::recursive_mutex> scopedLock(mutex_);
+    boost::shared_ptr<const BufferSlot> slot;
+    double playTime;
 
-            slot = queue_.begin()->slot();
-            queue_.erase(queue_.begin());
-        }
+    { 
+        boost::lock_guard<boost::recursive_mutex> scopedLock(mutex_);
 
-        double playTime = (queue_.size() ? queue_.begin()->timestamp() - slot->getHeader().publishTimestampMs_ : samplePeriod());
-        
-        LogTraceC << "-■-" << slot->dump()  << "~" << (int)playTime << "ms " 
-            << dump() << std::endl;
+        if (!nSamples_)
+            return;
 
-        extract(slot, playTime);
-        (*sstorage_)[Indicator::AcquiredNum]++;
-        
-        if (slot->getNameInfo().isDelta_)
-            buffer_->invalidatePrevious(slot->getPrefix());
-        else
-        {
-            // TODO: invalidate old key frames
-            (*sstorage_)[Indicator::AcquiredKeyNum]++;
-        }
-        
-        buffer_->releaseSlot(slot);
+        Sample& sample = at(head_);
+        int64_t timestamp = sample.timestamp_;
+
+        slot = sample.slot_;
+        sample.slot_.reset();
+        nSamples_--;
+        advanceHead();
+        updateSize();
+
+        playTime = (nSamples_ ? at(head_).timestamp_ - timestamp : samplePeriod());
     }
-}
+    
+    LogTraceC << "-■-" << slot->dump()  << "~" << (int)playTime << "ms " 
+        << dump() << std::endl;
 
-int64_t
-PlaybackQueue::size() const
-{
-    if (!queue_.size()) return 0;
-    if (queue_.size() == 1) return samplePeriod();
-    return (--queue_.end())->timestamp() - queue_.begin()->timestamp() + samplePeriod();
+    extract(slot, playTime);
+    (*sstorage_)[Indicator::AcquiredNum]++;
+    
+    if (slot->getNameInfo().isDelta_)
+        buffer_->invalidatePrevious(slot);
+    else
+    {
+        // TODO: invalidate old key frames
+        (*sstorage_)[Indicator::AcquiredKeyNum]++;
+    }
+    
+    buffer_->releaseSlot(slot);
 }
 
 int64_t
 PlaybackQueue::pendingSize() const
 {
-    return (packetRate_ > 0 ? 1000./packetRate_ * buffer_->getSlotsNum(streamPrefix_, BufferSlot::New|BufferSlot::Assembling) :
-        0.);
+    double packetRate = packetRate_;
+
+    // buffer serves one stream, thus all its pending slots belong to this
+    // queue
+    return (packetRate > 0 ? 1000./packetRate * buffer_->getPendingSlotsNum() : 0.);
 }
 
 void 
@@ -952,26 +1185,102 @@ PlaybackQueue::detach(IPlaybackQueueObserver* observer)
 std::string
 PlaybackQueue::dump()
 {
+    boost::lock_guard<boost::recursive_mutex> scopedLock(mutex_);
     std::stringstream ss;
     ss.precision(2);
     
     ss << "[ ";
     int idx = 0;
-    for (auto s:queue_)
+    for (PacketNumber playbackNo = head_; playbackNo < tail_; ++playbackNo)
     {
-        if ((idx++ % 10 == 0) || //s.slot()->getNameInfo().sampleNo_%10 == 0 ||
-            !s.slot()->getNameInfo().isDelta_)
-            ss  << s.slot()->getNameInfo().sampleNo_;
-        if (s.slot()->getVerificationStatus() == BufferSlot::Verification::Verified)
-            ss << (s.slot()->getNameInfo().isDelta_ ? "D" : "K");
+        boost::shared_ptr<const BufferSlot> slot = at(playbackNo).slot_;
+
+        if (!slot) continue;
+        if ((idx++ % 10 == 0) || //slot->getNameInfo().sampleNo_%10 == 0 ||
+            !slot->getNameInfo().isDelta_)
+            ss  << slot->getNameInfo().sampleNo_;
+        if (slot->getVerificationStatus() == BufferSlot::Verification::Verified)
+            ss << (slot->getNameInfo().isDelta_ ? "D" : "K");
         else
-            ss << (s.slot()->getNameInfo().isDelta_ ? "d" : "k");
+            ss << (slot->getNameInfo().isDelta_ ? "d" : "k");
     }
     ss << "]" << size() << "ms";
     
     return ss.str();
 }
 
+bool
+PlaybackQueue::push(const boost::shared_ptr<const BufferSlot>& slot, int64_t timestamp)
+{
+    PacketNumber playbackNo = slot->getPlaybackNumber();
+    PacketNumber ringSize = (PacketNumber)ring_.size();
+
+    if (playbackNo < 0)
+        return false;
+
+    // make room for newer sample, if it's too far ahead of the queue head
+    if (nSamples_ && playbackNo - head_ >= ringSize)
+        dropHead(playbackNo - ringSize + 1);
+
+    if (!nSamples_)
+        head_ = tail_ = playbackNo;
+    else if (playbackNo < head_)
+    {
+        if (tail_ - playbackNo > ringSize)
+            return false;
+        head_ = playbackNo;
+    }
+
+    Sample& sample = at(playbackNo);
+    if (sample.slot_)
+        return false;
+
+    sample.slot_ = slot;
+    sample.timestamp_ = timestamp;
+    if (playbackNo >= tail_)
+        tail_ = playbackNo+1;
+    nSamples_++;
+
+    return true;
+}
+
+void
+PlaybackQueue::dropHead(PacketNumber newHead)
+{
+    while (nSamples_ && head_ < newHead)
+    {
+        Sample& sample = at(head_);
+
+        LogWarnC << "drop queued sample " << sample.slot_->dump() << std::endl;
+
+        buffer_->releaseSlot(sample.slot_);
+        sample.slot_.reset();
+        nSamples_--;
+        advanceHead();
+
+        (*sstorage_)[Indicator::DroppedNum]++;
+    }
+}
+
+void
+PlaybackQueue::advanceHead()
+{
+    // skipped entries are gaps, left by samples that never made it to the
+    // queue, thus advancing is constant time on average
+    do
+        head_++;
+    while (head_ < tail_ && !at(head_).slot_);
+}
+
+void
+PlaybackQueue::updateSize()
+{
+    if (!nSamples_)
+        size_ = 0;
+    else
+        size_ = (int64_t)(at(tail_-1).timestamp_ - at(head_).timestamp_ + samplePeriod());
+}
+
 // IBufferObserver
 void 
 PlaybackQueue::onNewRequest(const boost::shared_ptr<BufferSlot>&)
@@ -986,9 +1295,19 @@ PlaybackQueue::onNewData(const BufferReceipt& receipt)
         streamPrefix_.match(receipt.slot_->getPrefix()))
     {
         boost::lock_guard<boost::recursive_mutex> scopedLock(mutex_);
+        CommonHeader header = receipt.slot_->getHeader();
+
         buffer_->reserveSlot(receipt.slot_);
-        packetRate_ = receipt.slot_->getHeader().sampleRate_;
-        queue_.insert(Sample(receipt.slot_));
+        packetRate_ = header.sampleRate_;
+
+        if (!push(receipt.slot_, header.publishTimestampMs_))
+        {
+            LogWarnC << "drop late sample " << receipt.slot_->dump() << std::endl;
+            buffer_->releaseSlot(receipt.slot_);
+            (*sstorage_)[Indicator::DroppedNum]++;
+            return;
+        }
+        updateSize();
 
         for (auto o:observers_) o->onNewSampleReady();
         
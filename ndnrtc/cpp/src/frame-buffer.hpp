@@ -11,6 +11,7 @@
 #ifndef __ndnrtc__frame_buffer__
 #define __ndnrtc__frame_buffer__
 
+#include <atomic>
 #include <boost/thread/mutex.hpp>
 #include <boost/thread.hpp>
 #include <ndn-cpp/name.hpp>
@@ -39,6 +40,7 @@ namespace ndnrtc
     public:
 
         SlotSegment(const boost::shared_ptr<const ndn::Interest>&);
+        SlotSegment(const boost::shared_ptr<const ndn::Interest>&, const NamespaceInfo&);
 
         const NamespaceInfo& getInfo() const;
         void setData(const boost::shared_ptr<WireSegment>& data);
@@ -139,6 +141,13 @@ namespace ndnrtc
          */
         void 
         segmentsRequested(const std::vector<boost::shared_ptr<const ndn::Interest>>& interests);
+
+        /**
+         * Same as above, but for Interests which names were parsed already.
+         * @param segments Vector of slot segments, created for issued Interests
+         */
+        void
+        segmentsRequested(const std::vector<boost::shared_ptr<SlotSegment>>& segments);
         
         /**
          * Clears all internal structures of this slot and returns to Free state
@@ -191,9 +200,9 @@ namespace ndnrtc
         unsigned int getRtxNum() const { return nRtx_; }
         int getRtxNum(const ndn::Name& segmentName);
         bool hasOriginalSegments() const { return hasOriginalSegments_; }
-        size_t getFetchedNum() const { return fetched_.size(); }
+        size_t getFetchedNum() const { return nFetched_[0]+nFetched_[1]; }
         void toggleLock();
-        bool hasAllSegmentsFetched() const { return nDataSegments_+nParitySegments_ == fetched_.size(); }
+        bool hasAllSegmentsFetched() const { return nDataSegments_+nParitySegments_ == getFetchedNum(); }
         int64_t getAssemblingTime() const
         { return ( state_ >= Ready ? assembledTimeUsec_-firstSegmentTimeUsec_ : 0); }
         int64_t getShortestDrd() const
@@ -209,6 +218,14 @@ namespace ndnrtc
          */
         const _CommonHeader getHeader() const;
 
+        /**
+         * Returns playback number of the sample, taken from the first fetched
+         * data segment (for video, it's a frame number in playback order,
+         * common for key and delta frames; for audio, it's a sample number).
+         * Returns -1 if no data segments were fetched yet.
+         */
+        PacketNumber getPlaybackNumber() const;
+
         std::string
         dump(bool showLastSegment = false) const;
 
@@ -219,9 +236,15 @@ namespace ndnrtc
         friend ManifestValidator;
         friend Buffer;
 
+        // data (0) and parity (1) segments, indexed by segment number; arrays
+        // keep their capacity when slot is cleared, so pooled slots don't
+        // reallocate them for every new sample
+        typedef std::vector<boost::shared_ptr<SlotSegment>> SegmentArray;
+
         ndn::Name name_;
         NamespaceInfo nameInfo_;
-        std::map<ndn::Name, boost::shared_ptr<SlotSegment>> requested_, fetched_;
+        SegmentArray requested_[2], fetched_[2];
+        size_t nFetched_[2];
         boost::shared_ptr<SlotSegment> lastFetched_;
         unsigned int consistency_, nRtx_, assembledSize_;
         unsigned int nDataSegments_, nParitySegments_;
@@ -234,6 +257,11 @@ namespace ndnrtc
 
         virtual void updateConsistencyState(const boost::shared_ptr<SlotSegment>& segment);
         void updateAssembledLevel();
+
+        static int segmentIdx(const NamespaceInfo& info)
+        { return (info.segmentClass_ == SegmentClass::Parity ? 1 : 0); }
+        // returns fetched segment with the lowest segment number
+        static boost::shared_ptr<SlotSegment> firstSegment(const SegmentArray& segments);
     };
 
     //******************************************************************************
@@ -328,6 +356,54 @@ namespace ndnrtc
         virtual void detach(IBufferObserver* observer) = 0;
     };
 
+    /**
+     * Open addressing (linear probing) table of buffer slots, keyed by
+     * sample's thread index, class and number. Unlike sample prefix, key
+     * does not depend on temporal layer of delta frames, as layers share
+     * sequence numbers. Table doubles once it's half full; erasing shifts
+     * following entries back, thus there are no tombstones.
+     */
+    class SlotTable {
+    public:
+        typedef uint64_t Key;
+
+        SlotTable(size_t capacity = 64);
+
+        static Key makeKey(unsigned int threadIdx, SampleClass cls, PacketNumber sampleNo)
+        {
+            return ((Key)threadIdx << 34) | ((Key)cls << 32) | (uint32_t)sampleNo;
+        }
+
+        // returns null if there's no slot for the key
+        boost::shared_ptr<BufferSlot> find(Key key) const;
+        void insert(Key key, const boost::shared_ptr<BufferSlot>& slot);
+        // returns erased slot or null if there was no slot for the key
+        boost::shared_ptr<BufferSlot> erase(Key key);
+        void clear();
+        size_t size() const { return size_; }
+
+        template <typename F>
+        void forEach(F f) const
+        {
+            for (auto& e:entries_)
+                if (e.slot_) f(e.key_, e.slot_);
+        }
+
+    private:
+        typedef struct _Entry {
+            Key key_;
+            boost::shared_ptr<BufferSlot> slot_; // null if entry is free
+        } Entry;
+
+        std::vector<Entry> entries_;
+        size_t size_, mask_;
+
+        size_t home(Key key) const
+        { return (size_t)((key * 0x9E3779B97F4A7C15ull) >> 32) & mask_; }
+        size_t lookup(Key key) const;
+        void grow();
+    };
+
     class Buffer : public NdnRtcComponent, public IBuffer {
     public:
         Buffer(boost::shared_ptr<statistics::StatisticsStorage> storage,
@@ -341,6 +417,13 @@ namespace ndnrtc
         bool isRequested(const boost::shared_ptr<WireSegment>& segment) const;
         unsigned int getSlotsNum(const ndn::Name& prefix, int stateMask) const;
 
+        /**
+         * Returns number of slots, that are waiting for data (New or
+         * Assembling). Unlike getSlotsNum(), this does not lock the buffer
+         * and may be called from any thread.
+         */
+        unsigned int getPendingSlotsNum() const { return nPending_; }
+
         void attach(IBufferObserver* observer);
         void detach(IBufferObserver* observer);
         boost::shared_ptr<SlotPool> getPool() const { return pool_; }
@@ -353,19 +436,28 @@ namespace ndnrtc
 
         mutable boost::recursive_mutex mutex_;
         boost::shared_ptr<SlotPool> pool_;
-        std::map<ndn::Name, boost::shared_ptr<BufferSlot>> activeSlots_, reservedSlots_;
+        SlotTable activeSlots_, reservedSlots_;
+        // thread names, indexed by thread index of slot keys
+        std::vector<std::string> threads_;
+        std::atomic<unsigned int> nPending_;
         std::vector<IBufferObserver*> observers_;
         boost::shared_ptr<statistics::StatisticsStorage> sstorage_;
         
         std::string
         shortdump() const;
 
+        void slotStateChanged(BufferSlot::State oldState, BufferSlot::State newState);
+
         void 
-        dumpSlotDictionary(std::stringstream&, 
-            const std::map<ndn::Name, boost::shared_ptr<BufferSlot>> &) const;
-        
-        void invalidate(const ndn::Name& slotPrefix);
-        void invalidatePrevious(const ndn::Name& slotPrefix);
+        dumpSlotDictionary(std::stringstream&, const SlotTable &) const;
+
+        // returns false if there are no slots of sample's thread
+        bool findKey(const NamespaceInfo& info, SlotTable::Key& key) const;
+        SlotTable::Key addKey(const NamespaceInfo& info);
+
+        void invalidate(SlotTable::Key key);
+        void invalidatePrevious(const boost::shared_ptr<const BufferSlot>& slot);
+        void dropSlot(const boost::shared_ptr<BufferSlot>& slot);
         
         void reserveSlot(const boost::shared_ptr<const BufferSlot>& slot);
         void releaseSlot(const boost::shared_ptr<const BufferSlot>& slot);
@@ -396,7 +488,13 @@ namespace ndnrtc
     /**
      * Class PaybackQueue implements functionality for ordering assembled frames
      * in playback order and provides interface for extracting media samples
-     * for playback
+     * for playback.
+     * Samples are kept in a ring, indexed by playback number (see
+     * BufferSlot::getPlaybackNumber()), thus insertion and extraction don't
+     * depend on the number of queued samples. Samples, which playback numbers
+     * don't fit in the ring, are dropped: late samples are released
+     * right away, while samples at the head of the queue are released to make
+     * room for the newer ones.
      */
     class PlaybackQueue : public NdnRtcComponent,
                           public IPlaybackQueue,
@@ -404,21 +502,24 @@ namespace ndnrtc
     {
     public:
         PlaybackQueue(const ndn::Name& streamPrefix,
-            const boost::shared_ptr<Buffer>& buffer);
+            const boost::shared_ptr<Buffer>& buffer,
+            unsigned int ringSize = 1024);
         ~PlaybackQueue();
 
         void
         pop(ExtractSlot extract);
 
         /**
-         * This returns size in milliseconds of actual playable content
+         * This returns size in milliseconds of actual playable content.
+         * Does not lock the queue, thus may be called from any thread.
          * @return Duration in milliseconds of playable content
          */
-        int64_t size() const;
+        int64_t size() const { return size_; }
 
         /**
          * This returns size in milliseconds of (estimated) pending content - 
          * the content that has not arrived from network yet.
+         * Does not lock the queue, thus may be called from any thread.
          */
         int64_t pendingSize() const;
 
@@ -431,27 +532,33 @@ namespace ndnrtc
         std::string dump();
 
     private:
-        class Sample {
-        public:
-            Sample(const boost::shared_ptr<const BufferSlot>& slot):slot_(slot){}
-
-            boost::shared_ptr<const BufferSlot> slot() const { return slot_; }
-            int64_t timestamp() const;
-            bool operator<(const Sample& sample) const
-            { return this->timestamp() < sample.timestamp(); }
-        
-        private:
-            boost::shared_ptr<const BufferSlot> slot_;
-        };
+        // publish timestamp is cached, so that slot's header is not parsed
+        // every time queue size is calculated
+        typedef struct _Sample {
+            boost::shared_ptr<const BufferSlot> slot_; // null if entry is empty
+            int64_t timestamp_;
+        } Sample;
 
         mutable boost::recursive_mutex mutex_;
         ndn::Name streamPrefix_;
         boost::shared_ptr<Buffer> buffer_;
-        double packetRate_;
-        std::set<Sample> queue_;
+        std::atomic<double> packetRate_;
+        // queued samples have playback numbers in [head_, tail_); samples
+        // at head_ and tail_-1 are always present, if queue is not empty
+        std::vector<Sample> ring_;
+        PacketNumber head_, tail_;
+        size_t nSamples_;
+        std::atomic<int64_t> size_;
         std::vector<IPlaybackQueueObserver*> observers_;
         boost::shared_ptr<statistics::StatisticsStorage> sstorage_;
 
+        Sample& at(PacketNumber playbackNo)
+        { return ring_[playbackNo % ring_.size()]; }
+        bool push(const boost::shared_ptr<const BufferSlot>& slot, int64_t timestamp);
+        void dropHead(PacketNumber newHead);
+        void advanceHead();
+        void updateSize();
+
         virtual void onNewRequest(const boost::shared_ptr<BufferSlot>&);
         virtual void onNewData(const BufferReceipt& receipt);
         virtual void onReset();
@@ -6,7 +6,9 @@
 //
 
 #include <webrtc/common_video/libyuv/include/webrtc_libyuv.h>
+#include <libyuv/convert.h>
 #include "frame-converter.hpp"
+#include "frame-pool.hpp"
 #include <stdexcept>
 
 using namespace ndnrtc;
@@ -29,15 +31,8 @@ WebRtcVideoFrame RawFrameConverter::convert(const ArgbRawFrameWrapper& wr, const
 {             
 	// make conversion to I420
 
-	int stride_y = wr.width_;
-	int stride_uv = (wr.width_ + 1) / 2;
-	int target_width = wr.width_;
-	int target_height = wr.height_;
-
-	frameBuffer_ = I420Buffer::Create(wr.width_, wr.height_, stride_y, stride_uv, stride_uv);
-
-	if (!frameBuffer_)
-		throw std::runtime_error("Failed to allocate I420 frame");
+	WebRtcSmartPtr<WebRtcVideoFrameBuffer> frameBuffer =
+		FrameBufferPool::getSharedInstance().getBuffer(wr.width_, wr.height_);
 
 	const int conversionResult = ConvertToI420(commonVideoType,
 											   wr.frameData_,
@@ -45,51 +40,85 @@ WebRtcVideoFrame RawFrameConverter::convert(const ArgbRawFrameWrapper& wr, const
                                                wr.width_, wr.height_,
                                                wr.frameSize_,
                                                kVideoRotation_0,
-                                               frameBuffer_.get());
+                                               frameBuffer.get());
 	if (conversionResult < 0)
 		throw std::runtime_error("Failed to convert capture frame to I420");
 
-	return WebRtcVideoFrame(frameBuffer_, webrtc::kVideoRotation_0, 0);
+	return WebRtcVideoFrame(frameBuffer, webrtc::kVideoRotation_0, 0);
 }
 
 WebRtcVideoFrame RawFrameConverter::operator<<(const I420RawFrameWrapper& wr)
 {
-	frameBuffer_ = I420Buffer::Create(wr.width_, wr.height_, wr.strideY_, wr.strideU_, wr.strideV_);
+	WebRtcSmartPtr<WebRtcVideoFrameBuffer> frameBuffer =
+		FrameBufferPool::getSharedInstance().getBuffer(wr.width_, wr.height_,
+													   wr.strideY_, wr.strideU_, wr.strideV_);
 
 	unsigned int ySize = wr.strideY_*wr.height_;
 	unsigned int uSize = wr.strideU_*(wr.height_+1)/2;
 	unsigned int vSize = wr.strideV_*(wr.height_+1)/2;
-	memcpy(frameBuffer_->MutableDataY(), wr.yBuffer_, ySize);
-	memcpy(frameBuffer_->MutableDataU(), wr.uBuffer_, uSize);
-	memcpy(frameBuffer_->MutableDataV(), wr.vBuffer_, vSize);
+	memcpy(frameBuffer->MutableDataY(), wr.yBuffer_, ySize);
+	memcpy(frameBuffer->MutableDataU(), wr.uBuffer_, uSize);
+	memcpy(frameBuffer->MutableDataV(), wr.vBuffer_, vSize);
 
-	return WebRtcVideoFrame(frameBuffer_, webrtc::kVideoRotation_0, 0);
+	return WebRtcVideoFrame(frameBuffer, webrtc::kVideoRotation_0, 0);
 }
 
 WebRtcVideoFrame RawFrameConverter::operator<<(const YUV_NV21FrameWrapper& wr)
-{             
-	// make conversion to I420
-	const VideoType commonVideoType = RawVideoTypeToCommonVideoVideoType(kVideoNV21);
-
-	int stride_y = wr.width_;
-	int stride_uv = (wr.width_ + 1) / 2;
-	int target_width = wr.width_;
-	int target_height = wr.height_;
-
-	frameBuffer_ = I420Buffer::Create(wr.width_, wr.height_, stride_y, stride_uv, stride_uv);
+{
+	// convert directly from caller's planes, which may have arbitrary
+	// strides and need not be contiguous
+	WebRtcSmartPtr<WebRtcVideoFrameBuffer> frameBuffer =
+		FrameBufferPool::getSharedInstance().getBuffer(wr.width_, wr.height_);
+
+	const int conversionResult = libyuv::NV21ToI420(wr.yBuffer_, wr.strideY_,
+													wr.uvBuffer_, wr.strideUV_,
+													frameBuffer->MutableDataY(), frameBuffer->StrideY(),
+													frameBuffer->MutableDataU(), frameBuffer->StrideU(),
+													frameBuffer->MutableDataV(), frameBuffer->StrideV(),
+													wr.width_, wr.height_);
+	if (conversionResult < 0)
+		throw std::runtime_error("Failed to convert capture frame to I420");
 
-	if (!frameBuffer_)
-		throw std::runtime_error("Failed to allocate I420 frame");
+	return WebRtcVideoFrame(frameBuffer, webrtc::kVideoRotation_0, 0);
+}
 
-	const int conversionResult = ConvertToI420(commonVideoType,
-											   wr.yBuffer_,
-                                               0, 0,  // No cropping
-                                               wr.width_, wr.height_,
-                                               wr.strideY_+wr.strideUV_,
-                                               kVideoRotation_0,
-                                               frameBuffer_.get());
+WebRtcVideoFrame RawFrameConverter::operator<<(const YUV_NV12FrameWrapper& wr)
+{
+	WebRtcSmartPtr<WebRtcVideoFrameBuffer> frameBuffer =
+		FrameBufferPool::getSharedInstance().getBuffer(wr.width_, wr.height_);
+
+	const int conversionResult = libyuv::NV12ToI420(wr.yBuffer_, wr.strideY_,
+													wr.uvBuffer_, wr.strideUV_,
+													frameBuffer->MutableDataY(), frameBuffer->StrideY(),
+													frameBuffer->MutableDataU(), frameBuffer->StrideU(),
+													frameBuffer->MutableDataV(), frameBuffer->StrideV(),
+													wr.width_, wr.height_);
 	if (conversionResult < 0)
 		throw std::runtime_error("Failed to convert capture frame to I420");
 
-	return WebRtcVideoFrame(frameBuffer_, webrtc::kVideoRotation_0, 0);
+	return WebRtcVideoFrame(frameBuffer, webrtc::kVideoRotation_0, 0);
+}
+
+WebRtcVideoFrame RawFrameConverter::operator<<(const ExternalI420FrameWrapper& wr)
+{
+	WebRtcSmartPtr<webrtc::VideoFrameBuffer> frameBuffer(new rtc::RefCountedObject<ExternalI420Buffer>(wr));
+	return WebRtcVideoFrame(frameBuffer, webrtc::kVideoRotation_0, 0);
+}
+
+//******************************************************************************
+ExternalI420Buffer::ExternalI420Buffer(const ExternalI420FrameWrapper& wr)
+	: planes_(wr.planes_), onReleased_(wr.onReleased_)
+{
+}
+
+ExternalI420Buffer::~ExternalI420Buffer()
+{
+	if (onReleased_)
+		onReleased_();
+}
+
+WebRtcSmartPtr<webrtc::VideoFrameBuffer> ExternalI420Buffer::NativeToI420Buffer()
+{
+	// not a native (texture) buffer
+	return nullptr;
 }
@@ -5,6 +5,8 @@
 //  Copyright 2013-2016 Regents of the University of California
 //
 
+#include <boost/function.hpp>
+
 #include "webrtc.hpp"
 
 namespace ndnrtc {
@@ -39,10 +41,66 @@ namespace ndnrtc {
 		const unsigned char* uvBuffer_;
 	} YUV_NV21FrameWrapper; 
 
+	typedef struct _YUV_NV12FrameWrapper {
+		const unsigned int width_;
+		const unsigned int height_;
+		const unsigned int strideY_;
+		const unsigned int strideUV_;
+		const unsigned char* yBuffer_;
+		const unsigned char* uvBuffer_;
+	} YUV_NV12FrameWrapper; 
+
+	// frame, encoded elsewhere (VP9), published as is
+	typedef struct _EncodedFrameWrapper {
+		const unsigned int width_;
+		const unsigned int height_;
+		const bool isKey_;
+		const uint32_t timestamp_;		// RTP timestamp (90kHz)
+		const int64_t captureTimeMs_;
+		const unsigned char* frameData_;
+		const unsigned int frameSize_;
+		const unsigned int temporalLayer_;
+	} EncodedFrameWrapper;
+
+	typedef boost::function<void(void)> OnFrameReleased;
+
+	// I420 planes, owned by the caller, which are not copied
+	typedef struct _ExternalI420FrameWrapper {
+		const I420RawFrameWrapper planes_;
+		OnFrameReleased onReleased_;
+	} ExternalI420FrameWrapper;
+
+	/**
+	 * Frame buffer that wraps I420 planes owned by someone else, without
+	 * copying them. Release callback is called once the last reference to
+	 * the buffer is released (on the thread which released it).
+	 */
+	class ExternalI420Buffer : public webrtc::VideoFrameBuffer
+	{
+	public:
+		ExternalI420Buffer(const ExternalI420FrameWrapper& wr);
+		~ExternalI420Buffer();
+
+		int width() const override { return planes_.width_; }
+		int height() const override { return planes_.height_; }
+		const uint8_t* DataY() const override { return planes_.yBuffer_; }
+		const uint8_t* DataU() const override { return planes_.uBuffer_; }
+		const uint8_t* DataV() const override { return planes_.vBuffer_; }
+		int StrideY() const override { return planes_.strideY_; }
+		int StrideU() const override { return planes_.strideU_; }
+		int StrideV() const override { return planes_.strideV_; }
+		void* native_handle() const override { return nullptr; }
+		WebRtcSmartPtr<webrtc::VideoFrameBuffer> NativeToI420Buffer() override;
+
+	private:
+		const I420RawFrameWrapper planes_;
+		OnFrameReleased onReleased_;
+	};
+
 	/**
 	 * FrameConverter converts wrappers of raw video frames into a
-	 * WebRTC raw video frame object. Converted object is stored inside the
-	 * converter and is valid as long as converter lives.
+	 * WebRTC raw video frame object. Converted frames use buffers from the
+	 * shared frame buffer pool, which are recycled once frames are released.
 	 */
 	class RawFrameConverter 
 	{
@@ -53,10 +111,11 @@ namespace ndnrtc {
 		WebRtcVideoFrame operator<<(const struct _8bitFixedSizeRawFrameWrapper&);
 		WebRtcVideoFrame operator<<(const I420RawFrameWrapper&);
 		WebRtcVideoFrame operator<<(const YUV_NV21FrameWrapper&);
+		WebRtcVideoFrame operator<<(const YUV_NV12FrameWrapper&);
+		// frame is not copied, see ExternalI420Buffer
+		WebRtcVideoFrame operator<<(const ExternalI420FrameWrapper&);
 
 	private:
-		WebRtcSmartPtr<WebRtcVideoFrameBuffer> frameBuffer_;
-
         WebRtcVideoFrame convert(const struct _8bitFixedSizeRawFrameWrapper&, 
                                  const webrtc::VideoType&);
 	};
@@ -71,6 +71,21 @@ class DataSegment : protected DataPacket::Blob
         return sp;
     }
 
+    /**
+     * Writes segment in wire format (same as getNetworkData() produces) 
+     * into provided buffer, which must be at least size() bytes long.
+     * Payload is copied directly from the packet it was sliced from.
+     */
+    void write(uint8_t *buffer) const
+    {
+        buffer[0] = 1;
+        buffer[1] = sizeof(Header) & 0x00ff;
+        buffer[2] = (sizeof(Header) & 0xff00) >> 8;
+        memcpy(buffer + 3, &header_, sizeof(Header));
+        if (Blob::size())
+            memcpy(buffer + 3 + sizeof(Header), Blob::data(), Blob::size());
+    }
+
     /**
      * This calculates total wire length for a segment with given payload 
      * length
@@ -91,9 +106,17 @@ class DataSegment : protected DataPacket::Blob
 
     static size_t numSlices(const NetworkData &nd,
                             size_t segmentWireLength)
+    {
+        return numSlices(nd.getLength(), segmentWireLength);
+    }
+
+    /**
+     * Number of segments data of given length will be sliced into
+     */
+    static size_t numSlices(size_t length, size_t segmentWireLength)
     {
         size_t payloadLength = DataSegment<Header>::payloadLength(segmentWireLength);
-        return (nd.getLength() / payloadLength) + (nd.getLength() % payloadLength ? 1 : 0);
+        return (length / payloadLength) + (length % payloadLength ? 1 : 0);
     }
 
     static std::vector<DataSegment<Header>> slice(const NetworkData &nd,
@@ -105,17 +128,17 @@ class DataSegment : protected DataPacket::Blob
         if (payloadLength == 0)
             return segments;
 
-        std::vector<uint8_t>::const_iterator p1 = nd.data().begin();
+        std::vector<uint8_t>::const_iterator p1 = nd.begin();
         std::vector<uint8_t>::const_iterator p2 = p1 + payloadLength;
 
-        while (p2 < nd.data().end())
+        while (p2 < nd.end())
         {
             segments.push_back(DataSegment<Header>(p1, p2));
             p1 = p2;
             p2 += payloadLength;
         }
 
-        segments.push_back(DataSegment<Header>(p1, nd.data().end()));
+        segments.push_back(DataSegment<Header>(p1, nd.end()));
 
         return segments;
     }
@@ -142,22 +165,35 @@ class VideoFramePacketT : public HeaderPacketT<CommonHeader, T>
     ENABLE_IF(T, Immutable)
     VideoFramePacketT(const boost::shared_ptr<const std::vector<uint8_t>> &data) : HeaderPacketT<CommonHeader, T>(data) {}
 
+    /**
+     * @param hasLayers Whether frame's thread has several temporal layers;
+     *          only then layer header follows frame header
+     * @param temporalLayer Temporal layer of the frame
+     */
     ENABLE_IF(T, Mutable)
-    VideoFramePacketT(const webrtc::EncodedImage &frame) : HeaderPacketT<CommonHeader, T>(frame._length, frame._buffer),
-                                                           isSyncListSet_(false)
+    VideoFramePacketT(const webrtc::EncodedImage &frame, bool hasLayers = false,
+                      unsigned int temporalLayer = 0) : HeaderPacketT<CommonHeader, T>(frame._length, frame._buffer,
+                                                                                       VideoFramePacketT<T>::headroom()),
+                                                        isSyncListSet_(false)
     {
         assert(frame._encodedWidth);
         assert(frame._encodedHeight);
 
-        Header hdr;
-        hdr.encodedWidth_ = frame._encodedWidth;
-        hdr.encodedHeight_ = frame._encodedHeight;
-        hdr.timestamp_ = frame._timeStamp;
-        hdr.capture_time_ms_ = frame.capture_time_ms_;
-        hdr.frameType_ = frame._frameType;
-        hdr.completeFrame_ = frame._completeFrame;
-        hdr.frameLength_ = frame._length;
-        this->addBlob(sizeof(hdr), (uint8_t *)&hdr);
+        struct
+        {
+            Header hdr;
+            LayerHeader layerHdr;
+        } __attribute__((packed)) hdrs;
+        hdrs.hdr.encodedWidth_ = frame._encodedWidth;
+        hdrs.hdr.encodedHeight_ = frame._encodedHeight;
+        hdrs.hdr.timestamp_ = frame._timeStamp;
+        hdrs.hdr.capture_time_ms_ = frame.capture_time_ms_;
+        hdrs.hdr.frameType_ = frame._frameType;
+        hdrs.hdr.completeFrame_ = frame._completeFrame;
+        hdrs.hdr.frameLength_ = frame._length;
+        hdrs.layerHdr.temporalLayer_ = temporalLayer;
+        hdrs.layerHdr.refPlaybackNo_ = -1;
+        this->addBlob((hasLayers ? sizeof(hdrs) : sizeof(Header)), (uint8_t *)&hdrs);
     }
 
     ENABLE_IF(T, Mutable)
@@ -180,6 +216,33 @@ class VideoFramePacketT : public HeaderPacketT<CommonHeader, T>
         return frame_;
     }
 
+    // whether frame has layer header, i.e. its thread has several temporal
+    // layers
+    bool hasLayerHeader() const
+    {
+        return this->blobs_[0].size() >= sizeof(Header) + sizeof(LayerHeader);
+    }
+
+    // temporal (SVC) layer of the frame, 0 for key frames
+    unsigned int getTemporalLayer() const
+    {
+        return (hasLayerHeader() ? getLayerHeader()->temporalLayer_ : 0);
+    }
+
+    // playback number of the previous frame of the same or lower temporal
+    // layer (the frame this one depends on), -1 if thread has one layer
+    PacketNumber getRefPlaybackNo() const
+    {
+        return (hasLayerHeader() ? getLayerHeader()->refPlaybackNo_ : -1);
+    }
+
+    ENABLE_IF(T, Mutable)
+    void setRefPlaybackNo(PacketNumber refPlaybackNo)
+    {
+        if (hasLayerHeader())
+            const_cast<LayerHeader *>(getLayerHeader())->refPlaybackNo_ = refPlaybackNo;
+    }
+
     const std::map<std::string, PacketNumber> getSyncList() const
     {
         typedef typename std::vector<typename DataPacketT<T>::Blob>::const_iterator BlobIterator;
@@ -200,9 +263,7 @@ class VideoFramePacketT : public HeaderPacketT<CommonHeader, T>
             throw std::runtime_error("Can't compute FEC parity data on invalid packet");
 
         size_t nDataSegmets = this->getLength() / segmentLength + (this->getLength() % segmentLength ? 1 : 0);
-        size_t nParitySegments = ceil(ratio * nDataSegmets);
-        if (nParitySegments == 0)
-            nParitySegments = 1;
+        size_t nParitySegments = getParitySymbolsNum(segmentLength, ratio);
 
         std::vector<uint8_t> fecData(nParitySegments * segmentLength, 0);
         fec::Rs28Encoder enc(nDataSegmets, nParitySegments, segmentLength);
@@ -210,16 +271,28 @@ class VideoFramePacketT : public HeaderPacketT<CommonHeader, T>
         boost::shared_ptr<NetworkData> parityData;
 
         // expand data with zeros
-        this->_data().resize(nDataSegmets * segmentLength, 0);
-        if (enc.encode(this->_data().data(), fecData.data()) >= 0)
+        this->_data().resize(this->offset_ + nDataSegmets * segmentLength, 0);
+        if (enc.encode(this->_data().data() + this->offset_, fecData.data()) >= 0)
             parityData = boost::make_shared<NetworkData>(boost::move(fecData));
         // shrink data back
-        this->_data().resize(this->getLength() - padding);
+        this->_data().resize(this->_data().size() - padding);
         this->reinit(); // data may have been relocated, so we need to reinit blobs
 
         return parityData;
     }
 
+    /**
+     * Returns number of parity symbols (segmentLength bytes each) that
+     * getParityData() produces for given ratio. Allows to know the size of
+     * parity data without computing it.
+     */
+    size_t getParitySymbolsNum(size_t segmentLength, double ratio) const
+    {
+        size_t nDataSegmets = this->getLength() / segmentLength + (this->getLength() % segmentLength ? 1 : 0);
+        size_t nParitySegments = ceil(ratio * nDataSegmets);
+        return (nParitySegments ? nParitySegments : 1);
+    }
+
     ENABLE_IF(T, Mutable)
     void setSyncList(const ThreadSyncList &syncList)
     {
@@ -245,6 +318,10 @@ class VideoFramePacketT : public HeaderPacketT<CommonHeader, T>
     merge(const ImmutableVideoSegmentsVector &segments);
 
   private:
+    // headroom reserved for sync list entries of this many threads
+    static const size_t SyncListHeadroomThreads = 4;
+    static const size_t SyncListHeadroomNameLength = 8;
+
     typedef struct _Header
     {
         uint32_t encodedWidth_;
@@ -256,8 +333,31 @@ class VideoFramePacketT : public HeaderPacketT<CommonHeader, T>
         uint32_t frameLength_;
     } __attribute__((packed)) Header;
 
+    // follows frame header in the same blob, only if frame's thread has
+    // several temporal layers; consumers that don't know about layers read
+    // frame header only
+    typedef struct _LayerHeader
+    {
+        uint8_t temporalLayer_;
+        PacketNumber refPlaybackNo_;
+    } __attribute__((packed)) LayerHeader;
+
     webrtc::EncodedImage frame_;
     bool isSyncListSet_;
+
+    const LayerHeader *getLayerHeader() const
+    {
+        return (const LayerHeader *)(this->blobs_[0].data() + sizeof(Header));
+    }
+
+    static size_t headroom()
+    {
+        size_t syncEntryLength = DataPacketT<T>::wireLength(SyncListHeadroomNameLength) +
+                                 DataPacketT<T>::wireLength(sizeof(PacketNumber));
+        return DataPacketT<T>::wireLength(sizeof(Header) + sizeof(LayerHeader)) +
+               DataPacketT<T>::wireLength(sizeof(CommonHeader)) +
+               SyncListHeadroomThreads * syncEntryLength;
+    }
 };
 
 typedef VideoFramePacketT<> VideoFramePacket;
@@ -341,22 +441,11 @@ class AudioBundlePacketT : public HeaderPacketT<CommonHeader, T>
     {
         if (hasSpace(sampleBlob))
         {
-            this->_data()[0]++;
-
-            uint8_t b1 = sampleBlob.size() & 0x00ff, b2 = (sampleBlob.size() & 0xff00) >> 8;
-            this->payloadBegin_ = this->_data().insert(this->payloadBegin_, b1);
-            this->payloadBegin_++;
-            this->payloadBegin_ = this->_data().insert(this->payloadBegin_, b2);
-            this->payloadBegin_++;
-            for (int i = 0; i < sizeof(sampleBlob.getHeader()); ++i)
-            {
-                this->payloadBegin_ = this->_data().insert(this->payloadBegin_, ((uint8_t *)&sampleBlob.getHeader())[i]);
-                this->payloadBegin_++;
-            }
-            // insert blob
-            this->_data().insert(this->payloadBegin_, sampleBlob.data(),
-                                 sampleBlob.data() + (sampleBlob.size() - sizeof(sampleBlob.getHeader())));
-            this->reinit();
+            uint8_t *blob = this->allocateBlob(sampleBlob.size());
+
+            memcpy(blob, &sampleBlob.getHeader(), sizeof(sampleBlob.getHeader()));
+            memcpy(blob + sizeof(sampleBlob.getHeader()), sampleBlob.data(),
+                   sampleBlob.size() - sizeof(sampleBlob.getHeader()));
             remainingSpace_ -= DataPacket::wireLength(sampleBlob.size());
         }
         else
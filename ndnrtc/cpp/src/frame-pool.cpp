@@ -0,0 +1,127 @@
+//
+// frame-pool.cpp
+//
+//  Copyright 2013-2018 Regents of the University of California
+//
+
+#include "frame-pool.hpp"
+
+#include <stdexcept>
+#include <boost/thread/lock_guard.hpp>
+
+using namespace ndnrtc;
+
+FrameBufferPool::FrameBufferPool(size_t maxBuffers)
+    : maxBuffers_(maxBuffers), nBuffers_(0), nHit_(0), nMiss_(0), nEvicted_(0)
+{
+}
+
+FrameBufferPool &FrameBufferPool::getSharedInstance()
+{
+    static FrameBufferPool pool;
+    return pool;
+}
+
+WebRtcSmartPtr<WebRtcVideoFrameBuffer>
+FrameBufferPool::getBuffer(unsigned int width, unsigned int height)
+{
+    return getBuffer(width, height, width, (width + 1) / 2, (width + 1) / 2);
+}
+
+WebRtcSmartPtr<WebRtcVideoFrameBuffer>
+FrameBufferPool::getBuffer(unsigned int width, unsigned int height,
+                           unsigned int strideY, unsigned int strideU, unsigned int strideV)
+{
+    boost::lock_guard<boost::mutex> scopedLock(mutex_);
+    BufferKey key(width, height, strideY, strideU, strideV);
+    Bucket &bucket = buckets_[key];
+    bucket.lastRequest_ = nHit_ + nMiss_;
+
+    // buffer is free if pool holds the only reference to it
+    for (auto &b : bucket.buffers_)
+        if (b->HasOneRef())
+        {
+            nHit_++;
+            return b;
+        }
+
+    nMiss_++;
+    WebRtcSmartPtr<PooledBuffer> buffer(new PooledBuffer(width, height, strideY, strideU, strideV));
+
+    if (!buffer)
+        throw std::runtime_error("failed to allocate frame buffer");
+
+    if (nBuffers_ < maxBuffers_ || evict(key))
+    {
+        bucket.buffers_.push_back(buffer);
+        nBuffers_++;
+    }
+
+    return buffer;
+}
+
+bool FrameBufferPool::evict(const BufferKey &keep)
+{
+    std::map<BufferKey, Bucket>::iterator lru = buckets_.end();
+
+    for (std::map<BufferKey, Bucket>::iterator it = buckets_.begin(); it != buckets_.end();)
+    {
+        if (it->first != keep && it->second.buffers_.empty())
+        {
+            it = buckets_.erase(it);
+            continue;
+        }
+
+        if (it->first != keep &&
+            (lru == buckets_.end() || it->second.lastRequest_ < lru->second.lastRequest_))
+            for (auto &b : it->second.buffers_)
+                if (b->HasOneRef())
+                {
+                    lru = it;
+                    break;
+                }
+        ++it;
+    }
+
+    if (lru == buckets_.end())
+        return false;
+
+    std::vector<WebRtcSmartPtr<PooledBuffer>> &buffers = lru->second.buffers_;
+    for (std::vector<WebRtcSmartPtr<PooledBuffer>>::iterator it = buffers.begin(); it != buffers.end(); ++it)
+        if ((*it)->HasOneRef())
+        {
+            buffers.erase(it);
+            break;
+        }
+
+    if (buffers.empty())
+        buckets_.erase(lru);
+    nBuffers_--;
+    nEvicted_++;
+
+    return true;
+}
+
+size_t FrameBufferPool::size() const
+{
+    boost::lock_guard<boost::mutex> scopedLock(mutex_);
+    return nBuffers_;
+}
+
+uint64_t FrameBufferPool::getHitNum() const
+{
+    boost::lock_guard<boost::mutex> scopedLock(mutex_);
+    return nHit_;
+}
+
+uint64_t FrameBufferPool::getMissNum() const
+{
+    boost::lock_guard<boost::mutex> scopedLock(mutex_);
+    return nMiss_;
+}
+
+uint64_t FrameBufferPool::getEvictedNum() const
+{
+    boost::lock_guard<boost::mutex> scopedLock(mutex_);
+    return nEvicted_;
+}
@@ -0,0 +1,85 @@
+//
+// frame-pool.hpp
+//
+//  Copyright 2013-2018 Regents of the University of California
+//
+
+#ifndef __frame_pool_h__
+#define __frame_pool_h__
+
+#include <map>
+#include <vector>
+#include <boost/tuple/tuple.hpp>
+#include <boost/tuple/tuple_comparison.hpp>
+#include <boost/thread/mutex.hpp>
+
+#include "webrtc.hpp"
+
+namespace ndnrtc
+{
+/**
+ * Frame buffer pool recycles I420 frame buffers of raw video frames.
+ * Buffers are pooled by resolution and strides. Buffer returns to the pool
+ * once the last reference to it, held outside of the pool (i.e. by
+ * WebRtcVideoFrame objects), is released; next request for the same
+ * resolution and strides will get this buffer instead of allocating a new
+ * one. Once the pool is full, idle buffers of the least recently requested
+ * resolution are released to make room for new ones, thus buffers of
+ * resolutions that are no longer used don't occupy the pool. Pool is
+ * thread-safe. Shared instance is used by raw frame converters and frame
+ * scalers of all streams.
+ */
+class FrameBufferPool
+{
+  public:
+    /**
+     * @param maxBuffers Maximum number of buffers pooled; once reached and
+     *          all pooled buffers are in use, buffers are allocated
+     *          without pooling
+     */
+    FrameBufferPool(size_t maxBuffers = 64);
+
+    static FrameBufferPool &getSharedInstance();
+
+    WebRtcSmartPtr<WebRtcVideoFrameBuffer>
+    getBuffer(unsigned int width, unsigned int height);
+
+    WebRtcSmartPtr<WebRtcVideoFrameBuffer>
+    getBuffer(unsigned int width, unsigned int height,
+              unsigned int strideY, unsigned int strideU, unsigned int strideV);
+
+    // number of buffers pooled
+    size_t size() const;
+    // number of requests served by recycled buffers
+    uint64_t getHitNum() const;
+    // number of requests served by newly allocated buffers
+    uint64_t getMissNum() const;
+    // number of idle buffers released to make room for other resolutions
+    uint64_t getEvictedNum() const;
+
+  private:
+    typedef rtc::RefCountedObject<WebRtcVideoFrameBuffer> PooledBuffer;
+    typedef boost::tuple<unsigned int, unsigned int, unsigned int,
+                         unsigned int, unsigned int>
+        BufferKey;
+
+    typedef struct _Bucket
+    {
+        _Bucket() : lastRequest_(0) {}
+
+        std::vector<WebRtcSmartPtr<PooledBuffer>> buffers_;
+        uint64_t lastRequest_; // number of the last request for this bucket
+    } Bucket;
+
+    FrameBufferPool(const FrameBufferPool &) = delete;
+
+    size_t maxBuffers_, nBuffers_;
+    uint64_t nHit_, nMiss_, nEvicted_;
+    mutable boost::mutex mutex_;
+    std::map<BufferKey, Bucket> buckets_;
+
+    bool evict(const BufferKey &keep);
+};
+}
+
+#endif
@@ -22,6 +22,7 @@
 #include <ndn-cpp/security/tpm/tpm-back-end-memory.hpp>
 #include <ndn-cpp/security/tpm/tpm-back-end-file.hpp>
 #include <ndn-cpp/security/signing-info.hpp>
+#include <ndn-cpp/security/key-params.hpp>
 #include <ndn-cpp/util/memory-content-cache.hpp>
 #include <ndn-cpp/face.hpp>
 #include <boost/chrono.hpp>
@@ -73,13 +74,15 @@ KeyChainManager::KeyChainManager(boost::shared_ptr<ndn::Face> face,
                     const std::string& instanceName,
                     const std::string& configPolicy,
                     unsigned int instanceCertLifetime,
-                    boost::shared_ptr<ndnlog::new_api::Logger> logger):
+                    boost::shared_ptr<ndnlog::new_api::Logger> logger,
+                    ndn::KeyType instanceKeyType):
 face_(face),
 defaultKeyChain_(keyChain),
 signingIdentity_(identityName),
 instanceName_(instanceName),
 configPolicy_(configPolicy),
-runTime_(instanceCertLifetime)
+runTime_(instanceCertLifetime),
+instanceKeyType_(instanceKeyType)
 {
 	description_ = "key-chain-manager";
 	setLogger(logger);
@@ -219,7 +222,10 @@ void KeyChainManager::createInstanceIdentity()
     
     LogInfoC << "Instance identity " << instanceIdentity << std::endl;
 
-    Name instanceKeyName = instanceKeyChain_->generateRSAKeyPairAsDefault(instanceIdentity, true);
+    // instance key signs all stream data; ECDSA signing is much faster than RSA
+    Name instanceKeyName = (instanceKeyType_ == KEY_TYPE_EC ?
+                            instanceKeyChain_->generateEcdsaKeyPairAsDefault(instanceIdentity, true) :
+                            instanceKeyChain_->generateRSAKeyPairAsDefault(instanceIdentity, true));
     Name signingCert = defaultKeyChain_->getIdentityManager()->getDefaultCertificateNameForIdentity(Name(signingIdentity_));
 
 	LogDebugC << "Instance key " << instanceKeyName << std::endl;
@@ -256,8 +262,9 @@ void KeyChainManager::createInstanceIdentityV2()
     
     LogInfoC << "Instance identity " << instanceIdentity << std::endl;
 
-	boost::shared_ptr<PibIdentity> instancePibIdentity =
-      instanceKeyChain_->createIdentityV2(instanceIdentity);
+	boost::shared_ptr<PibIdentity> instancePibIdentity = (instanceKeyType_ == KEY_TYPE_EC ?
+      instanceKeyChain_->createIdentityV2(instanceIdentity, EcKeyParams()) :
+      instanceKeyChain_->createIdentityV2(instanceIdentity, RsaKeyParams()));
 	boost::shared_ptr<PibKey> instancePibKey = 
       instancePibIdentity->getDefaultKey();
 	boost::shared_ptr<PibKey> signingPibKey = defaultKeyChain_->getPib()
@@ -132,6 +132,7 @@ pimpl_(boost::make_shared<VideoStreamImpl>(streamPrefix, settings, useFec))
 
 LocalVideoStream::~LocalVideoStream()
 {
+	pimpl_->stopPipeline();
 }
 
 void
@@ -185,6 +186,83 @@ int LocalVideoStream::incomingNV21Frame(const unsigned int width,
 		strideUV, yBuffer, uvBuffer}));
 }
 
+int LocalVideoStream::incomingExternalI420Frame(const unsigned int width,
+	const unsigned int height,
+	const unsigned int strideY,
+	const unsigned int strideU,
+	const unsigned int strideV,
+	const unsigned char* yBuffer,
+	const unsigned char* uBuffer,
+	const unsigned char* vBuffer,
+	OnFrameReleased onReleased)
+{
+	return pimpl_->incomingFrame(ExternalI420FrameWrapper({
+		I420RawFrameWrapper({width, height, strideY, strideU, strideV, yBuffer, uBuffer, vBuffer}),
+		onReleased}));
+}
+
+int LocalVideoStream::incomingExternalNV12Frame(const unsigned int width,
+	const unsigned int height,
+	const unsigned int strideY,
+	const unsigned int strideUV,
+	const unsigned char* yBuffer,
+	const unsigned char* uvBuffer,
+	OnFrameReleased onReleased)
+{
+	int res = -1;
+	try
+	{
+		res = pimpl_->incomingFrame(YUV_NV12FrameWrapper({width, height, strideY,
+			strideUV, yBuffer, uvBuffer}));
+	}
+	catch (...)
+	{
+		if (onReleased) onReleased();
+		throw;
+	}
+
+	if (onReleased) onReleased();
+	return res;
+}
+
+int LocalVideoStream::incomingExternalNV21Frame(const unsigned int width,
+	const unsigned int height,
+	const unsigned int strideY,
+	const unsigned int strideUV,
+	const unsigned char* yBuffer,
+	const unsigned char* uvBuffer,
+	OnFrameReleased onReleased)
+{
+	int res = -1;
+	try
+	{
+		res = pimpl_->incomingFrame(YUV_NV21FrameWrapper({width, height, strideY,
+			strideUV, yBuffer, uvBuffer}));
+	}
+	catch (...)
+	{
+		if (onReleased) onReleased();
+		throw;
+	}
+
+	if (onReleased) onReleased();
+	return res;
+}
+
+int LocalVideoStream::incomingEncodedFrame(const std::string& threadName,
+	const unsigned int width,
+	const unsigned int height,
+	bool isKey,
+	uint32_t timestamp,
+	int64_t captureTimeMs,
+	const unsigned char* frameData,
+	unsigned int frameSize,
+	unsigned int temporalLayer)
+{
+	return pimpl_->incomingEncodedFrame(threadName, EncodedFrameWrapper({width, height, 
+		isKey, timestamp, captureTimeMs, frameData, frameSize, temporalLayer}));
+}
+
 const std::map<std::string, FrameInfo>& 
 LocalVideoStream::getLastPublishedInfo() const
 {
@@ -53,11 +53,22 @@ MediaStreamBase::MediaStreamBase(const std::string &basePrefix,
 	//liupenghui,  for audio sample fetching... 	
     cache_->setMinimumCacheLifetime(4000);
     // set filter for prefix without the timestamp, because stream _meta is served there
-    cache_->setInterestFilter(streamPrefix_.getPrefix(-1), cache_->getStorePendingInterest());
+    cache_->setInterestFilter(streamPrefix_.getPrefix(-1),
+                              boost::bind(&MediaStreamBase::onDataNotFound, this, _1, _2, _3, _4, _5));
+
+    const GeneralProducerParams::SampleCacheParams &scp = settings_.params_.producerParams_.sampleCache_;
+    sampleCache_ = boost::make_shared<SampleCache>(streamPrefix_, scp.lifetimeMs_,
+                                                   (size_t)scp.budgetMb_ * 1024 * 1024);
+
+    if (settings_.sign_ && settings_.params_.producerParams_.signing_.threads_)
+        signingPool_ = boost::make_shared<SigningPool>(settings_.params_.producerParams_.signing_.threads_,
+                                                       settings_.keyChain_, settings_.signingKeyChains_);
 
     PublisherSettings ps;
     ps.sign_ = settings_.sign_; // it's ok to sign every packet as data publisher
                                 // is used for low-rate data (max 10fps) and manifests
+    ps.signingPool_ = signingPool_.get();
+    ps.faceIo_ = &settings_.faceIo_;
     ps.keyChain_ = settings_.keyChain_;
     ps.memoryCache_ = cache_.get();
     ps.segmentWireLength_ = MAX_NDN_PACKET_SIZE; // it's ok to rely on link-layer fragmenting
@@ -92,6 +103,31 @@ void MediaStreamBase::removeThread(const string &threadName)
     publishMeta();
 }
 
+void MediaStreamBase::onDataNotFound(const boost::shared_ptr<const Name> &prefix,
+                                     const boost::shared_ptr<const Interest> &interest,
+                                     Face &face, uint64_t interestFilterId,
+                                     const boost::shared_ptr<const InterestFilter> &filter)
+{
+    if (satisfyInterest(interest, face))
+        return;
+
+    storePendingInterest(interest, face);
+    onPendingInterest(interest);
+}
+
+bool MediaStreamBase::satisfyInterest(const boost::shared_ptr<const Interest> &interest,
+                                      Face &face)
+{
+    return sampleCache_->satisfy(*interest, face);
+}
+
+void MediaStreamBase::storePendingInterest(const boost::shared_ptr<const Interest> &interest,
+                                           Face &face)
+{
+    if (!sampleCache_->storePendingInterest(interest, face))
+        cache_->storePendingInterest(interest, face);
+}
+
 statistics::StatisticsStorage
 MediaStreamBase::getStatistics() const
 {
@@ -120,7 +156,7 @@ void MediaStreamBase::publishMeta()
         boost::static_pointer_cast<MediaStreamBase>(shared_from_this());
 
     async::dispatchAsync(settings_.faceIo_, [me, metaName, meta]() {
-        me->metadataPublisher_->publish(metaName, *meta);
+        me->metadataPublisher_->publishAsync(metaName, *meta, -1, false, false);
     });
 }
 
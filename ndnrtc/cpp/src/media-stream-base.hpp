@@ -19,6 +19,9 @@
 namespace ndn
 {
 class MemoryContentCache;
+class Interest;
+class InterestFilter;
+class Face;
 }
 
 namespace ndnrtc
@@ -80,6 +83,11 @@ class MediaStreamBase : public NdnRtcComponent,
     std::string basePrefix_;
     ndn::Name streamPrefix_;
     boost::shared_ptr<ndn::MemoryContentCache> cache_;
+    // samples' segments are kept apart from metadata and manifests, in the
+    // cache that shares segments' wire encoding and is indexed by sequence
+    // numbers
+    boost::shared_ptr<SampleCache> sampleCache_;
+    boost::shared_ptr<SigningPool> signingPool_;
     boost::shared_ptr<CommonPacketPublisher> metadataPublisher_;
     boost::shared_ptr<statistics::StatisticsStorage> statStorage_;
     boost::shared_ptr<StorageEngine> storage_;
@@ -91,6 +99,35 @@ class MediaStreamBase : public NdnRtcComponent,
     void publishMeta();
     unsigned int periodicInvocation();
     virtual bool updateMeta() = 0;
+
+    /**
+     * Called on face thread for every incoming interest that couldn't be
+     * satisfied from the cache. Interest is stored as pending by the time 
+     * this is called, so any data published in response will satisfy it.
+     */
+    virtual void onPendingInterest(const boost::shared_ptr<const ndn::Interest> &interest) {}
+
+    /**
+     * Called on face thread for every incoming interest that couldn't be
+     * satisfied from the generic cache. By default, answers it from the
+     * sample cache.
+     * @return true if interest was answered
+     */
+    virtual bool satisfyInterest(const boost::shared_ptr<const ndn::Interest> &interest,
+                                 ndn::Face &face);
+
+    /**
+     * Stores interest that couldn't be satisfied as pending. Interests for
+     * samples are stored in the sample cache, the rest - in the generic cache.
+     */
+    virtual void storePendingInterest(const boost::shared_ptr<const ndn::Interest> &interest,
+                                      ndn::Face &face);
+
+  private:
+    void onDataNotFound(const boost::shared_ptr<const ndn::Name> &prefix,
+                        const boost::shared_ptr<const ndn::Interest> &interest,
+                        ndn::Face &face, uint64_t interestFilterId,
+                        const boost::shared_ptr<const ndn::InterestFilter> &filter);
 };
 }
 
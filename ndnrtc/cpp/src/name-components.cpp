@@ -71,7 +71,11 @@ NamespaceInfo::getPrefix(int filter) const
                 streamType_ == MediaStreamParams::MediaStreamType::MediaStreamTypeVideo)
                     prefix.append((class_ == SampleClass::Delta ? NameComponents::NameComponentDelta : NameComponents::NameComponentKey));
             if (filter&(Sample^Thread))
+            {
+                if (hasTemporalLayer_)
+                    prefix.append(Name::Component::fromNumber(temporalLayer_));
                 prefix.appendSequenceNumber(sampleNo_);
+            }
 
             if (filter&(Segment^Sample))
             {
@@ -121,7 +125,11 @@ NamespaceInfo::getSuffix(int filter) const
             if (isMeta_)
                 suffix.appendVersion(metaVersion_);
             else
+            {
+                if (hasTemporalLayer_)
+                    suffix.append(Name::Component::fromNumber(temporalLayer_));
                 suffix.appendSequenceNumber(sampleNo_);
+            }
         }
         if (filter&(Segment) && hasSegNo_)
         {
@@ -183,6 +191,27 @@ NameComponents::videoStreamPrefix(string basePrefix)
     return streamPrefix(MediaStreamParams::MediaStreamType::MediaStreamTypeVideo, basePrefix);
 }
 
+unsigned int
+NameComponents::temporalLayer(unsigned int gopPos, unsigned int nLayers)
+{
+    if (nLayers <= 1)
+        return 0;
+
+    unsigned int pos = gopPos % (1 << (nLayers - 1));
+    unsigned int layer = nLayers - 1;
+
+    if (pos == 0)
+        return 0;
+
+    // the lower the layer, the more times position is divisible by 2
+    while (pos % 2 == 0)
+    {
+        pos /= 2;
+        layer--;
+    }
+    return layer;
+}
+
 //******************************************************************************
 bool extractMeta(const ndn::Name& name, NamespaceInfo& info)
 {
@@ -259,6 +288,15 @@ bool extractVideoStreamInfo(const ndn::Name& name, NamespaceInfo& info)
             info.class_ = (info.isDelta_ ? SampleClass::Delta : SampleClass::Key);
 
             try{
+                // example: name == camera/%FC%00%00%01c_%27%DE%D6/hi/d/%02/%FE%07/%00%00
+                if (info.isDelta_ && name.size() > idx && !name[idx].isSequenceNumber() &&
+                    name[idx] != Name::Component(NameComponents::NameComponentParity) &&
+                    name[idx] != Name::Component(NameComponents::NameComponentManifest))
+                {
+                    info.hasTemporalLayer_ = true;
+                    info.temporalLayer_ = (unsigned int)name[idx++].toNumber();
+                }
+
                 if (name.size() > idx)
                     info.sampleNo_ = (PacketNumber)name[idx++].toSequenceNumber();
                 else
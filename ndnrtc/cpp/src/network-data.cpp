@@ -10,6 +10,7 @@
 #include <ndn-cpp/data.hpp>
 #include <ndn-cpp/interest.hpp>
 #include "fec.hpp"
+#include "name-components.hpp"
 
 using namespace ndnrtc;
 using namespace std;
@@ -40,6 +41,67 @@ bool Manifest::hasData(const ndn::Data &data) const
     return false;
 }
 
+//******************************************************************************
+AggregatedManifest::AggregatedManifest(PacketNumber windowNo,
+                                       const std::vector<boost::shared_ptr<const ndn::Data>> &dataObjects)
+    : DataPacket(digestsPayload(dataObjects), wireLength(sizeof(windowNo)))
+{
+    addBlob(sizeof(windowNo), (uint8_t *)&windowNo);
+}
+
+AggregatedManifest::AggregatedManifest(NetworkData &&nd) : DataPacket(boost::move(nd))
+{
+    isValid_ = (blobs_.size() == 1 && blobs_[0].size() == sizeof(PacketNumber) &&
+                getPayload().size() % ndn_SHA256_DIGEST_SIZE == 0);
+}
+
+PacketNumber AggregatedManifest::getWindowNo() const
+{
+    return *(PacketNumber *)blobs_[0].data();
+}
+
+bool AggregatedManifest::hasData(const ndn::Data &data) const
+{
+    ndn::Blob digest = (*data.getFullName())[-1].getValue();
+    Blob payload = getPayload();
+
+    if (digest.size() != ndn_SHA256_DIGEST_SIZE)
+        return false;
+
+    for (const uint8_t *d = payload.data(); d < payload.data() + payload.size(); d += ndn_SHA256_DIGEST_SIZE)
+        if (memcmp(d, digest.buf(), ndn_SHA256_DIGEST_SIZE) == 0)
+            return true;
+    return false;
+}
+
+size_t AggregatedManifest::size() const
+{
+    return getPayload().size() / ndn_SHA256_DIGEST_SIZE;
+}
+
+std::vector<uint8_t>
+AggregatedManifest::digestsPayload(const std::vector<boost::shared_ptr<const ndn::Data>> &dataObjects)
+{
+    std::vector<uint8_t> digests;
+    digests.reserve(dataObjects.size() * ndn_SHA256_DIGEST_SIZE);
+
+    for (auto &d : dataObjects)
+    {
+        ndn::Blob digest = (*d->getFullName())[-1].getValue();
+        digests.insert(digests.end(), digest.buf(), digest.buf() + digest.size());
+    }
+
+    return digests;
+}
+
+ndn::Name AggregatedManifest::windowName(const ndn::Name &threadPrefix, PacketNumber windowNo)
+{
+    return ndn::Name(threadPrefix)
+        .append(NameComponents::NameComponentDelta)
+        .append(NameComponents::NameComponentManifest)
+        .appendSequenceNumber(windowNo);
+}
+
 //******************************************************************************
 AudioThreadMeta::AudioThreadMeta(double rate, uint64_t bundleNo, const std::string &codec)
     : DataPacket(std::vector<uint8_t>())
@@ -79,8 +141,12 @@ AudioThreadMeta::getCodec() const
 
 //******************************************************************************
 VideoThreadMeta::VideoThreadMeta(double rate, PacketNumber deltaSeqNo, PacketNumber keySeqNo,
-                                 unsigned char gopPos, const FrameSegmentsInfo &segInfo, const VideoCoderParams &coder)
-    : DataPacket(std::vector<uint8_t>())
+                                 unsigned char gopPos, const FrameSegmentsInfo &segInfo, const VideoCoderParams &coder,
+                                 double deltaParityRatio, double keyParityRatio,
+                                 unsigned int fecGroupSize, unsigned int manifestWindow,
+                                 bool dormant)
+    : DataPacket(parityInfoPayload(deltaParityRatio, keyParityRatio, fecGroupSize, manifestWindow,
+                                   coder.temporalLayers_, dormant))
 {
     Meta m({rate, deltaSeqNo, keySeqNo, gopPos,
             coder.gop_, coder.startBitrate_, coder.encodeWidth_, coder.encodeHeight_,
@@ -119,6 +185,67 @@ FrameSegmentsInfo VideoThreadMeta::getSegInfo() const
                               m->keyAvgSegNum_, m->keyAvgParitySegNum_});
 }
 
+std::vector<uint8_t> VideoThreadMeta::parityInfoPayload(double deltaParityRatio, double keyParityRatio,
+                                                        unsigned int fecGroupSize, unsigned int manifestWindow,
+                                                        unsigned int temporalLayers, bool dormant)
+{
+    ParityInfo p({deltaParityRatio, keyParityRatio, fecGroupSize, manifestWindow, temporalLayers,
+                  (uint8_t)dormant});
+    return std::vector<uint8_t>((uint8_t *)&p, (uint8_t *)&p + sizeof(p));
+}
+
+pair<double, double> VideoThreadMeta::getParityRatio() const
+{
+    Blob payload = getPayload();
+
+    if (payload.size() < offsetof(ParityInfo, fecGroupSize_))
+        return make_pair(0., 0.);
+
+    ParityInfo *p = (ParityInfo *)payload.data();
+    double deltaParityRatio = p->deltaParityRatio_, keyParityRatio = p->keyParityRatio_;
+    return make_pair(deltaParityRatio, keyParityRatio);
+}
+
+unsigned int VideoThreadMeta::getFecGroupSize() const
+{
+    Blob payload = getPayload();
+
+    if (payload.size() < offsetof(ParityInfo, manifestWindow_))
+        return 0;
+
+    return ((ParityInfo *)payload.data())->fecGroupSize_;
+}
+
+unsigned int VideoThreadMeta::getManifestWindow() const
+{
+    Blob payload = getPayload();
+
+    if (payload.size() < offsetof(ParityInfo, temporalLayers_))
+        return 0;
+
+    return ((ParityInfo *)payload.data())->manifestWindow_;
+}
+
+unsigned int VideoThreadMeta::getTemporalLayers() const
+{
+    Blob payload = getPayload();
+
+    if (payload.size() < offsetof(ParityInfo, dormant_))
+        return 1;
+
+    return ((ParityInfo *)payload.data())->temporalLayers_;
+}
+
+bool VideoThreadMeta::isDormant() const
+{
+    Blob payload = getPayload();
+
+    if (payload.size() < sizeof(ParityInfo))
+        return false;
+
+    return ((ParityInfo *)payload.data())->dormant_ != 0;
+}
+
 VideoCoderParams VideoThreadMeta::getCoderParams() const
 {
     Meta *m = (Meta *)blobs_[0].data();
@@ -127,6 +254,7 @@ VideoCoderParams VideoThreadMeta::getCoderParams() const
     c.startBitrate_ = m->bitrate_;
     c.encodeWidth_ = m->width_;
     c.encodeHeight_ = m->height_;
+    c.temporalLayers_ = getTemporalLayers();
     return c;
 }
 
@@ -199,7 +327,8 @@ MediaStreamMeta::getStreamTimestamp() const
 WireSegment::WireSegment(const boost::shared_ptr<ndn::Data> &data,
                          const boost::shared_ptr<const ndn::Interest> &interest)
     : data_(data), interest_(interest),
-      isValid_(NameComponents::extractInfo(data->getName(), dataNameInfo_))
+      isValid_(NameComponents::extractInfo(data->getName(), dataNameInfo_)),
+      isRecovered_(false)
 {
     if (dataNameInfo_.apiVersion_ != NameComponents::nameApiVersion())
     {
@@ -210,12 +339,15 @@ WireSegment::WireSegment(const boost::shared_ptr<ndn::Data> &data,
            << std::endl;
         throw std::runtime_error(ss.str());
     }
+
+    parseSegment();
 }
 
 WireSegment::WireSegment(const NamespaceInfo &info,
                          const boost::shared_ptr<ndn::Data> &data,
                          const boost::shared_ptr<const ndn::Interest> &interest)
-    : dataNameInfo_(info), data_(data), interest_(interest), isValid_(true)
+    : dataNameInfo_(info), data_(data), interest_(interest), isValid_(true),
+      isRecovered_(false)
 {
     if (dataNameInfo_.apiVersion_ != NameComponents::nameApiVersion())
     {
@@ -224,10 +356,14 @@ WireSegment::WireSegment(const NamespaceInfo &info,
            << "unsupported namespace API version: " << dataNameInfo_.apiVersion_ << std::endl;
         throw std::runtime_error(ss.str());
     }
+
+    parseSegment();
 }
 
 WireSegment::WireSegment(const WireSegment &data) : data_(data.data_),
-                                                    dataNameInfo_(data.dataNameInfo_), isValid_(data.isValid_) {}
+                                                    dataNameInfo_(data.dataNameInfo_), isValid_(data.isValid_),
+                                                    isRecovered_(data.isRecovered_),
+                                                    segment_(data.segment_), header_(data.header_) {}
 
 size_t WireSegment::getSlicesNum() const
 {
@@ -237,11 +373,12 @@ size_t WireSegment::getSlicesNum() const
 const DataSegmentHeader
 WireSegment::header() const
 {
-    // this cast will be invalid for VideoFrameSegment packets,
-    // still casting to DataSegmentHeader is possible, because
-    // it's a parent class for VideoFrameSegmentHeader
-    ImmutableHeaderPacket<DataSegmentHeader> s(data_->getContent());
-    return s.getHeader();
+    // for VideoFrameSegment packets this points to VideoFrameSegmentHeader,
+    // which is a child class of DataSegmentHeader
+    if (!header_)
+        throw std::runtime_error("Segment has no valid header");
+
+    return *header_;
 }
 
 const CommonHeader
@@ -251,9 +388,8 @@ WireSegment::packetHeader() const
         throw std::runtime_error("Accessing packet header in "
                                  "non-zero segment is not allowed");
 
-    ImmutableHeaderPacket<DataSegmentHeader> s0(data_->getContent());
-    boost::shared_ptr<std::vector<uint8_t>> data(boost::make_shared<std::vector<uint8_t>>(s0.getPayload().begin(),
-                                                                                          s0.getPayload().end()));
+    boost::shared_ptr<std::vector<uint8_t>> data(boost::make_shared<std::vector<uint8_t>>(segment_->getPayload().begin(),
+                                                                                          segment_->getPayload().end()));
     ImmutableHeaderPacket<CommonHeader> p0(data);
     return p0.getHeader();
 }
@@ -267,6 +403,25 @@ bool WireSegment::isOriginal() const
     return header().interestNonce_ == *(uint32_t *)(interest_->getNonce().buf());
 }
 
+void WireSegment::parseSegment()
+{
+    // same choice of segment header as in WireSegment::createSegment()
+    if (dataNameInfo_.streamType_ == MediaStreamParams::MediaStreamType::MediaStreamTypeVideo &&
+        (dataNameInfo_.segmentClass_ == SegmentClass::Data || dataNameInfo_.segmentClass_ == SegmentClass::Parity))
+        setSegment(boost::make_shared<const ImmutableHeaderPacket<VideoFrameSegmentHeader>>(data_->getContent()));
+    else
+        setSegment(boost::make_shared<const ImmutableHeaderPacket<DataSegmentHeader>>(data_->getContent()));
+}
+
+void WireSegment::findCommonHeader()
+{
+    // segment header type does not match the data - see whether it has
+    // at least a common DataSegmentHeader. data content storage is kept
+    // alive by segment_, so the header pointer stays valid
+    ImmutableHeaderPacket<DataSegmentHeader> s(data_->getContent());
+    header_ = (s.isValid() ? &s.getHeader() : nullptr);
+}
+
 double 
 WireSegment::getShareSize(unsigned int nDataSlices) const
 {
@@ -7,7 +7,9 @@
 #ifndef __network_data_hpp__
 #define __network_data_hpp__
 
+#include <cstring>
 #include <boost/crc.hpp>
+#include <boost/make_shared.hpp>
 #include <boost/move/move.hpp>
 #include <boost/shared_ptr.hpp>
 #include <boost/type_traits.hpp>
@@ -55,35 +57,39 @@ struct Immutable
      * It is intentional by design, that incoming packets are immutable. Internal storage
      * is a smart pointer to a vector of bytes. This allows for ImmutableNetworkData objects
      * to be leightweight when copied or passed by values.
+     * Mutable storage may keep unused bytes (headroom) in front of the packet
+     * bytes. Derived classes use it to prepend data without moving the packet
+     * payload. Use getData()/getLength() or begin()/end() to access packet bytes.
      */
 template <typename T = Mutable>
 class NetworkDataT
 {
   public:
     ENABLE_IF(T, Immutable)
-    NetworkDataT(const boost::shared_ptr<const std::vector<uint8_t>> &data) : data_(data) {}
+    NetworkDataT(const boost::shared_ptr<const std::vector<uint8_t>> &data) : data_(data), offset_(0) {}
 
     ENABLE_IF(T, Mutable)
-    NetworkDataT(unsigned int dataLength, const uint8_t *rawData) : isValid_(true)
+    NetworkDataT(unsigned int dataLength, const uint8_t *rawData) : isValid_(true), offset_(0)
     {
         copyFromRaw(dataLength, rawData);
     }
 
     ENABLE_IF(T, Mutable)
-    NetworkDataT(const std::vector<uint8_t> &data) : isValid_(true), data_(data) {}
+    NetworkDataT(const std::vector<uint8_t> &data) : isValid_(true), data_(data), offset_(0) {}
 
     ENABLE_IF(T, Mutable)
-    NetworkDataT(const NetworkDataT &data) : data_(data.data_), isValid_(data.isValid_) {}
+    NetworkDataT(const NetworkDataT &data) : data_(data.data_), isValid_(data.isValid_), offset_(data.offset_) {}
 
     ENABLE_IF(T, Mutable)
-    NetworkDataT(NetworkDataT &&data) : isValid_(data.isValid())
+    NetworkDataT(NetworkDataT &&data) : isValid_(data.isValid()), offset_(data.offset_)
     {
         data_.swap(data.data_);
         data.isValid_ = false;
+        data.offset_ = 0;
     }
 
     ENABLE_IF(T, Mutable)
-    NetworkDataT(std::vector<uint8_t> &data) : data_(boost::move(data)), isValid_(true) {}
+    NetworkDataT(std::vector<uint8_t> &data) : data_(boost::move(data)), isValid_(true), offset_(0) {}
 
     virtual ~NetworkDataT() {}
 
@@ -91,19 +97,40 @@ class NetworkDataT
      * Returns packet payload size in bytes
      */
     virtual int
-    getLength() const { return _data().size(); }
+    getLength() const { return _data().size() - offset_; }
 
     /**
      * Returns const pointer to the packet payload
      */
     const uint8_t *
-    getData() const { return _data().data(); }
+    getData() const { return _data().data() + offset_; }
+
+    /**
+     * Returns const iterators to the first and past-the-last bytes of the
+     * packet payload
+     */
+    std::vector<uint8_t>::const_iterator
+    begin() const { return _data().begin() + offset_; }
+
+    std::vector<uint8_t>::const_iterator
+    end() const { return _data().end(); }
 
     /**
          * Returns payload as const vector of bytes
          */
-    const std::vector<uint8_t> &data() const
+    ENABLE_IF(T, Immutable)
+    const std::vector<uint8_t> &data() const { return _data(); }
+
+    /**
+         * Returns payload as const vector of bytes
+         * If packet has unused headroom, it is released first, which requires
+         * moving the whole packet. Prefer getData() and getLength().
+         */
+    ENABLE_IF(T, Mutable)
+    const std::vector<uint8_t> &data()
     {
+        if (offset_)
+            releaseHeadroom();
         return _data();
     }
 
@@ -122,6 +149,7 @@ class NetworkDataT
         {
             data_ = networkData.data_;
             isValid_ = networkData.isValid_;
+            offset_ = networkData.offset_;
         }
 
         return *this;
@@ -134,6 +162,7 @@ class NetworkDataT
     swap(NetworkDataT &networkData)
     {
         std::swap(isValid_, networkData.isValid_);
+        std::swap(offset_, networkData.offset_);
         data_.swap(networkData.data_);
     }
 
@@ -145,13 +174,19 @@ class NetworkDataT
     getCrcValue() const
     {
         boost::crc_16_type crc_computer_;
-        crc_computer_ = std::for_each(data_.begin(), data_.end(), crc_computer_);
+        crc_computer_ = std::for_each(begin(), end(), crc_computer_);
         return crc_computer_();
     }
 
   protected:
     bool isValid_;
     typename T::storage data_;
+    size_t offset_; // headroom size, always 0 for immutable data
+
+    /**
+     * Called after packet bytes were moved within the storage
+     */
+    virtual void onRelocated() {}
 
     ENABLE_IF(T, Immutable)
     const std::vector<uint8_t> &_data(ENABLE_FOR(Immutable)) const
@@ -177,6 +212,17 @@ class NetworkDataT
     {
         data_.assign(rawData, rawData + dataLength);
     }
+
+    ENABLE_IF(T, Immutable)
+    void releaseHeadroom(ENABLE_FOR(Immutable)) {}
+
+    ENABLE_IF(T, Mutable)
+    void releaseHeadroom(ENABLE_FOR(Mutable))
+    {
+        data_.erase(data_.begin(), data_.begin() + offset_);
+        offset_ = 0;
+        onRelocated();
+    }
 };
 
 typedef NetworkDataT<Immutable> ImmutableNetworkData;
@@ -191,6 +237,13 @@ typedef NetworkDataT<> NetworkData;
  *
  *      <#_of_blobs>[<blob_size_byte0><blob_size_byte1><blob>]*<payload_bytes>+
  *
+ * Mutable packets, created with payload, reserve headroom in front of the
+ * packet for blobs. Blobs are written right before the payload, shifting only
+ * previously added blobs into the headroom, so the payload is never moved
+ * (unless headroom is exhausted, in which case it is grown geometrically).
+ * Packets without payload simply append blobs at the end. Thus, adding a blob
+ * costs time independent of the payload size and doesn't require re-parsing
+ * the packet.
  */
 template <typename T = Mutable>
 class DataPacketT : public NetworkDataT<T>
@@ -245,7 +298,8 @@ class DataPacketT : public NetworkDataT<T>
 
     DataPacketT(const DataPacketT<T> &dataPacket) : NetworkDataT<T>(dataPacket.data_)
     {
-        this->reinit();
+        this->offset_ = dataPacket.offset_;
+        copyParsed(dataPacket);
     }
 
     ENABLE_IF(T, Immutable)
@@ -255,18 +309,23 @@ class DataPacketT : public NetworkDataT<T>
         this->reinit();
     }
 
+    /**
+     * Creates packet with a copy of the payload and reserves headroom bytes
+     * in front of it for the blobs that will be added later.
+     * @see wireLength(std::vector<size_t>)
+     */
     ENABLE_IF(T, Mutable)
-    DataPacketT(unsigned int dataLength, const uint8_t *payload) : NetworkDataT<T>(dataLength, payload)
+    DataPacketT(unsigned int dataLength, const uint8_t *payload,
+                size_t headroom = 0) : NetworkDataT<T>(std::vector<uint8_t>())
     {
-        this->_data().insert(this->_data().begin(), 0);
-        payloadBegin_ = this->_data().begin() + 1;
+        initPayload(dataLength, payload, headroom);
     }
 
     ENABLE_IF(T, Mutable)
-    DataPacketT(const std::vector<uint8_t> &payload) : NetworkDataT<T>(payload)
+    DataPacketT(const std::vector<uint8_t> &payload,
+                size_t headroom = 0) : NetworkDataT<T>(std::vector<uint8_t>())
     {
-        this->_data().insert(this->_data().begin(), 0);
-        payloadBegin_ = this->_data().begin() + 1;
+        initPayload(payload.size(), payload.data(), headroom);
     }
 
     ENABLE_IF(T, Mutable)
@@ -290,6 +349,7 @@ class DataPacketT : public NetworkDataT<T>
     void swap(DataPacketT<T> &dataPacket)
     {
         this->data_.swap(dataPacket.data_);
+        std::swap(this->offset_, dataPacket.offset_);
         this->reinit();
         dataPacket.reinit();
     }
@@ -353,14 +413,14 @@ class DataPacketT : public NetworkDataT<T>
     virtual void reinit()
     {
         blobs_.clear();
-        if (!this->_data().size())
+        if (!this->getLength())
         {
             this->isValid_ = false;
             return;
         }
 
-        typename T::payload_iter p1 = (this->_data().begin() + 1), p2;
-        uint8_t nBlobs = this->_data()[0];
+        typename T::payload_iter p1 = (this->_data().begin() + this->offset_ + 1), p2;
+        uint8_t nBlobs = this->_data()[this->offset_];
         bool invalid = false;
 
         for (int i = 0; i < nBlobs; i++)
@@ -385,22 +445,105 @@ class DataPacketT : public NetworkDataT<T>
             this->isValid_ = false;
     }
 
+    void onRelocated() override
+    {
+        reinit();
+    }
+
     ENABLE_IF(T, Mutable)
     void addBlob(uint16_t dataLength, const uint8_t *data)
     {
         if (dataLength == 0)
             return;
 
-        // increase blob counter
-        this->_data()[0]++;
-        // save blob size
-        uint8_t b1 = dataLength & 0x00ff, b2 = (dataLength & 0xff00) >> 8;
-        payloadBegin_ = this->_data().insert(payloadBegin_, b1);
-        payloadBegin_++;
-        payloadBegin_ = this->_data().insert(payloadBegin_, b2);
-        payloadBegin_++;
-        // insert blob
-        this->_data().insert(payloadBegin_, data, data + dataLength);
+        memcpy(allocateBlob(dataLength), data, dataLength);
+    }
+
+    /**
+     * Adds new blob of given length to the packet and returns pointer to the
+     * blob's bytes, which shall be written by the caller. The pointer is valid
+     * until the next blob is added.
+     */
+    ENABLE_IF(T, Mutable)
+    uint8_t *allocateBlob(uint16_t dataLength)
+    {
+        size_t blobWireLength = DataPacketT<T>::wireLength(dataLength);
+
+        if (payloadBegin_ == this->_data().end())
+        {
+            // no payload - blob goes to the end of the packet
+            const uint8_t *storage = this->_data().data();
+            size_t blobOffset = this->_data().size();
+
+            this->_data().resize(blobOffset + blobWireLength);
+            if (this->_data().data() != storage)
+                this->reinit();
+            payloadBegin_ = this->_data().end();
+            blobs_.push_back(Blob(payloadBegin_ - dataLength, payloadBegin_));
+        }
+        else
+        {
+            if (this->offset_ < blobWireLength)
+                growHeadroom(blobWireLength);
+
+            // move existing blobs (and blob counter) into the headroom
+            uint8_t *headerBegin = this->_data().data() + this->offset_;
+            size_t headerLength = (payloadBegin_ - this->_data().begin()) - this->offset_;
+
+            memmove(headerBegin - blobWireLength, headerBegin, headerLength);
+            this->offset_ -= blobWireLength;
+            for (auto &b : blobs_)
+                b = Blob(b.begin() - blobWireLength, b.end() - blobWireLength);
+            blobs_.push_back(Blob(payloadBegin_ - dataLength, payloadBegin_));
+        }
+
+        // increase blob counter and save blob size
+        uint8_t *blobSize = &(*(payloadBegin_ - blobWireLength));
+        this->_data()[this->offset_]++;
+        blobSize[0] = dataLength & 0x00ff;
+        blobSize[1] = (dataLength & 0xff00) >> 8;
+
+        return blobSize + 2;
+    }
+
+  private:
+    // immutable packets share storage, so parsed blobs can be copied as is
+    ENABLE_IF(T, Immutable)
+    void copyParsed(const DataPacketT<T> &dataPacket)
+    {
+        this->isValid_ = dataPacket.isValid_;
+        blobs_ = dataPacket.blobs_;
+        payloadBegin_ = dataPacket.payloadBegin_;
+    }
+
+    ENABLE_IF(T, Mutable)
+    void copyParsed(const DataPacketT<T> &dataPacket)
+    {
+        this->reinit();
+    }
+
+    ENABLE_IF(T, Mutable)
+    void initPayload(unsigned int dataLength, const uint8_t *payload, size_t headroom)
+    {
+        // no point in reserving headroom when there is no payload
+        this->offset_ = (dataLength ? headroom : 0);
+        this->_data().resize(this->offset_ + 1 + dataLength);
+        this->_data()[this->offset_] = 0;
+        if (dataLength)
+            memcpy(this->_data().data() + this->offset_ + 1, payload, dataLength);
+        payloadBegin_ = this->_data().begin() + this->offset_ + 1;
+    }
+
+    ENABLE_IF(T, Mutable)
+    void growHeadroom(size_t minHeadroom)
+    {
+        size_t headerLength = (payloadBegin_ - this->_data().begin()) - this->offset_;
+        size_t headroom = 2 * (minHeadroom + headerLength);
+        std::vector<uint8_t> storage(headroom + this->getLength());
+
+        memcpy(storage.data() + headroom, this->getData(), this->getLength());
+        this->_data().swap(storage);
+        this->offset_ = headroom;
         this->reinit();
     }
 };
@@ -429,17 +572,26 @@ class HeaderPacketT : public DataPacketT<T>
         this->isValid_ = isHeaderSet_;
     }
 
+    /**
+     * By default, headroom is reserved only for the header. Derived classes
+     * that add more blobs shall reserve more.
+     */
     ENABLE_IF(T, Mutable)
-    HeaderPacketT(unsigned int dataLength, const uint8_t *payload) : DataPacketT<T>(dataLength, payload),
-                                                                     isHeaderSet_(false) { this->isValid_ = false; }
+    HeaderPacketT(unsigned int dataLength, const uint8_t *payload,
+                  size_t headroom = DataPacketT<T>::wireLength(sizeof(Header)))
+        : DataPacketT<T>(dataLength, payload, headroom),
+          isHeaderSet_(false) { this->isValid_ = false; }
 
     ENABLE_IF(T, Mutable)
-    HeaderPacketT(const std::vector<uint8_t> &payload) : DataPacketT<T>(payload),
-                                                         isHeaderSet_(false) { this->isValid_ = false; }
+    HeaderPacketT(const std::vector<uint8_t> &payload,
+                  size_t headroom = DataPacketT<T>::wireLength(sizeof(Header)))
+        : DataPacketT<T>(payload, headroom),
+          isHeaderSet_(false) { this->isValid_ = false; }
 
     ENABLE_IF(T, Mutable)
     HeaderPacketT(const Header &header, unsigned int dataLength,
-                  const uint8_t *payload) : DataPacketT<T>(dataLength, payload),
+                  const uint8_t *payload) : DataPacketT<T>(dataLength, payload,
+                                                           DataPacketT<T>::wireLength(sizeof(Header))),
                                             isHeaderSet_(false)
     {
         setHeader(header);
@@ -460,15 +612,14 @@ class HeaderPacketT : public DataPacketT<T>
     {
     
 	//liupenghui,  for audio sample fetching... 	
+        // audio bundles may set header more than once, only the first one is
+        // kept
         if (!isHeaderSet_)
         {
             this->addBlob(sizeof(header), (uint8_t *)&header);
             this->isValid_ = true;
             isHeaderSet_ = true;
         }
-        else
-          //  throw std::runtime_error("Sample header has been already "
-          //                           "added to the packet");
     }
 
     const Header &getHeader() const
@@ -486,8 +637,8 @@ class HeaderPacketT : public DataPacketT<T>
     bool isHeaderSet() const { return isHeaderSet_; }
     void clear()
     {
-        this->_data().clear();
-        this->_data().insert(this->_data().begin(), 0);
+        this->_data().assign(1, 0);
+        this->offset_ = 0;
         this->payloadBegin_ = this->_data().begin() + 1;
         this->blobs_.clear();
         isHeaderSet_ = false;
@@ -566,6 +717,48 @@ class Manifest : public DataPacket
     size_t size() const { return blobs_.size(); }
 };
 
+/**
+ * Aggregated manifest covers all segments of a window of consecutive delta
+ * frames of a thread. Delta frame with sequence number N belongs to the window
+ * number N / <window size>. Manifest is published once the last frame of the
+ * window is published, under <thread>/d/_manifest/<window number>/<version>,
+ * thus producer signs and consumer fetches one manifest per window instead of
+ * one per frame. If frames of a published window get more segments (parity
+ * computed on request), window is published again with a newer version.
+ * Unlike Manifest, digests are stored as payload, so the number of covered
+ * data objects is not limited by the number of blobs.
+ */
+class AggregatedManifest : public DataPacket
+{
+  public:
+    AggregatedManifest(PacketNumber windowNo,
+                       const std::vector<boost::shared_ptr<const ndn::Data>> &dataObjects);
+    AggregatedManifest(NetworkData &&nd);
+
+    PacketNumber getWindowNo() const;
+
+    /**
+     * Checks whether given data object is a part of this manifest
+     */
+    bool hasData(const ndn::Data &data) const;
+
+    /**
+     * Returns total number of data objects described by this manifest
+     */
+    size_t size() const;
+
+    static PacketNumber windowNo(PacketNumber seqNo, unsigned int windowSize)
+    {
+        return seqNo / windowSize;
+    }
+
+    static ndn::Name windowName(const ndn::Name &threadPrefix, PacketNumber windowNo);
+
+  private:
+    static std::vector<uint8_t>
+    digestsPayload(const std::vector<boost::shared_ptr<const ndn::Data>> &dataObjects);
+};
+
 //******************************************************************************
 class AudioThreadMeta : public DataPacket
 {
@@ -583,7 +776,10 @@ class VideoThreadMeta : public DataPacket
   public:
     VideoThreadMeta(double rate, PacketNumber deltaSeqNo, PacketNumber keySeqNo,
                     unsigned char gopPos,
-                    const FrameSegmentsInfo &segInfo, const VideoCoderParams &coder);
+                    const FrameSegmentsInfo &segInfo, const VideoCoderParams &coder,
+                    double deltaParityRatio = 0, double keyParityRatio = 0,
+                    unsigned int fecGroupSize = 0, unsigned int manifestWindow = 0,
+                    bool dormant = false);
     VideoThreadMeta(NetworkData &&data);
 
     double getRate() const;
@@ -592,7 +788,55 @@ class VideoThreadMeta : public DataPacket
     FrameSegmentsInfo getSegInfo() const;
     VideoCoderParams getCoderParams() const;
 
+    /**
+     * Returns current FEC parity ratios for delta (first) and key (second)
+     * frames. Ratios are zero if producer doesn't publish them.
+     */
+    std::pair<double, double> getParityRatio() const;
+
+    /**
+     * Returns number of consecutive delta frames, protected by one FEC group
+     * packet (see fec-group.hpp), or zero if delta frames have per-frame
+     * parity.
+     */
+    unsigned int getFecGroupSize() const;
+
+    /**
+     * Returns number of consecutive delta frames, covered by one aggregated
+     * manifest, or zero if every frame has its own manifest.
+     */
+    unsigned int getManifestWindow() const;
+
+    /**
+     * Returns number of temporal layers of the thread (1 if producer 
+     * doesn't publish it).
+     */
+    unsigned int getTemporalLayers() const;
+
+    /**
+     * Returns true if producer doesn't encode the thread at the moment, as
+     * nobody requested it for a while. Encoding resumes with a key frame once
+     * interests for the thread arrive.
+     */
+    bool isDormant() const;
+
   private:
+    // parity ratios are stored as payload, so that older consumers, which 
+    // don't know about them, could still read metadata; newer fields are
+    // appended, thus payload of older producers is shorter
+    typedef struct _ParityInfo
+    {
+        double deltaParityRatio_, keyParityRatio_;
+        uint32_t fecGroupSize_;
+        uint32_t manifestWindow_;
+        uint32_t temporalLayers_;
+        uint8_t dormant_;
+    } __attribute__((packed)) ParityInfo;
+
+    static std::vector<uint8_t> parityInfoPayload(double deltaParityRatio, double keyParityRatio,
+                                                  unsigned int fecGroupSize, unsigned int manifestWindow,
+                                                  unsigned int temporalLayers, bool dormant);
+
     typedef struct _Meta
     {
         double rate_; // FPS
@@ -673,7 +917,7 @@ class WireSegment
     const NamespaceInfo &getInfo() const { return dataNameInfo_; }
 
     /**
-     * Retrieves segment header from data
+     * Retrieves segment header, parsed from data at construction
      * @return DataSegmentHeader
      */
     const DataSegmentHeader header() const;
@@ -696,6 +940,14 @@ class WireSegment
      */
     bool isOriginal() const;
 
+    /**
+     * Indicates, whether segment was recovered by consumer (i.e. from FEC
+     * group packet) rather than fetched. Such segments are not signed and
+     * are not covered by manifests.
+     */
+    bool isRecovered() const { return isRecovered_; }
+    void setRecovered() { isRecovered_ = true; }
+
     // method implementation in frame-data.cpp
     static boost::shared_ptr<WireSegment>
     createSegment(const NamespaceInfo &namespaceInfo,
@@ -704,13 +956,30 @@ class WireSegment
 
   protected:
     NamespaceInfo dataNameInfo_;
-    bool isValid_;
+    bool isValid_, isRecovered_;
     boost::shared_ptr<ndn::Data> data_;
     boost::shared_ptr<const ndn::Interest> interest_;
+    // data content is parsed only once, at construction
+    boost::shared_ptr<const ImmutableDataPacket> segment_;
+    const DataSegmentHeader *header_;
 
     WireSegment(const NamespaceInfo &info,
                 const boost::shared_ptr<ndn::Data> &data,
                 const boost::shared_ptr<const ndn::Interest> &interest);
+
+    template <typename SegmentHeader>
+    void setSegment(const boost::shared_ptr<const ImmutableHeaderPacket<SegmentHeader>> &segment)
+    {
+        segment_ = segment;
+        if (segment->isValid())
+            header_ = &segment->getHeader();
+        else
+            findCommonHeader();
+    }
+
+  private:
+    void parseSegment();
+    void findCommonHeader();
 };
 
 template <typename SegmentHeader>
@@ -718,12 +987,15 @@ class WireData : public WireSegment
 {
   public:
     WireData(const boost::shared_ptr<ndn::Data> &data,
-             const boost::shared_ptr<const ndn::Interest> &interest) : WireSegment(data, interest) {}
-    WireData(const WireData<SegmentHeader> &data) : WireSegment(data) {}
+             const boost::shared_ptr<const ndn::Interest> &interest) : WireSegment(data, interest)
+    {
+        initSegment();
+    }
+    WireData(const WireData<SegmentHeader> &data) : WireSegment(data), typedSegment_(data.typedSegment_) {}
 
-    const ImmutableHeaderPacket<SegmentHeader> segment() const
+    const ImmutableHeaderPacket<SegmentHeader> &segment() const
     {
-        return ImmutableHeaderPacket<SegmentHeader>(data_->getContent());
+        return *typedSegment_;
     }
 
     PacketNumber getPlaybackNo() const
@@ -739,7 +1011,24 @@ class WireData : public WireSegment
 
     WireData(const NamespaceInfo &info,
              const boost::shared_ptr<ndn::Data> &data,
-             const boost::shared_ptr<const ndn::Interest> &interest) : WireSegment(info, data, interest) {}
+             const boost::shared_ptr<const ndn::Interest> &interest) : WireSegment(info, data, interest)
+    {
+        initSegment();
+    }
+
+    boost::shared_ptr<const ImmutableHeaderPacket<SegmentHeader>> typedSegment_;
+
+    void initSegment()
+    {
+        // segment has been already parsed by WireSegment, unless namespace
+        // suggested different segment header type
+        typedSegment_ = boost::dynamic_pointer_cast<const ImmutableHeaderPacket<SegmentHeader>>(segment_);
+        if (!typedSegment_)
+        {
+            typedSegment_ = boost::make_shared<const ImmutableHeaderPacket<SegmentHeader>>(data_->getContent());
+            setSegment(typedSegment_);
+        }
+    }
 
     ENABLE_IF(SegmentHeader, _DataSegmentHeader)
     PacketNumber playbackNo(ENABLE_FOR(_DataSegmentHeader)) const
@@ -8,8 +8,15 @@
 #ifndef __packet_publisher_h__
 #define __packet_publisher_h__
 
+#include <atomic>
+#include <map>
 #include <boost/shared_ptr.hpp>
+#include <boost/make_shared.hpp>
+#include <boost/enable_shared_from_this.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/lock_guard.hpp>
 #include <ndn-cpp/c/common.h>
+#include <ndn-cpp/face.hpp>
 #include <ndn-cpp/interest.hpp>
 #include <ndn-cpp/security/key-chain.hpp>
 #include <ndn-cpp/util/memory-content-cache.hpp>
@@ -17,8 +24,11 @@
 
 #include <ndn-cpp/key-locator.hpp>
 
+#include "async.hpp"
 #include "frame-data.hpp"
 #include "ndnrtc-object.hpp"
+#include "sample-cache.hpp"
+#include "signing-pool.hpp"
 #include "statistics.hpp"
 
 #define ADD_CRC 0
@@ -38,7 +48,6 @@ class InterestFilter;
 
 namespace ndnrtc
 {
-
 static const size_t MAX_NDN_PACKET_SIZE = 8800;
 
 namespace statistics
@@ -52,12 +61,14 @@ struct _DataSegmentHeader;
 typedef NetworkDataT<Mutable> MutableNetworkData;
 typedef std::vector<boost::shared_ptr<const ndn::Data>> PublishedDataPtrVector;
 typedef boost::function<void(PublishedDataPtrVector)> OnSegmentsCached;
+typedef boost::function<void(const PublishedDataPtrVector &)> OnPublished;
 
 template <typename KeyChain, typename MemoryCache>
 struct _PublisherSettings
 {
     _PublisherSettings() : keyChain_(nullptr), memoryCache_(nullptr),
-                           statStorage_(nullptr) {}
+                           statStorage_(nullptr), signingPool_(nullptr),
+                           faceIo_(nullptr) {}
 
     KeyChain *keyChain_;
     MemoryCache *memoryCache_;
@@ -66,15 +77,97 @@ struct _PublisherSettings
     size_t segmentWireLength_;
     unsigned int freshnessPeriodMs_;
     bool sign_ = true;
+    // whether pending interests, extracted from the sample cache, are
+    // answered with application NACKs or left to time out
+    bool sendNacks_ = false;
+    // if set together with face thread, segments of packets, published
+    // with publishAsync(), are signed in parallel, off face thread
+    SigningPool *signingPool_;
+    boost::asio::io_service *faceIo_;
 };
 
 typedef _PublisherSettings<ndn::KeyChain, ndn::MemoryContentCache> PublisherSettings;
 
+/**
+ * Pool of byte buffers that back content of published data objects.
+ * Buffers are returned to the pool automatically, once the last data
+ * object referencing them (returned by publish()) is released. Buffers
+ * may be returned from any thread. Pool object must be created using
+ * boost::make_shared.
+ */
+class SegmentBufferPool : public boost::enable_shared_from_this<SegmentBufferPool>
+{
+  public:
+    SegmentBufferPool(size_t capacity = 1000) : capacity_(capacity), nAllocated_(0) {}
+    ~SegmentBufferPool()
+    {
+        for (auto b : pool_)
+            delete b;
+    }
+
+    /**
+     * Returns buffer of requested size. Buffer contents are undefined.
+     */
+    boost::shared_ptr<std::vector<uint8_t>> acquire(size_t size)
+    {
+        std::vector<uint8_t> *buffer = nullptr;
+        {
+            boost::lock_guard<boost::mutex> scopedLock(mutex_);
+            if (pool_.size())
+            {
+                buffer = pool_.back();
+                pool_.pop_back();
+            }
+        }
+
+        if (!buffer)
+        {
+            buffer = new std::vector<uint8_t>();
+            ++nAllocated_;
+        }
+
+        buffer->resize(size);
+
+        boost::weak_ptr<SegmentBufferPool> me = shared_from_this();
+        return boost::shared_ptr<std::vector<uint8_t>>(buffer, [me](std::vector<uint8_t> *b) {
+            boost::shared_ptr<SegmentBufferPool> pool = me.lock();
+            if (!pool || !pool->recycle(b))
+                delete b;
+        });
+    }
+
+    size_t capacity() const { return capacity_; }
+    size_t size() const { return pool_.size(); }
+    // total number of buffers allocated by the pool so far
+    size_t allocated() const { return nAllocated_; }
+
+  private:
+    SegmentBufferPool(const SegmentBufferPool &) = delete;
+
+    size_t capacity_;
+    std::atomic<size_t> nAllocated_;
+    boost::mutex mutex_;
+    std::vector<std::vector<uint8_t> *> pool_;
+
+    bool recycle(std::vector<uint8_t> *buffer)
+    {
+        boost::lock_guard<boost::mutex> scopedLock(mutex_);
+        if (pool_.size() < capacity_)
+        {
+            pool_.push_back(buffer);
+            return true;
+        }
+        return false;
+    }
+};
+
 template <typename SegmentType, typename Settings>
 class PacketPublisher : public NdnRtcComponent
 {
   public:
-    PacketPublisher(const Settings &settings) : settings_(settings), fullPitClean_(0)
+    PacketPublisher(const Settings &settings) : settings_(settings), fullPitClean_(0),
+                                                bufferPool_(boost::make_shared<SegmentBufferPool>()),
+                                                nExpectedInterests_(0), nReceivedInterests_(0)
     {
         assert(settings_.keyChain_);
         assert(settings_.memoryCache_);
@@ -89,7 +182,7 @@ class PacketPublisher : public NdnRtcComponent
         // we don't care of bytes that will be saved in this memory, so allocate it
         // as shared_ptr so it's released automatically upon completion
         boost::shared_ptr<uint8_t[]> dummyHeader(new uint8_t[SegmentType::headerSize()]);
-        memset(dummyHeader.get(), SegmentType::headerSize(), 0);
+        memset(dummyHeader.get(), 0, SegmentType::headerSize());
         return publish(name, data, (_DataSegmentHeader &)*dummyHeader.get(),
                        freshnessMs, forcePitClean, banPitClean);
     }
@@ -98,7 +191,117 @@ class PacketPublisher : public NdnRtcComponent
                                    _DataSegmentHeader &commonHeader, int freshnessMs,
                                    bool forcePitClean = false, bool banPitClean = false)
     {
-        PublishedDataPtrVector ndnSegments;
+        std::vector<boost::shared_ptr<ndn::Data>> segments = prepare(name, data, commonHeader, freshnessMs);
+
+        // all segments are signed before any of them is added to the cache,
+        // so they are added in order
+        for (auto segment : segments)
+            sign(segment);
+
+        return cache(name, segments, forcePitClean, banPitClean);
+    }
+
+    /**
+     * Same as publish(), but if signing pool is set, segments are signed
+     * on pool's threads and function returns without waiting for them.
+     * Signed segments are added to the cache on face thread, in the order
+     * packets were published, and then onPublished is called there.
+     * Otherwise, packet is published right away and onPublished is called
+     * before returning. Common header is filled in before returning in
+     * both cases. If segments couldn't be signed, they are not cached and
+     * onPublished gets no segments.
+     */
+    void publishAsync(const ndn::Name &name, const MutableNetworkData &data,
+                      _DataSegmentHeader &commonHeader, int freshnessMs,
+                      bool forcePitClean, bool banPitClean,
+                      const OnPublished &onPublished = OnPublished())
+    {
+        if (!(settings_.sign_ && settings_.signingPool_ && settings_.faceIo_))
+        {
+            PublishedDataPtrVector segments = publish(name, data, commonHeader, freshnessMs,
+                                                      forcePitClean, banPitClean);
+            if (onPublished)
+                onPublished(segments);
+            return;
+        }
+
+        boost::shared_ptr<std::vector<boost::shared_ptr<ndn::Data>>> segments =
+            boost::make_shared<std::vector<boost::shared_ptr<ndn::Data>>>(prepare(name, data, commonHeader, freshnessMs));
+        std::vector<SigningPool::SigningTask> tasks;
+
+        // key chain also encodes signed segment, encoding is reused later
+        for (auto segment : *segments)
+            tasks.push_back([segment](ndn::KeyChain &keyChain) { keyChain.sign(*segment); });
+
+        // publisher may be released while segments are signed
+        boost::weak_ptr<PacketPublisher> wme = boost::static_pointer_cast<PacketPublisher>(shared_from_this());
+        boost::asio::io_service &faceIo = *settings_.faceIo_;
+
+        settings_.signingPool_->submit(tasks, [wme, &faceIo, name, segments, forcePitClean, banPitClean, onPublished](const std::string &error) {
+            async::dispatchAsync(faceIo, [wme, name, segments, forcePitClean, banPitClean, onPublished, error]() {
+                boost::shared_ptr<PacketPublisher> me = wme.lock();
+                if (me)
+                    me->onSigned(name, *segments, error, forcePitClean, banPitClean, onPublished);
+            });
+        });
+    }
+
+    void publishAsync(const ndn::Name &name, const MutableNetworkData &data,
+                      int freshnessMs, bool forcePitClean, bool banPitClean,
+                      const OnPublished &onPublished = OnPublished())
+    {
+        boost::shared_ptr<uint8_t[]> dummyHeader(new uint8_t[SegmentType::headerSize()]);
+        memset(dummyHeader.get(), 0, SegmentType::headerSize());
+        publishAsync(name, data, (_DataSegmentHeader &)*dummyHeader.get(),
+                     freshnessMs, forcePitClean, banPitClean, onPublished);
+    }
+
+    boost::shared_ptr<const SegmentBufferPool> getBufferPool() const { return bufferPool_; }
+
+    /**
+     * Total number of published segments, for which there were expected to
+     * be pending interests, i.e. segments of packets that were requested by 
+     * consumers, up to the highest requested segment.
+     */
+    uint64_t getExpectedInterestsNum() const { return nExpectedInterests_; }
+
+    /**
+     * Total number of published segments, which had pending interests.
+     * Difference with getExpectedInterestsNum() gives number of interests
+     * lost on their way to producer.
+     */
+    uint64_t getReceivedInterestsNum() const { return nReceivedInterests_; }
+
+  private:
+    Settings settings_;
+    unsigned int fullPitClean_;
+    boost::shared_ptr<SegmentBufferPool> bufferPool_;
+    std::atomic<uint64_t> nExpectedInterests_, nReceivedInterests_;
+
+    bool checkForPendingInterests(const ndn::Name &name, _DataSegmentHeader &commonHeader)
+    {
+        std::vector<boost::shared_ptr<const ndn::MemoryContentCache::PendingInterest>> pendingInterests;
+        settings_.memoryCache_->getPendingInterestsForName(name, pendingInterests);
+
+        if (pendingInterests.size())
+        {
+            commonHeader.interestNonce_ = *(uint32_t *)(pendingInterests.back()->getInterest()->getNonce().buf());
+            commonHeader.interestArrivalMs_ = pendingInterests.back()->getTimeoutPeriodStart();
+            commonHeader.generationDelayMs_ = ndn_getNowMilliseconds() - pendingInterests.back()->getTimeoutPeriodStart();
+
+            (*settings_.statStorage_)[statistics::Indicator::InterestsReceivedNum] += pendingInterests.size();
+
+            LogTraceC << "PIT hit " << pendingInterests.back()->getInterest()->toUri() << std::endl;
+        }
+
+        return pendingInterests.size() > 0;
+    }
+
+    std::vector<boost::shared_ptr<ndn::Data>>
+    prepare(const ndn::Name &name, const MutableNetworkData &data,
+            _DataSegmentHeader &commonHeader, int freshnessMs)
+    {
+        std::vector<boost::shared_ptr<ndn::Data>> ndnSegments;
         std::vector<SegmentType> segments = SegmentType::slice(data, settings_.segmentWireLength_);
         LogTraceC << "sliced into " << segments.size() << " segments" << std::endl;
 
@@ -106,7 +309,7 @@ class PacketPublisher : public NdnRtcComponent
         commonHeader.generationDelayMs_ = 0;
         commonHeader.interestArrivalMs_ = 0;
 
-        unsigned int segIdx = 0;
+        unsigned int segIdx = 0, nPitHits = 0, lastPitHitIdx = 0;
         freshnessMs = (freshnessMs == -1 ? settings_.freshnessPeriodMs_ : freshnessMs);
 
         for (auto segment : segments)
@@ -117,25 +320,62 @@ class PacketPublisher : public NdnRtcComponent
             segmentName.append(ndn::Name::Component::fromNumber(segmentData->getCrcValue()));
 #endif
 
-            checkForPendingInterests(segmentName, commonHeader);
+            if (checkForPendingInterests(segmentName, commonHeader))
+            {
+                ++nPitHits;
+                lastPitHitIdx = segIdx;
+            }
             segment.setHeader(commonHeader);
 
-            boost::shared_ptr<MutableNetworkData> segmentData = segment.getNetworkData();
+            // segment is written directly into the buffer, which becomes data
+            // object's content, so building data object does not copy payload
+            // again; SampleCache keeps data's wire encoding as is, while
+            // ndn::MemoryContentCache (used for low-rate metadata and
+            // manifests) stores its own copy
+            boost::shared_ptr<std::vector<uint8_t>> segmentData = bufferPool_->acquire(segment.size());
+            segment.write(segmentData->data());
+
             boost::shared_ptr<ndn::Data> ndnSegment(boost::make_shared<ndn::Data>(segmentName));
             ndnSegment->getMetaInfo().setFreshnessPeriod(freshnessMs);
             ndnSegment->getMetaInfo().setFinalBlockId(ndn::Name::Component::fromSegment(segments.size() - 1));
-            ndnSegment->setContent(segmentData->getData(), segment.size());
-            sign(ndnSegment);
-            settings_.memoryCache_->add(*ndnSegment);
+            ndnSegment->setContent(ndn::Blob(segmentData, false));
             ++segIdx;
             ndnSegments.push_back(ndnSegment);
+        }
+
+        // segments are requested in order, so all segments below the last
+        // requested one are expected to have pending interests
+        if (nPitHits)
+        {
+            nExpectedInterests_ += lastPitHitIdx + 1;
+            nReceivedInterests_ += nPitHits;
+        }
+
+        return ndnSegments;
+    }
+
+    PublishedDataPtrVector cache(const ndn::Name &name,
+                                 const std::vector<boost::shared_ptr<ndn::Data>> &segments,
+                                 bool forcePitClean, bool banPitClean)
+    {
+        PublishedDataPtrVector ndnSegments;
+
+        for (auto ndnSegment : segments)
+        {
+            const ndn::Name &segmentName = ndnSegment->getName();
+            // segment is encoded once (unless it was encoded by the key chain
+            // already) and becomes immutable; statistics, sample cache and
+            // persistent storage reuse its default wire encoding
+            ndn::SignedBlob wire = ndnSegment->wireEncode();
+            settings_.memoryCache_->add(*ndnSegment);
+            ndnSegments.push_back(ndnSegment);
 
             (*settings_.statStorage_)[statistics::Indicator::BytesPublished] += ndnSegment->getContent().size();
-            (*settings_.statStorage_)[statistics::Indicator::RawBytesPublished] += ndnSegment->getDefaultWireEncoding().size();
+            (*settings_.statStorage_)[statistics::Indicator::RawBytesPublished] += wire.size();
 
             LogTraceC << "cached " << segmentName << " ("
                       << ndnSegment->getContent().size() << "b payload, "
-                      << ndnSegment->getDefaultWireEncoding().size() << "b wire, "
+                      << wire.size() << "b wire, "
                       << ndnSegment->getMetaInfo().getFreshnessPeriod() << "ms fp)"
                       << std::endl;
         }
@@ -151,31 +391,30 @@ class PacketPublisher : public NdnRtcComponent
         return ndnSegments;
     }
 
-  private:
-    Settings settings_;
-    unsigned int fullPitClean_;
-
-    void checkForPendingInterests(const ndn::Name &name, _DataSegmentHeader &commonHeader)
+    void onSigned(const ndn::Name &name, const std::vector<boost::shared_ptr<ndn::Data>> &segments,
+                  const std::string &error, bool forcePitClean, bool banPitClean,
+                  const OnPublished &onPublished)
     {
-        std::vector<boost::shared_ptr<const ndn::MemoryContentCache::PendingInterest>> pendingInterests;
-        settings_.memoryCache_->getPendingInterestsForName(name, pendingInterests);
+        PublishedDataPtrVector ndnSegments;
 
-        if (pendingInterests.size())
+        if (error.size())
+            LogErrorC << "failed to sign " << name << ": " << error << std::endl;
+        else
         {
-            commonHeader.interestNonce_ = *(uint32_t *)(pendingInterests.back()->getInterest()->getNonce().buf());
-            commonHeader.interestArrivalMs_ = pendingInterests.back()->getTimeoutPeriodStart();
-            commonHeader.generationDelayMs_ = ndn_getNowMilliseconds() - pendingInterests.back()->getTimeoutPeriodStart();
-
-            (*settings_.statStorage_)[statistics::Indicator::InterestsReceivedNum] += pendingInterests.size();
-
-            LogTraceC << "PIT hit " << pendingInterests.back()->getInterest()->toUri() << std::endl;
+            (*settings_.statStorage_)[statistics::Indicator::SignNum] += segments.size();
+            ndnSegments = cache(name, segments, forcePitClean, banPitClean);
         }
+
+        if (onPublished)
+            onPublished(ndnSegments);
     }
 
     void sign(boost::shared_ptr<ndn::Data> segment)
     {
         if (settings_.sign_)
         {
+            // key chain may be used by signing pool at the same time
+            boost::lock_guard<boost::mutex> keyChainLock(SigningPool::getKeyChainMutex(settings_.keyChain_));
             settings_.keyChain_->sign(*segment);
             (*settings_.statStorage_)[statistics::Indicator::SignNum]++;
         }
@@ -194,9 +433,22 @@ class PacketPublisher : public NdnRtcComponent
      * Retrieves all pending interests for given name and publishes application NACKs for them
      */
     void cleanPit(const ndn::Name &name, bool forceFullPitClean = false)
+    {
+        cleanPit(settings_.memoryCache_, name);
+
+        if (fullPitClean_++ % FULL_PIT_FREQUENCY == 0 || forceFullPitClean)
+        {
+            if (!forceFullPitClean)
+                fullPitClean_ = 0;
+            deepCleanPit(settings_.memoryCache_, name);
+        }
+    }
+
+    template <typename MemoryCache>
+    void cleanPit(MemoryCache *memoryCache, const ndn::Name &name)
     {
         std::vector<boost::shared_ptr<const ndn::MemoryContentCache::PendingInterest>> pendingInterests;
-        settings_.memoryCache_->getPendingInterestsWithPrefix(name, pendingInterests);
+        memoryCache->getPendingInterestsWithPrefix(name, pendingInterests);
 
         if (pendingInterests.size())
         {
@@ -210,16 +462,27 @@ class PacketPublisher : public NdnRtcComponent
         }
         else
             LogTraceC << "no pending for " << name << std::endl;
+    }
 
-        if (fullPitClean_++ % FULL_PIT_FREQUENCY == 0 || forceFullPitClean)
+    void cleanPit(SampleCache *sampleCache, const ndn::Name &name)
+    {
+        std::vector<boost::shared_ptr<const SampleCache::PendingInterest>> pendingInterests;
+        sampleCache->extractPendingInterestsWithPrefix(name, pendingInterests);
+
+        if (pendingInterests.size())
         {
-            if (!forceFullPitClean)
-                fullPitClean_ = 0;
-            deepCleanPit(name);
+            LogTraceC
+                << "cleaning PIT for " << name
+                << " (sending NACKs for "
+                << pendingInterests.size() << " interests)" << std::endl;
+            publishNacks(pendingInterests);
         }
+        else
+            LogTraceC << "no pending for " << name << std::endl;
     }
 
-    void deepCleanPit(const ndn::Name &name)
+    template <typename MemoryCache>
+    void deepCleanPit(MemoryCache *memoryCache, const ndn::Name &name)
     {
         NamespaceInfo info;
 
@@ -235,7 +498,7 @@ class PacketPublisher : public NdnRtcComponent
         std::vector<boost::shared_ptr<const ndn::MemoryContentCache::PendingInterest>> pendingInterests;
 
         // extract all pending interests for this stream
-        settings_.memoryCache_->getPendingInterestsWithPrefix(info.getPrefix(prefix_filter::Stream), pendingInterests);
+        memoryCache->getPendingInterestsWithPrefix(info.getPrefix(prefix_filter::Stream), pendingInterests);
 
         if (pendingInterests.size())
         {
@@ -260,6 +523,54 @@ class PacketPublisher : public NdnRtcComponent
         }
     }
 
+    void deepCleanPit(SampleCache *sampleCache, const ndn::Name &name)
+    {
+        // older interests of the thread (those that request data that has
+        // already been published) are answered with NACKs, this is needed
+        // when consumer runs slightly behind producer
+        std::vector<boost::shared_ptr<const SampleCache::PendingInterest>> pendingInterests;
+        sampleCache->extractPendingInterestsBefore(name, pendingInterests);
+
+        if (pendingInterests.size())
+        {
+            LogTraceC << "PIT deep clean " << name << " (sending NACKs for "
+                      << pendingInterests.size() << " interests)" << std::endl;
+            publishNacks(pendingInterests);
+        }
+    }
+
+    /**
+     * Answers pending interests, extracted from the cache, with application
+     * NACKs, if enabled. NACKs are sent directly to the faces interests came
+     * from and are not cached. One NACK is created per name, as several
+     * consumers may have asked for the same segment.
+     */
+    void publishNacks(const std::vector<boost::shared_ptr<const SampleCache::PendingInterest>> &pendingInterests)
+    {
+        if (!settings_.sendNacks_)
+            return;
+
+        std::map<ndn::Name, boost::shared_ptr<ndn::Data>> nacks;
+        ndn::Blob nackContent((const uint8_t *)"nack", 4);
+
+        for (auto pi : pendingInterests)
+        {
+            const ndn::Name &name = pi->getInterest()->getName();
+            boost::shared_ptr<ndn::Data> &nack = nacks[name];
+
+            if (!nack)
+            {
+                nack = boost::make_shared<ndn::Data>(name);
+                nack->getMetaInfo().setFreshnessPeriod(settings_.freshnessPeriodMs_);
+                nack->getMetaInfo().setType(ndn_ContentType_NACK);
+                nack->setContent(nackContent);
+                sign(nack);
+            }
+
+            pi->getFace().putData(*nack);
+        }
+    }
+
     void publishNack(const ndn::Name &name)
     {
         boost::shared_ptr<ndn::Data> nack(boost::make_shared<ndn::Data>(name));
@@ -272,6 +583,10 @@ class PacketPublisher : public NdnRtcComponent
 
 typedef PacketPublisher<VideoFrameSegment, PublisherSettings> VideoPacketPublisher;
 typedef PacketPublisher<CommonSegment, PublisherSettings> CommonPacketPublisher;
+// video frames and audio bundles are published into SampleCache
+typedef _PublisherSettings<ndn::KeyChain, SampleCache> SamplePublisherSettings;
+typedef PacketPublisher<VideoFrameSegment, SamplePublisherSettings> VideoSamplePublisher;
+typedef PacketPublisher<CommonSegment, SamplePublisherSettings> CommonSamplePublisher;
 }
 
 #endif
@@ -0,0 +1,54 @@
+//
+// parity-control.cpp
+//
+//  Copyright 2013-2018 Regents of the University of California
+//
+
+#include <algorithm>
+
+#include "parity-control.hpp"
+
+using namespace ndnrtc;
+
+// smoothing factor for loss estimation
+#define LOSS_SMOOTHING (1. / 16.)
+// loss is capped, as ratio grows unbounded when loss approaches 1
+#define MAX_LOSS 0.5
+// how many more parity segments are added than it's needed to recover
+// average loss; key frames get more, as they are larger and losing them
+// is more expensive
+#define DELTA_LOSS_MARGIN 1.5
+#define KEY_LOSS_MARGIN 3.
+
+ParityControl::ParityControl(const GeneralProducerParams::FecParams &params)
+    : params_(params), loss_(0)
+{
+}
+
+void ParityControl::interestsObserved(unsigned int nExpected, unsigned int nReceived)
+{
+    if (nExpected == 0 || nReceived > nExpected)
+        return;
+
+    double loss = 1. - (double)nReceived / (double)nExpected;
+    loss_ = loss_ + (loss - loss_) * LOSS_SMOOTHING;
+}
+
+double ParityControl::getParityRatio(SampleClass st) const
+{
+    double baseRatio = (st == SampleClass::Key ? params_.keyParityRatio_ : params_.deltaParityRatio_);
+    double ratio = baseRatio;
+
+    if (params_.adaptive_)
+    {
+        // to recover loss p, one needs p/(1-p) parity segments per one data
+        // segment
+        double loss = std::min(loss_.load(), MAX_LOSS);
+        double margin = (st == SampleClass::Key ? KEY_LOSS_MARGIN : DELTA_LOSS_MARGIN);
+
+        ratio += margin * loss / (1. - loss);
+        ratio = std::max(std::min(ratio, params_.maxParityRatio_), baseRatio);
+    }
+
+    return ratio;
+}
@@ -0,0 +1,58 @@
+//
+// parity-control.hpp
+//
+//  Copyright 2013-2018 Regents of the University of California
+//
+
+#ifndef __parity_control_h__
+#define __parity_control_h__
+
+#include <atomic>
+
+#include "params.hpp"
+#include "name-components.hpp"
+
+namespace ndnrtc
+{
+/**
+ * Parity control chooses FEC parity ratio (number of parity segments per
+ * one data segment) for frames of a video thread. Key and delta frames have
+ * separate ratios. Fixed ratios are taken from producer parameters. Adaptive
+ * ratios start from configured ones (which are lower bounds) and follow the
+ * estimation of segment loss.
+ * Loss is estimated from interests pattern, seen upon publishing a frame:
+ * consumers request segments of upcoming frames in batches, so if there are
+ * pending interests for a frame, but some of its lower segments are not
+ * requested, these interests were lost on the way (and consumer will have to
+ * retransmit them after timeout).
+ * Ratios may be read from a thread other than the one reporting interests.
+ */
+class ParityControl
+{
+  public:
+    ParityControl(const GeneralProducerParams::FecParams &params);
+
+    /**
+     * Must be called each time frame is published.
+     * @param nExpected Number of segments that consumers were expected to
+     *          request for this frame
+     * @param nReceived Number of segments that had pending interests
+     */
+    void interestsObserved(unsigned int nExpected, unsigned int nReceived);
+
+    /**
+     * Returns parity ratio to use for the next frame of given class.
+     */
+    double getParityRatio(SampleClass st) const;
+
+    double getLossEstimation() const { return loss_; }
+    bool isAdaptive() const { return params_.adaptive_; }
+
+  private:
+    GeneralProducerParams::FecParams params_;
+    // updated on publishing thread, read on encoding thread
+    std::atomic<double> loss_;
+};
+}
+
+#endif
@@ -244,11 +244,13 @@ bool StorageEngineImpl::put(const Data &data)
     if (!db_)
         throw std::runtime_error("DB is not open");
 
+    // published data is already encoded, thus this returns its default
+    // wire encoding without encoding it again
+    SignedBlob encoding = data.wireEncode();
     db_namespace::Status s =
         db_->Put(db_namespace::WriteOptions(),
                  data.getName().toUri(),
-                 db_namespace::Slice((const char *)data.wireEncode().buf(),
-                                     data.wireEncode().size()));
+                 db_namespace::Slice((const char *)encoding.buf(), encoding.size()));
     return s.ok();
 #else
     return false;
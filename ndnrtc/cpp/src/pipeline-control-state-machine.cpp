@@ -67,10 +67,22 @@ class ReceivedMetadataProcessing
                 << " gop size " << gopSize
                 << " rate " << metadata->getRate()
                 << " drd " << initialDrd
+                << (metadata->isDormant() ? " dormant" : "")
                 << std::endl;
 
             // add some smart logic about what to fetch next...
-            if (gopPos < ((float)gopSize / 2.))
+            if (metadata->isDormant())
+            {
+                // producer doesn't encode the thread until it gets our 
+                // interests, then it starts off with a new key frame
+                startOffSeqNums_.first = -1;
+                startOffSeqNums_.second = metadata->getSeqNo().second + 1;
+                // unless the last published frame was key, delta sequence 
+                // number points to the last published delta
+                deltaToFetch = metadata->getSeqNo().first + (gopPos ? 1 : 0);
+                keyToFetch = metadata->getSeqNo().second + 1;
+            }
+            else if (gopPos < ((float)gopSize / 2.))
             {
                 // initial pipeline size helps us determine from which delta frame we need to start playback
                 startOffSeqNums_.first = metadata->getSeqNo().first + pipelineInitial;
@@ -107,6 +119,10 @@ class ReceivedMetadataProcessing
                                                            SampleClass::Key, SegmentClass::Data);
             ctrl->sampleEstimator_->bootstrapSegmentNumber(metadata->getSegInfo().keyAvgParitySegNum_,
                                                            SampleClass::Key, SegmentClass::Parity);
+            ctrl->sampleEstimator_->bootstrapParityRatio(metadata->getParityRatio().first,
+                                                         SampleClass::Delta);
+            ctrl->sampleEstimator_->bootstrapParityRatio(metadata->getParityRatio().second,
+                                                         SampleClass::Key);
 
             ctrl->interestControl_->initialize(metadata->getRate(), pipelineInitial);
             ctrl->pipeliner_->setSequenceNumber(deltaToFetch, SampleClass::Delta);
@@ -9,6 +9,7 @@
 //
 
 #include "pipeliner.hpp"
+#include <climits>
 #include <ndn-cpp/exclude.hpp>
 
 #include "sample-estimator.hpp"
@@ -59,8 +60,9 @@ Pipeliner::expressBootstrap(const ndn::Name& threadPrefix)
 void
 Pipeliner::express(const ndn::Name& threadPrefix, bool placeInBuffer)
 {
-    Name n = nameScheme_->samplePrefix(threadPrefix, nextSamplePriority_);
-    n.appendSequenceNumber((nextSamplePriority_ == SampleClass::Delta ? seqCounter_.delta_ : seqCounter_.key_));
+    PacketNumber seqNo = (nextSamplePriority_ == SampleClass::Delta ? seqCounter_.delta_ : seqCounter_.key_);
+    Name n = nameScheme_->samplePrefix(threadPrefix, nextSamplePriority_, seqNo);
+    n.appendSequenceNumber(seqNo);
     
     const std::vector<boost::shared_ptr<const Interest>> batch = getBatch(n, nextSamplePriority_);
     
@@ -91,9 +93,19 @@ Pipeliner::fillUpPipeline(const ndn::Name& threadPrefix)
     
     while (interestControl_->room() > 0)
     {
-        Name n = nameScheme_->samplePrefix(threadPrefix, nextSamplePriority_);
-        n.appendSequenceNumber((nextSamplePriority_ == SampleClass::Delta ?
-                                seqCounter_.delta_ : seqCounter_.key_));
+        PacketNumber seqNo = (nextSamplePriority_ == SampleClass::Delta ?
+                              seqCounter_.delta_ : seqCounter_.key_);
+
+        if (!nameScheme_->needSample(nextSamplePriority_, seqNo))
+        {
+            // e.g. delta frame of temporal layer, which is not fetched
+            LogTraceC << "skip " << seqNo << std::endl;
+            seqCounter_.delta_++;
+            continue;
+        }
+
+        Name n = nameScheme_->samplePrefix(threadPrefix, nextSamplePriority_, seqNo);
+        n.appendSequenceNumber(seqNo);
         //liupenghui,  for audio sample fetching...     
         Name m("audio");
         int result = n.compare(4, 1,m, 0);
@@ -241,17 +253,57 @@ void Pipeliner::onNewData(const BufferReceipt& receipt)
     }
 }
 
+Pipeliner::VideoNameScheme::VideoNameScheme():
+nLayers_(1), gopSize_(0), gopStart_(0), maxLayer_(UINT_MAX)
+{
+}
+
 Name
-Pipeliner::VideoNameScheme::samplePrefix(const Name& threadPrefix, SampleClass cls)
+Pipeliner::VideoNameScheme::samplePrefix(const Name& threadPrefix, SampleClass cls,
+                                         PacketNumber seqNo)
 {
     Name prefix(threadPrefix);
     if (cls == SampleClass::Delta)
+    {
         prefix.append(NameComponents::NameComponentDelta);
+        if (nLayers_ > 1)
+            prefix.append(Name::Component::fromNumber(getTemporalLayer(seqNo)));
+    }
     else
         prefix.append(NameComponents::NameComponentKey);
     return prefix;
 }
 
+bool
+Pipeliner::VideoNameScheme::needSample(SampleClass cls, PacketNumber seqNo)
+{
+    return (cls != SampleClass::Delta || nLayers_ <= 1 || 
+            getTemporalLayer(seqNo) <= maxLayer_);
+}
+
+void
+Pipeliner::VideoNameScheme::setTemporalLayers(unsigned int nLayers, unsigned int gopSize,
+                                              PacketNumber gopStartSeqNo)
+{
+    nLayers_ = nLayers;
+    gopSize_ = gopSize;
+    gopStart_ = gopStartSeqNo;
+}
+
+unsigned int
+Pipeliner::VideoNameScheme::getTemporalLayer(PacketNumber deltaSeqNo) const
+{
+    if (nLayers_ <= 1 || gopSize_ <= 1)
+        return 0;
+
+    // there are gopSize-1 delta frames in GOP, the first one has position 1
+    int nDeltas = gopSize_ - 1;
+    int offset = (deltaSeqNo - gopStart_) % nDeltas;
+    if (offset < 0) offset += nDeltas;
+
+    return NameComponents::temporalLayer(offset + 1, nLayers_);
+}
+
 Name
 Pipeliner::VideoNameScheme::metadataPrefix(const ndn::Name& threadPrefix)
 {
@@ -272,7 +324,8 @@ Pipeliner::VideoNameScheme::metadataInterest(const ndn::Name threadPrefix,
 }
 
 Name
-Pipeliner::AudioNameScheme::samplePrefix(const Name& threadPrefix, SampleClass cls)
+Pipeliner::AudioNameScheme::samplePrefix(const Name& threadPrefix, SampleClass cls,
+                                         PacketNumber seqNo)
 {
     return threadPrefix;
 }
@@ -12,6 +12,7 @@
 #define __ndnrtc__pipeliner__
 
 #include <boost/thread/mutex.hpp>
+#include <boost/atomic.hpp>
 
 #include "ndnrtc-object.hpp"
 #include "name-components.hpp"
@@ -151,25 +152,76 @@ namespace ndnrtc {
          */
         class INameScheme {
         public:
-            virtual ndn::Name samplePrefix(const ndn::Name&, SampleClass) = 0;
+            /**
+             * Returns prefix of the sample with given sequence number (sequence
+             * number is not included)
+             */
+            virtual ndn::Name samplePrefix(const ndn::Name&, SampleClass, PacketNumber) = 0;
+            /**
+             * Returns false if sample with given sequence number must not be
+             * fetched
+             */
+            virtual bool needSample(SampleClass, PacketNumber) = 0;
             virtual ndn::Name metadataPrefix(const ndn::Name&) = 0;
             virtual boost::shared_ptr<ndn::Interest> metadataInterest(const ndn::Name,
                                                                       unsigned int,
                                                                       SequenceCounter) = 0;
         };
         
+        /**
+         * Delta frames of threads with several temporal layers are named
+         * <thread>/d/<layer>/<seq>, where layer is defined by frame's GOP 
+         * position (see NameComponents::temporalLayer). Thus, in order to
+         * name a delta frame, name scheme needs to know GOP size and sequence 
+         * number of the first delta frame of some GOP. Delta frames of layers
+         * higher than maximum layer are not fetched.
+         */
         class VideoNameScheme : public INameScheme {
         public:
-            ndn::Name samplePrefix(const ndn::Name&, SampleClass);
+            VideoNameScheme();
+
+            ndn::Name samplePrefix(const ndn::Name&, SampleClass, PacketNumber);
+            bool needSample(SampleClass, PacketNumber);
             ndn::Name metadataPrefix(const ndn::Name&);
             boost::shared_ptr<ndn::Interest> metadataInterest(const ndn::Name,
                                                               unsigned int,
                                                               SequenceCounter);
+
+            /**
+             * Sets temporal layers of the thread
+             * @param nLayers Number of temporal layers
+             * @param gopSize GOP size of the thread
+             * @param gopStartSeqNo Sequence number of the first delta frame of
+             *          some GOP
+             */
+            void setTemporalLayers(unsigned int nLayers, unsigned int gopSize,
+                                   PacketNumber gopStartSeqNo);
+
+            /**
+             * Sets sequence number of the first delta frame of a GOP. Should
+             * be called for every received key frame, as GOPs may be shorter
+             * than expected (e.g. if producer restarts encoder).
+             */
+            void setGopStart(PacketNumber gopStartSeqNo) { gopStart_ = gopStartSeqNo; }
+
+            /**
+             * Sets maximum temporal layer to fetch. Can be called on any thread.
+             */
+            void setMaxTemporalLayer(unsigned int layer) { maxLayer_ = layer; }
+            unsigned int getMaxTemporalLayer() const { return maxLayer_; }
+
+            unsigned int getTemporalLayer(PacketNumber deltaSeqNo) const;
+
+        private:
+            unsigned int nLayers_, gopSize_;
+            boost::atomic<PacketNumber> gopStart_;
+            boost::atomic<unsigned int> maxLayer_;
         };
         
         class AudioNameScheme : public INameScheme {
         public:
-            ndn::Name samplePrefix(const ndn::Name&, SampleClass);
+            ndn::Name samplePrefix(const ndn::Name&, SampleClass, PacketNumber);
+            bool needSample(SampleClass, PacketNumber) { return true; }
             ndn::Name metadataPrefix(const ndn::Name&);
             boost::shared_ptr<ndn::Interest> metadataInterest(const ndn::Name,
                                                               unsigned int,
@@ -0,0 +1,110 @@
+//
+// rate-control.cpp
+//
+//  Copyright 2013-2018 Regents of the University of California
+//
+
+#include <algorithm>
+#include <stdexcept>
+
+#include "rate-control.hpp"
+
+using namespace ndnrtc;
+
+// CPU is overused if encoding takes this much of frame interval
+#define ENCODE_OVERUSE 0.9
+// publishing is overused if backlog reaches this much of pipeline's limit
+#define BACKLOG_OVERUSE 0.5
+// consumers are lagging if they requested less than this fraction of
+// published frames ahead (while requesting some)
+#define DEMAND_UNDERUSE 0.5
+// multiplicative decrease on overuse
+#define DECREASE_FACTOR 0.85
+// additive increase (fraction of nominal) after stable intervals
+#define INCREASE_STEP 0.05
+#define STABLE_INTERVALS 3
+
+RateControl::RateControl(const GeneralProducerParams::RateControlParams &params, double frameRate)
+    : params_(params), frameRate_(frameRate),
+      minFrameRateRatio_(frameRate > 0 ? std::min(1., params.minFrameRate_ / frameRate) : 1.),
+      bitrateRatio_(1.), frameRateRatio_(1.),
+      nDropped_(0), nStable_(0), nPublished_(0), nDemanded_(0)
+{
+    if (params_.minBitrateRatio_ <= 0 || params_.minBitrateRatio_ > 1)
+        throw std::runtime_error("Minimal bitrate ratio must be in (0;1]");
+}
+
+void RateControl::interestsObserved(unsigned int nSegments, unsigned int nRequested)
+{
+    if (nSegments == 0)
+        return;
+
+    nPublished_++;
+    if (nRequested)
+        nDemanded_++;
+}
+
+bool RateControl::update(const Load &load)
+{
+    unsigned int nPublished = nPublished_.exchange(0);
+    unsigned int nDemanded = nDemanded_.exchange(0);
+    bool dropped = (load.nDropped_ > nDropped_);
+    nDropped_ = load.nDropped_;
+
+    bool cpuOveruse = (load.frameIntervalMs_ > 0 &&
+                       load.encodeDelayMs_ > ENCODE_OVERUSE * load.frameIntervalMs_);
+    bool publishOveruse = (load.publishBacklog_ >= BACKLOG_OVERUSE);
+    // no demand at all means there are no consumers, rather than lagging ones
+    bool consumersLag = (nDemanded > 0 && nDemanded < DEMAND_UNDERUSE * nPublished);
+
+    if (cpuOveruse)
+    {
+        nStable_ = 0;
+        return decreaseFrameRate();
+    }
+
+    if (publishOveruse || consumersLag || dropped)
+    {
+        nStable_ = 0;
+        return decreaseBitrate() || decreaseFrameRate();
+    }
+
+    if (++nStable_ >= STABLE_INTERVALS)
+    {
+        nStable_ = 0;
+        return increase();
+    }
+
+    return false;
+}
+
+bool RateControl::decreaseBitrate()
+{
+    double ratio = std::max(params_.minBitrateRatio_, bitrateRatio_ * DECREASE_FACTOR);
+    bool changed = (ratio != bitrateRatio_);
+
+    bitrateRatio_ = ratio;
+    return changed;
+}
+
+bool RateControl::decreaseFrameRate()
+{
+    double ratio = std::max(minFrameRateRatio_, frameRateRatio_ * DECREASE_FACTOR);
+    bool changed = (ratio != frameRateRatio_);
+
+    frameRateRatio_ = ratio;
+    return changed;
+}
+
+bool RateControl::increase()
+{
+    // frame rate is restored first, as its' loss is more noticeable
+    if (frameRateRatio_ < 1.)
+        frameRateRatio_ = std::min(1., frameRateRatio_ + INCREASE_STEP);
+    else if (bitrateRatio_ < 1.)
+        bitrateRatio_ = std::min(1., bitrateRatio_ + INCREASE_STEP);
+    else
+        return false;
+
+    return true;
+}
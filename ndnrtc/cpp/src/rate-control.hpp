@@ -0,0 +1,87 @@
+//
+// rate-control.hpp
+//
+//  Copyright 2013-2018 Regents of the University of California
+//
+
+#ifndef __rate_control_h__
+#define __rate_control_h__
+
+#include <atomic>
+#include <stdint.h>
+
+#include "params.hpp"
+
+namespace ndnrtc
+{
+/**
+ * Rate control adjusts encoders' bitrate and frame rate to producer's load,
+ * so that quality degrades gradually, before pipeline starts dropping frames.
+ * Load is evaluated periodically:
+ *  - if encoding takes (almost) all the time between captured frames, CPU is
+ *    overused and frame rate is lowered;
+ *  - if publishing backlog grows, frames get dropped by the pipeline or
+ *    consumers stop requesting upcoming frames ahead, too much data is
+ *    produced and bitrate is lowered (frame rate - once bitrate reached its
+ *    lower bound).
+ * Once there's no overuse for several intervals, frame rate and then bitrate
+ * are gradually restored.
+ * Targets are expressed as fractions of threads' nominal bitrate and frame
+ * rate. Consumers' demand is reported on publishing thread, load - on
+ * encoding thread.
+ */
+class RateControl
+{
+  public:
+    typedef struct _Load
+    {
+        double encodeDelayMs_;   // average time to encode one frame
+        double frameIntervalMs_; // average interval between captured frames
+        double publishBacklog_;  // frames being published, as a fraction of
+                                 // the pipeline's limit
+        uint64_t nDropped_;      // total number of frames, dropped by pipeline
+    } Load;
+
+    /**
+     * @param params Rate control parameters
+     * @param frameRate Nominal frame rate (FPS)
+     */
+    RateControl(const GeneralProducerParams::RateControlParams &params, double frameRate);
+
+    /**
+     * Must be called each time frame is published.
+     * @param nSegments Number of data segments of the frame
+     * @param nRequested Number of segments that had pending interests
+     */
+    void interestsObserved(unsigned int nSegments, unsigned int nRequested);
+
+    /**
+     * Evaluates load, observed since the previous call, and adjusts targets.
+     * @return true if targets have changed
+     */
+    bool update(const Load &load);
+
+    // fraction of nominal bitrate to encode with
+    double getBitrateRatio() const { return bitrateRatio_; }
+    // fraction of nominal frame rate to encode with
+    double getFrameRateRatio() const { return frameRateRatio_; }
+    double getTargetFrameRate() const { return frameRate_ * frameRateRatio_; }
+
+    const GeneralProducerParams::RateControlParams &getParams() const { return params_; }
+
+  private:
+    GeneralProducerParams::RateControlParams params_;
+    double frameRate_, minFrameRateRatio_;
+    double bitrateRatio_, frameRateRatio_;
+    uint64_t nDropped_;
+    unsigned int nStable_;
+    // updated on publishing thread
+    std::atomic<unsigned int> nPublished_, nDemanded_;
+
+    bool decreaseBitrate();
+    bool decreaseFrameRate();
+    bool increase();
+};
+}
+
+#endif
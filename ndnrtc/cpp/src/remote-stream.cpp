@@ -187,4 +187,10 @@ void
 RemoteVideoStream::start(const FetchingRuleSet& ruleset, IExternalRenderer* renderer)
 {
     boost::dynamic_pointer_cast<RemoteVideoStreamImpl>(pimpl_)->start(ruleset, renderer);
-}
\ No newline at end of file
+}
+
+void
+RemoteVideoStream::setMaxTemporalLayer(unsigned int layer)
+{
+    boost::dynamic_pointer_cast<RemoteVideoStreamImpl>(pimpl_)->setMaxTemporalLayer(layer);
+}
@@ -7,6 +7,8 @@
 
 #include "remote-video-stream.hpp"
 #include <ndn-cpp/name.hpp>
+#include <ndn-cpp/data.hpp>
+#include <ndn-cpp/interest.hpp>
 #include <webrtc/common_video/libyuv/include/webrtc_libyuv.h>
 
 #include "interfaces.hpp"
@@ -19,6 +21,8 @@
 #include "playout-control.hpp"
 #include "sample-estimator.hpp"
 #include "sample-validator.hpp"
+#include "rtx-controller.hpp"
+#include "fec-group-recovery.hpp"
 #include "video-decoder.hpp"
 #include "clock.hpp"
 
@@ -52,6 +56,32 @@ class BufferObserver : public IBufferObserver {
         boost::shared_ptr<IInterestControl> interestControl_;
 };
 
+// Keeps name scheme's GOP anchor up to date: every key frame points to the 
+// first delta frame of its' GOP, which temporal layers of the following delta 
+// frames are derived from.
+class GopObserver : public IBufferObserver {
+    public:
+    GopObserver(boost::shared_ptr<Pipeliner::VideoNameScheme> nameScheme)
+        : nameScheme_(nameScheme) {}
+    ~GopObserver(){}
+
+    void onNewRequest(const boost::shared_ptr<BufferSlot>&) {}
+    void onNewData(const BufferReceipt& receipt)
+    {
+        if (receipt.slot_->getNameInfo().class_ == SampleClass::Key)
+        {
+            boost::shared_ptr<WireData<VideoFrameSegmentHeader>> wd =
+                boost::dynamic_pointer_cast<WireData<VideoFrameSegmentHeader>>(receipt.segment_->getData());
+            if (wd)
+                nameScheme_->setGopStart(wd->segment().getHeader().pairedSequenceNo_);
+        }
+    }
+    void onReset() {}
+
+    private:
+        boost::shared_ptr<Pipeliner::VideoNameScheme> nameScheme_;
+};
+
 class PlaybackObserver : public IVideoPlayoutObserver {
     public: 
         PlaybackObserver(boost::shared_ptr<IPipeliner> pipeliner, 
@@ -82,6 +112,7 @@ class PlaybackObserver : public IVideoPlayoutObserver {
             pipeliner_->fillUpPipeline(threadPrefix_);
         }
 };
+
 //liupenghui, add type  MediaStreamTypeVideo
 
 RemoteVideoStreamImpl::RemoteVideoStreamImpl(boost::asio::io_service &io,
@@ -122,7 +153,8 @@ void RemoteVideoStreamImpl::construct()
     pps.segmentController_ = segmentController_;
     pps.sstorage_ = sstorage_;
 
-    pipeliner_ = make_shared<Pipeliner>(pps, boost::make_shared<Pipeliner::VideoNameScheme>());
+    nameScheme_ = boost::make_shared<Pipeliner::VideoNameScheme>();
+    pipeliner_ = make_shared<Pipeliner>(pps, nameScheme_);
     playout_ = boost::make_shared<VideoPlayout>(io_, playbackQueue_, sstorage_);
     playoutControl_ = boost::make_shared<PlayoutControl>(playout_, playbackQueue_, rtxController_);
     playbackQueue_->attach(playoutControl_.get());
@@ -185,7 +217,10 @@ void RemoteVideoStreamImpl::initiateFetching()
         buffer_->attach(bufferObserver_.get());
     }
 
+    setupTemporalLayers();
     setupDecoder();
+    setupFecGroupRecovery();
+    validator_->setManifestWindow(VideoThreadMeta(threadsMeta_[threadName_]->data()).getManifestWindow());
     setupPipelineControl();
     pipelineControl_->start();
 }
@@ -199,16 +234,30 @@ void RemoteVideoStreamImpl::stopFetching()
     else
         buffer_->detach(bufferObserver_.get());
 
+    if (gopObserver_)
+    {
+        buffer_->detach(gopObserver_.get());
+        gopObserver_.reset();
+    }
+
     releasePipelineControl();
+    releaseFecGroupRecovery();
     releaseDecoder();
 }
 
+void RemoteVideoStreamImpl::setMaxTemporalLayer(unsigned int layer)
+{
+    nameScheme_->setMaxTemporalLayer(layer);
+}
+
 void RemoteVideoStreamImpl::setLogger(boost::shared_ptr<ndnlog::new_api::Logger> logger)
 {
     RemoteStreamImpl::setLogger(logger);
     validator_->setLogger(logger);
     boost::dynamic_pointer_cast<NdnRtcComponent>(playoutControl_)->setLogger(logger);
     boost::dynamic_pointer_cast<Playout>(playout_)->setLogger(logger);
+    if (fecGroupRecovery_)
+        fecGroupRecovery_->setLogger(logger);
 }
 
 #pragma mark private
@@ -255,6 +304,55 @@ void RemoteVideoStreamImpl::releaseDecoder()
     decoder_.reset();
 }
 
+void RemoteVideoStreamImpl::setupTemporalLayers()
+{
+    VideoThreadMeta meta(threadsMeta_[threadName_]->data());
+
+    if (meta.getTemporalLayers() > 1)
+    {
+        // metadata points to the last published frame, find the beginning
+        // of its' GOP
+        PacketNumber gopStart = (meta.getGopPos() ? meta.getSeqNo().first - (meta.getGopPos() - 1)
+                                                  : meta.getSeqNo().first);
+        nameScheme_->setTemporalLayers(meta.getTemporalLayers(), meta.getCoderParams().gop_, gopStart);
+        gopObserver_ = boost::make_shared<GopObserver>(nameScheme_);
+        buffer_->attach(gopObserver_.get());
+
+        LogInfoC << "thread has " << meta.getTemporalLayers() << " temporal layers, fetching up to "
+                 << std::min(meta.getTemporalLayers() - 1, nameScheme_->getMaxTemporalLayer())
+                 << std::endl;
+    }
+}
+
+void RemoteVideoStreamImpl::setupFecGroupRecovery()
+{
+    VideoThreadMeta meta(threadsMeta_[threadName_]->data());
+
+    if (meta.getFecGroupSize() > 1)
+    {
+        fecGroupRecovery_ = boost::make_shared<FecGroupRecovery>(io_, face_, keyChain_, buffer_,
+                                                                 getStreamPrefix().append(threadName_),
+                                                                 threadName_, meta.getFecGroupSize(),
+                                                                 sstorage_);
+        fecGroupRecovery_->setLogger(logger_);
+        buffer_->attach(fecGroupRecovery_.get());
+        rtxController_->attach(fecGroupRecovery_.get());
+
+        LogInfoC << "delta frames are protected by FEC groups of "
+                 << meta.getFecGroupSize() << " frames" << std::endl;
+    }
+}
+
+void RemoteVideoStreamImpl::releaseFecGroupRecovery()
+{
+    if (fecGroupRecovery_)
+    {
+        rtxController_->detach(fecGroupRecovery_.get());
+        buffer_->detach(fecGroupRecovery_.get());
+        fecGroupRecovery_.reset();
+    }
+}
+
 void RemoteVideoStreamImpl::setupPipelineControl()
 {
     Name threadPrefix(getStreamPrefix());
@@ -12,6 +12,7 @@
 #include "sample-validator.hpp"
 #include "webrtc.hpp"
 #include "interfaces.hpp"
+#include "pipeliner.hpp"
 
 namespace ndnrtc
 {
@@ -23,6 +24,7 @@ class VideoDecoder;
 class IExternalRenderer;
 class IVideoPlayoutObserver;
 class IBufferObserver;
+class FecGroupRecovery;
 
 class RemoteVideoStreamImpl : public RemoteStreamImpl
 {
@@ -48,22 +50,29 @@ class RemoteVideoStreamImpl : public RemoteStreamImpl
     void start(const RemoteVideoStream::FetchingRuleSet& ruleset, IExternalRenderer *render);
     void initiateFetching();
     void stopFetching();
+    void setMaxTemporalLayer(unsigned int layer);
     void setLogger(boost::shared_ptr<ndnlog::new_api::Logger> logger);
 
   private:
     bool isPlaybackDriven_;
+    boost::shared_ptr<Pipeliner::VideoNameScheme> nameScheme_;
     boost::shared_ptr<IVideoPlayoutObserver> playbackObserver_;
     boost::shared_ptr<IBufferObserver> bufferObserver_;
+    boost::shared_ptr<IBufferObserver> gopObserver_;
     RemoteVideoStream::FetchingRuleSet ruleset_;
 
     boost::shared_ptr<ManifestValidator> validator_;
     IExternalRenderer *renderer_;
     boost::shared_ptr<VideoDecoder> decoder_;
+    boost::shared_ptr<FecGroupRecovery> fecGroupRecovery_;
 
     void construct();
     void feedFrame(const FrameInfo&, const WebRtcVideoFrame &);
+    void setupTemporalLayers();
     void setupDecoder();
     void releaseDecoder();
+    void setupFecGroupRecovery();
+    void releaseFecGroupRecovery();
     void setupPipelineControl();
     void releasePipelineControl();
 };
@@ -0,0 +1,403 @@
+//
+// sample-cache.cpp
+//
+//  Copyright 2013-2018 Regents of the University of California
+//
+
+#include <algorithm>
+#include <stdexcept>
+#include <boost/make_shared.hpp>
+#include <ndn-cpp/c/common.h>
+#include <ndn-cpp/face.hpp>
+
+#include "sample-cache.hpp"
+#include "clock.hpp"
+
+using namespace ndnrtc;
+using namespace ndn;
+
+namespace
+{
+const Name::Component DeltaComponent(NameComponents::NameComponentDelta);
+const Name::Component KeyComponent(NameComponents::NameComponentKey);
+const Name::Component ParityComponent(NameComponents::NameComponentParity);
+const Name::Component ManifestComponent(NameComponents::NameComponentManifest);
+}
+
+SampleCache::SampleCache(const ndn::Name &streamPrefix, unsigned int lifetimeMs,
+                         size_t budgetBytes, unsigned int ringSize)
+    : streamPrefix_(streamPrefix), lifetimeMs_(lifetimeMs),
+      budgetBytes_(budgetBytes), ringSize_(ringSize), nBytes_(0), nPending_(0)
+{
+    if (ringSize_ == 0)
+        throw std::runtime_error("Sample cache ring size must be positive");
+}
+
+bool SampleCache::isSampleName(const ndn::Name &name) const
+{
+    SegmentKey key;
+    return parse(name, key);
+}
+
+void SampleCache::add(const ndn::Data &data)
+{
+    SegmentKey key;
+    if (!parse(data.getName(), key))
+        throw std::runtime_error("Not a sample segment name: " + data.getName().toUri());
+
+    int64_t nowMs = clock::millisecondTimestamp();
+    Ring &ring = rings_[std::make_pair(key.thread_, key.class_)];
+    if (ring.empty())
+        ring.assign(ringSize_, Sample({-1, 0, 0}));
+
+    Sample &sample = ring[key.sampleNo_ % ringSize_];
+    if (sample.sampleNo_ != key.sampleNo_)
+    {
+        // ring wrapped around
+        if (sample.sampleNo_ != -1)
+            evict(sample);
+
+        sample.sampleNo_ = key.sampleNo_;
+        sample.addedMs_ = nowMs;
+        fifo_.push_back(FifoEntry({&ring, key.sampleNo_, nowMs}));
+    }
+
+    std::vector<Segment> &segments = sample.segments_[key.isParity_];
+    if (segments.size() <= key.segNo_)
+        segments.resize(key.segNo_ + 1, Segment({ndn::Name(), ndn::SignedBlob(), 0, 0}));
+
+    Segment &segment = segments[key.segNo_];
+    sample.nBytes_ -= segment.nBytes_;
+    nBytes_ -= segment.nBytes_;
+
+    // reuses encoding made while publishing, if data hasn't changed since
+    segment = Segment({data.getName(), data.wireEncode(),
+                       data.getMetaInfo().getFreshnessPeriod(), data.getContent().size()});
+    sample.nBytes_ += segment.nBytes_;
+    nBytes_ += segment.nBytes_;
+
+    PendingSample *pending = lookupPending(key);
+    if (pending)
+    {
+        PendingInterests pendingInterests;
+        extract(*pending, key.isParity_, data.getName(), pendingInterests);
+        for (auto pi : pendingInterests)
+            pi->getFace().send(segment.wire_);
+        prunePending(key);
+    }
+
+    evict(nowMs);
+}
+
+bool SampleCache::satisfy(const ndn::Interest &interest, ndn::Face &face)
+{
+    SegmentKey key;
+    if (!parse(interest.getName(), key))
+        return false;
+
+    Sample *sample = lookup(key);
+    if (!sample)
+        return false;
+
+    const std::vector<Segment> &segments = sample->segments_[key.isParity_];
+    if (segments.size() <= key.segNo_ || segments[key.segNo_].wire_.isNull())
+        return false;
+
+    const Segment &segment = segments[key.segNo_];
+    // delta frames of different temporal layers share sequence numbers
+    if (segment.name_ != interest.getName())
+        return false;
+    if (interest.getMustBeFresh() &&
+        clock::millisecondTimestamp() - sample->addedMs_ >= segment.freshnessPeriodMs_)
+        return false;
+
+    face.send(segment.wire_);
+    return true;
+}
+
+bool SampleCache::storePendingInterest(const boost::shared_ptr<const ndn::Interest> &interest,
+                                       ndn::Face &face)
+{
+    SegmentKey key;
+    if (!parse(interest->getName(), key))
+        return false;
+
+    cleanupPit(ndn_getNowMilliseconds());
+
+    PendingSample &sample = pit_[std::make_pair(key.thread_, key.class_)][key.sampleNo_];
+    std::vector<PendingInterests> &segments = sample.segments_[key.isParity_];
+    if (segments.size() <= key.segNo_)
+        segments.resize(key.segNo_ + 1);
+
+    boost::shared_ptr<const PendingInterest> pi = boost::make_shared<PendingInterest>(interest, face);
+    segments[key.segNo_].push_back(pi);
+    sample.nPending_++;
+    pitFifo_.push_back(std::make_pair(key, pi));
+    nPending_++;
+
+    return true;
+}
+
+void SampleCache::getPendingInterestsForName(const ndn::Name &name,
+                                             std::vector<boost::shared_ptr<const PendingInterest>> &pendingInterests)
+{
+    pendingInterests.clear();
+
+    SegmentKey key;
+    if (!parse(name, key))
+        return;
+
+    cleanupPit(ndn_getNowMilliseconds());
+
+    PendingSample *sample = lookupPending(key);
+    if (!sample || sample->segments_[key.isParity_].size() <= key.segNo_)
+        return;
+
+    for (auto pi : sample->segments_[key.isParity_][key.segNo_])
+        if (pi->getInterest()->getName() == name)
+            pendingInterests.push_back(pi);
+}
+
+bool SampleCache::hasPendingInterests(const ndn::Name &prefix)
+{
+    SegmentKey key;
+    bool hasSegment;
+    if (!parseSample(prefix, key, hasSegment) || hasSegment)
+        return false;
+
+    cleanupPit(ndn_getNowMilliseconds());
+
+    PendingSample *sample = lookupPending(key);
+    if (!sample)
+        return false;
+
+    for (int parity = key.isParity_; parity < 2; ++parity)
+        for (auto &pis : sample->segments_[parity])
+            for (auto pi : pis)
+                if (prefix.isPrefixOf(pi->getInterest()->getName()))
+                    return true;
+
+    return false;
+}
+
+void SampleCache::extractPendingInterestsWithPrefix(const ndn::Name &prefix,
+                                                    std::vector<boost::shared_ptr<const PendingInterest>> &pendingInterests)
+{
+    pendingInterests.clear();
+
+    SegmentKey key;
+    bool hasSegment;
+    if (!parseSample(prefix, key, hasSegment) || hasSegment)
+        return;
+
+    cleanupPit(ndn_getNowMilliseconds());
+
+    PendingSample *sample = lookupPending(key);
+    if (!sample)
+        return;
+
+    for (int parity = key.isParity_; parity < 2; ++parity)
+        extract(*sample, parity, prefix, pendingInterests);
+    prunePending(key);
+}
+
+void SampleCache::extractPendingInterestsBefore(const ndn::Name &prefix,
+                                                std::vector<boost::shared_ptr<const PendingInterest>> &pendingInterests)
+{
+    pendingInterests.clear();
+
+    SegmentKey key;
+    bool hasSegment;
+    if (!parseSample(prefix, key, hasSegment))
+        return;
+
+    cleanupPit(ndn_getNowMilliseconds());
+
+    auto it = pit_.find(std::make_pair(key.thread_, key.class_));
+    if (it == pit_.end())
+        return;
+
+    PendingSamples &samples = it->second;
+    auto end = samples.lower_bound(key.sampleNo_);
+    for (auto sampleIt = samples.begin(); sampleIt != end; ++sampleIt)
+    {
+        for (int parity = 0; parity < 2; ++parity)
+            for (auto &pis : sampleIt->second.segments_[parity])
+                pendingInterests.insert(pendingInterests.end(), pis.begin(), pis.end());
+        nPending_ -= sampleIt->second.nPending_;
+    }
+    samples.erase(samples.begin(), end);
+
+    if (samples.empty())
+        pit_.erase(it);
+}
+
+//******************************************************************************
+bool SampleCache::parse(const ndn::Name &name, SegmentKey &key) const
+{
+    bool hasSegment;
+    return parseSample(name, key, hasSegment) && hasSegment;
+}
+
+bool SampleCache::parseSample(const ndn::Name &name, SegmentKey &key, bool &hasSegment) const
+{
+    // <stream prefix>/<thread>/{k|d[/<layer>]}/<seq>[/_parity][/<segment>]
+    // or, for audio bundles, <stream prefix>/<thread>/<seq>[/<segment>]
+    size_t idx = streamPrefix_.size();
+    if (name.size() < idx + 2 || !streamPrefix_.isPrefixOf(name))
+        return false;
+
+    key.thread_ = name[idx++].toEscapedString();
+
+    if (name[idx].isSequenceNumber())
+        key.class_ = SampleClass::Unknown;
+    else if (name.size() < idx + 2)
+        return false;
+    else if (name[idx] == DeltaComponent)
+        key.class_ = SampleClass::Delta;
+    else if (name[idx] == KeyComponent)
+        key.class_ = SampleClass::Key;
+    else
+        return false;
+
+    if (key.class_ != SampleClass::Unknown)
+        idx++;
+
+    // temporal layer of delta frame is not a part of the key, as sequence
+    // numbers are shared by all layers
+    if (key.class_ == SampleClass::Delta && !name[idx].isSequenceNumber())
+    {
+        if (name[idx] == ParityComponent || name[idx] == ManifestComponent)
+            return false;
+        idx++;
+    }
+
+    if (name.size() <= idx || !name[idx].isSequenceNumber())
+        return false;
+    key.sampleNo_ = (PacketNumber)name[idx++].toSequenceNumber();
+
+    key.isParity_ = (name.size() > idx && name[idx] == ParityComponent);
+    if (key.isParity_)
+        idx++;
+
+    key.segNo_ = 0;
+    hasSegment = (name.size() > idx);
+    if (!hasSegment)
+        return true;
+
+    if (name.size() != idx + 1 || !name[idx].isSegment())
+        return false;
+    key.segNo_ = (unsigned int)name[idx].toSegment();
+
+    return true;
+}
+
+SampleCache::Sample *SampleCache::lookup(const SegmentKey &key)
+{
+    auto it = rings_.find(std::make_pair(key.thread_, key.class_));
+    if (it == rings_.end())
+        return nullptr;
+
+    Sample &sample = it->second[key.sampleNo_ % ringSize_];
+    if (sample.sampleNo_ != key.sampleNo_ ||
+        clock::millisecondTimestamp() - sample.addedMs_ > lifetimeMs_)
+        return nullptr;
+
+    return &sample;
+}
+
+void SampleCache::evict(int64_t nowMs)
+{
+    while (fifo_.size() &&
+           (nowMs - fifo_.front().addedMs_ > lifetimeMs_ || nBytes_ > budgetBytes_))
+    {
+        FifoEntry &e = fifo_.front();
+        Sample &sample = (*e.ring_)[e.sampleNo_ % ringSize_];
+
+        // slot may have been reused already
+        if (sample.sampleNo_ == e.sampleNo_)
+            evict(sample);
+        fifo_.pop_front();
+    }
+}
+
+void SampleCache::evict(Sample &sample)
+{
+    nBytes_ -= sample.nBytes_;
+    sample.sampleNo_ = -1;
+    sample.nBytes_ = 0;
+    sample.segments_[0].clear();
+    sample.segments_[1].clear();
+}
+
+SampleCache::PendingSample *SampleCache::lookupPending(const SegmentKey &key)
+{
+    auto it = pit_.find(std::make_pair(key.thread_, key.class_));
+    if (it == pit_.end())
+        return nullptr;
+
+    auto sampleIt = it->second.find(key.sampleNo_);
+    if (sampleIt == it->second.end())
+        return nullptr;
+
+    return &sampleIt->second;
+}
+
+void SampleCache::prunePending(const SegmentKey &key)
+{
+    auto it = pit_.find(std::make_pair(key.thread_, key.class_));
+    if (it == pit_.end())
+        return;
+
+    auto sampleIt = it->second.find(key.sampleNo_);
+    if (sampleIt != it->second.end() && sampleIt->second.nPending_ == 0)
+        it->second.erase(sampleIt);
+    if (it->second.empty())
+        pit_.erase(it);
+}
+
+void SampleCache::extract(PendingSample &sample, bool isParity, const ndn::Name &prefix,
+                          PendingInterests &pendingInterests)
+{
+    for (auto &pis : sample.segments_[isParity])
+    {
+        auto it = std::partition(pis.begin(), pis.end(),
+                                 [&prefix](const boost::shared_ptr<const PendingInterest> &pi) {
+                                     return !prefix.isPrefixOf(pi->getInterest()->getName());
+                                 });
+        size_t n = pis.end() - it;
+
+        pendingInterests.insert(pendingInterests.end(), it, pis.end());
+        pis.erase(it, pis.end());
+        sample.nPending_ -= n;
+        nPending_ -= n;
+    }
+}
+
+void SampleCache::cleanupPit(double nowMs)
+{
+    // interests are checked in the order of arrival; ones with longer
+    // lifetime, that arrived earlier, may hold cleanup of the others
+    while (pitFifo_.size() && pitFifo_.front().second->isTimedOut(nowMs))
+    {
+        const SegmentKey &key = pitFifo_.front().first;
+        PendingSample *sample = lookupPending(key);
+
+        // interest may have been answered already
+        if (sample && sample->segments_[key.isParity_].size() > key.segNo_)
+        {
+            PendingInterests &pis = sample->segments_[key.isParity_][key.segNo_];
+            auto it = std::find(pis.begin(), pis.end(), pitFifo_.front().second);
+
+            if (it != pis.end())
+            {
+                pis.erase(it);
+                sample->nPending_--;
+                nPending_--;
+                prunePending(key);
+            }
+        }
+
+        pitFifo_.pop_front();
+    }
+}
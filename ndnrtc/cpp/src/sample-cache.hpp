@@ -0,0 +1,197 @@
+//
+// sample-cache.hpp
+//
+//  Copyright 2013-2018 Regents of the University of California
+//
+
+#ifndef __sample_cache_h__
+#define __sample_cache_h__
+
+#include <deque>
+#include <map>
+#include <boost/shared_ptr.hpp>
+#include <ndn-cpp/name.hpp>
+#include <ndn-cpp/data.hpp>
+#include <ndn-cpp/interest.hpp>
+#include <ndn-cpp/util/memory-content-cache.hpp>
+
+#include "ndnrtc-common.hpp"
+#include "name-components.hpp"
+
+namespace ndn
+{
+class Face;
+}
+
+namespace ndnrtc
+{
+/**
+ * Producer's cache for segments of media samples (data and parity segments
+ * of video frames, segments of audio bundles). Unlike ndn::MemoryContentCache, which is a generic name-keyed
+ * store, it keeps samples of every thread and sample class in a ring,
+ * indexed by sequence number, thus interests are answered in constant time
+ * regardless of the number of cached samples. Samples are evicted once they
+ * are older than cache lifetime or, oldest first, once cache exceeds its
+ * memory budget.
+ * Only sample segment names of the stream are accepted (see isSampleName()),
+ * other names (metadata, manifests, FEC groups) should go through the
+ * generic cache.
+ * Pending interests are indexed by thread, sample class and sample number,
+ * so that interests for a segment are found without searching through the
+ * whole table and interests for a range of samples can be extracted at
+ * once (see extractPendingInterestsBefore()).
+ * Implements the subset of ndn::MemoryContentCache interface, used by
+ * PacketPublisher. Must be used on face thread.
+ */
+class SampleCache
+{
+  public:
+    typedef ndn::MemoryContentCache::PendingInterest PendingInterest;
+
+    /**
+     * @param streamPrefix Stream prefix (including stream timestamp)
+     * @param lifetimeMs Time samples are kept in cache
+     * @param budgetBytes Maximum total size of cached segments' content
+     * @param ringSize Maximum number of cached samples per thread and sample
+     *                 class
+     */
+    SampleCache(const ndn::Name &streamPrefix, unsigned int lifetimeMs,
+                size_t budgetBytes, unsigned int ringSize = 512);
+
+    /**
+     * Checks whether name is a name of a sample segment of the stream.
+     */
+    bool isSampleName(const ndn::Name &name) const;
+
+    /**
+     * Adds sample segment to the cache and sends it to all pending
+     * interests for it. Segments of a sample must be added in a row.
+     * Segment's default wire encoding is kept, thus data should be encoded
+     * (signed) before it is added.
+     * Throws if name is not a sample segment name.
+     */
+    void add(const ndn::Data &data);
+
+    /**
+     * Sends cached data for the interest, if there is any.
+     * @return true if interest was answered
+     */
+    bool satisfy(const ndn::Interest &interest, ndn::Face &face);
+
+    /**
+     * Stores interest, which couldn't be satisfied, until data for it is
+     * added or interest times out.
+     * @return false if interest is not for a sample segment, thus can't be
+     *         stored
+     */
+    bool storePendingInterest(const boost::shared_ptr<const ndn::Interest> &interest,
+                              ndn::Face &face);
+
+    void getPendingInterestsForName(const ndn::Name &name,
+                                    std::vector<boost::shared_ptr<const PendingInterest>> &pendingInterests);
+
+    /**
+     * Checks whether there are pending interests for a sample.
+     * @param prefix Sample name or sample parity name
+     *               (<sample name>/_parity)
+     */
+    bool hasPendingInterests(const ndn::Name &prefix);
+
+    /**
+     * Removes pending interests for a sample from the table and returns them.
+     * @param prefix Sample name or sample parity name. For sample name,
+     *               interests for both data and parity segments are
+     *               extracted.
+     */
+    void extractPendingInterestsWithPrefix(const ndn::Name &prefix,
+                                           std::vector<boost::shared_ptr<const PendingInterest>> &pendingInterests);
+
+    /**
+     * Removes pending interests for all samples of the same thread and
+     * sample class as the given sample, that have lower sample numbers, from
+     * the table and returns them.
+     * @param prefix Sample name, sample parity name or sample segment name
+     */
+    void extractPendingInterestsBefore(const ndn::Name &prefix,
+                                       std::vector<boost::shared_ptr<const PendingInterest>> &pendingInterests);
+
+    // total size of cached segments' content
+    size_t getSize() const { return nBytes_; }
+    size_t getPendingInterestsNum() const { return nPending_; }
+
+  private:
+    typedef struct _SegmentKey
+    {
+        std::string thread_;
+        SampleClass class_;
+        PacketNumber sampleNo_;
+        bool isParity_;
+        unsigned int segNo_;
+    } SegmentKey;
+
+    typedef std::vector<boost::shared_ptr<const PendingInterest>> PendingInterests;
+
+    typedef struct _PendingSample
+    {
+        _PendingSample() : nPending_(0) {}
+
+        // pending interests for data and parity segments, indexed by segment
+        // number
+        std::vector<PendingInterests> segments_[2];
+        size_t nPending_;
+    } PendingSample;
+
+    // pending samples of a thread and sample class, ordered by sample number
+    typedef std::map<PacketNumber, PendingSample> PendingSamples;
+
+    // cached segment is kept in wire format, as it is sent to the face
+    typedef struct _Segment
+    {
+        ndn::Name name_;
+        ndn::SignedBlob wire_; // null if segment is missing
+        double freshnessPeriodMs_;
+        size_t nBytes_;
+    } Segment;
+
+    typedef struct _Sample
+    {
+        PacketNumber sampleNo_; // -1 if slot is empty
+        int64_t addedMs_;
+        size_t nBytes_;
+        // data and parity segments, indexed by segment number
+        std::vector<Segment> segments_[2];
+    } Sample;
+
+    typedef std::vector<Sample> Ring;
+
+    typedef struct _FifoEntry
+    {
+        Ring *ring_;
+        PacketNumber sampleNo_;
+        int64_t addedMs_;
+    } FifoEntry;
+
+    ndn::Name streamPrefix_;
+    unsigned int lifetimeMs_;
+    size_t budgetBytes_, ringSize_, nBytes_, nPending_;
+    std::map<std::pair<std::string, SampleClass>, Ring> rings_;
+    // samples in the order they were added, for eviction
+    std::deque<FifoEntry> fifo_;
+    std::map<std::pair<std::string, SampleClass>, PendingSamples> pit_;
+    // pending interests in the order of arrival, for cleanup
+    std::deque<std::pair<SegmentKey, boost::shared_ptr<const PendingInterest>>> pitFifo_;
+
+    bool parse(const ndn::Name &name, SegmentKey &key) const;
+    bool parseSample(const ndn::Name &name, SegmentKey &key, bool &hasSegment) const;
+    Sample *lookup(const SegmentKey &key);
+    PendingSample *lookupPending(const SegmentKey &key);
+    void prunePending(const SegmentKey &key);
+    void extract(PendingSample &sample, bool isParity, const ndn::Name &prefix,
+                 PendingInterests &pendingInterests);
+    void evict(int64_t nowMs);
+    void evict(Sample &sample);
+    void cleanupPit(double nowMs);
+};
+}
+
+#endif
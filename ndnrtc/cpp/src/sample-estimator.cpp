@@ -6,6 +6,7 @@
 //
 
 #include "sample-estimator.hpp"
+#include <cmath>
 #include <boost/assign.hpp>
 
 #include "estimators.hpp"
@@ -19,7 +20,8 @@ using namespace estimators;
 //******************************************************************************
 SampleEstimator::Estimators::_Estimators():
 segNum_(Average(boost::make_shared<SampleWindow>(30))),
-segSize_(Average(boost::make_shared<SampleWindow>(30)))
+segSize_(Average(boost::make_shared<SampleWindow>(30))),
+parityRatio_(Average(boost::make_shared<SampleWindow>(30)))
 {}
 
 SampleEstimator::Estimators::~_Estimators()
@@ -46,6 +48,13 @@ void SampleEstimator::bootstrapSegmentSize(double value, SampleClass st, Segment
     estimators_[std::make_pair(st,dt)].segSize_.newValue((value > 0 ? value : 1000.));
 }
 
+void
+SampleEstimator::bootstrapParityRatio(double value, SampleClass st)
+{
+    if (value > 0)
+        estimators_[std::make_pair(st,SegmentClass::Parity)].parityRatio_.newValue(value);
+}
+
 void 
 SampleEstimator::segmentArrived(const boost::shared_ptr<WireSegment>& segment)
 {
@@ -57,6 +66,17 @@ SampleEstimator::segmentArrived(const boost::shared_ptr<WireSegment>& segment)
         //std::cout<<"SampleEstimator segmentArrived:"<<(double)(segment->getSlicesNum())<<" "<<(double)(segment->getData()->getContent().size())<<std::endl;
         estimators_[std::make_pair(st,dt)].segNum_.newValue(segment->getSlicesNum());
         estimators_[std::make_pair(st,dt)].segSize_.newValue(segment->getData()->getContent().size());
+
+        // every video data segment tells how many parity segments its frame has
+        boost::shared_ptr<WireData<VideoFrameSegmentHeader>> videoSegment = 
+            boost::dynamic_pointer_cast<WireData<VideoFrameSegmentHeader>>(segment);
+        if (dt == SegmentClass::Data && videoSegment)
+        {
+            const VideoFrameSegmentHeader &hdr = videoSegment->segment().getHeader();
+            if (hdr.totalSegmentsNum_ > 0 && hdr.paritySegmentsNum_ > 0)
+                estimators_[std::make_pair(st,SegmentClass::Parity)].parityRatio_.newValue(
+                    (double)hdr.paritySegmentsNum_/(double)hdr.totalSegmentsNum_);
+        }
         
         if (st == SampleClass::Delta)
         {
@@ -94,6 +114,17 @@ SampleEstimator::reset()
 double 
 SampleEstimator::getSegmentNumberEstimation(SampleClass st, SegmentClass dt)
 {
+    if (dt == SegmentClass::Parity)
+    {
+        double parityRatio = estimators_[std::make_pair(st,dt)].parityRatio_.value();
+        // same as producer (see getParitySymbolsNum()): ceil(ratio*nData), at least one
+        // segment; ratio is derived from integer segment numbers, so its
+        // rounding error is discarded before taking ceiling
+        if (parityRatio > 0)
+            return std::max(1., std::ceil(parityRatio*
+                estimators_[std::make_pair(st,SegmentClass::Data)].segNum_.value() - 1e-6));
+    }
+
 	return estimators_[std::make_pair(st,dt)].segNum_.value();
 }
 
@@ -41,6 +41,12 @@ namespace ndnrtc {
          * This initializes average estimator of the segment size per sample
          */
         void bootstrapSegmentSize(double value, SampleClass st, SegmentClass dt);
+
+        /**
+         * This initializes average estimator of the parity ratio (number of
+         * parity segments per one data segment), announced by producer
+         */
+        void bootstrapParityRatio(double value, SampleClass st);
         
         /**
          * Called by SegmentController each time new segment arrives
@@ -58,6 +64,11 @@ namespace ndnrtc {
          * @param dt Segment class - Data or Parity
          * @return Average estimation of the number of segments for sample/segment 
          *          class requested
+         * @note Once parity ratio is known (either from bootstrap or from data 
+         *          segments headers), number of parity segments is estimated 
+         *          from it and the number of data segments, so it follows 
+         *          producer's parity adjustments even if parity segments are 
+         *          lost or not fetched
          */
 		double getSegmentNumberEstimation(SampleClass st, SegmentClass dt);
         
@@ -76,6 +87,8 @@ namespace ndnrtc {
 			~_Estimators();
 
 			estimators::Average segNum_, segSize_;
+			// used for Parity segment class only
+			estimators::Average parityRatio_;
 		} Estimators;
 		typedef std::map<std::pair<SampleClass, SegmentClass>, Estimators> EstimatorMap;
 		EstimatorMap estimators_;
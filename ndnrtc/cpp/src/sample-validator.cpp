@@ -13,8 +13,14 @@
 #include "frame-data.hpp"
 #include "name-components.hpp"
 #include "meta-fetcher.hpp"
+#include "clock.hpp"
 
 static const unsigned int META_FETCHER_POOL_SIZE = 100;
+// number of most recent aggregated manifests kept
+static const unsigned int MANIFEST_WINDOWS_NUM = 8;
+// aggregated manifest is published only when producer closes the window,
+// thus interest for it may time out
+static const unsigned int MANIFEST_WINDOW_RETRIES = 3;
 
 using namespace ndnrtc;
 using namespace ndn;
@@ -57,75 +63,293 @@ ManifestValidator::ManifestValidator(boost::shared_ptr<ndn::Face> face,
                                      boost::shared_ptr<ndn::KeyChain> keyChain,
                                      const boost::shared_ptr<StatisticsStorage> &statStorage) 
     : StatObject(statStorage), face_(face), keyChain_(keyChain),
-    metaFetcherPool_(META_FETCHER_POOL_SIZE)
+    metaFetcherPool_(META_FETCHER_POOL_SIZE), manifestWindow_(0)
 {
     description_ = "sample-validator";
 }
 
+void ManifestValidator::setManifestWindow(unsigned int manifestWindow)
+{
+    manifestWindow_ = (manifestWindow > 1 ? manifestWindow : 0);
+    windows_.clear();
+}
+
 void ManifestValidator::onNewRequest(const boost::shared_ptr<BufferSlot> &slot)
 {
     if (slot->getState() == BufferSlot::State::New)
     {
-        // initiate manifest fetching
-        if (metaFetcherPool_.size() == 0)
-            metaFetcherPool_.enlarge(META_FETCHER_POOL_SIZE);
-
-        boost::shared_ptr<ManifestValidator> me = boost::dynamic_pointer_cast<ManifestValidator>(shared_from_this());
-        boost::shared_ptr<MetaFetcher> mfetcher = metaFetcherPool_.pop();
-        Name manifestName = slot->getNameInfo().getPrefix(prefix_filter::Sample).append(NameComponents::NameComponentManifest);
-        mfetcher->fetch(face_, keyChain_,
-                        manifestName,
-                        [mfetcher, slot, me, this](NetworkData &nd, 
-                                                   const std::vector<ValidationErrorInfo> info, 
-                                                   const std::vector<boost::shared_ptr<Data>>&) {
-                            if (info.size())
+        if (isWindowed(slot))
+        {
+            // producer publishes aggregated manifest when it publishes the
+            // last frame of the window, so it's requested along with it
+            PacketNumber sampleNo = slot->getNameInfo().sampleNo_;
+            PacketNumber windowNo = AggregatedManifest::windowNo(sampleNo, manifestWindow_);
+            if ((sampleNo + 1) % manifestWindow_ == 0 && windows_.find(windowNo) == windows_.end())
+                fetchManifestWindow(slot->getNameInfo().getPrefix(prefix_filter::ThreadNT), windowNo);
+        }
+        else
+            fetchManifest(slot);
+    }
+}
+
+void ManifestValidator::onNewData(const BufferReceipt &receipt)
+{
+    const boost::shared_ptr<const BufferSlot> &slot = receipt.slot_;
+
+    if (slot->getVerificationStatus() == BufferSlot::Verification::Unknown)
+        if (slot->getState() & BufferSlot::State::Ready ||
+            slot->getState() & BufferSlot::State::Locked)
+        {
+            if (slot->manifest_.get())
+                verifySlot(slot);
+            else if (isWindowed(slot))
+                verifyWindowedSlot(slot);
+        }
+}
+
+void ManifestValidator::verifyWindowedSlot(const boost::shared_ptr<const BufferSlot> &slot)
+{
+    PacketNumber windowNo = AggregatedManifest::windowNo(slot->getNameInfo().sampleNo_, manifestWindow_);
+    std::map<PacketNumber, ManifestWindow>::iterator it = windows_.find(windowNo);
+
+    // window's last frame is not requested yet, window fetching failed
+    // before or slot was requested before aggregated manifests were announced
+    if (it == windows_.end())
+    {
+        fetchManifestWindow(slot->getNameInfo().getPrefix(prefix_filter::ThreadNT), windowNo);
+        if ((it = windows_.find(windowNo)) == windows_.end())
+        {
+            // window is older than all the ones kept
+            slotVerificationFailed(slot);
+            return;
+        }
+    }
+
+    if (it->second.manifest_)
+        verifySlot(slot, windowNo, it->second);
+    else
+    {
+        Name sampleName = slot->getNameInfo().getPrefix(prefix_filter::Sample);
+        for (auto &p : it->second.pending_)
+            if (p.first == slot && p.second == sampleName)
+                return;
+        it->second.pending_.push_back(PendingSlot(slot, sampleName));
+    }
+}
+
+bool ManifestValidator::isWindowed(const boost::shared_ptr<const BufferSlot> &slot) const
+{
+    return manifestWindow_ && slot->getNameInfo().isDelta_ && slot->getNameInfo().hasSeqNo_;
+}
+
+void ManifestValidator::fetchManifest(const boost::shared_ptr<const BufferSlot> &slot)
+{
+    // initiate manifest fetching
+    if (metaFetcherPool_.size() == 0)
+        metaFetcherPool_.enlarge(META_FETCHER_POOL_SIZE);
+
+    boost::shared_ptr<ManifestValidator> me = boost::dynamic_pointer_cast<ManifestValidator>(shared_from_this());
+    boost::shared_ptr<MetaFetcher> mfetcher = metaFetcherPool_.pop();
+    Name manifestName = slot->getNameInfo().getPrefix(prefix_filter::Sample).append(NameComponents::NameComponentManifest);
+    mfetcher->fetch(face_, keyChain_,
+                    manifestName,
+                    [mfetcher, slot, me, this](NetworkData &nd, 
+                                               const std::vector<ValidationErrorInfo> info, 
+                                               const std::vector<boost::shared_ptr<Data>>&) {
+                        if (info.size())
+                        {
+                            // had problems verifying manifest
+                            for (auto &i : info)
+                                LogWarnC << "manifest verification failure " << i.getData()->getName()
+                                         << " (KeyLocator " << (KeyLocator::getFromSignature(i.getData()->getSignature())).getKeyName()
+                                         << "), reason: "
+                                         << i.getReason() << std::endl;
+                            slot->verified_ = BufferSlot::Verification::Failed;
+                            (*me->statStorage_)[Indicator::VerifyFailure]++;
+                        }
+                        else
+                        {
+                            LogTraceC << "received manifest for "
+                                      << slot->getNameInfo().getSuffix(suffix_filter::Thread) << std::endl;
+
+                            if (slot->getState() >= BufferSlot::State::New)
                             {
-                                // had problems verifying manifest
-                                for (auto &i : info)
-                                    LogWarnC << "manifest verification failure " << i.getData()->getName()
-                                             << " (KeyLocator " << (KeyLocator::getFromSignature(i.getData()->getSignature())).getKeyName()
-                                             << "), reason: "
-                                             << i.getReason() << std::endl;
-                                slot->verified_ = BufferSlot::Verification::Failed;
-                                (*me->statStorage_)[Indicator::VerifyFailure]++;
+                                slot->manifest_ = boost::make_shared<Manifest>(boost::move(nd));
+                                if (slot->getState() >= BufferSlot::State::Ready)
+                                    verifySlot(slot);
                             }
                             else
+                                LogWarnC << "late manifest arrival "
+                                         << slot->getNameInfo().getSuffix(suffix_filter::Thread) << std::endl;
+                        }
+                        metaFetcherPool_.push(mfetcher);
+                    },
+                    [mfetcher, slot, me, this](const std::string &) {
+                        LogErrorC << "couldn't fetch manifest for "
+                                  << slot->getNameInfo().getSuffix(suffix_filter::Thread)
+                                  << std::endl;
+
+                        metaFetcherPool_.push(mfetcher);
+                        (*me->statStorage_)[Indicator::VerifyFailure]++;
+                    });
+
+    LogTraceC << "fetch " << manifestName << std::endl;
+}
+
+void ManifestValidator::fetchManifestWindow(const ndn::Name &threadPrefix, PacketNumber windowNo,
+                                            bool isRetry)
+{
+    // window may be fetched again (its newer version), slots waiting for it
+    // are kept
+    windows_[windowNo].manifest_.reset();
+    if (!isRetry)
+        windows_[windowNo].nRetries_ = 0;
+    while (windows_.size() > MANIFEST_WINDOWS_NUM)
+        windows_.erase(windows_.begin());
+
+    if (metaFetcherPool_.size() == 0)
+        metaFetcherPool_.enlarge(META_FETCHER_POOL_SIZE);
+
+    boost::shared_ptr<ManifestValidator> me = boost::dynamic_pointer_cast<ManifestValidator>(shared_from_this());
+    boost::shared_ptr<MetaFetcher> mfetcher = metaFetcherPool_.pop();
+    Name manifestName = AggregatedManifest::windowName(threadPrefix, windowNo);
+    mfetcher->fetch(face_, keyChain_,
+                    manifestName,
+                    [mfetcher, windowNo, me, this](NetworkData &nd,
+                                                   const std::vector<ValidationErrorInfo> info,
+                                                   const std::vector<boost::shared_ptr<Data>>&) {
+                        boost::shared_ptr<AggregatedManifest> manifest;
+
+                        if (info.size())
+                        {
+                            for (auto &i : info)
+                                LogWarnC << "aggregated manifest verification failure " << i.getData()->getName()
+                                         << " (KeyLocator " << (KeyLocator::getFromSignature(i.getData()->getSignature())).getKeyName()
+                                         << "), reason: "
+                                         << i.getReason() << std::endl;
+                            (*me->statStorage_)[Indicator::VerifyFailure]++;
+                        }
+                        else
+                        {
+                            manifest = boost::make_shared<AggregatedManifest>(boost::move(nd));
+                            if (!manifest->isValid())
                             {
-                                LogTraceC << "received manifest for "
-                                          << slot->getNameInfo().getSuffix(suffix_filter::Thread) << std::endl;
-
-                                if (slot->getState() >= BufferSlot::State::New)
-                                {
-                                    slot->manifest_ = boost::make_shared<Manifest>(boost::move(nd));
-                                    if (slot->getState() >= BufferSlot::State::Ready)
-                                        verifySlot(slot);
-                                }
-                                else
-                                    LogWarnC << "late manifest arrival "
-                                             << slot->getNameInfo().getSuffix(suffix_filter::Thread) << std::endl;
+                                LogWarnC << "received invalid aggregated manifest " << windowNo << std::endl;
+                                manifest.reset();
                             }
-                            metaFetcherPool_.push(mfetcher);
-                        },
-                        [mfetcher, slot, me, this](const std::string &) {
-                            LogErrorC << "couldn't fetch manifest for "
-                                      << slot->getNameInfo().getSuffix(suffix_filter::Thread)
-                                      << std::endl;
-
-                            metaFetcherPool_.push(mfetcher);
-                            (*me->statStorage_)[Indicator::VerifyFailure]++;
-                        });
+                            else
+                                (*me->statStorage_)[Indicator::ManifestWindowFetchedNum]++;
+                        }
+
+                        metaFetcherPool_.push(mfetcher);
+                        onManifestWindow(windowNo, manifest);
+                    },
+                    [mfetcher, threadPrefix, windowNo, me, this](const std::string &reason) {
+                        metaFetcherPool_.push(mfetcher);
+
+                        // window may be closed later than expected, i.e. if
+                        // its last frame was requested ahead or frames were
+                        // dropped by producer
+                        std::map<PacketNumber, ManifestWindow>::iterator it = windows_.find(windowNo);
+                        if (it != windows_.end() && it->second.nRetries_ < MANIFEST_WINDOW_RETRIES)
+                        {
+                            it->second.nRetries_++;
+                            LogDebugC << "retry fetching aggregated manifest " << windowNo
+                                      << " (" << reason << ")" << std::endl;
+                            fetchManifestWindow(threadPrefix, windowNo, true);
+                            return;
+                        }
+
+                        LogWarnC << "couldn't fetch aggregated manifest " << windowNo << std::endl;
+                        onManifestWindow(windowNo, boost::shared_ptr<AggregatedManifest>());
+                    });
+
+    LogTraceC << "fetch " << manifestName << std::endl;
+}
+
+void ManifestValidator::onManifestWindow(PacketNumber windowNo,
+                                         const boost::shared_ptr<AggregatedManifest> &manifest)
+{
+    std::map<PacketNumber, ManifestWindow>::iterator it = windows_.find(windowNo);
+    if (it == windows_.end())
+        return;
+
+    std::vector<PendingSlot> pending;
+    pending.swap(it->second.pending_);
+
+    LogTraceC << "received aggregated manifest " << windowNo
+              << (manifest ? "" : " (failed)")
+              << " pending slots " << pending.size() << std::endl;
 
-        LogTraceC << "fetch " << manifestName << std::endl;
+    // delta frames may have no manifests of their own, thus frames of the
+    // window can't be verified, if aggregated manifest is not available;
+    // window is fetched again for frames that become ready later
+    if (manifest)
+    {
+        it->second.manifest_ = manifest;
+        it->second.fetchedUsec_ = clock::microsecondTimestamp();
+    }
+    else
+        windows_.erase(it);
+
+    for (auto &p : pending)
+    {
+        const boost::shared_ptr<const BufferSlot> &slot = p.first;
+
+        if (slot->getState() >= BufferSlot::State::Ready &&
+            slot->getVerificationStatus() == BufferSlot::Verification::Unknown &&
+            slot->getNameInfo().getPrefix(prefix_filter::Sample) == p.second)
+        {
+            if (!manifest)
+                slotVerificationFailed(slot);
+            else if (it->second.manifest_)
+                verifySlot(slot, windowNo, it->second);
+            else // another slot made window to be fetched again
+                it->second.pending_.push_back(p);
+        }
     }
 }
 
-void ManifestValidator::onNewData(const BufferReceipt &receipt)
+void ManifestValidator::verifySlot(const boost::shared_ptr<const BufferSlot> &slot,
+                                   PacketNumber windowNo, const ManifestWindow &window)
 {
-    if (receipt.slot_->getVerificationStatus() == BufferSlot::Verification::Unknown)
-        if ((receipt.slot_->getState() & BufferSlot::State::Ready ||
-             receipt.slot_->getState() & BufferSlot::State::Locked) &&
-            receipt.slot_->manifest_.get())
-            verifySlot(receipt.slot_);
+    bool covered = true;
+    int64_t lastArrivalUsec = 0;
+
+    for (auto &s : slot->getFetchedSegments())
+    {
+        if (s->getData()->isRecovered())
+            continue;
+
+        covered = covered && window.manifest_->hasData(*(s->getData()->getData()));
+        lastArrivalUsec = std::max(lastArrivalUsec, s->getArrivalTimeUsec());
+    }
+
+    if (covered)
+        slotVerified(slot);
+    else if (lastArrivalUsec > window.fetchedUsec_)
+    {
+        // segments published after the window was closed (i.e. parity
+        // computed on request) are covered by a newer version of the window
+        LogDebugC << "segment is not in aggregated manifest "
+                  << slot->getNameInfo().getSuffix(suffix_filter::Thread)
+                  << ", fetching newer one" << std::endl;
+
+        PendingSlot pendingSlot(slot, slot->getNameInfo().getPrefix(prefix_filter::Sample));
+        fetchManifestWindow(slot->getNameInfo().getPrefix(prefix_filter::ThreadNT), windowNo);
+        windows_[windowNo].pending_.push_back(pendingSlot);
+    }
+    else
+        slotVerificationFailed(slot);
+}
+
+void ManifestValidator::slotVerificationFailed(const boost::shared_ptr<const BufferSlot> &slot)
+{
+    slot->verified_ = BufferSlot::Verification::Failed;
+
+    LogErrorC << "slot verification failure "
+              << slot->getNameInfo().getSuffix(suffix_filter::Thread) << std::endl;
+    (*statStorage_)[Indicator::VerifyFailure]++;
 }
 
 void ManifestValidator::verifySlot(const boost::shared_ptr<const BufferSlot> slot)
@@ -133,19 +357,28 @@ void ManifestValidator::verifySlot(const boost::shared_ptr<const BufferSlot> slo
     assert(slot->getState() >= BufferSlot::State::Ready);
 
     bool verified = true;
-    for (auto &it : slot->fetched_)
-        verified &= slot->manifest_->hasData(*(it.second->getData()->getData()));
-    slot->verified_ = (verified ? BufferSlot::Verification::Verified : BufferSlot::Verification::Failed);
+    for (auto &s : slot->getFetchedSegments())
+        if (!s->getData()->isRecovered())
+            verified &= slot->manifest_->hasData(*(s->getData()->getData()));
 
-    if (slot->getVerificationStatus() == BufferSlot::Verification::Failed)
-    {
-        LogErrorC << "slot verification failure "
-                  << slot->getNameInfo().getSuffix(suffix_filter::Thread) << std::endl;
-        (*statStorage_)[Indicator::VerifyFailure]++;
-    }
+    if (!verified)
+        slotVerificationFailed(slot);
     else
-    {
-        LogDebugC << "verified " << slot->dump() << std::endl;
-        (*statStorage_)[Indicator::VerifySuccess]++;
-    }
+        slotVerified(slot);
+}
+
+void ManifestValidator::slotVerified(const boost::shared_ptr<const BufferSlot> &slot)
+{
+    // recovered segments are not in manifests, but they are computed from
+    // FEC group packets, which are verified upon fetching
+    bool hasRecovered = false;
+    for (auto &s : slot->getFetchedSegments())
+        hasRecovered |= s->getData()->isRecovered();
+
+    slot->verified_ = BufferSlot::Verification::Verified;
+
+    LogDebugC << "verified " << (hasRecovered ? "(recovered) " : "") << slot->dump() << std::endl;
+    (*statStorage_)[Indicator::VerifySuccess]++;
+    if (hasRecovered)
+        (*statStorage_)[Indicator::VerifyRecovered]++;
 }
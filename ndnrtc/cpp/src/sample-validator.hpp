@@ -8,6 +8,8 @@
 #ifndef __sample_validator_h__
 #define __sample_validator_h__
 
+#include <map>
+
 #include "ndnrtc-object.hpp"
 #include "frame-buffer.hpp"
 #include "statistics.hpp"
@@ -26,6 +28,7 @@ class StatisticsStorage;
 }
 
 class MetaFetcher;
+class AggregatedManifest;
 
 /**
  * Used for validating signed samples.
@@ -47,6 +50,13 @@ class SampleValidator : public NdnRtcComponent, public IBufferObserver, statisti
 
 /**
  * Used for validating multi-segment unsigned data, where signed manifest is published. 
+ * If producer covers delta frames with aggregated manifests, one manifest is
+ * fetched per window of delta frames, once the window's last frame is
+ * requested; delta frames of such windows have no manifests of their own and
+ * fail verification if their segments are not described by aggregated
+ * manifest (or its newer version). Segments recovered from FEC group packets
+ * are not described by manifests and are not checked against them (see
+ * WireSegment::isRecovered()).
  */
 class ManifestValidator : public NdnRtcComponent, public IBufferObserver, statistics::StatObject
 {
@@ -55,6 +65,13 @@ class ManifestValidator : public NdnRtcComponent, public IBufferObserver, statis
                       boost::shared_ptr<ndn::KeyChain> keyChain,
                       const boost::shared_ptr<statistics::StatisticsStorage> &statStorage);
 
+    /**
+     * Sets number of consecutive delta frames, covered by one aggregated
+     * manifest, as announced in thread metadata. Zero turns aggregated
+     * manifests off.
+     */
+    void setManifestWindow(unsigned int manifestWindow);
+
   private:
     template <typename T>
     class Pool
@@ -100,14 +117,39 @@ class ManifestValidator : public NdnRtcComponent, public IBufferObserver, statis
         std::vector<boost::shared_ptr<T>> pool_;
     };
 
+    // ready slots, waiting for aggregated manifest, are kept along with their
+    // sample names, as slots may be reused for other samples meanwhile
+    typedef std::pair<boost::shared_ptr<const BufferSlot>, ndn::Name> PendingSlot;
+    typedef struct _ManifestWindow
+    {
+        _ManifestWindow() : fetchedUsec_(0), nRetries_(0) {}
+
+        boost::shared_ptr<AggregatedManifest> manifest_; // nullptr while fetching
+        int64_t fetchedUsec_; // when manifest was received
+        unsigned int nRetries_; // fetch attempts timed out so far
+        std::vector<PendingSlot> pending_;
+    } ManifestWindow;
+
     boost::shared_ptr<ndn::Face> face_;
     boost::shared_ptr<ndn::KeyChain> keyChain_;
     Pool<MetaFetcher> metaFetcherPool_;
+    unsigned int manifestWindow_;
+    std::map<PacketNumber, ManifestWindow> windows_;
 
     void onNewRequest(const boost::shared_ptr<BufferSlot> &);
     void onNewData(const BufferReceipt &receipt);
-    void onReset() {}
+    void onReset() { windows_.clear(); }
+    void fetchManifest(const boost::shared_ptr<const BufferSlot> &slot);
+    void fetchManifestWindow(const ndn::Name &threadPrefix, PacketNumber windowNo,
+                             bool isRetry = false);
+    void onManifestWindow(PacketNumber windowNo, const boost::shared_ptr<AggregatedManifest> &manifest);
+    bool isWindowed(const boost::shared_ptr<const BufferSlot> &slot) const;
     void verifySlot(const boost::shared_ptr<const BufferSlot> slot);
+    void verifyWindowedSlot(const boost::shared_ptr<const BufferSlot> &slot);
+    void verifySlot(const boost::shared_ptr<const BufferSlot> &slot, PacketNumber windowNo,
+                    const ManifestWindow &window);
+    void slotVerified(const boost::shared_ptr<const BufferSlot> &slot);
+    void slotVerificationFailed(const boost::shared_ptr<const BufferSlot> &slot);
 };
 }
 
@@ -0,0 +1,171 @@
+//
+// signing-pool.cpp
+//
+//  Copyright 2013-2018 Regents of the University of California
+//
+
+#include "signing-pool.hpp"
+
+#include <map>
+#include <stdexcept>
+#include <boost/bind.hpp>
+#include <boost/make_shared.hpp>
+
+using namespace ndnrtc;
+
+SigningPool::SigningPool(unsigned int nThreads, ndn::KeyChain *keyChain,
+                         const std::vector<ndn::KeyChain *> &workerKeyChains)
+    : isRunning_(true), keyChain_(keyChain)
+{
+    for (unsigned int i = 0; i < nThreads; ++i)
+        workers_.push_back(boost::thread(boost::bind(&SigningPool::work, this,
+                                                     (i < workerKeyChains.size() ? workerKeyChains[i] : nullptr))));
+}
+
+SigningPool::~SigningPool()
+{
+    {
+        boost::lock_guard<boost::mutex> scopedLock(mutex_);
+        isRunning_ = false;
+    }
+    taskCond_.notify_all();
+
+    for (auto &w : workers_)
+        w.join();
+}
+
+void SigningPool::submit(const std::vector<SigningTask> &tasks, const OnBatchDone &onDone)
+{
+    if (workers_.size() == 0)
+    {
+        std::string error;
+        for (auto &t : tasks)
+        {
+            std::string taskError = perform(t, keyChain_, true);
+            if (error.empty())
+                error = taskError;
+        }
+
+        onDone(error);
+        return;
+    }
+
+    boost::shared_ptr<Batch> batch(boost::make_shared<Batch>());
+    batch->tasks_ = tasks;
+    batch->onDone_ = onDone;
+    batch->nextTask_ = 0;
+    batch->nDone_ = 0;
+
+    {
+        boost::lock_guard<boost::mutex> scopedLock(mutex_);
+        batches_.push_back(batch);
+    }
+    taskCond_.notify_all();
+
+    // nothing to perform, but batch still completes in order
+    if (tasks.empty())
+        complete();
+}
+
+boost::mutex &SigningPool::getKeyChainMutex(const void *keyChain)
+{
+    // there are only few key chains per application, thus mutexes are never
+    // released
+    static boost::mutex registryMutex;
+    static std::map<const void *, boost::shared_ptr<boost::mutex>> mutexes;
+
+    boost::lock_guard<boost::mutex> scopedLock(registryMutex);
+    boost::shared_ptr<boost::mutex> &m = mutexes[keyChain];
+    if (!m)
+        m = boost::make_shared<boost::mutex>();
+
+    return *m;
+}
+
+//******************************************************************************
+void SigningPool::work(ndn::KeyChain *ownKeyChain)
+{
+    ndn::KeyChain *keyChain = (ownKeyChain ? ownKeyChain : keyChain_);
+
+    while (true)
+    {
+        boost::shared_ptr<Batch> batch;
+        const SigningTask *task;
+        {
+            boost::unique_lock<boost::mutex> lock(mutex_);
+            while (isRunning_)
+            {
+                // the oldest batch, which tasks are not taken yet
+                for (auto b : batches_)
+                    if (b->nextTask_ < b->tasks_.size())
+                    {
+                        batch = b;
+                        break;
+                    }
+
+                if (batch)
+                    break;
+                taskCond_.wait(lock);
+            }
+
+            if (!isRunning_)
+                return;
+            task = &batch->tasks_[batch->nextTask_++];
+        }
+
+        std::string error = perform(*task, keyChain, (ownKeyChain == nullptr));
+        bool isDone;
+        {
+            boost::lock_guard<boost::mutex> scopedLock(mutex_);
+            if (error.size() && batch->error_.empty())
+                batch->error_ = error;
+            isDone = (++batch->nDone_ == batch->tasks_.size());
+        }
+
+        if (isDone)
+            complete();
+    }
+}
+
+std::string SigningPool::perform(const SigningTask &task, ndn::KeyChain *keyChain, bool isShared)
+{
+    try
+    {
+        if (isShared)
+        {
+            boost::lock_guard<boost::mutex> keyChainLock(getKeyChainMutex(keyChain));
+            task(*keyChain);
+        }
+        else
+            task(*keyChain);
+    }
+    catch (std::exception &e)
+    {
+        return e.what();
+    }
+
+    return "";
+}
+
+void SigningPool::complete()
+{
+    // one thread at a time calls completion callbacks, in the order batches
+    // were submitted; batch, completed ahead of older ones, is completed by
+    // the thread that completes the last of the older batches
+    boost::lock_guard<boost::mutex> completionLock(completionMutex_);
+
+    while (true)
+    {
+        boost::shared_ptr<Batch> batch;
+        {
+            boost::lock_guard<boost::mutex> scopedLock(mutex_);
+            if (batches_.empty() || batches_.front()->nDone_ < batches_.front()->tasks_.size())
+                return;
+
+            batch = batches_.front();
+            batches_.pop_front();
+        }
+
+        batch->onDone_(batch->error_);
+    }
+}
@@ -0,0 +1,95 @@
+//
+// signing-pool.hpp
+//
+//  Copyright 2013-2018 Regents of the University of California
+//
+
+#ifndef __signing_pool_h__
+#define __signing_pool_h__
+
+#include <deque>
+#include <string>
+#include <vector>
+#include <boost/function.hpp>
+#include <boost/shared_ptr.hpp>
+#include <boost/thread.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/condition_variable.hpp>
+
+namespace ndn
+{
+class KeyChain;
+}
+
+namespace ndnrtc
+{
+/**
+ * Signing pool performs signing of packet segments in parallel on a fixed
+ * number of worker threads. Segments of one packet are submitted as a batch
+ * of tasks; submit() returns right away and batch completion callback is
+ * called on one of the worker threads once all tasks of the batch are
+ * performed. Completion callbacks are called in the order batches were
+ * submitted, thus caller may add signed segments to memory cache in order.
+ * ndn::KeyChain is not thread-safe. Workers that were given their own key
+ * chains sign in parallel; the rest share one key chain and use it one at a
+ * time, under the lock returned by getKeyChainMutex(), which must also be
+ * held by any other thread signing with this key chain.
+ */
+class SigningPool
+{
+  public:
+    typedef boost::function<void(ndn::KeyChain &)> SigningTask;
+    // error is empty if all tasks of the batch succeeded
+    typedef boost::function<void(const std::string &error)> OnBatchDone;
+
+    /**
+     * @param nThreads Number of worker threads. With zero threads, tasks
+     *                 are performed on the calling thread
+     * @param keyChain Key chain shared by workers that don't have their own
+     * @param workerKeyChains Key chains of the first workers, one per worker
+     */
+    SigningPool(unsigned int nThreads, ndn::KeyChain *keyChain,
+                const std::vector<ndn::KeyChain *> &workerKeyChains = std::vector<ndn::KeyChain *>());
+    ~SigningPool();
+
+    /**
+     * Queues batch of signing tasks and returns without waiting for them.
+     * Without worker threads, performs tasks and calls onDone before
+     * returning. Batches that are still queued when the pool is destroyed
+     * are dropped without calling onDone.
+     */
+    void submit(const std::vector<SigningTask> &tasks, const OnBatchDone &onDone);
+
+    unsigned int getThreadsNum() const { return workers_.size(); }
+
+    /**
+     * Returns mutex that guards given key chain from concurrent use.
+     */
+    static boost::mutex &getKeyChainMutex(const void *keyChain);
+
+  private:
+    SigningPool(const SigningPool &) = delete;
+
+    typedef struct _Batch
+    {
+        std::vector<SigningTask> tasks_;
+        OnBatchDone onDone_;
+        size_t nextTask_, nDone_;
+        std::string error_;
+    } Batch;
+
+    bool isRunning_;
+    ndn::KeyChain *keyChain_;
+    boost::mutex mutex_, completionMutex_;
+    boost::condition_variable taskCond_;
+    std::vector<boost::thread> workers_;
+    // batches in the order of submission, until they are completed
+    std::deque<boost::shared_ptr<Batch>> batches_;
+
+    void work(ndn::KeyChain *ownKeyChain);
+    static std::string perform(const SigningTask &task, ndn::KeyChain *keyChain, bool isShared);
+    void complete();
+};
+}
+
+#endif
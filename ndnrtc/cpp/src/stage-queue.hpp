@@ -0,0 +1,127 @@
+//
+// stage-queue.hpp
+//
+//  Copyright 2013-2018 Regents of the University of California
+//
+
+#ifndef __stage_queue_h__
+#define __stage_queue_h__
+
+#include <deque>
+#include <stdexcept>
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/lock_guard.hpp>
+#include <boost/thread/condition_variable.hpp>
+
+namespace ndnrtc
+{
+/**
+ * Stage queue connects two stages of a processing pipeline, each running on
+ * its own thread (single producer - single consumer). Queue is bounded: once
+ * it's full, either the oldest queued element is dropped to free space for
+ * the new one, or the new one is dropped. Producer is never blocked, consumer
+ * blocks until there is an element or the queue is stopped.
+ */
+template <typename T>
+class StageQueue
+{
+  public:
+    typedef enum _DropPolicy
+    {
+        DropOldest,
+        DropNewest
+    } DropPolicy;
+
+    StageQueue(size_t capacity, DropPolicy policy = DropOldest)
+        : capacity_(capacity), policy_(policy), isRunning_(true), nDropped_(0)
+    {
+        if (capacity_ == 0)
+            throw std::runtime_error("stage queue capacity must be positive");
+    }
+
+    /**
+     * Enqueues element.
+     * @return false if queue is stopped or element was dropped due to
+     *          drop-newest policy, true otherwise
+     */
+    bool push(const T &el)
+    {
+        {
+            boost::lock_guard<boost::mutex> scopedLock(mutex_);
+
+            if (!isRunning_)
+                return false;
+
+            if (queue_.size() >= capacity_)
+            {
+                nDropped_++;
+                if (policy_ == DropNewest)
+                    return false;
+                queue_.pop_front();
+            }
+            queue_.push_back(el);
+        }
+        cond_.notify_one();
+        return true;
+    }
+
+    /**
+     * Dequeues element, blocks if the queue is empty.
+     * @return false if queue was stopped
+     */
+    bool pop(T &el)
+    {
+        boost::unique_lock<boost::mutex> lock(mutex_);
+        while (isRunning_ && queue_.size() == 0)
+            cond_.wait(lock);
+
+        if (!isRunning_)
+            return false;
+
+        el = queue_.front();
+        queue_.pop_front();
+        return true;
+    }
+
+    /**
+     * Stops the queue: wakes up blocked consumer and discards queued elements.
+     */
+    void stop()
+    {
+        {
+            boost::lock_guard<boost::mutex> scopedLock(mutex_);
+            isRunning_ = false;
+            queue_.clear();
+        }
+        cond_.notify_all();
+    }
+
+    size_t size() const
+    {
+        boost::lock_guard<boost::mutex> scopedLock(mutex_);
+        return queue_.size();
+    }
+
+    size_t capacity() const { return capacity_; }
+
+    // number of elements dropped because queue was full
+    uint64_t getDroppedNum() const
+    {
+        boost::lock_guard<boost::mutex> scopedLock(mutex_);
+        return nDropped_;
+    }
+
+  private:
+    StageQueue(const StageQueue<T> &) = delete;
+
+    size_t capacity_;
+    DropPolicy policy_;
+    bool isRunning_;
+    uint64_t nDropped_;
+    std::deque<T> queue_;
+    mutable boost::mutex mutex_;
+    boost::condition_variable cond_;
+};
+}
+
+#endif
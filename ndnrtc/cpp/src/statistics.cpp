@@ -32,6 +32,8 @@ map_list_of
 ( Indicator::RecoveredKeyNum, "Recovered key frames" ) 
 ( Indicator::RescuedNum, "Rescued frames" ) 
 ( Indicator::RescuedKeyNum, "Rescued key frames" ) 
+( Indicator::FecGroupFetchedNum, "Fetched FEC groups" ) 
+( Indicator::FecGroupRecoveredNum, "Frames recovered by FEC groups" ) 
 ( Indicator::IncompleteNum, "Incomplete frames" ) 
 ( Indicator::IncompleteKeyNum, "Incomplete key frames" ) 
 ( Indicator::BufferTargetSize, "Jitter target size" ) 
@@ -40,6 +42,8 @@ map_list_of
 ( Indicator::CurrentProducerFramerate, "Producer rate" )
 ( Indicator::VerifySuccess, "Verified samples" )
 ( Indicator::VerifyFailure, "Verify failure samples" )
+( Indicator::VerifyRecovered, "Verified samples with recovered segments" )
+( Indicator::ManifestWindowFetchedNum, "Fetched aggregated manifests" )
 ( Indicator::LatencyControlStable, "Latency control stable state" )
 ( Indicator::LatencyControlCommand, "Latency control command" )
 ( Indicator::FrameFetchAvgDelta, "Average time for fetching delta frames" )
@@ -90,12 +94,30 @@ map_list_of
 ( Indicator::PublishedKeyNum, "Published key frames" )
 ( Indicator::InterestsReceivedNum, "Interests received" )
 ( Indicator::SignNum, "Sign operations")
+( Indicator::ParityDeferredNum, "Frames with deferred parity" )
+( Indicator::ParityLazyNum, "Frames with parity computed on request" )
+( Indicator::ParityFailedNum, "Frames which parity failed to compute" )
+( Indicator::FecGroupPublishedNum, "Published FEC groups" )
+( Indicator::ManifestWindowPublishedNum, "Published aggregated manifests" )
+
+// producer pipeline
+( Indicator::PipelineCaptureQueueSize, "Pipeline capture queue" )
+( Indicator::PipelinePublishQueueSize, "Pipeline publish queue" )
+( Indicator::PipelineDroppedNum, "Pipeline dropped frames" )
+( Indicator::PipelineQueueDelay, "Pipeline queueing delay (ms)" )
+( Indicator::PipelineEncodeDelay, "Pipeline encoding delay (ms)" )
+( Indicator::PipelinePublishDelay, "Pipeline publishing delay (ms)" )
 
 // encoder
 ( Indicator::EncodedNum, "Encoded frames" )
+( Indicator::EncoderBitrateRatio, "Encoder bitrate ratio" )
+( Indicator::EncoderFrameRateRatio, "Encoder frame rate ratio" )
+( Indicator::RateControlSkippedNum, "Frames skipped by rate control" )
 
 // capturer
-( Indicator::CapturedNum, "Captured frames" );
+( Indicator::CapturedNum, "Captured frames" )
+( Indicator::FramePoolHitNum, "Frame buffer pool hits (all streams)" )
+( Indicator::FramePoolMissNum, "Frame buffer pool misses (all streams)" );
 
 const StatisticsStorage::StatRepo StatisticsStorage::ConsumerStatRepo =
 map_list_of
@@ -113,6 +135,8 @@ map_list_of
 ( Indicator::RecoveredKeyNum, 0. )
 ( Indicator::RescuedNum, 0. )
 ( Indicator::RescuedKeyNum, 0. )
+( Indicator::FecGroupFetchedNum, 0. )
+( Indicator::FecGroupRecoveredNum, 0. )
 ( Indicator::IncompleteNum, 0. )
 ( Indicator::IncompleteKeyNum, 0. )
 ( Indicator::BufferTargetSize, 0. )
@@ -121,6 +145,8 @@ map_list_of
 ( Indicator::CurrentProducerFramerate, 0. )
 ( Indicator::VerifySuccess, 0. )
 ( Indicator::VerifyFailure, 0. )
+( Indicator::VerifyRecovered, 0. )
+( Indicator::ManifestWindowFetchedNum, 0. )
 ( Indicator::LatencyControlStable, 0. )
 ( Indicator::LatencyControlCommand, 0. )
 ( Indicator::FrameFetchAvgDelta, 0. )
@@ -173,12 +199,29 @@ map_list_of ( Indicator::Timestamp, 0. )
 ( Indicator::PublishedKeyNum, 0. )
 ( Indicator::InterestsReceivedNum, 0. )
 ( Indicator::SignNum, 0. )
+( Indicator::ParityDeferredNum, 0. )
+( Indicator::ParityLazyNum, 0. )
+( Indicator::ParityFailedNum, 0. )
+( Indicator::FecGroupPublishedNum, 0. )
+( Indicator::ManifestWindowPublishedNum, 0. )
+// producer pipeline
+( Indicator::PipelineCaptureQueueSize, 0. )
+( Indicator::PipelinePublishQueueSize, 0. )
+( Indicator::PipelineDroppedNum, 0. )
+( Indicator::PipelineQueueDelay, 0. )
+( Indicator::PipelineEncodeDelay, 0. )
+( Indicator::PipelinePublishDelay, 0. )
 ( Indicator::CurrentProducerFramerate, 0. )
 // encoder
 ( Indicator::DroppedNum, 0. )
 ( Indicator::EncodedNum, 0. )
+( Indicator::EncoderBitrateRatio, 1. )
+( Indicator::EncoderFrameRateRatio, 1. )
+( Indicator::RateControlSkippedNum, 0. )
 // capturer
-( Indicator::CapturedNum, 0. );
+( Indicator::CapturedNum, 0. )
+( Indicator::FramePoolHitNum, 0. )
+( Indicator::FramePoolMissNum, 0. );
 
 // all statistics indicator names
 const std::map<Indicator, std::string> StatisticsStorage::IndicatorKeywords =
@@ -197,6 +240,8 @@ boost::assign::map_list_of
 (Indicator::RecoveredKeyNum, "framesRecKey")
 (Indicator::RescuedNum, "framesResc")
 (Indicator::RescuedKeyNum, "framesRescKey")
+(Indicator::FecGroupFetchedNum, "fecGroupsFetched")
+(Indicator::FecGroupRecoveredNum, "framesRecGroup")
 (Indicator::IncompleteNum, "framesInc")
 (Indicator::IncompleteKeyNum, "framesIncKey")
 (Indicator::BufferTargetSize, "jitterTar")
@@ -205,6 +250,8 @@ boost::assign::map_list_of
 (Indicator::CurrentProducerFramerate, "prodRate")
 (Indicator::VerifySuccess, "verifySuccess")
 (Indicator::VerifyFailure, "verifyFailure")
+(Indicator::VerifyRecovered, "verifyRecovered")
+(Indicator::ManifestWindowFetchedNum, "manifestWinFetched")
 (Indicator::LatencyControlStable, "latCtrlStable" )
 (Indicator::LatencyControlCommand, "latCtrlCmd" )
 ( Indicator::FrameFetchAvgDelta, "fetchDeltaAvg" )
@@ -253,10 +300,27 @@ boost::assign::map_list_of
 (Indicator::PublishedKeyNum, "framesPubKey")
 (Indicator::InterestsReceivedNum, "irecvd")
 (Indicator::SignNum, "signNum")
+(Indicator::ParityDeferredNum, "parityDeferred")
+(Indicator::ParityLazyNum, "parityLazy")
+(Indicator::ParityFailedNum, "parityFailed")
+(Indicator::FecGroupPublishedNum, "fecGroupsPub")
+(Indicator::ManifestWindowPublishedNum, "manifestWinPub")
+// producer pipeline
+(Indicator::PipelineCaptureQueueSize, "pipeCaptureQ")
+(Indicator::PipelinePublishQueueSize, "pipePublishQ")
+(Indicator::PipelineDroppedNum, "pipeDropped")
+(Indicator::PipelineQueueDelay, "pipeQueueDelay")
+(Indicator::PipelineEncodeDelay, "pipeEncDelay")
+(Indicator::PipelinePublishDelay, "pipePubDelay")
 // encoder
 (Indicator::EncodedNum, "framesEncoded")
+(Indicator::EncoderBitrateRatio, "encBitrateRatio")
+(Indicator::EncoderFrameRateRatio, "encRateRatio")
+(Indicator::RateControlSkippedNum, "rcSkipped")
 // capturer
-(Indicator::CapturedNum, "framesCaptured");
+(Indicator::CapturedNum, "framesCaptured")
+(Indicator::FramePoolHitNum, "framePoolHit")
+(Indicator::FramePoolMissNum, "framePoolMiss");
 
 StatisticsStorage::StatRepo
 StatisticsStorage::getIndicators() const
@@ -12,14 +12,17 @@
 // #define USE_VP9
 
 #include <boost/thread.hpp>
+#include <boost/make_shared.hpp>
 #include <webrtc/modules/video_coding/codecs/vp8/include/vp8.h>
 #include <webrtc/modules/video_coding/codecs/vp9/include/vp9.h>
 #include <webrtc/modules/video_coding/include/video_coding.h>
 #include <webrtc/modules/video_coding/include/video_codec_interface.h>
 #include <webrtc/modules/video_coding/codec_database.h>
+#include <libyuv/scale.h>
 
 #include "video-coder.hpp"
 #include "threading-capability.hpp"
+#include "frame-pool.hpp"
 
 using namespace std;
 using namespace ndnlog;
@@ -90,10 +93,15 @@ webrtc::VideoCodec VideoCoder::codecFromSettings(const VideoCoderParams &setting
     codec.VP9()->resilience = 1;
     codec.VP9()->frameDroppingOn = settings.dropFramesOn_;
     codec.VP9()->keyFrameInterval = settings.gop_;
+    // non-flexible mode, temporal layers follow fixed pattern (see
+    // NameComponents::temporalLayer)
+    codec.VP9()->numberOfTemporalLayers = settings.temporalLayers_;
+    codec.VP9()->flexibleMode = false;
 #else
     codec.VP8()->resilience = kResilientStream;
     codec.VP8()->frameDroppingOn = settings.dropFramesOn_;
     codec.VP8()->keyFrameInterval = settings.gop_;
+    codec.VP8()->numberOfTemporalLayers = settings.temporalLayers_;
 #endif
 
     // customize parameteres if possible
@@ -113,7 +121,6 @@ FrameScaler::FrameScaler(unsigned int dstWidth, unsigned int dstHeight)
     : srcWidth_(0), srcHeight_(0),
       dstWidth_(dstWidth), dstHeight_(dstHeight)
 {
-    initScaledFrame();
 }
 
 const WebRtcVideoFrame
@@ -124,25 +131,144 @@ FrameScaler::operator()(const WebRtcVideoFrame &frame)
     //     scaledFrameBuffer_->ScaleFrom(frame);
     // });
 
-    scaledFrameBuffer_->ScaleFrom(*(frame.video_frame_buffer()));
+    WebRtcSmartPtr<WebRtcVideoFrameBuffer> scaledFrameBuffer =
+        FrameBufferPool::getSharedInstance().getBuffer(dstWidth_, dstHeight_);
+    scaledFrameBuffer->ScaleFrom(*(frame.video_frame_buffer()));
 
-    return WebRtcVideoFrame(scaledFrameBuffer_, frame.rotation(), frame.timestamp_us());
+    return WebRtcVideoFrame(scaledFrameBuffer, frame.rotation(), frame.timestamp_us());
 }
 
-void FrameScaler::initScaledFrame()
+//******************************************************************************
+ScalingPyramid::ScalingPyramid()
+    : frameNo_(0), rotation_(kVideoRotation_0), timestampUs_(0)
 {
-    int stride_y = dstWidth_;
-    int stride_uv = (dstWidth_ + 1) / 2;
-    int target_width = dstWidth_;
-    int target_height = dstHeight_;
-
-    scaledFrameBuffer_ = I420Buffer::Create(target_width,
-                                            abs(target_height),
-                                            stride_y,
-                                            stride_uv, stride_uv);
-
-    if (!scaledFrameBuffer_)
-        throw std::runtime_error("failed to allocate scaled frame");
+}
+
+void ScalingPyramid::addLevel(const std::string &threadName, unsigned int width,
+                              unsigned int height)
+{
+    if (threadLevels_.find(threadName) != threadLevels_.end())
+        throw std::runtime_error("scaling level for thread " + threadName + " exists already");
+
+    boost::shared_ptr<Level> level;
+    auto it = levels_.find(std::make_pair(width, height));
+
+    if (it == levels_.end())
+    {
+        level = boost::make_shared<Level>();
+        level->width_ = width;
+        level->height_ = height;
+        level->nThreads_ = 0;
+        level->frameNo_ = 0;
+        levels_[std::make_pair(width, height)] = level;
+        linkLevels();
+    }
+    else
+        level = it->second;
+
+    level->nThreads_++;
+    threadLevels_[threadName] = level;
+}
+
+void ScalingPyramid::removeLevel(const std::string &threadName)
+{
+    auto it = threadLevels_.find(threadName);
+
+    if (it != threadLevels_.end())
+    {
+        boost::shared_ptr<Level> level = it->second;
+        threadLevels_.erase(it);
+
+        if (--level->nThreads_ == 0)
+        {
+            levels_.erase(std::make_pair(level->width_, level->height_));
+            linkLevels();
+        }
+    }
+}
+
+void ScalingPyramid::setFrame(const WebRtcVideoFrame &frame)
+{
+    frameBuffer_ = frame.video_frame_buffer();
+    rotation_ = frame.rotation();
+    timestampUs_ = frame.timestamp_us();
+    frameNo_++;
+}
+
+const WebRtcVideoFrame
+ScalingPyramid::getLevel(const std::string &threadName)
+{
+    auto it = threadLevels_.find(threadName);
+
+    if (it == threadLevels_.end())
+        throw std::runtime_error("no scaling level for thread " + threadName);
+
+    return WebRtcVideoFrame(scale(*it->second), rotation_, timestampUs_);
+}
+
+void ScalingPyramid::reset()
+{
+    frameBuffer_ = nullptr;
+    for (auto l : levels_)
+        l.second->buffer_ = nullptr;
+}
+
+void ScalingPyramid::linkLevels()
+{
+    // parent of a level is the smallest level which is larger in both
+    // dimensions
+    for (auto l : levels_)
+    {
+        l.second->parent_.reset();
+
+        for (auto p : levels_)
+            if (p.second != l.second &&
+                p.second->width_ >= l.second->width_ && p.second->height_ >= l.second->height_ &&
+                (!l.second->parent_ ||
+                 p.second->width_ * p.second->height_ < l.second->parent_->width_ * l.second->parent_->height_))
+                l.second->parent_ = p.second;
+    }
+}
+
+WebRtcSmartPtr<webrtc::VideoFrameBuffer>
+ScalingPyramid::scale(Level &level)
+{
+    // level is scaled only once per frame by the first thread that requests
+    // it (or any of its children), others wait on level's mutex
+    boost::lock_guard<boost::mutex> scopedLock(level.mutex_);
+
+    if (level.frameNo_ == frameNo_)
+        return level.buffer_;
+
+    WebRtcSmartPtr<webrtc::VideoFrameBuffer> src = frameBuffer_;
+    // release previous frame's buffer, so that it can be recycled
+    level.buffer_ = nullptr;
+
+    if (src->width() == (int)level.width_ && src->height() == (int)level.height_)
+        level.buffer_ = src;
+    else
+    {
+        // scale from parent level only if it's not upscaled itself
+        if (level.parent_ &&
+            (int)level.parent_->width_ <= src->width() && (int)level.parent_->height_ <= src->height())
+            src = scale(*level.parent_);
+
+        WebRtcSmartPtr<WebRtcVideoFrameBuffer> dst =
+            FrameBufferPool::getSharedInstance().getBuffer(level.width_, level.height_);
+
+        libyuv::I420Scale(src->DataY(), src->StrideY(),
+                          src->DataU(), src->StrideU(),
+                          src->DataV(), src->StrideV(),
+                          src->width(), src->height(),
+                          dst->MutableDataY(), dst->StrideY(),
+                          dst->MutableDataU(), dst->StrideU(),
+                          dst->MutableDataV(), dst->StrideV(),
+                          level.width_, level.height_, libyuv::kFilterBox);
+        level.buffer_ = dst;
+    }
+
+    level.frameNo_ = frameNo_;
+    return level.buffer_;
 }
 
 //********************************************************************************
@@ -154,9 +280,14 @@ VideoCoder::VideoCoder(const VideoCoderParams &coderParams, IEncoderDelegate *de
       delegate_(delegate),
       keyFrameTrigger_(0),
       gopPos_(0),
+      temporalLayer_(0),
+      ratesChanged_(false),
+      targetBitrate_(coderParams.startBitrate_),
+      targetFrameRate_(coderParams.codecFrameRate_),
       codec_(VideoCoder::codecFromSettings(coderParams_)),
       codecSpecificInfo_(nullptr),
       keyEnforcement_(keyEnforcement),
+      keyFrameRequested_(false),
 #ifdef USE_VP9
       encoder_(VP9Encoder::Create())
 #else
@@ -167,17 +298,26 @@ VideoCoder::VideoCoder(const VideoCoderParams &coderParams, IEncoderDelegate *de
     description_ = "coder";
     keyFrameType_.push_back(webrtc::kVideoFrameKey);
 
+    if (coderParams_.temporalLayers_ < 1 ||
+        coderParams_.temporalLayers_ > MAX_TEMPORAL_LAYERS)
+        throw std::runtime_error("Unsupported number of temporal layers");
+
     if (!encoder_.get())
         throw std::runtime_error("Error creating encoder");
 
     encoder_->RegisterEncodeCompleteCallback(this);
     int maxPayload = 1440;
+    // encoder derives number of its' threads and tile columns from the 
+    // number of cores (and resolution)
+    int nCores = (coderParams_.encoderThreads_ ? coderParams_.encoderThreads_
+                                               : boost::thread::hardware_concurrency());
 
-    if (encoder_->InitEncode(&codec_, boost::thread::hardware_concurrency(), maxPayload) != WEBRTC_VIDEO_CODEC_OK)
+    if (encoder_->InitEncode(&codec_, nCores, maxPayload) != WEBRTC_VIDEO_CODEC_OK)
         throw std::runtime_error("Can't initialize encoder");
 
     LogInfoC
         << "initialized. max payload " << maxPayload
+        << " cores " << nCores
         << " parameters: " << plotCodec(codec_) << endl;
 }
 
@@ -196,9 +336,14 @@ void VideoCoder::onRawFrame(const WebRtcVideoFrame &frame)
         throw std::runtime_error(ss.str());
     }
 
+    applyRates();
+
     encodeComplete_ = false;
     delegate_->onEncodingStarted();
 
+    if (keyFrameRequested_.exchange(false))
+        keyFrameTrigger_ = 0;
+
     int err;
     if (keyFrameTrigger_ % coderParams_.gop_ == 0)
     {
@@ -232,6 +377,41 @@ void VideoCoder::onRawFrame(const WebRtcVideoFrame &frame)
         LogErrorC << "can't encode frame due to error " << err << std::endl;
 }
 
+void VideoCoder::setRates(unsigned int bitrateKbps, double frameRate)
+{
+    boost::lock_guard<boost::mutex> scopedLock(ratesMutex_);
+    targetBitrate_ = bitrateKbps;
+    targetFrameRate_ = frameRate;
+    ratesChanged_ = true;
+}
+
+//********************************************************************************
+#pragma mark - private
+void VideoCoder::applyRates()
+{
+    unsigned int bitrate;
+    double frameRate;
+    {
+        boost::lock_guard<boost::mutex> scopedLock(ratesMutex_);
+        if (!ratesChanged_)
+            return;
+
+        ratesChanged_ = false;
+        bitrate = std::max(targetBitrate_, codec_.minBitrate);
+        frameRate = std::max(1., targetFrameRate_);
+    }
+
+    // VP9 encoder splits bitrate between temporal layers on its' own, thus
+    // only total bitrate is set
+    webrtc::BitrateAllocation allocation;
+    allocation.SetBitrate(0, 0, bitrate * 1000);
+
+    if (encoder_->SetRateAllocation(allocation, (uint32_t)frameRate) != WEBRTC_VIDEO_CODEC_OK)
+        LogWarnC << "couldn't set rates " << bitrate << "kbps " << frameRate << "fps" << std::endl;
+    else
+        LogInfoC << "set rates " << bitrate << "kbps " << frameRate << "fps" << std::endl;
+}
+
 //********************************************************************************
 #pragma mark - interfaces realization - EncodedImageCallback
 webrtc::EncodedImageCallback::Result
@@ -244,9 +424,20 @@ VideoCoder::OnEncodedImage(const EncodedImage &encodedImage,
     if (encodedImage._frameType == webrtc::kVideoFrameKey)
         gopPos_ = 0;
 
+    uint8_t temporalIdx = kNoTemporalIdx;
+    if (codecSpecificInfo)
+    {
+#ifdef USE_VP9
+        temporalIdx = codecSpecificInfo->codecSpecific.VP9.temporal_idx;
+#else
+        temporalIdx = (uint8_t)codecSpecificInfo->codecSpecific.VP8.temporalIdx;
+#endif
+    }
+    temporalLayer_ = (temporalIdx == kNoTemporalIdx ? 0 : temporalIdx);
+
     LogTraceC << "⤷ encoded  ● "
               << (encodedImage._frameType == webrtc::kVideoFrameKey ? "K " : "D ")
-              << gopPos_ << std::endl;
+              << gopPos_ << " T" << temporalLayer_ << std::endl;
 
     if (keyEnforcement_ == KeyEnforcement::Gop)
         keyFrameTrigger_++;
@@ -12,6 +12,9 @@
 #ifndef __ndnrtc__video_coder__
 #define __ndnrtc__video_coder__
 
+#include <map>
+#include <atomic>
+#include <boost/thread/mutex.hpp>
 #include <webrtc/modules/video_coding/include/video_codec_interface.h>
 
 #include "webrtc.hpp"
@@ -20,6 +23,8 @@
 #include "ndnrtc-object.hpp"
 
 #define USE_VP9
+// maximum number of temporal layers, supported by encoder
+#define MAX_TEMPORAL_LAYERS 3
 
 namespace ndnrtc
 {
@@ -64,10 +69,68 @@ class FrameScaler
     unsigned int dstWidth_, dstHeight_;
     // webrtc::Scaler scaler_;
     // WebRtcVideoFrame scaledFrame_;
-    WebRtcSmartPtr<WebRtcVideoFrameBuffer> scaledFrameBuffer_;
+};
+
+/**
+     * Scaling pyramid scales one captured frame to resolutions of several
+     * video threads. Threads with identical resolutions share one pyramid
+     * level. Each level is scaled (with box filter) from the nearest larger
+     * level, rather than from the captured frame, which saves memory bandwidth
+     * when several downscaled resolutions are needed. Levels are scaled lazily,
+     * upon first request, thus different levels can be requested in parallel
+     * from different threads.
+     */
+class ScalingPyramid
+{
+  public:
+    ScalingPyramid();
+
+    void addLevel(const std::string &threadName, unsigned int width, unsigned int height);
+    void removeLevel(const std::string &threadName);
+
+    /**
+         * Sets new captured frame and invalidates levels, scaled from the
+         * previous one. Must not be called while levels are requested.
+         */
+    void setFrame(const WebRtcVideoFrame &frame);
+
+    /**
+         * Returns captured frame scaled to the level of the given thread.
+         * Thread-safe.
+         */
+    const WebRtcVideoFrame getLevel(const std::string &threadName);
 
-    void
-    initScaledFrame();
+    /**
+         * Releases captured frame and scaled levels. Must not be called
+         * while levels are requested.
+         */
+    void reset();
+
+    size_t getLevelsNum() const { return levels_.size(); }
+
+  private:
+    typedef struct _Level
+    {
+        unsigned int width_, height_;
+        unsigned int nThreads_;
+        uint64_t frameNo_; // number of the frame scaled into buffer_
+        boost::mutex mutex_;
+        WebRtcSmartPtr<webrtc::VideoFrameBuffer> buffer_;
+        boost::shared_ptr<struct _Level> parent_;
+    } Level;
+
+    ScalingPyramid(const ScalingPyramid &) = delete;
+
+    uint64_t frameNo_;
+    // captured frame
+    WebRtcSmartPtr<webrtc::VideoFrameBuffer> frameBuffer_;
+    webrtc::VideoRotation rotation_;
+    int64_t timestampUs_;
+    std::map<std::string, boost::shared_ptr<Level>> threadLevels_;
+    std::map<std::pair<unsigned int, unsigned int>, boost::shared_ptr<Level>> levels_;
+
+    void linkLevels();
+    WebRtcSmartPtr<webrtc::VideoFrameBuffer> scale(Level &level);
 };
 
 /**
@@ -92,6 +155,23 @@ class VideoCoder : public NdnRtcComponent,
 
     void onRawFrame(const WebRtcVideoFrame &frame);
     int getGopCounter() const { return gopPos_; }
+    // temporal layer of the last encoded frame
+    unsigned int getTemporalLayer() const { return temporalLayer_; }
+    const VideoCoderParams &getSettings() const { return coderParams_; }
+
+    /**
+     * Sets encoder's target bitrate and frame rate. Can be called on any 
+     * thread, new rates are applied before encoding the next frame.
+     * @param bitrateKbps Target bitrate (kbps)
+     * @param frameRate Target frame rate (FPS)
+     */
+    void setRates(unsigned int bitrateKbps, double frameRate);
+
+    /**
+     * Makes encoder produce key frame out of the next raw frame. Can be 
+     * called on any thread.
+     */
+    void requestKeyFrame() { keyFrameRequested_ = true; }
 
     static webrtc::VideoCodec codecFromSettings(const VideoCoderParams &settings);
 
@@ -108,7 +188,16 @@ class VideoCoder : public NdnRtcComponent,
     boost::shared_ptr<webrtc::VideoEncoder> encoder_;
 
     int keyFrameTrigger_, gopPos_;
+    unsigned int temporalLayer_;
     KeyEnforcement keyEnforcement_;
+    std::atomic<bool> keyFrameRequested_;
+
+    boost::mutex ratesMutex_;
+    bool ratesChanged_;
+    unsigned int targetBitrate_;
+    double targetFrameRate_;
+
+    void applyRates();
 
     // interface webrtc::EncodedImageCallback
     webrtc::EncodedImageCallback::Result OnEncodedImage(const webrtc::EncodedImage &encoded_image,
@@ -55,6 +55,7 @@ void VideoPlayoutImpl::stop()
     PlayoutImpl::stop();
     currentPlayNo_ = -1;
     gopCount_ = 0;
+    layerPlayNo_.clear();
 }
 
 //******************************************************************************
@@ -84,13 +85,51 @@ bool VideoPlayoutImpl::processSample(const boost::shared_ptr<const BufferSlot>&
                 (*statStorage_)[Indicator::RecoveredKeyNum]++;
         }
 
+        bool isPlayable = true;
+        // threads with several temporal layers have layer header in frames
+        unsigned int temporalLayer = framePacket->getTemporalLayer();
+        PacketNumber refPlaybackNo = framePacket->getRefPlaybackNo();
+
         if (!slot->getNameInfo().isDelta_)
         {
             gopIsValid_ = true; 
             ++gopCount_;
+            layerPlayNo_.assign(std::max<size_t>(layerPlayNo_.size(), 1), hdr.playbackNo_);
 
             LogTraceC << "gop " << gopCount_ << std::endl;
         }
+        else if (refPlaybackNo >= 0)
+        {
+            // frame of a temporal layer: playback numbers are not contiguous 
+            // if higher layers are not fetched, so instead check that the 
+            // frame it references was played
+            if (layerPlayNo_.size() <= temporalLayer)
+                layerPlayNo_.resize(temporalLayer + 1, 
+                                    (layerPlayNo_.size() ? layerPlayNo_.back() : -1));
+
+            if (!gopIsValid_ || layerPlayNo_[temporalLayer] != refPlaybackNo)
+            {
+                if (!gopIsValid_)
+                    LogWarnC << "skip " << frameStr << ". invalid GOP" << std::endl;
+                else
+                    LogWarnC << "skip " << frameStr << " T" << (int)temporalLayer
+                             << " (reference " << refPlaybackNo << "p is missing)"
+                             << std::endl;
+
+                isPlayable = false;
+
+                {
+                    boost::lock_guard<boost::recursive_mutex> scopedLock(mutex_);
+                    for (auto o : observers_)
+                        ((IVideoPlayoutObserver *)o)->frameSkipped(hdr.playbackNo_, false);
+                }
+
+                (*statStorage_)[Indicator::SkippedNum]++;
+            }
+            else
+                for (size_t l = temporalLayer; l < layerPlayNo_.size(); ++l)
+                    layerPlayNo_[l] = hdr.playbackNo_;
+        }
         else
         {
             if (currentPlayNo_ >= 0 &&
@@ -116,8 +155,9 @@ bool VideoPlayoutImpl::processSample(const boost::shared_ptr<const BufferSlot>&
         }
 
         currentPlayNo_ = hdr.playbackNo_;
+        isPlayable = isPlayable && gopIsValid_;
 
-        if (gopIsValid_)
+        if (isPlayable)
         {
             {
                 boost::lock_guard<boost::recursive_mutex> scopedLock(mutex_);
@@ -156,7 +196,7 @@ bool VideoPlayoutImpl::processSample(const boost::shared_ptr<const BufferSlot>&
                 (*statStorage_)[Indicator::LastPlayedDeltaNo] = slot->getNameInfo().sampleNo_;
         } // gop is valid
 
-        return gopIsValid_;
+        return isPlayable;
     }
     else
     {
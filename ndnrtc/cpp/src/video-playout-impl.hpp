@@ -49,6 +49,8 @@ namespace ndnrtc {
         bool gopIsValid_;
         PacketNumber currentPlayNo_;
         int gopCount_;
+        // playback number of the last played frame of each temporal layer
+        std::vector<PacketNumber> layerPlayNo_;
 
         bool
         processSample(const boost::shared_ptr<const BufferSlot>&);
@@ -26,8 +26,14 @@
 #include "clock.hpp"
 #include "async.hpp"
 #include "params.hpp"
+#include "parity-control.hpp"
+#include "rate-control.hpp"
+#include "sample-cache.hpp"
+#include "fec-group.hpp"
+#include "frame-pool.hpp"
 
-#define PARITY_RATIO 0.2
+// number of most recent frames for which parity can be computed on request
+#define LAZY_PARITY_QUEUE_SIZE 150
 
 using namespace ndnrtc;
 using namespace ndnrtc::statistics;
@@ -38,13 +44,23 @@ using namespace estimators;
 typedef boost::shared_ptr<VideoFramePacket> FramePacketPtr;
 typedef boost::future<FramePacketPtr> FutureFrame;
 typedef boost::shared_ptr<boost::future<FramePacketPtr>> FutureFramePtr;
+typedef boost::shared_ptr<boost::promise<FramePacketPtr>> FramePromisePtr;
 
 VideoStreamImpl::VideoStreamImpl(const std::string &streamPrefix,
                                  const MediaStreamSettings &settings, bool useFec)
     : MediaStreamBase(streamPrefix, settings),
       playbackCounter_(0),
       fecEnabled_(useFec),
-      busyPublishing_(0)
+      busyPublishing_(0),
+      isPipelineRunning_(false),
+      queueDelay_(Average(boost::make_shared<SampleWindow>(30))),
+      encodeDelay_(Average(boost::make_shared<SampleWindow>(30))),
+      publishDelay_(Average(boost::make_shared<SampleWindow>(30))),
+      captureInterval_(Average(boost::make_shared<SampleWindow>(30))),
+      publishBacklog_(Average(boost::make_shared<SampleWindow>(30))),
+      lastCaptureMs_(0), lastRateUpdateMs_(0),
+      captureIntervalMs_(0), nBusyDropped_(0), frameCredit_(0),
+      scalingPyramid_(boost::make_shared<ScalingPyramid>())
 {
     if (settings_.params_.type_ == MediaStreamParams::MediaStreamType::MediaStreamTypeAudio)
         throw runtime_error("Wrong media stream parameters type supplied (audio instead of video)");
@@ -55,13 +71,17 @@ VideoStreamImpl::VideoStreamImpl(const std::string &streamPrefix,
         if (settings_.params_.getVideoThread(i))
             add(settings_.params_.getVideoThread(i));
 
-    PublisherSettings ps;
-    ps.sign_ = false; // stream samples are not signed - we use manifests for verification
+    SamplePublisherSettings ps;
+    // by default, stream samples are not signed - we use manifests for verification
+    ps.sign_ = settings_.sign_ && settings_.params_.producerParams_.signing_.signSamples_;
+    ps.signingPool_ = signingPool_.get();
+    ps.faceIo_ = &settings_.faceIo_;
     ps.keyChain_ = settings_.keyChain_;
-    ps.memoryCache_ = cache_.get();
+    ps.memoryCache_ = sampleCache_.get();
 	//liupenghui, configure it by xxx.cfg
     ps.segmentWireLength_ = settings_.params_.producerParams_.segmentSize_;
     ps.freshnessPeriodMs_ = settings_.params_.producerParams_.freshness_.sampleMs_;
+    ps.sendNacks_ = settings_.params_.producerParams_.sendNacks_;
     ps.statStorage_ = statStorage_.get();
 
     if (settings_.storagePath_ != "")
@@ -69,13 +89,28 @@ VideoStreamImpl::VideoStreamImpl(const std::string &streamPrefix,
         ps.onSegmentsCached_ = boost::bind(&MediaStreamBase::onSegmentsCached, this, _1);
     }
 
-    framePublisher_ = boost::make_shared<VideoPacketPublisher>(ps);
+    framePublisher_ = boost::make_shared<VideoSamplePublisher>(ps);
     framePublisher_->setDescription("seg-publisher-" + settings_.params_.streamName_);
+
+    if (settings_.params_.producerParams_.rateControl_.enabled_)
+    {
+        double frameRate = 0;
+        for (auto it : threads_)
+            frameRate = std::max(frameRate, it.second->getCoder().getSettings().codecFrameRate_);
+        rateControl_ = boost::make_shared<RateControl>(settings_.params_.producerParams_.rateControl_, frameRate);
+    }
+
+    if (settings_.params_.producerParams_.pipeline_.depth_)
+        startPipeline();
+    if (fecEnabled_ && settings_.params_.producerParams_.fec_.lazy_)
+        startMyThread();
 }
 
 VideoStreamImpl::~VideoStreamImpl()
 {
-    // cleanup
+    stopPipeline();
+    if (fecEnabled_ && settings_.params_.producerParams_.fec_.lazy_)
+        stopMyThread();
 }
 
 vector<string> VideoStreamImpl::getThreads() const
@@ -113,6 +148,78 @@ int VideoStreamImpl::incomingFrame(const YUV_NV21FrameWrapper &w)
     return -1;
 }
 
+int VideoStreamImpl::incomingFrame(const YUV_NV12FrameWrapper &w)
+{
+    LogDebugC << "⤹ incoming NV12 frame " << w.width_ << "x" << w.height_ << std::endl;
+    if (feedFrame(conv_ << w))
+        return (playbackCounter_ - 1);
+    return -1;
+}
+
+int VideoStreamImpl::incomingFrame(const ExternalI420FrameWrapper &w)
+{
+    LogDebugC << "⤹ incoming external I420 frame " << w.planes_.width_ << "x" << w.planes_.height_ << std::endl;
+    if (feedFrame(conv_ << w))
+        return (playbackCounter_ - 1);
+    return -1;
+}
+
+int VideoStreamImpl::incomingEncodedFrame(const std::string &threadName, const EncodedFrameWrapper &w)
+{
+    LogDebugC << "⤹ incoming encoded " << (w.isKey_ ? "key" : "delta") << " frame "
+              << w.width_ << "x" << w.height_ << " for " << threadName << std::endl;
+
+    boost::lock_guard<boost::mutex> scopedLock(internalMutex_);
+
+    if (threads_.find(threadName) == threads_.end())
+        throw runtime_error("Thread " + threadName + " does not exist");
+
+    const VideoCoderParams &coderParams = threads_[threadName]->getCoder().getSettings();
+    if (w.width_ != coderParams.encodeWidth_ || w.height_ != coderParams.encodeHeight_)
+    {
+        stringstream ss;
+        ss << "Encoded frame size (" << w.width_ << "x" << w.height_
+           << ") does not equal resolution of thread " << threadName << " ("
+           << coderParams.encodeWidth_ << "x" << coderParams.encodeHeight_ << ")";
+        throw runtime_error(ss.str());
+    }
+    if (w.temporalLayer_ >= coderParams.temporalLayers_ || (w.isKey_ && w.temporalLayer_))
+        throw runtime_error("Wrong temporal layer of encoded frame for thread " + threadName);
+    if (seqCounters_[threadName].first != (uint64_t)-1 &&
+        !isLayerPredicted(threadName, w.isKey_, w.temporalLayer_))
+        throw runtime_error("Temporal layer of encoded frame does not follow GOP pattern of thread " + threadName);
+
+    (*statStorage_)[Indicator::CapturedNum]++;
+
+    // consumers can't decode anything before the first key frame
+    if (!w.isKey_ && seqCounters_[threadName].first == (uint64_t)-1)
+    {
+        LogWarnC << "⨂ delta frame before first key frame for " << threadName
+                 << " - dropped" << std::endl;
+        (*statStorage_)[Indicator::DroppedNum]++;
+        return -1;
+    }
+
+    webrtc::EncodedImage encodedImage(const_cast<uint8_t *>(w.frameData_), w.frameSize_, w.frameSize_);
+    encodedImage._encodedWidth = w.width_;
+    encodedImage._encodedHeight = w.height_;
+    encodedImage._timeStamp = w.timestamp_;
+    encodedImage.capture_time_ms_ = w.captureTimeMs_;
+    encodedImage._frameType = (w.isKey_ ? webrtc::kVideoFrameKey : webrtc::kVideoFrameDelta);
+    encodedImage._completeFrame = true;
+
+    // unlike raw frames, encoded frames are never dropped when publishing
+    // is busy, as this would break decoding of the following frames
+    map<string, FramePacketPtr> frames;
+    frames[threadName] = boost::make_shared<VideoFramePacket>(encodedImage, (coderParams.temporalLayers_ > 1),
+                                                              w.temporalLayer_);
+    publish(frames);
+    playbackCounter_++;
+    setupMetaInvocation();
+
+    return (playbackCounter_ - 1);
+}
+
 void VideoStreamImpl::setLogger(boost::shared_ptr<ndnlog::new_api::Logger> logger)
 {
     boost::lock_guard<boost::mutex> scopedLock(internalMutex_);
@@ -140,14 +247,42 @@ void VideoStreamImpl::add(const MediaThreadParams *mp)
     {
         boost::lock_guard<boost::mutex> scopedLock(internalMutex_);
 
-        threads_[params->threadName_] = boost::make_shared<VideoThread>(params->coderParams_);
-        scalers_[params->threadName_] = boost::make_shared<FrameScaler>(params->coderParams_.encodeWidth_,
-                                                                        params->coderParams_.encodeHeight_);
+        VideoCoderParams coderParams(params->coderParams_);
+        // unless set explicitly, cores are split evenly between stream's
+        // threads, so that concurrent encoders don't oversubscribe CPU
+        if (!coderParams.encoderThreads_)
+            coderParams.encoderThreads_ =
+                std::max<unsigned int>(1, boost::thread::hardware_concurrency() /
+                                              std::max<size_t>(1, settings_.params_.getThreadNum()));
+
+        threads_[params->threadName_] = boost::make_shared<VideoThread>(coderParams, params->cpuCore_);
+        scalingPyramid_->addLevel(params->threadName_, params->coderParams_.encodeWidth_,
+                                  params->coderParams_.encodeHeight_);
         seqCounters_[params->threadName_].first = -1;
         seqCounters_[params->threadName_].second = -1;
-        metaKeepers_[params->threadName_] = boost::make_shared<MetaKeeper>(params);
+        gopPositions_[params->threadName_] = 0;
+        if (params->coderParams_.temporalLayers_ > 1)
+            layerPlaybackNos_[params->threadName_].assign(params->coderParams_.temporalLayers_, -1);
+
+        unsigned int fecGroupSize = settings_.params_.producerParams_.fec_.groupSize_;
+        if (fecEnabled_ && fecGroupSize > 1)
+            fecGroupEncoders_[params->threadName_] =
+                boost::make_shared<FecGroupEncoder>(fecGroupSize,
+                                                    VideoFrameSegment::payloadLength(settings_.params_.producerParams_.segmentSize_));
+        else
+            fecGroupSize = 0;
+
+        unsigned int manifestWindow = settings_.params_.producerParams_.manifest_.window_;
+        if (manifestWindow > 1)
+            manifestWindows_[params->threadName_] = boost::make_shared<ManifestWindows>();
+        else
+            manifestWindow = 0;
+
+        metaKeepers_[params->threadName_] = boost::make_shared<MetaKeeper>(params, fecGroupSize, manifestWindow);
+        parityControls_[params->threadName_] = boost::make_shared<ParityControl>(settings_.params_.producerParams_.fec_);
 
         threads_[params->threadName_]->setDescription("thread-" + params->threadName_);
+        demandObserved(params->threadName_);
     }
 
     LogTraceC << "added thread " << params->threadName_ << std::endl;
@@ -160,9 +295,18 @@ void VideoStreamImpl::remove(const string &threadName)
         boost::lock_guard<boost::mutex> scopedLock(internalMutex_);
 
         threads_.erase(threadName);
-        scalers_.erase(threadName);
+        scalingPyramid_->removeLevel(threadName);
         seqCounters_.erase(threadName);
+        gopPositions_.erase(threadName);
+        layerPlaybackNos_.erase(threadName);
         metaKeepers_.erase(threadName);
+        parityControls_.erase(threadName);
+        fecGroupEncoders_.erase(threadName);
+        manifestWindows_.erase(threadName);
+        {
+            boost::lock_guard<boost::mutex> demandLock(demandMutex_);
+            lastDemandMs_.erase(threadName);
+        }
 
         LogTraceC << "remove thread " << threadName << std::endl;
     }
@@ -170,27 +314,76 @@ void VideoStreamImpl::remove(const string &threadName)
 
 bool VideoStreamImpl::feedFrame(const WebRtcVideoFrame &frame)
 {
+    int64_t nowMs = clock::millisecondTimestamp();
+    if (lastCaptureMs_)
+    {
+        captureInterval_.newValue(nowMs - lastCaptureMs_);
+        captureIntervalMs_ = captureInterval_.value();
+    }
+    lastCaptureMs_ = nowMs;
+
     (*statStorage_)[Indicator::CapturedNum]++;
+    // pool is shared by all streams, figures are not stream's own
+    (*statStorage_)[Indicator::FramePoolHitNum] = FrameBufferPool::getSharedInstance().getHitNum();
+    (*statStorage_)[Indicator::FramePoolMissNum] = FrameBufferPool::getSharedInstance().getMissNum();
+
+    if (captureQueue_)
+    {
+        uint64_t nDropped = captureQueue_->getDroppedNum();
+        bool queued = captureQueue_->push(boost::make_shared<CapturedFrame>(CapturedFrame({frame, clock::millisecondTimestamp()})));
+
+        if (captureQueue_->getDroppedNum() != nDropped)
+            LogWarnC << "⨂ capture queue is full, dropped "
+                     << (queued ? "oldest" : "incoming") << " frame"
+                     << " (capture rate may be too high)" << std::endl;
+
+        (*statStorage_)[Indicator::PipelineCaptureQueueSize] = captureQueue_->size();
+        (*statStorage_)[Indicator::PipelineDroppedNum] = captureQueue_->getDroppedNum();
+        return queued;
+    }
 
     if (busyPublishing_ > 0)
     {
         LogWarnC << "⨂ busy publishing (capture rate may be too high)" << std::endl;
+        nBusyDropped_++;
         return false;
     }
 
+    return encodeFrame(frame);
+}
+
+bool VideoStreamImpl::encodeFrame(const WebRtcVideoFrame &frame)
+{
     if (threads_.size())
     {
         boost::lock_guard<boost::mutex> scopedLock(internalMutex_);
+
+        if (rateControl_ && isFrameSkipped())
+        {
+            LogDebugC << "⨂ frame skipped (rate control)" << std::endl;
+            (*statStorage_)[Indicator::RateControlSkippedNum]++;
+            return false;
+        }
+
         LogDebugC << "↓ feeding " << playbackCounter_ << "p into encoders..." << std::endl;
+        int64_t encodeStartMs = clock::millisecondTimestamp();
+
+        // each thread encodes on its own persistent worker; scaling pyramid
+        // levels are scaled there as well, in parallel
+        scalingPyramid_->setFrame(frame);
 
         map<string, FutureFramePtr> futureFrames;
         for (auto it : threads_)
         {
-            FutureFramePtr ff =
-                boost::make_shared<FutureFrame>(boost::move(boost::async(boost::launch::async,
-                                                                         boost::bind(&VideoThread::encode, it.second.get(),
-                                                                         (*scalers_[it.first])(frame)))));
-            futureFrames[it.first] = ff;
+            // levels of dormant threads are not scaled either, as scaling
+            // happens upon request
+            if (!isDemanded(it.first, encodeStartMs))
+                continue;
+
+            FramePromisePtr fp = boost::make_shared<boost::promise<FramePacketPtr>>();
+            futureFrames[it.first] = boost::make_shared<FutureFrame>(fp->get_future());
+            it.second->encodeAsync(boost::bind(&ScalingPyramid::getLevel, scalingPyramid_.get(), it.first),
+                                   [fp](const FramePacketPtr &f) { fp->set_value(f); });
         }
 
         map<string, FramePacketPtr> frames;
@@ -200,11 +393,30 @@ bool VideoStreamImpl::feedFrame(const WebRtcVideoFrame &frame)
             if (f.get())
             {
                 (*statStorage_)[Indicator::EncodedNum]++;
+
+                // frame can't be published under the layer consumers expect,
+                // encoder has to start the pattern over
+                if (!isLayerPredicted(it.first, (f->getFrame()._frameType == webrtc::kVideoFrameKey),
+                                      f->getTemporalLayer()))
+                {
+                    LogWarnC << "frame of temporal layer " << f->getTemporalLayer()
+                             << " breaks GOP pattern of " << it.first
+                             << " - dropped, requesting key frame" << std::endl;
+                    threads_[it.first]->requestKeyFrame();
+                    continue;
+                }
+
                 frames[it.first] = f;
             }
         }
-
-        (*statStorage_)[Indicator::DroppedNum] += (threads_.size() - frames.size());
+        // encoders are done with the frame - let captured (possibly external)
+        // and scaled buffers go
+        scalingPyramid_->reset();
+        encodeDelay_.newValue(clock::millisecondTimestamp() - encodeStartMs);
+        (*statStorage_)[Indicator::PipelineEncodeDelay] = encodeDelay_.value();
+        publishBacklog_.newValue(busyPublishing_);
+
+        (*statStorage_)[Indicator::DroppedNum] += (futureFrames.size() - frames.size());
         bool result = false;
 
         if (frames.size())
@@ -214,13 +426,10 @@ bool VideoStreamImpl::feedFrame(const WebRtcVideoFrame &frame)
             result = true;
         }
 
-        if (!isPeriodicInvocationSet())
-        {
-            boost::shared_ptr<VideoStreamImpl> me = boost::dynamic_pointer_cast<VideoStreamImpl>(shared_from_this());
-            setupInvocation(MediaStreamBase::MetaCheckIntervalMs,
-                            boost::bind(&VideoStreamImpl::periodicInvocation, me));
-        }
+        if (rateControl_)
+            updateRates();
 
+        setupMetaInvocation();
         return result;
     }
     else
@@ -229,6 +438,202 @@ bool VideoStreamImpl::feedFrame(const WebRtcVideoFrame &frame)
     return false;
 }
 
+bool VideoStreamImpl::isFrameSkipped()
+{
+    double captureRate = (captureIntervalMs_ > 0 ? 1000. / captureIntervalMs_ : 0);
+    double targetRate = rateControl_->getTargetFrameRate();
+
+    if (captureRate <= targetRate)
+        return false;
+
+    // encode every n-th frame, so that the average rate follows the target
+    frameCredit_ += targetRate / captureRate;
+    if (frameCredit_ >= 1.)
+    {
+        frameCredit_ -= 1.;
+        return false;
+    }
+
+    return true;
+}
+
+void VideoStreamImpl::updateRates()
+{
+    int64_t nowMs = clock::millisecondTimestamp();
+
+    if (nowMs - lastRateUpdateMs_ < (int64_t)rateControl_->getParams().intervalMs_)
+        return;
+    lastRateUpdateMs_ = nowMs;
+
+    // encoder thread waits once this many frames are being published
+    unsigned int backlogLimit = (captureQueue_ ? settings_.params_.producerParams_.pipeline_.depth_ * threads_.size() : threads_.size());
+    RateControl::Load load({encodeDelay_.value(), captureIntervalMs_,
+                            publishBacklog_.value() / std::max<unsigned int>(1, backlogLimit),
+                            (captureQueue_ ? captureQueue_->getDroppedNum() : 0) + nBusyDropped_});
+
+    if (rateControl_->update(load))
+    {
+        for (auto it : threads_)
+        {
+            const VideoCoderParams &cp = it.second->getCoder().getSettings();
+            it.second->setRates((unsigned int)(cp.startBitrate_ * rateControl_->getBitrateRatio()),
+                                cp.codecFrameRate_ * rateControl_->getFrameRateRatio());
+        }
+
+        LogInfoC << "rate control: bitrate x" << rateControl_->getBitrateRatio()
+                 << " frame rate x" << rateControl_->getFrameRateRatio()
+                 << " (encoding " << load.encodeDelayMs_ << "/" << load.frameIntervalMs_ << "ms"
+                 << " backlog " << load.publishBacklog_
+                 << " dropped " << load.nDropped_ << ")" << std::endl;
+    }
+
+    (*statStorage_)[Indicator::EncoderBitrateRatio] = rateControl_->getBitrateRatio();
+    (*statStorage_)[Indicator::EncoderFrameRateRatio] = rateControl_->getFrameRateRatio();
+}
+
+bool VideoStreamImpl::isDemanded(const std::string &thread, int64_t nowMs)
+{
+    if (!settings_.params_.producerParams_.demand_.enabled_)
+        return true;
+
+    int64_t lastDemandMs;
+    {
+        boost::lock_guard<boost::mutex> scopedLock(demandMutex_);
+        lastDemandMs = lastDemandMs_[thread];
+    }
+
+    boost::shared_ptr<MetaKeeper> keeper = metaKeepers_[thread];
+    bool dormant = (nowMs - lastDemandMs > (int64_t)settings_.params_.producerParams_.demand_.idleWindowMs_);
+
+    if (dormant != keeper->isDormant())
+    {
+        keeper->setDormant(dormant);
+        // consumers can't decode anything before a key frame
+        if (!dormant)
+            threads_[thread]->requestKeyFrame();
+
+        LogInfoC << "thread " << thread << (dormant ? " is dormant (no interests for "
+                                                    : " resumed (interest after ")
+                 << nowMs - lastDemandMs << "ms)" << std::endl;
+    }
+
+    return !dormant;
+}
+
+void VideoStreamImpl::demandObserved(const std::string &thread)
+{
+    boost::lock_guard<boost::mutex> scopedLock(demandMutex_);
+    lastDemandMs_[thread] = clock::millisecondTimestamp();
+}
+
+bool VideoStreamImpl::isLayerPredicted(const std::string &thread, bool isKey, unsigned int temporalLayer)
+{
+    std::map<std::string, std::vector<PacketNumber>>::const_iterator it = layerPlaybackNos_.find(thread);
+    if (isKey || it == layerPlaybackNos_.end())
+        return true;
+
+    // consumer predicts layer of the next delta frame by its' GOP position
+    unsigned char gopPos = gopPositions_[thread] + 1;
+    return (temporalLayer == NameComponents::temporalLayer(gopPos, it->second.size()));
+}
+
+void VideoStreamImpl::setupMetaInvocation()
+{
+    if (!isPeriodicInvocationSet())
+    {
+        boost::shared_ptr<VideoStreamImpl> me = boost::dynamic_pointer_cast<VideoStreamImpl>(shared_from_this());
+        setupInvocation(MediaStreamBase::MetaCheckIntervalMs,
+                        boost::bind(&VideoStreamImpl::periodicInvocation, me));
+    }
+}
+
+void VideoStreamImpl::startPipeline()
+{
+    const GeneralProducerParams::PipelineParams &pp = settings_.params_.producerParams_.pipeline_;
+
+    captureQueue_ = boost::make_shared<StageQueue<boost::shared_ptr<CapturedFrame>>>(pp.depth_,
+        (pp.dropOldest_ ? StageQueue<boost::shared_ptr<CapturedFrame>>::DropOldest
+                        : StageQueue<boost::shared_ptr<CapturedFrame>>::DropNewest));
+    isPipelineRunning_ = true;
+    encoderThread_ = boost::thread(boost::bind(&VideoStreamImpl::runEncoder, this));
+
+    LogInfoC << "started pipeline: queue depth " << pp.depth_
+             << (pp.dropOldest_ ? " drop oldest" : " drop newest") << std::endl;
+}
+
+void VideoStreamImpl::stopPipeline()
+{
+    if (!captureQueue_)
+        return;
+
+    {
+        boost::lock_guard<boost::mutex> scopedLock(publishMutex_);
+        isPipelineRunning_ = false;
+    }
+    publishCond_.notify_all();
+    captureQueue_->stop();
+
+    // encoder thread never releases the last reference to the stream (see
+    // runEncoder()), thus it can always be joined
+    assert(encoderThread_.get_id() != boost::this_thread::get_id());
+    if (encoderThread_.joinable())
+        encoderThread_.join();
+}
+
+void VideoStreamImpl::runEncoder()
+{
+    unsigned int depth = settings_.params_.producerParams_.pipeline_.depth_;
+    boost::shared_ptr<CapturedFrame> cf;
+
+    while (captureQueue_->pop(cf))
+    {
+        // stream is kept alive while frame is encoded, but the reference is
+        // released on face thread, as stream's destructor joins this thread
+        boost::shared_ptr<boost::shared_ptr<VideoStreamImpl>> me =
+            boost::make_shared<boost::shared_ptr<VideoStreamImpl>>();
+        try
+        {
+            *me = boost::static_pointer_cast<VideoStreamImpl>(shared_from_this());
+        }
+        catch (boost::bad_weak_ptr &e)
+        {
+            break; // stream is being destroyed
+        }
+
+        {
+            // encoding of the next frame overlaps with publishing of previous
+            // ones, unless there are too many of them
+            boost::unique_lock<boost::mutex> lock(publishMutex_);
+            while (isPipelineRunning_ && busyPublishing_ >= (int)(depth * std::max<size_t>(1, threads_.size())))
+                publishCond_.wait(lock);
+
+            if (!isPipelineRunning_)
+            {
+                async::dispatchAsync(settings_.faceIo_, [me]() { me->reset(); });
+                break;
+            }
+        }
+
+        queueDelay_.newValue(clock::millisecondTimestamp() - cf->captureTimeMs_);
+        (*statStorage_)[Indicator::PipelineCaptureQueueSize] = captureQueue_->size();
+        (*statStorage_)[Indicator::PipelineQueueDelay] = queueDelay_.value();
+
+        try
+        {
+            encodeFrame(cf->frame_);
+        }
+        catch (std::exception &e)
+        {
+            LogErrorC << "error while encoding frame: " << e.what() << std::endl;
+        }
+
+        cf.reset();
+        async::dispatchAsync(settings_.faceIo_, [me]() { me->reset(); });
+    }
+
+    LogTraceC << "encoder thread stopped" << std::endl;
+}
+
 void VideoStreamImpl::publish(map<string, FramePacketPtr> &frames)
 {
     LogTraceC << "will publish " << frames.size() << " frames" << std::endl;
@@ -239,9 +644,15 @@ void VideoStreamImpl::publish(map<string, FramePacketPtr> &frames)
         bool isKey = (it.second->getFrame()._frameType == webrtc::kVideoFrameKey);
 
         if (isKey)
+        {
             seqCounters_[it.first].first++;
+            gopPositions_[it.first] = 0;
+        }
         else
+        {
             seqCounters_[it.first].second++;
+            gopPositions_[it.first]++;
+        }
 
         CommonHeader packetHdr;
         packetHdr.sampleRate_ = metaKeepers_[it.first]->getRate();
@@ -262,24 +673,73 @@ void VideoStreamImpl::publish(map<string, FramePacketPtr> &frames)
 
 std::string VideoStreamImpl::publish(const string &thread, FramePacketPtr &fp)
 {
-    boost::shared_ptr<NetworkData> parityData = fp->getParityData(
-        VideoFrameSegment::payloadLength(settings_.params_.producerParams_.segmentSize_),
-        PARITY_RATIO);
-
     bool isKey = (fp->getFrame()._frameType == webrtc::kVideoFrameKey);
+    boost::shared_ptr<ParityControl> parityControl = parityControls_[thread];
+    double parityRatio = parityControl->getParityRatio(isKey ? SampleClass::Key : SampleClass::Delta);
+    size_t paritySymbolLength = VideoFrameSegment::payloadLength(settings_.params_.producerParams_.segmentSize_);
+
+    // delta frames of such threads are protected by FEC groups instead of
+    // per-frame parity
+    boost::shared_ptr<FecGroupEncoder> fecGroupEncoder;
+    if (!isKey && fecGroupEncoders_.find(thread) != fecGroupEncoders_.end())
+        fecGroupEncoder = fecGroupEncoders_[thread];
+    // delta frames of such threads are covered by aggregated manifests, key
+    // frames always have their own
+    boost::shared_ptr<ManifestWindows> manifestWindow;
+    if (!isKey && manifestWindows_.find(thread) != manifestWindows_.end())
+        manifestWindow = manifestWindows_[thread];
+
     PacketNumber seqNo = (isKey ? seqCounters_[thread].first : seqCounters_[thread].second);
     PacketNumber pairedSeq = (isKey ? seqCounters_[thread].second + 1 : seqCounters_[thread].first);
     PacketNumber playbackNo = playbackCounter_;
-    unsigned char gopPos = (char)threads_[thread]->getCoder().getGopCounter();
+    // same as encoder's GOP counter, but also valid for pre-encoded frames
+    unsigned char gopPos = gopPositions_[thread];
     Name dataName(streamPrefix_);
     dataName.append(thread)
-        .append((isKey ? NameComponents::NameComponentKey : NameComponents::NameComponentDelta))
-        .appendSequenceNumber(seqNo);
+        .append((isKey ? NameComponents::NameComponentKey : NameComponents::NameComponentDelta));
+
+    // delta frames of every temporal layer are published in their own
+    // namespace, thus consumer can stop fetching upper layers
+    unsigned int temporalLayer = 0;
+    PacketNumber refPlaybackNo = -1;
+    if (layerPlaybackNos_.find(thread) != layerPlaybackNos_.end())
+    {
+        std::vector<PacketNumber> &layerPlaybackNos = layerPlaybackNos_[thread];
+        temporalLayer = std::min<unsigned int>(fp->getTemporalLayer(), layerPlaybackNos.size() - 1);
+
+        if (isKey)
+            layerPlaybackNos.assign(layerPlaybackNos.size(), playbackNo);
+        else
+        {
+            // layer follows GOP position (see isLayerPredicted())
+            dataName.append(Name::Component::fromNumber(temporalLayer));
+            refPlaybackNo = layerPlaybackNos[temporalLayer];
+            // goes into frame's layer header, before parity is computed
+            fp->setRefPlaybackNo(refPlaybackNo);
+            for (size_t l = temporalLayer; l < layerPlaybackNos.size(); ++l)
+                layerPlaybackNos[l] = playbackNo;
+        }
+    }
+    dataName.appendSequenceNumber(seqNo);
 
     size_t nDataSeg = VideoFrameSegment::numSlices(*fp,
                                                    settings_.params_.producerParams_.segmentSize_);
-    size_t nParitySeg = fecEnabled_ && VideoFrameSegment::numSlices(*parityData,
-                                                     settings_.params_.producerParams_.segmentSize_);
+    // parity data is computed later, on publishing thread, but its size is
+    // needed now for segment headers
+    size_t nParitySeg = (fecEnabled_ && !fecGroupEncoder ? VideoFrameSegment::numSlices(fp->getParitySymbolsNum(paritySymbolLength, parityRatio) *
+                                                                        paritySymbolLength,
+                                                                    settings_.params_.producerParams_.segmentSize_)
+                                     : 0);
+    // unless parity is computed on request, it's computed here, so that it 
+    // doesn't load publishing thread
+    boost::shared_ptr<NetworkData> parityData;
+    if (nParitySeg && !settings_.params_.producerParams_.fec_.lazy_)
+        parityData = fp->getParityData(paritySymbolLength, parityRatio);
+    // same for group parity, only finished groups are passed to publishing
+    // thread
+    boost::shared_ptr<FecGroupPacket> groupPacket;
+    if (fecGroupEncoder)
+        groupPacket = fecGroupEncoder->addFrame(seqNo, playbackNo, pairedSeq, *fp, parityRatio);
     boost::shared_ptr<VideoStreamImpl> me = boost::static_pointer_cast<VideoStreamImpl>(shared_from_this());
     boost::shared_ptr<MetaKeeper> keeper = metaKeepers_[thread];
 
@@ -290,72 +750,392 @@ std::string VideoStreamImpl::publish(const string &thread, FramePacketPtr &fp)
               << "(" << SAMPLE_SUFFIX(dataName) << ")" << std::endl;
 
     busyPublishing_++;
+    (*statStorage_)[Indicator::PipelinePublishQueueSize] = busyPublishing_;
+    int64_t dispatchTimeMs = clock::millisecondTimestamp();
     async::dispatchAsync(settings_.faceIo_, [me, nParitySeg, nDataSeg, seqNo, pairedSeq, keeper, isKey,
-                                             thread, fp, parityData, dataName, playbackNo, gopPos, this] {
-        VideoFrameSegmentHeader segmentHdr;
-        segmentHdr.totalSegmentsNum_ = nDataSeg;
-        segmentHdr.paritySegmentsNum_ = nParitySeg;
-        segmentHdr.playbackNo_ = playbackNo;
-        segmentHdr.pairedSequenceNo_ = pairedSeq;
-
-        PublishedDataPtrVector segments =
-            me->framePublisher_->publish(dataName, *fp, segmentHdr,
-                                         (isKey ? settings_.params_.producerParams_.freshness_.sampleKeyMs_ : -1),
-                                         isKey, true);
-        assert(segments.size());
-        keeper->updateMeta(isKey, nDataSeg, nParitySeg, seqNo, pairedSeq, gopPos);
-
-        LogDebugC << "↓ published "
-                  << seqNo << (isKey ? "k " : "d ") << playbackNo << "p "
-                  << "(" << SAMPLE_SUFFIX(dataName) << ")x" << segments.size()
-                  << " Dgen " << segmentHdr.generationDelayMs_ << "ms" << std::endl;
-
-        PublishedDataPtrVector paritySegments;
-        if (nParitySeg)
-        {
+                                             thread, fp, parityData, dataName, playbackNo, gopPos,
+                                             parityControl, parityRatio, groupPacket, manifestWindow,
+                                             dispatchTimeMs, this] {
+        // header is filled in by publisher and is needed once segments are
+        // signed, which may happen on signing threads
+        boost::shared_ptr<VideoFrameSegmentHeader> segmentHdr(boost::make_shared<VideoFrameSegmentHeader>());
+        segmentHdr->totalSegmentsNum_ = nDataSeg;
+        segmentHdr->paritySegmentsNum_ = nParitySeg;
+        segmentHdr->playbackNo_ = playbackNo;
+        segmentHdr->pairedSequenceNo_ = pairedSeq;
+
+        // completion callbacks may be the last to hold signing pool, they
+        // must not hold the stream which owns it
+        boost::weak_ptr<VideoStreamImpl> wme(me);
+        uint64_t nExpectedInterests = me->framePublisher_->getExpectedInterestsNum();
+        uint64_t nReceivedInterests = me->framePublisher_->getReceivedInterestsNum();
+        me->framePublisher_->publishAsync(dataName, *fp, *segmentHdr,
+                                          (isKey ? settings_.params_.producerParams_.freshness_.sampleKeyMs_ : -1),
+                                          isKey, true,
+                                          [wme, nParitySeg, nDataSeg, seqNo, isKey, thread, fp, parityData,
+                                           dataName, playbackNo, segmentHdr, parityControl, parityRatio,
+                                           groupPacket, manifestWindow, dispatchTimeMs, this](const PublishedDataPtrVector &published) {
+            boost::shared_ptr<VideoStreamImpl> stream = wme.lock();
+            if (!stream)
+                return;
+
+            LogDebugC << "↓ published "
+                      << seqNo << (isKey ? "k " : "d ") << playbackNo << "p "
+                      << "(" << SAMPLE_SUFFIX(dataName) << ")x" << published.size()
+                      << " Dgen " << segmentHdr->generationDelayMs_ << "ms" << std::endl;
+
+            // manifest covers parity too, unless it's computed on request,
+            // thus it's published once parity is published
+            boost::function<void(const PublishedDataPtrVector &, size_t)> onFramePublished =
+                [wme, seqNo, isKey, thread, dataName, playbackNo, nParitySeg, groupPacket,
+                 manifestWindow, dispatchTimeMs, this](const PublishedDataPtrVector &segments, size_t nParityPublished) {
+                    boost::shared_ptr<VideoStreamImpl> stream = wme.lock();
+                    if (!stream)
+                        return;
+
+                    PublishedDataPtrVector ss(segments);
+                    if (!manifestWindow || settings_.params_.producerParams_.manifest_.perFrame_)
+                        publishManifest(dataName, ss);
+                    if (manifestWindow)
+                        addToManifestWindow(Name(streamPrefix_).append(thread), *manifestWindow, seqNo, segments);
+
+                    if (groupPacket)
+                        publishFecGroup(Name(streamPrefix_).append(thread), *groupPacket);
+
+                    {
+                        boost::lock_guard<boost::mutex> scopedLock(publishMutex_);
+                        busyPublishing_--;
+                    }
+                    publishCond_.notify_one();
+                    publishDelay_.newValue(clock::millisecondTimestamp() - dispatchTimeMs);
+                    (*statStorage_)[Indicator::PipelinePublishQueueSize] = busyPublishing_;
+                    (*statStorage_)[Indicator::PipelinePublishDelay] = publishDelay_.value();
+
+                    LogInfoC << "▻ published frame "
+                             << seqNo << (isKey ? "k " : "d ") << playbackNo << "p "
+                             << " data segments x" << (segments.size() - nParityPublished)
+                             << " parity segments x" << nParityPublished
+                             << (nParitySeg && nParityPublished == 0 ? " (deferred)" : "")
+                             << std::endl;
+
+                    (*statStorage_)[Indicator::PublishedNum]++;
+                    if (isKey)
+                        (*statStorage_)[Indicator::PublishedKeyNum]++;
+                    if (busyPublishing_ == 0)
+                        (*statStorage_)[Indicator::ProcessedNum]++;
+                };
+
+            if (!nParitySeg)
+            {
+                onFramePublished(published, 0);
+                return;
+            }
+
+            LazyParity lp({fp, *segmentHdr, parityRatio, isKey, PublishedDataPtrVector(), parityData,
+                           manifestWindow,
+                           (manifestWindow ? AggregatedManifest::windowNo(seqNo, settings_.params_.producerParams_.manifest_.window_) : -1)});
             Name parityName(dataName);
             parityName.append(NameComponents::NameComponentParity);
 
-            paritySegments =
-                me->framePublisher_->publish(parityName, *parityData, segmentHdr,
-                                             (isKey ? settings_.params_.producerParams_.freshness_.sampleKeyMs_ : -1),
-                                             isKey);
-            assert(paritySegments.size());
-            std::copy(paritySegments.begin(), paritySegments.end(), std::back_inserter(segments));
+            if (parityData)
+            {
+                publishParity(dataName, lp, [wme, published, seqNo, isKey, playbackNo, parityName,
+                                             parityControl, parityRatio, onFramePublished, this](const PublishedDataPtrVector &paritySegments) {
+                    boost::shared_ptr<VideoStreamImpl> stream = wme.lock();
+                    if (!stream)
+                        return;
+
+                    LogDebugC << "↓ published "
+                              << seqNo << (isKey ? "k " : "d ") << playbackNo << "p "
+                              << "(" << PARITY_SUFFIX(parityName) << ")x" << paritySegments.size()
+                              << " ratio " << parityRatio
+                              << " loss " << parityControl->getLossEstimation()
+                              << std::endl;
+
+                    PublishedDataPtrVector segments(published);
+                    std::copy(paritySegments.begin(), paritySegments.end(), std::back_inserter(segments));
+                    onFramePublished(segments, paritySegments.size());
+                });
+            }
+            else
+            {
+                lp.segments_ = published;
+                if (hasPendingInterests(parityName))
+                    computeParity(dataName, lp);
+                else
+                    deferParity(dataName, lp);
+                onFramePublished(published, 0);
+            }
+        });
+
+        parityControl->interestsObserved(me->framePublisher_->getExpectedInterestsNum() - nExpectedInterests,
+                                         me->framePublisher_->getReceivedInterestsNum() - nReceivedInterests);
+        if (rateControl_)
+            rateControl_->interestsObserved(nDataSeg, me->framePublisher_->getReceivedInterestsNum() - nReceivedInterests);
+        if (me->framePublisher_->getReceivedInterestsNum() > nReceivedInterests)
+            me->demandObserved(thread);
+        keeper->updateMeta(isKey, nDataSeg, nParitySeg, seqNo, pairedSeq, gopPos,
+                           (nParitySeg ? parityRatio : 0));
+    });
 
-            LogDebugC << "↓ published "
-                      << seqNo << (isKey ? "k " : "d ") << playbackNo << "p "
-                      << "(" << PARITY_SUFFIX(parityName) << ")x" << paritySegments.size()
-                      << std::endl;
+    return dataName.toUri();
+}
+
+void VideoStreamImpl::publishParity(const ndn::Name &dataName, const LazyParity &lp,
+                                    const OnPublished &onPublished)
+{
+    // parity is never computed on face thread
+    assert(lp.parityData_);
+    Name parityName(dataName);
+    parityName.append(NameComponents::NameComponentParity);
+    VideoFrameSegmentHeader segmentHdr(lp.segmentHdr_);
+
+    framePublisher_->publishAsync(parityName, *lp.parityData_, segmentHdr,
+                                  (lp.isKey_ ? settings_.params_.producerParams_.freshness_.sampleKeyMs_ : -1),
+                                  lp.isKey_, false, onPublished);
+}
+
+void VideoStreamImpl::publishFecGroup(const ndn::Name &threadPrefix, const FecGroupPacket &groupPacket)
+{
+    Name groupName(FecGroupPacket::groupName(threadPrefix, groupPacket.getGroupNo()));
+    groupName.appendVersion(0);
+    // consumers ask for group packets only when some frame of the group has
+    // missing segments, thus pending interests for this name must not be
+    // treated as interests for upcoming frames
+    boost::weak_ptr<VideoStreamImpl> wme = boost::static_pointer_cast<VideoStreamImpl>(shared_from_this());
+    PacketNumber groupNo = groupPacket.getGroupNo();
+    size_t nMembers = groupPacket.getMembers().size();
+    size_t nParitySymbols = groupPacket.getParitySymbolsNum();
+
+    metadataPublisher_->publishAsync(groupName, groupPacket,
+                                     settings_.params_.producerParams_.freshness_.sampleMs_, false, true,
+                                     [wme, groupName, groupNo, nMembers, nParitySymbols, this](const PublishedDataPtrVector &ss) {
+        if (!wme.lock())
+            return;
+
+        (*statStorage_)[Indicator::FecGroupPublishedNum]++;
+        LogDebugC << "↓ published FEC group " << groupNo
+                  << " (" << groupName.getSubName(-5, 5) << ")x" << ss.size()
+                  << " frames " << nMembers
+                  << " parity symbols " << nParitySymbols << std::endl;
+    });
+}
+
+void VideoStreamImpl::addToManifestWindow(const ndn::Name &threadPrefix, ManifestWindows &windows,
+                                          PacketNumber seqNo, const PublishedDataPtrVector &segments)
+{
+    unsigned int windowSize = settings_.params_.producerParams_.manifest_.window_;
+    PacketNumber windowNo = AggregatedManifest::windowNo(seqNo, windowSize);
+    ManifestWindow &window = windows.current_;
+
+    // thread was reset or frames were dropped - publish what's been collected,
+    // so that consumer could verify these frames too
+    if (window.segments_.size() && windowNo != window.windowNo_)
+        closeManifestWindow(threadPrefix, windows);
+
+    window.windowNo_ = windowNo;
+    window.segments_.insert(window.segments_.end(), segments.begin(), segments.end());
+
+    if ((seqNo + 1) % windowSize == 0)
+        closeManifestWindow(threadPrefix, windows);
+}
+
+void VideoStreamImpl::addLateToManifestWindow(const ndn::Name &threadPrefix, ManifestWindows &windows,
+                                              PacketNumber windowNo, const PublishedDataPtrVector &segments)
+{
+    // window is still open, segments will be published with it
+    if (windows.current_.windowNo_ == windowNo)
+    {
+        windows.current_.segments_.insert(windows.current_.segments_.end(), segments.begin(), segments.end());
+        return;
+    }
+
+    for (auto &w : windows.closed_)
+        if (w.windowNo_ == windowNo)
+        {
+            w.segments_.insert(w.segments_.end(), segments.begin(), segments.end());
+            w.version_++;
+            publishManifestWindow(threadPrefix, w);
+            return;
         }
-        publishManifest(dataName, segments);
-        busyPublishing_--;
 
-        LogInfoC << "▻ published frame "
-                 << seqNo << (isKey ? "k " : "d ") << playbackNo << "p "
-                 << " data segments x" << segments.size()
-                 << " parity segments x" << paritySegments.size()
-                 << std::endl;
+    LogWarnC << "aggregated manifest " << windowNo << " is closed already, "
+             << segments.size() << " late segments are not covered" << std::endl;
+}
 
-        (*statStorage_)[Indicator::PublishedNum]++;
-        if (isKey)
-            (*statStorage_)[Indicator::PublishedKeyNum]++;
-        if (busyPublishing_ == 0)
-            (*statStorage_)[Indicator::ProcessedNum]++;
+void VideoStreamImpl::closeManifestWindow(const ndn::Name &threadPrefix, ManifestWindows &windows)
+{
+    // closed windows are kept as long as their frames may get parity on
+    // request
+    size_t nClosedWindows = LAZY_PARITY_QUEUE_SIZE / settings_.params_.producerParams_.manifest_.window_ + 1;
+
+    publishManifestWindow(threadPrefix, windows.current_);
+    windows.closed_.push_back(windows.current_);
+    while (windows.closed_.size() > nClosedWindows)
+        windows.closed_.pop_front();
+    windows.current_ = ManifestWindow();
+}
+
+void VideoStreamImpl::publishManifestWindow(const ndn::Name &threadPrefix, const ManifestWindow &window)
+{
+    AggregatedManifest m(window.windowNo_, window.segments_);
+    Name manifestName(AggregatedManifest::windowName(threadPrefix, window.windowNo_));
+    manifestName.appendVersion(window.version_);
+    // consumers ask for aggregated manifest ahead, once per window, thus
+    // pending interests for this name must not be treated as interests for
+    // upcoming frames
+    boost::weak_ptr<VideoStreamImpl> wme = boost::static_pointer_cast<VideoStreamImpl>(shared_from_this());
+    PacketNumber windowNo = window.windowNo_;
+    uint64_t version = window.version_;
+    size_t nCovered = m.size();
+
+    metadataPublisher_->publishAsync(manifestName, m, -1, false, true,
+                                     [wme, manifestName, windowNo, version, nCovered, this](const PublishedDataPtrVector &ss) {
+        if (!wme.lock())
+            return;
+
+        (*statStorage_)[Indicator::ManifestWindowPublishedNum]++;
+        LogDebugC << "⤷ published aggregated manifest ☆ " << windowNo
+                  << " v" << version
+                  << " (" << manifestName.getSubName(-5, 5) << ")x" << ss.size()
+                  << " segments " << nCovered << std::endl;
     });
+}
 
-    return dataName.toUri();
+bool VideoStreamImpl::hasPendingInterests(const ndn::Name &prefix) const
+{
+    return sampleCache_->hasPendingInterests(prefix);
+}
+
+void VideoStreamImpl::deferParity(const ndn::Name &dataName, const LazyParity &lp)
+{
+    if (lazyParityQueue_.size() >= LAZY_PARITY_QUEUE_SIZE)
+    {
+        lazyParity_.erase(lazyParityQueue_.front());
+        lazyParityQueue_.pop_front();
+    }
+
+    lazyParity_[dataName] = lp;
+    lazyParityQueue_.push_back(dataName);
+    (*statStorage_)[Indicator::ParityDeferredNum]++;
 }
 
-void VideoStreamImpl::publishManifest(ndn::Name dataName, PublishedDataPtrVector &segments)
+void VideoStreamImpl::onPendingInterest(const boost::shared_ptr<const ndn::Interest> &interest)
+{
+    const Name &n = interest->getName();
+
+    // any interest under thread's prefix (meta, upcoming frames) is demand
+    // for the thread
+    if (settings_.params_.producerParams_.demand_.enabled_ &&
+        n.size() > streamPrefix_.size() && streamPrefix_.isPrefixOf(n))
+    {
+        std::string thread = n[streamPrefix_.size()].toEscapedString();
+        boost::lock_guard<boost::mutex> scopedLock(demandMutex_);
+        if (lastDemandMs_.find(thread) != lastDemandMs_.end())
+            lastDemandMs_[thread] = clock::millisecondTimestamp();
+    }
+
+    // parity interest name is <frame name>/_parity/<segment>
+    if (lazyParity_.size() == 0 || n.size() < 2 ||
+        n[-2].toEscapedString() != NameComponents::NameComponentParity)
+        return;
+
+    Name dataName(n.getPrefix(-2));
+    auto it = lazyParity_.find(dataName);
+    if (it == lazyParity_.end())
+        return;
+
+    LazyParity lp = it->second;
+    lazyParity_.erase(it);
+    lazyParityQueue_.erase(std::find(lazyParityQueue_.begin(), lazyParityQueue_.end(), dataName));
+
+    // interests for other parity segments of the frame, which arrive while
+    // parity is computed, are answered once it's published
+    computeParity(dataName, lp);
+}
+
+void VideoStreamImpl::computeParity(const ndn::Name &dataName, const LazyParity &lp)
+{
+    // stream may be released while parity is computed, its destructor stops
+    // parity thread, thus only face thread may hold stream's reference
+    boost::weak_ptr<VideoStreamImpl> wme = boost::static_pointer_cast<VideoStreamImpl>(shared_from_this());
+    boost::asio::io_service &faceIo = settings_.faceIo_;
+    size_t paritySymbolLength = VideoFrameSegment::payloadLength(settings_.params_.producerParams_.segmentSize_);
+
+    dispatchOnMyThread([wme, &faceIo, dataName, lp, paritySymbolLength, this]() {
+        LazyParity computed(lp);
+        try
+        {
+            computed.parityData_ = computed.frame_->getParityData(paritySymbolLength, computed.parityRatio_);
+        }
+        catch (std::exception &e)
+        {
+            boost::shared_ptr<VideoStreamImpl> me = wme.lock();
+            if (!me)
+                return;
+
+            LogErrorC << "error while computing parity for " << dataName
+                      << ": " << e.what() << std::endl;
+            (*statStorage_)[Indicator::ParityFailedNum]++;
+            // the reference is released on face thread
+            async::dispatchAsync(faceIo, [me]() {});
+            return;
+        }
+
+        async::dispatchAsync(faceIo, [wme, dataName, computed]() {
+            boost::shared_ptr<VideoStreamImpl> me = wme.lock();
+
+            if (me && computed.parityData_)
+                me->publishRequestedParity(dataName, computed);
+        });
+    });
+}
+
+void VideoStreamImpl::publishRequestedParity(const ndn::Name &dataName, const LazyParity &lp)
+{
+    boost::weak_ptr<VideoStreamImpl> wme = boost::static_pointer_cast<VideoStreamImpl>(shared_from_this());
+
+    publishParity(dataName, lp, [wme, dataName, lp, this](const PublishedDataPtrVector &paritySegments) {
+        if (!wme.lock())
+            return;
+
+        // manifest published with the frame didn't have parity, publish new
+        // one (frame name is <thread prefix>/d/<seq no>)
+        if (lp.manifestWindows_)
+            addLateToManifestWindow(dataName.getPrefix(-2), *lp.manifestWindows_, lp.windowNo_, paritySegments);
+        if (!lp.manifestWindows_ || settings_.params_.producerParams_.manifest_.perFrame_)
+        {
+            PublishedDataPtrVector segments(lp.segments_);
+            std::copy(paritySegments.begin(), paritySegments.end(), std::back_inserter(segments));
+            publishManifest(dataName, segments, 1);
+        }
+        (*statStorage_)[Indicator::ParityLazyNum]++;
+
+        Name parityName(dataName);
+        parityName.append(NameComponents::NameComponentParity);
+        LogDebugC << "↓ published on request "
+                  << "(" << PARITY_SUFFIX(parityName) << ")x" << paritySegments.size()
+                  << " ratio " << lp.parityRatio_
+                  << std::endl;
+    });
+}
+
+void VideoStreamImpl::publishManifest(ndn::Name dataName, PublishedDataPtrVector &segments,
+                                      uint64_t version)
 {
     Manifest m(segments);
-    dataName.append(NameComponents::NameComponentManifest).appendVersion(0);
-    PublishedDataPtrVector ss = metadataPublisher_->publish(dataName, m);
+    dataName.append(NameComponents::NameComponentManifest).appendVersion(version);
+    boost::weak_ptr<VideoStreamImpl> wme = boost::static_pointer_cast<VideoStreamImpl>(shared_from_this());
+
+    metadataPublisher_->publishAsync(dataName, m, -1, false, false,
+                                     [wme, dataName, this](const PublishedDataPtrVector &ss) {
+        if (!wme.lock())
+            return;
 
-    LogDebugC << (busyPublishing_ == 1 ? "⤷" : "↓")
-              << " published manifest ☆ (" << dataName.getSubName(-5, 5) << ")x"
-              << ss.size() << std::endl;
+        LogDebugC << (busyPublishing_ == 1 ? "⤷" : "↓")
+                  << " published manifest ☆ (" << dataName.getSubName(-5, 5) << ")x"
+                  << ss.size() << std::endl;
+    });
 }
 
 map<string, PacketNumber>
@@ -376,7 +1156,7 @@ bool VideoStreamImpl::updateMeta()
         Name metaName(streamPrefix_);
         metaName.append(it.first).append(NameComponents::NameComponentMeta)
                 .appendVersion(it.second->getVersionNumber());
-        metadataPublisher_->publish(metaName, it.second->getMeta());
+        metadataPublisher_->publishAsync(metaName, it.second->getMeta(), -1, false, false);
 
         LogDebugC << "published meta: seginfo "
                   << it.second->getMeta().getSegInfo().deltaAvgSegNum_ << " "
@@ -386,6 +1166,11 @@ bool VideoStreamImpl::updateMeta()
                   << " seq " << it.second->getMeta().getSeqNo().first << " "
                   << it.second->getMeta().getSeqNo().second << " "
                   << " gop pos " << (int)it.second->getMeta().getGopPos()
+                  << " parity ratio " << it.second->getMeta().getParityRatio().first << " "
+                  << it.second->getMeta().getParityRatio().second
+                  << " fec group " << it.second->getMeta().getFecGroupSize()
+                  << " manifest window " << it.second->getMeta().getManifestWindow()
+                  << (it.second->isDormant() ? " dormant" : "")
                   << std::endl;
 
         (*statStorage_)[Indicator::CurrentProducerFramerate] = it.second->getRate();
@@ -395,14 +1180,19 @@ bool VideoStreamImpl::updateMeta()
 }
 
 //******************************************************************************
-VideoStreamImpl::MetaKeeper::MetaKeeper(const VideoThreadParams *params)
+VideoStreamImpl::MetaKeeper::MetaKeeper(const VideoThreadParams *params, unsigned int fecGroupSize,
+                                        unsigned int manifestWindow)
     : BaseMetaKeeper(params),
       rateMeter_(FreqMeter(boost::make_shared<TimeWindow>(1000))),
       deltaData_(Average(boost::make_shared<TimeWindow>(100))),
       deltaParity_(Average(boost::make_shared<TimeWindow>(100))),
       keyData_(Average(boost::make_shared<SampleWindow>(2))),
       keyParity_(Average(boost::make_shared<SampleWindow>(2))),
-      versionNumber_(0)
+      parityRatio_(0, 0),
+      fecGroupSize_(fecGroupSize),
+      manifestWindow_(manifestWindow),
+      versionNumber_(0),
+      dormant_(false)
 {
 }
 
@@ -411,7 +1201,8 @@ VideoStreamImpl::MetaKeeper::~MetaKeeper()
 }
 
 void VideoStreamImpl::MetaKeeper::updateMeta(bool isKey, size_t nDataSeg, size_t nParitySeg,
-                                             PacketNumber seqNo, PacketNumber pairedSeqNo, unsigned char gopPos)
+                                             PacketNumber seqNo, PacketNumber pairedSeqNo, unsigned char gopPos,
+                                             double parityRatio)
 {
     Average &dataAvg = (isKey ? keyData_ : deltaData_);
     Average &parityAvg = (isKey ? keyParity_ : deltaParity_);
@@ -428,6 +1219,7 @@ void VideoStreamImpl::MetaKeeper::updateMeta(bool isKey, size_t nDataSeg, size_t
     seqNo_.first = (isKey ? pairedSeqNo : seqNo); // first is delta
     seqNo_.second = (isKey ? seqNo : pairedSeqNo); // second is key
     gopPos_ = gopPos;
+    (isKey ? parityRatio_.second : parityRatio_.first) = parityRatio;
     versionNumber_++;
 }
 
@@ -441,7 +1233,15 @@ VideoStreamImpl::MetaKeeper::getMeta() const
     segInfo.keyAvgParitySegNum_ = keyParity_.value();
 
     return boost::move(VideoThreadMeta(rateMeter_.value(), seqNo_.first, seqNo_.second, gopPos_,
-                                       segInfo, ((VideoThreadParams *)params_)->coderParams_));
+                                       segInfo, ((VideoThreadParams *)params_)->coderParams_,
+                                       parityRatio_.first, parityRatio_.second, fecGroupSize_,
+                                       manifestWindow_, dormant_));
+}
+
+void VideoStreamImpl::MetaKeeper::setDormant(bool dormant)
+{
+    dormant_ = dormant;
+    versionNumber_++;
 }
 
 double
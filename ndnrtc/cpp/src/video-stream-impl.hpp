@@ -12,6 +12,8 @@
 #include <boost/thread.hpp>
 #include <boost/asio/steady_timer.hpp>
 #include <boost/atomic.hpp>
+#include <atomic>
+#include <deque>
 
 #include "interfaces.hpp"
 #include "media-stream-base.hpp"
@@ -19,6 +21,8 @@
 #include "packet-publisher.hpp"
 #include "frame-converter.hpp"
 #include "estimators.hpp"
+#include "stage-queue.hpp"
+#include "threading-capability.hpp"
 
 namespace ndn
 {
@@ -36,14 +40,23 @@ class Logger;
 namespace ndnrtc
 {
 class VideoThread;
-class FrameScaler;
+class ScalingPyramid;
 class VideoThreadParams;
+class ParityControl;
+class RateControl;
+class FecGroupEncoder;
+class FecGroupPacket;
 struct Mutable;
 template <typename T>
 class VideoFramePacketT;
 typedef VideoFramePacketT<Mutable> VideoFramePacketAlias;
 
-class VideoStreamImpl : public MediaStreamBase
+/**
+ * If parity is computed on request, it is computed on stream's own thread
+ * (see ThreadingCapability) and published on face thread.
+ */
+class VideoStreamImpl : public MediaStreamBase,
+                        public ThreadingCapability
 {
   public:
     VideoStreamImpl(const std::string &streamPrefix,
@@ -55,6 +68,9 @@ class VideoStreamImpl : public MediaStreamBase
     int incomingFrame(const ArgbRawFrameWrapper &);
     int incomingFrame(const I420RawFrameWrapper &);
     int incomingFrame(const YUV_NV21FrameWrapper &);
+    int incomingFrame(const YUV_NV12FrameWrapper &);
+    int incomingFrame(const ExternalI420FrameWrapper &);
+    int incomingEncodedFrame(const std::string &threadName, const EncodedFrameWrapper &);
     
     const std::map<std::string, FrameInfo>& getLastPublished() { return lastPublished_; }
     void setLogger(boost::shared_ptr<ndnlog::new_api::Logger>) override;
@@ -68,17 +84,23 @@ class VideoStreamImpl : public MediaStreamBase
     class MetaKeeper : public MediaStreamBase::BaseMetaKeeper<VideoThreadMeta>
     {
       public:
-        MetaKeeper(const VideoThreadParams *params);
+        MetaKeeper(const VideoThreadParams *params, unsigned int fecGroupSize = 0,
+                   unsigned int manifestWindow = 0);
         ~MetaKeeper();
 
         VideoThreadMeta getMeta() const;
         double getRate() const;
 
         void updateMeta(bool isKey, size_t nDataSeg, size_t nParitySeg, 
-                        PacketNumber seqNo, PacketNumber pairedSeqNo, unsigned char gopPos);
+                        PacketNumber seqNo, PacketNumber pairedSeqNo, unsigned char gopPos,
+                        double parityRatio);
 
         uint32_t getVersionNumber() const { return versionNumber_; }
 
+        // dormant thread is not encoded until there's demand for it
+        void setDormant(bool dormant);
+        bool isDormant() const { return dormant_; }
+
       private:
         MetaKeeper(const MetaKeeper &) = delete;
 
@@ -86,29 +108,136 @@ class VideoStreamImpl : public MediaStreamBase
         estimators::Average deltaData_, deltaParity_;
         estimators::Average keyData_, keyParity_;
         std::pair<PacketNumber, PacketNumber> seqNo_;
+        std::pair<double, double> parityRatio_; // first is delta
+        unsigned int fecGroupSize_, manifestWindow_;
         unsigned char gopPos_;
         uint32_t versionNumber_;
+        bool dormant_;
     };
 
+    // segments of delta frames of an aggregated manifest window
+    typedef struct _ManifestWindow
+    {
+        _ManifestWindow() : windowNo_(-1), version_(0) {}
+
+        PacketNumber windowNo_; // -1 if there's no open window
+        uint64_t version_;      // incremented every time window is republished
+        PublishedDataPtrVector segments_;
+    } ManifestWindow;
+
+    // aggregated manifest windows of a thread: the current one and a few
+    // closed ones, which are republished with a new version once their frames
+    // get parity on request; accessed on face thread only
+    typedef struct _ManifestWindows
+    {
+        ManifestWindow current_;
+        std::deque<ManifestWindow> closed_;
+    } ManifestWindows;
+
+    // frame which parity is computed upon first request for it
+    typedef struct _LazyParity
+    {
+        boost::shared_ptr<VideoFramePacketAlias> frame_;
+        VideoFrameSegmentHeader segmentHdr_;
+        double parityRatio_;
+        bool isKey_;
+        PublishedDataPtrVector segments_; // data segments, for the manifest
+        boost::shared_ptr<NetworkData> parityData_; // null until computed
+        // if frame is covered by aggregated manifest, parity is added to its
+        // window instead of frame's own manifest
+        boost::shared_ptr<ManifestWindows> manifestWindows_;
+        PacketNumber windowNo_;
+    } LazyParity;
+
+    // captured frame, queued for encoding
+    typedef struct _CapturedFrame
+    {
+        WebRtcVideoFrame frame_;
+        int64_t captureTimeMs_;
+    } CapturedFrame;
+
     bool fecEnabled_;
     boost::atomic<int> busyPublishing_;
+    // capture -> encode -> publish pipeline, if enabled: captured frames are
+    // encoded on encoder thread, publishing of encoded frames overlaps with
+    // encoding of the next ones
+    boost::shared_ptr<StageQueue<boost::shared_ptr<CapturedFrame>>> captureQueue_;
+    boost::thread encoderThread_;
+    bool isPipelineRunning_;
+    boost::mutex publishMutex_;
+    boost::condition_variable publishCond_;
+    estimators::Average queueDelay_, encodeDelay_, publishDelay_;
+    // adjusts encoders' bitrate and frame rate to producer's load, if enabled
+    boost::shared_ptr<RateControl> rateControl_;
+    estimators::Average captureInterval_, publishBacklog_;
+    int64_t lastCaptureMs_, lastRateUpdateMs_;
+    // updated on capturing thread, read on encoding thread
+    std::atomic<double> captureIntervalMs_;
+    std::atomic<uint64_t> nBusyDropped_;
+    // accumulates fractions of captured frames to encode, when frame rate is
+    // lowered by rate control
+    double frameCredit_;
+    // if demand-driven encoding is enabled, threads that had no interests
+    // for a while are not encoded; time of the last interest for each thread
+    // is updated on face thread, checked on encoding thread
+    boost::mutex demandMutex_;
+    std::map<std::string, int64_t> lastDemandMs_;
     RawFrameConverter conv_;
     std::map<std::string, boost::shared_ptr<VideoThread>> threads_;
-    std::map<std::string, boost::shared_ptr<FrameScaler>> scalers_;
+    // captured frame is scaled once per resolution, shared by all threads
+    boost::shared_ptr<ScalingPyramid> scalingPyramid_;
     std::map<std::string, boost::shared_ptr<MetaKeeper>> metaKeepers_;
+    std::map<std::string, boost::shared_ptr<ParityControl>> parityControls_;
+    // only for threads, which delta frames are protected by FEC groups
+    std::map<std::string, boost::shared_ptr<FecGroupEncoder>> fecGroupEncoders_;
+    // only for threads, which delta frames are covered by aggregated manifests
+    std::map<std::string, boost::shared_ptr<ManifestWindows>> manifestWindows_;
     std::map<std::string, std::pair<uint64_t, uint64_t>> seqCounters_;
-    uint64_t playbackCounter_;
-    boost::shared_ptr<VideoPacketPublisher> framePublisher_;
+    // GOP position of the last published frame, per thread
+    std::map<std::string, unsigned char> gopPositions_;
+    // only for threads with several temporal layers: playback number of the
+    // last published frame of each layer or any lower one, per thread
+    std::map<std::string, std::vector<PacketNumber>> layerPlaybackNos_;
+    boost::atomic<uint64_t> playbackCounter_;
+    boost::shared_ptr<VideoSamplePublisher> framePublisher_;
     std::map<std::string, FrameInfo> lastPublished_;
+    // accessed on face thread only
+    std::map<ndn::Name, LazyParity> lazyParity_;
+    std::deque<ndn::Name> lazyParityQueue_;
 
     void add(const MediaThreadParams *params) override;
     void remove(const std::string &threadName) override;
     bool updateMeta() override;
 
     bool feedFrame(const WebRtcVideoFrame &frame);
+    bool encodeFrame(const WebRtcVideoFrame &frame);
+    bool isFrameSkipped();
+    void updateRates();
+    bool isDemanded(const std::string &thread, int64_t nowMs);
+    bool isLayerPredicted(const std::string &thread, bool isKey, unsigned int temporalLayer);
+    void demandObserved(const std::string &thread);
+    void setupMetaInvocation();
+    void startPipeline();
+    void stopPipeline();
+    void runEncoder();
     void publish(std::map<std::string, boost::shared_ptr<VideoFramePacketAlias>> &frames);
     std::string publish(const std::string &thread, boost::shared_ptr<VideoFramePacketAlias> &fp);
-    void publishManifest(ndn::Name dataName, PublishedDataPtrVector &segments);
+    void publishManifest(ndn::Name dataName, PublishedDataPtrVector &segments,
+                         uint64_t version = 0);
+    void publishParity(const ndn::Name &dataName, const LazyParity &lp,
+                       const OnPublished &onPublished);
+    void computeParity(const ndn::Name &dataName, const LazyParity &lp);
+    void publishRequestedParity(const ndn::Name &dataName, const LazyParity &lp);
+    void publishFecGroup(const ndn::Name &threadPrefix, const FecGroupPacket &groupPacket);
+    void addToManifestWindow(const ndn::Name &threadPrefix, ManifestWindows &windows,
+                             PacketNumber seqNo, const PublishedDataPtrVector &segments);
+    void addLateToManifestWindow(const ndn::Name &threadPrefix, ManifestWindows &windows,
+                                 PacketNumber windowNo, const PublishedDataPtrVector &segments);
+    void closeManifestWindow(const ndn::Name &threadPrefix, ManifestWindows &windows);
+    void publishManifestWindow(const ndn::Name &threadPrefix, const ManifestWindow &window);
+    bool hasPendingInterests(const ndn::Name &prefix) const;
+    void deferParity(const ndn::Name &dataName, const LazyParity &lp);
+    void onPendingInterest(const boost::shared_ptr<const ndn::Interest> &interest) override;
     std::map<std::string, PacketNumber> getCurrentSyncList(bool forKey = false);
 };
 }
@@ -9,7 +9,11 @@
 //
 
 #include <boost/make_shared.hpp>
+#include <boost/bind.hpp>
 #include <ndn-cpp/data.hpp>
+#ifdef __linux__
+#include <pthread.h>
+#endif
 
 #include "video-thread.hpp"
 #include "frame-data.hpp"
@@ -19,16 +23,24 @@ using namespace ndnlog;
 using namespace ndnrtc;
 using namespace webrtc;
 
+// number of frames that can wait for encoding; frames are given one at a time
+// per video thread, thus it's only exceeded if encoding is too slow
+#define ENCODE_QUEUE_SIZE 2
+
 //******************************************************************************
-VideoThread::VideoThread(const VideoCoderParams &coderParams)
+VideoThread::VideoThread(const VideoCoderParams &coderParams, int cpuCore)
     : coder_(coderParams, this, VideoCoder::KeyEnforcement::Gop),
-      nEncoded_(0), nDropped_(0)
+      nEncoded_(0), nDropped_(0),
+      tasks_(ENCODE_QUEUE_SIZE, StageQueue<boost::shared_ptr<EncodeTask>>::DropNewest)
 {
     description_ = "vthread";
+    worker_ = boost::thread(boost::bind(&VideoThread::work, this, cpuCore));
 }
 
 VideoThread::~VideoThread()
 {
+    tasks_.stop();
+    worker_.join();
 }
 
 //******************************************************************************
@@ -43,6 +55,20 @@ VideoThread::encode(const WebRtcVideoFrame &frame)
     return boost::move(videoFramePacket_);
 }
 
+void VideoThread::encodeAsync(const WebRtcVideoFrame &frame, OnEncoded onEncoded)
+{
+    encodeAsync([frame]() { return frame; }, onEncoded);
+}
+
+void VideoThread::encodeAsync(FrameSource frameSource, OnEncoded onEncoded)
+{
+    if (!tasks_.push(boost::make_shared<EncodeTask>(EncodeTask({frameSource, onEncoded}))))
+    {
+        LogWarnC << "encoder is busy, frame dropped" << std::endl;
+        onEncoded(boost::shared_ptr<VideoFramePacket>());
+    }
+}
+
 void VideoThread::setDescription(const std::string &desc)
 {
     description_ = desc;
@@ -58,7 +84,8 @@ void VideoThread::onEncodingStarted()
 void VideoThread::onEncodedFrame(const webrtc::EncodedImage &encodedImage)
 {
     nEncoded_++;
-    videoFramePacket_ = boost::make_shared<VideoFramePacket>(encodedImage);
+    videoFramePacket_ = boost::make_shared<VideoFramePacket>(encodedImage, (coder_.getSettings().temporalLayers_ > 1),
+                                                             coder_.getTemporalLayer());
 }
 
 void VideoThread::onDroppedFrame()
@@ -66,6 +93,38 @@ void VideoThread::onDroppedFrame()
     nDropped_++;
 }
 
+void VideoThread::work(int cpuCore)
+{
+    if (cpuCore >= 0)
+    {
+#ifdef __linux__
+        cpu_set_t cpuSet;
+        CPU_ZERO(&cpuSet);
+        CPU_SET(cpuCore, &cpuSet);
+        if (pthread_setaffinity_np(pthread_self(), sizeof(cpuSet), &cpuSet))
+            LogWarnC << "couldn't pin encoder to core " << cpuCore << std::endl;
+#else
+        LogWarnC << "pinning encoder to a core is not supported on this platform" << std::endl;
+#endif
+    }
+
+    boost::shared_ptr<EncodeTask> task;
+    while (tasks_.pop(task))
+    {
+        boost::shared_ptr<VideoFramePacket> packet;
+        try
+        {
+            packet = encode(task->frameSource_());
+        }
+        catch (std::exception &e)
+        {
+            LogErrorC << "error while encoding frame: " << e.what() << std::endl;
+        }
+        task->onEncoded_(packet);
+        task.reset();
+    }
+}
+
 void VideoThread::setLogger(boost::shared_ptr<ndnlog::new_api::Logger> logger)
 {
     coder_.setLogger(logger);
@@ -12,8 +12,11 @@
 #define __ndnrtc__video_thread__
 
 #include <boost/shared_ptr.hpp>
+#include <boost/function.hpp>
+#include <boost/thread.hpp>
 
 #include "video-coder.hpp"
+#include "stage-queue.hpp"
 
 namespace ndnrtc
 {
@@ -21,15 +24,43 @@ struct Mutable;
 template <typename T>
 class VideoFramePacketT;
 
+/**
+ * Video thread owns an encoder and a long-lived worker thread, on which
+ * frames, passed to encodeAsync(), are encoded one after another. Worker
+ * thread may be pinned to a CPU core.
+ */
 class VideoThread : public NdnRtcComponent,
                     public IEncoderDelegate
 {
   public:
-    VideoThread(const VideoCoderParams &coderParams);
+    typedef boost::function<void(const boost::shared_ptr<VideoFramePacketT<Mutable>> &)> OnEncoded;
+    typedef boost::function<const WebRtcVideoFrame(void)> FrameSource;
+
+    /**
+     * @param coderParams Encoder parameters
+     * @param cpuCore CPU core to pin worker thread to, -1 for no pinning
+     */
+    VideoThread(const VideoCoderParams &coderParams, int cpuCore = -1);
     ~VideoThread();
 
+    /**
+     * Encodes frame on the calling thread. Must not be mixed with encodeAsync().
+     * @return Encoded frame packet or nullptr if frame was dropped by encoder
+     */
     boost::shared_ptr<VideoFramePacketT<Mutable>> encode(const WebRtcVideoFrame &frame);
 
+    /**
+     * Queues frame for encoding on worker thread. Callback is called on
+     * worker thread with encoded frame packet or nullptr, if frame was
+     * dropped (by encoder or because worker is busy with previous frames).
+     */
+    void encodeAsync(const WebRtcVideoFrame &frame, OnEncoded onEncoded);
+
+    /**
+     * Same as above, but frame is obtained (e.g. scaled) on worker thread.
+     */
+    void encodeAsync(FrameSource frameSource, OnEncoded onEncoded);
+
     void
         setLogger(boost::shared_ptr<ndnlog::new_api::Logger>);
 
@@ -45,10 +76,30 @@ class VideoThread : public NdnRtcComponent,
     const VideoCoder &
     getCoder() const { return coder_; }
 
+    /**
+     * Sets encoder's target bitrate (kbps) and frame rate (see VideoCoder).
+     */
+    void
+    setRates(unsigned int bitrateKbps, double frameRate) { coder_.setRates(bitrateKbps, frameRate); }
+
+    /**
+     * Next frame will be encoded as key frame (see VideoCoder).
+     */
+    void
+    requestKeyFrame() { coder_.requestKeyFrame(); }
+
   private:
+    typedef struct _EncodeTask
+    {
+        FrameSource frameSource_;
+        OnEncoded onEncoded_;
+    } EncodeTask;
+
     VideoThread(const VideoThread &) = delete;
     VideoCoder coder_;
     unsigned int nEncoded_, nDropped_;
+    StageQueue<boost::shared_ptr<EncodeTask>> tasks_;
+    boost::thread worker_;
 
 #warning using shared pointer here as libstdc++ on OSX does not support std::move
     // TODO: update code to use std::move on Ubuntu
@@ -62,6 +113,8 @@ class VideoThread : public NdnRtcComponent,
 
     void
     onDroppedFrame();
+
+    void work(int cpuCore);
 };
 }
 
@@ -0,0 +1,368 @@
+//
+// test-fec-group.cc
+//
+//  Copyright 2013-2018 Regents of the University of California
+//
+
+#include <stdlib.h>
+#include <ctime>
+#include <set>
+
+#include <boost/asio.hpp>
+#include <ndn-cpp/interest.hpp>
+
+#include "tests-helpers.hpp"
+#include "gtest/gtest.h"
+#include "mock-objects/buffer-observer-mock.hpp"
+#include "src/fec-group.hpp"
+#include "src/fec-group-recovery.hpp"
+#include "src/frame-data.hpp"
+#include "src/frame-buffer.hpp"
+
+using namespace ndnrtc;
+using namespace testing;
+
+namespace
+{
+    const size_t SymbolLength = 1000;
+
+    // publishes frames of a group of groupSize frames, starting from
+    // sequence number firstSeqNo; returns the last packet produced
+    boost::shared_ptr<FecGroupPacket>
+    encodeGroup(FecGroupEncoder &encoder, PacketNumber firstSeqNo,
+                const std::vector<size_t> &frameSizes, double ratio,
+                std::vector<VideoFramePacket> &frames)
+    {
+        boost::shared_ptr<FecGroupPacket> groupPacket;
+        PacketNumber seqNo = firstSeqNo;
+
+        for (auto size : frameSizes)
+        {
+            frames.push_back(getVideoFramePacket(size));
+            EXPECT_FALSE(groupPacket);
+            groupPacket = encoder.addFrame(seqNo, seqNo * 2, 7, frames.back(), ratio);
+            seqNo++;
+        }
+
+        return groupPacket;
+    }
+
+    void feedSegments(FecGroupDecoder &decoder, PacketNumber seqNo, const NetworkData &frame,
+                      std::set<unsigned int> lost = std::set<unsigned int>())
+    {
+        size_t nSegments = FecGroupPacket::symbolsNum(frame.getLength(), SymbolLength);
+
+        for (unsigned int segNo = 0; segNo < nSegments; ++segNo)
+        {
+            size_t length = std::min(SymbolLength, frame.getLength() - segNo * SymbolLength);
+            if (lost.find(segNo) == lost.end())
+                decoder.segmentArrived(seqNo, segNo, frame.getData() + segNo * SymbolLength, length);
+        }
+    }
+
+    // group packets are handed over by the test instead of being fetched
+    class FecGroupRecoveryStub : public FecGroupRecovery
+    {
+      public:
+        FecGroupRecoveryStub(boost::asio::io_service &io, const boost::shared_ptr<IBuffer> &buffer,
+                             const ndn::Name &threadPrefix, const std::string &threadName,
+                             unsigned int groupSize,
+                             const boost::shared_ptr<statistics::StatisticsStorage> &storage)
+            : FecGroupRecovery(io, boost::shared_ptr<ndn::Face>(), boost::shared_ptr<ndn::KeyChain>(),
+                               buffer, threadPrefix, threadName, groupSize, storage) {}
+
+        void groupFetched(PacketNumber groupNo, const boost::shared_ptr<FecGroupPacket> &groupPacket)
+        {
+            onGroupFetched(groupNo, groupPacket);
+        }
+
+        std::vector<PacketNumber> fetched_;
+
+      protected:
+        void fetchGroup(PacketNumber groupNo) override { fetched_.push_back(groupNo); }
+    };
+
+    boost::shared_ptr<WireSegment> wireData(const boost::shared_ptr<ndn::Data> &data)
+    {
+        boost::shared_ptr<ndn::Interest> interest(boost::make_shared<ndn::Interest>(data->getName(), 1000));
+        int nonce = 0;
+        interest->setNonce(ndn::Blob((uint8_t *)&nonce, sizeof(int)));
+        return boost::make_shared<WireData<VideoFrameSegmentHeader>>(data, interest);
+    }
+}
+
+TEST(TestFecGroupPacket, TestCreate)
+{
+    std::vector<FecGroupPacket::Member> members({{8, 20, 3, 1500}, {9, 21, 3, 300}});
+    std::vector<uint8_t> parity(2 * SymbolLength, 0xab);
+    FecGroupPacket p(4, SymbolLength, members, parity);
+
+    EXPECT_TRUE(p.isValid());
+    EXPECT_EQ(4, p.getGroupNo());
+    EXPECT_EQ(SymbolLength, p.getSymbolLength());
+    EXPECT_EQ(2, p.getParitySymbolsNum());
+
+    NetworkData nd(boost::move(p));
+    FecGroupPacket p2(boost::move(nd));
+
+    EXPECT_TRUE(p2.isValid());
+    EXPECT_EQ(4, p2.getGroupNo());
+    EXPECT_EQ(2, p2.getParitySymbolsNum());
+    ASSERT_EQ(2, p2.getMembers().size());
+    EXPECT_EQ(9, p2.getMembers()[1].seqNo_);
+    EXPECT_EQ(21, p2.getMembers()[1].playbackNo_);
+    EXPECT_EQ(3, p2.getMembers()[1].pairedSequenceNo_);
+    EXPECT_EQ(300, p2.getMembers()[1].length_);
+    EXPECT_EQ(parity, std::vector<uint8_t>(p2.getPayload().begin(), p2.getPayload().end()));
+
+    { // parity is not a whole number of symbols
+        FecGroupPacket p(4, SymbolLength, members, std::vector<uint8_t>(SymbolLength + 1));
+        NetworkData nd(boost::move(p));
+        FecGroupPacket p2(boost::move(nd));
+
+        EXPECT_FALSE(p2.isValid());
+    }
+    { // not a group packet
+        NetworkData nd(std::vector<uint8_t>(100, 1));
+        FecGroupPacket p2(boost::move(nd));
+
+        EXPECT_FALSE(p2.isValid());
+    }
+}
+
+TEST(TestFecGroupPacket, TestGroupName)
+{
+    ndn::Name threadPrefix("/ndn/edu/ucla/remap/ndnrtc/%FD%03/video/camera/%FC%00%00%01c_%27%DE%D6/hi");
+
+    EXPECT_EQ(0, FecGroupPacket::groupNo(3, 4));
+    EXPECT_EQ(1, FecGroupPacket::groupNo(4, 4));
+    EXPECT_EQ(ndn::Name(threadPrefix).append(NameComponents::NameComponentDelta)
+                  .append(NameComponents::NameComponentParity)
+                  .appendSequenceNumber(5),
+              FecGroupPacket::groupName(threadPrefix, 5));
+}
+
+TEST(TestFecGroupEncoder, TestEncode)
+{
+    FecGroupEncoder encoder(4, SymbolLength);
+    std::vector<VideoFramePacket> frames;
+    boost::shared_ptr<FecGroupPacket> groupPacket =
+        encodeGroup(encoder, 8, {1500, 300, 700, 2100}, 0.2, frames);
+
+    ASSERT_TRUE(groupPacket.get());
+    EXPECT_TRUE(groupPacket->isValid());
+    EXPECT_EQ(2, groupPacket->getGroupNo());
+    EXPECT_EQ(SymbolLength, groupPacket->getSymbolLength());
+    ASSERT_EQ(4, groupPacket->getMembers().size());
+
+    size_t nSymbols = 0;
+    for (int i = 0; i < frames.size(); ++i)
+    {
+        EXPECT_EQ(8 + i, groupPacket->getMembers()[i].seqNo_);
+        EXPECT_EQ(2 * (8 + i), groupPacket->getMembers()[i].playbackNo_);
+        EXPECT_EQ(frames[i].getLength(), groupPacket->getMembers()[i].length_);
+        nSymbols += VideoFrameSegment::numSlices(frames[i].getLength(), VideoFrameSegment::wireLength(SymbolLength));
+    }
+    EXPECT_EQ(ceil(0.2 * nSymbols), groupPacket->getParitySymbolsNum());
+
+    // there is at least one parity symbol
+    frames.clear();
+    groupPacket = encodeGroup(encoder, 12, {100, 100, 100, 100}, 0.2, frames);
+    ASSERT_TRUE(groupPacket.get());
+    EXPECT_EQ(1, groupPacket->getParitySymbolsNum());
+}
+
+TEST(TestFecGroupEncoder, TestIncompleteGroup)
+{
+    FecGroupEncoder encoder(4, SymbolLength);
+    std::vector<VideoFramePacket> frames;
+
+    // frames 8 and 9 are never completed by 10 and 11
+    EXPECT_FALSE(encodeGroup(encoder, 8, {1500, 300}, 0.2, frames));
+    boost::shared_ptr<FecGroupPacket> groupPacket =
+        encodeGroup(encoder, 12, {1500, 300, 700, 2100}, 0.2, frames);
+
+    ASSERT_TRUE(groupPacket.get());
+    EXPECT_EQ(3, groupPacket->getGroupNo());
+    EXPECT_EQ(4, groupPacket->getMembers().size());
+    EXPECT_EQ(12, groupPacket->getMembers().front().seqNo_);
+
+    // thread started from the middle of a group
+    frames.clear();
+    groupPacket = encodeGroup(encoder, 18, {1500, 300}, 0.2, frames);
+    ASSERT_TRUE(groupPacket.get());
+    EXPECT_EQ(2, groupPacket->getMembers().size());
+}
+
+TEST(TestFecGroupDecoder, TestRecover)
+{
+    std::srand(std::time(0));
+
+    FecGroupEncoder encoder(4, SymbolLength);
+    std::vector<VideoFramePacket> frames;
+    std::vector<size_t> frameSizes;
+    for (int i = 0; i < 4; ++i)
+        frameSizes.push_back(200 + std::rand() % 2000);
+
+    boost::shared_ptr<FecGroupPacket> groupPacket =
+        encodeGroup(encoder, 0, frameSizes, 1., frames);
+    ASSERT_TRUE(groupPacket.get());
+
+    // whole frame 1 is lost and the last segment of frame 2
+    FecGroupDecoder decoder;
+    size_t frame2Segments = FecGroupPacket::symbolsNum(frames[2].getLength(), SymbolLength);
+    feedSegments(decoder, 0, frames[0]);
+    feedSegments(decoder, 2, frames[2], {(unsigned int)frame2Segments - 1});
+    feedSegments(decoder, 3, frames[3]);
+
+    NetworkData nd(boost::move(*groupPacket));
+    FecGroupPacket received(boost::move(nd));
+    std::map<PacketNumber, FecGroupDecoder::FrameSegments> recovered = decoder.recover(received);
+
+    ASSERT_EQ(2, recovered.size());
+    ASSERT_EQ(FecGroupPacket::symbolsNum(frames[1].getLength(), SymbolLength), recovered[1].size());
+    ASSERT_EQ(1, recovered[2].size());
+
+    std::vector<uint8_t> frame1;
+    for (auto &s : recovered[1])
+        frame1.insert(frame1.end(), s.second.begin(), s.second.end());
+    EXPECT_EQ(std::vector<uint8_t>(frames[1].getData(), frames[1].getData() + frames[1].getLength()), frame1);
+
+    std::vector<uint8_t> &lastSegment = recovered[2][frame2Segments - 1];
+    EXPECT_EQ(frames[2].getLength() - (frame2Segments - 1) * SymbolLength, lastSegment.size());
+    EXPECT_TRUE(std::equal(lastSegment.begin(), lastSegment.end(),
+                           frames[2].getData() + (frame2Segments - 1) * SymbolLength));
+
+    // recovered segments are kept, nothing is missing anymore
+    EXPECT_EQ(4, decoder.size());
+    EXPECT_EQ(0, decoder.recover(received).size());
+}
+
+TEST(TestFecGroupDecoder, TestTooManyLosses)
+{
+    FecGroupEncoder encoder(4, SymbolLength);
+    std::vector<VideoFramePacket> frames;
+    boost::shared_ptr<FecGroupPacket> groupPacket =
+        encodeGroup(encoder, 0, {1500, 1500, 1500, 1500}, 0.2, frames);
+    ASSERT_TRUE(groupPacket.get());
+    ASSERT_EQ(2, groupPacket->getParitySymbolsNum());
+
+    FecGroupDecoder decoder;
+    feedSegments(decoder, 0, frames[0]);
+    feedSegments(decoder, 2, frames[2]);
+    feedSegments(decoder, 3, frames[3], {0});
+
+    EXPECT_EQ(0, decoder.recover(*groupPacket).size());
+}
+
+TEST(TestFecGroupDecoder, TestCapacity)
+{
+    FecGroupDecoder decoder(8);
+    std::vector<uint8_t> payload(SymbolLength, 1);
+
+    for (int i = 0; i < 20; ++i)
+        decoder.segmentArrived(i, 0, payload.data(), payload.size());
+
+    EXPECT_EQ(8, decoder.size());
+    decoder.reset();
+    EXPECT_EQ(0, decoder.size());
+}
+
+TEST(TestFecGroupRecovery, TestRecoverOnRetransmission)
+{
+    std::string threadPrefix = "/ndn/edu/ucla/remap/peter/ndncon/instance1/ndnrtc/%FD%03/video/camera/%FC%00%00%01c_%27%DE%D6/hi";
+    // same as segment payload of sliceFrame()
+    size_t symbolLength = VideoFrameSegment::payloadLength(1000);
+    boost::asio::io_service io;
+    boost::shared_ptr<statistics::StatisticsStorage> storage(statistics::StatisticsStorage::createConsumerStatistics());
+    boost::shared_ptr<Buffer> buffer(boost::make_shared<Buffer>(storage, boost::make_shared<SlotPool>(10)));
+    boost::shared_ptr<FecGroupRecoveryStub> recovery(boost::make_shared<FecGroupRecoveryStub>(io, buffer,
+                                                                                              ndn::Name(threadPrefix), "hi",
+                                                                                              2, storage));
+    MockBufferObserver observer;
+    buffer->attach(recovery.get());
+    buffer->attach(&observer);
+
+    std::vector<unsigned int> recoveredSegments;
+    EXPECT_CALL(observer, onNewRequest(_))
+        .Times(2);
+    EXPECT_CALL(observer, onNewData(_))
+        .WillRepeatedly(Invoke([&recoveredSegments](const BufferReceipt &r) {
+            if (r.segment_->getData()->isRecovered())
+                recoveredSegments.push_back(r.segment_->getInfo().segNo_);
+        }));
+
+    // group of two delta frames, all of them are requested
+    FecGroupEncoder encoder(2, symbolLength);
+    boost::shared_ptr<FecGroupPacket> groupPacket;
+    std::vector<ndn::Name> frameNames;
+    std::vector<std::vector<boost::shared_ptr<ndn::Data>>> frameData;
+    std::vector<std::vector<boost::shared_ptr<const ndn::Interest>>> frameInterests;
+
+    for (PacketNumber seqNo = 0; seqNo < 2; ++seqNo)
+    {
+        VideoFramePacket vp = getVideoFramePacket(4300);
+        groupPacket = encoder.addFrame(seqNo, seqNo + 1, 0, vp, 0.5);
+
+        frameNames.push_back(ndn::Name(threadPrefix).append("d").appendSequenceNumber(seqNo));
+        std::vector<VideoFrameSegment> segments = sliceFrame(vp, seqNo + 1, 0);
+        frameData.push_back(dataFromSegments(frameNames.back().toUri(), segments));
+
+        std::vector<boost::shared_ptr<const ndn::Interest>> interests;
+        for (auto &d : frameData.back())
+        {
+            boost::shared_ptr<ndn::Interest> interest(boost::make_shared<ndn::Interest>(d->getName(), 1000));
+            int nonce = 0x1234 + interests.size();
+            interest->setNonce(ndn::Blob((uint8_t *)&nonce, sizeof(int)));
+            interests.push_back(interest);
+        }
+        frameInterests.push_back(interests);
+        EXPECT_TRUE(buffer->requested(interests));
+    }
+    ASSERT_TRUE(groupPacket.get());
+    ASSERT_LT(3, frameData[1].size());
+
+    // segments 1 and 2 of frame 1 are lost
+    for (int i = 0; i < 2; ++i)
+        for (int j = 0; j < frameData[i].size(); ++j)
+            if (i == 0 || (j != 1 && j != 2))
+                buffer->received(wireData(frameData[i][j]));
+
+    EXPECT_EQ(1, buffer->getSlotsNum(frameNames[0], BufferSlot::Ready));
+    EXPECT_EQ(1, buffer->getSlotsNum(frameNames[1], BufferSlot::Assembling));
+
+    // group packet is fetched upon retransmission, only segments with pending
+    // interests are passed to the buffer
+    recovery->onRetransmissionRequired({frameInterests[1][1]});
+    ASSERT_EQ(1, recovery->fetched_.size());
+    EXPECT_EQ(0, recovery->fetched_[0]);
+    EXPECT_EQ(0, recoveredSegments.size());
+
+    recovery->groupFetched(0, groupPacket);
+    ASSERT_EQ(1, recoveredSegments.size());
+    EXPECT_EQ(1, recoveredSegments[0]);
+    EXPECT_EQ(1, (*storage)[statistics::Indicator::FecGroupFetchedNum]);
+    EXPECT_EQ(1, (*storage)[statistics::Indicator::FecGroupRecoveredNum]);
+    EXPECT_EQ(1, buffer->getSlotsNum(frameNames[1], BufferSlot::Assembling));
+
+    // group packet is kept, recovery happens on io thread
+    recovery->onRetransmissionRequired({frameInterests[1][2]});
+    EXPECT_EQ(1, recovery->fetched_.size());
+    EXPECT_EQ(1, recoveredSegments.size());
+
+    io.run();
+    ASSERT_EQ(2, recoveredSegments.size());
+    EXPECT_EQ(2, recoveredSegments[1]);
+    EXPECT_EQ(1, (*storage)[statistics::Indicator::FecGroupFetchedNum]);
+    EXPECT_EQ(2, (*storage)[statistics::Indicator::FecGroupRecoveredNum]);
+    EXPECT_EQ(1, buffer->getSlotsNum(frameNames[1], BufferSlot::Ready));
+
+    buffer->detach(&observer);
+    buffer->detach(recovery.get());
+}
+
+int main(int argc, char **argv)
+{
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,183 @@
+//
+// test-fec.cc
+//
+//  Copyright 2013-2018 Regents of the University of California
+//
+
+#include <stdlib.h>
+#include <ctime>
+#include <boost/chrono.hpp>
+
+#include "tests-helpers.hpp"
+#include "gtest/gtest.h"
+#include "src/fec.hpp"
+#include "src/fec-rs28.hpp"
+
+using namespace fec;
+
+namespace
+{
+    std::vector<uint8_t> randomData(size_t size)
+    {
+        std::vector<uint8_t> data(size);
+        for (auto &b : data)
+            b = std::rand() % 256;
+        return data;
+    }
+
+    std::vector<uint8_t> encode(unsigned int k, unsigned int r, unsigned int symbolLength,
+                                std::vector<uint8_t> &data)
+    {
+        std::vector<uint8_t> parity(r * symbolLength, 0);
+        Rs28Encoder enc(k, r, symbolLength);
+        EXPECT_EQ(0, enc.encode(data.data(), parity.data()));
+        return parity;
+    }
+
+    std::vector<rs28::SimdLevel> supportedSimdLevels()
+    {
+        std::vector<rs28::SimdLevel> levels;
+        levels.push_back(rs28::SimdLevel::None);
+        if (rs28::detectSimdLevel() >= rs28::SimdLevel::Ssse3)
+            levels.push_back(rs28::SimdLevel::Ssse3);
+        if (rs28::detectSimdLevel() >= rs28::SimdLevel::Avx2)
+            levels.push_back(rs28::SimdLevel::Avx2);
+        return levels;
+    }
+}
+
+TEST(TestFec, TestNativeMatchesOpenFec)
+{
+    // (k, r, symbol length) layouts, including ones used for video frames
+    unsigned int layouts[][3] = {{1, 1, 1000}, {2, 1, 1000}, {3, 2, 8000}, {10, 5, 1000},
+                                 {37, 19, 8000}, {100, 50, 1000}, {170, 85, 1000},
+                                 {20, 1, 33}, {5, 0, 100}};
+    bool nativeEnabled = isNativeRs28Enabled();
+    rs28::SimdLevel simdLevel = rs28::getSimdLevel();
+
+    std::srand(std::time(0));
+    for (auto &l : layouts)
+    {
+        unsigned int k = l[0], r = l[1], symbolLength = l[2];
+        std::vector<uint8_t> data = randomData(k * symbolLength);
+
+        setNativeRs28Enabled(false);
+        std::vector<uint8_t> openFecParity = encode(k, r, symbolLength, data);
+
+        setNativeRs28Enabled(true);
+        for (auto level : supportedSimdLevels())
+        {
+            rs28::setSimdLevel(level);
+            std::vector<uint8_t> nativeParity = encode(k, r, symbolLength, data);
+
+            EXPECT_TRUE(openFecParity == nativeParity)
+                << "k " << k << " r " << r << " simd " << rs28::toString(level);
+        }
+    }
+
+    rs28::setSimdLevel(simdLevel);
+    setNativeRs28Enabled(nativeEnabled);
+}
+
+TEST(TestFec, TestNativeDecode)
+{
+    unsigned int k = 30, r = 15, symbolLength = 1000;
+    bool nativeEnabled = isNativeRs28Enabled();
+
+    std::srand(std::time(0));
+    setNativeRs28Enabled(true);
+    for (int trial = 0; trial < 10; ++trial)
+    {
+        std::vector<uint8_t> data = randomData(k * symbolLength);
+        std::vector<uint8_t> parity = encode(k, r, symbolLength, data);
+        std::vector<uint8_t> received(data);
+        std::vector<unsigned char> rList(k + r, FEC_RLIST_SYMREADY);
+        int nLost = 0;
+
+        while (nLost < r)
+        {
+            int idx = std::rand() % (k + r);
+            if (rList[idx] == FEC_RLIST_SYMREADY)
+            {
+                rList[idx] = FEC_RLIST_SYMEMPTY;
+                if (idx < k)
+                    memset(received.data() + idx * symbolLength, 0, symbolLength);
+                else
+                    memset(parity.data() + (idx - k) * symbolLength, 0, symbolLength);
+                ++nLost;
+            }
+        }
+
+        Rs28Decoder dec(k, r, symbolLength);
+        EXPECT_EQ(nLost, dec.decode(received.data(), parity.data(), rList.data()));
+        EXPECT_TRUE(data == received);
+        for (auto s : rList)
+            EXPECT_NE(FEC_RLIST_SYMEMPTY, s);
+    }
+
+    { // not enough symbols
+        std::vector<uint8_t> data = randomData(k * symbolLength);
+        std::vector<uint8_t> parity = encode(k, r, symbolLength, data);
+        std::vector<unsigned char> rList(k + r, FEC_RLIST_SYMREADY);
+
+        for (int i = 0; i < r + 1; ++i)
+            rList[i] = FEC_RLIST_SYMEMPTY;
+
+        Rs28Decoder dec(k, r, symbolLength);
+        EXPECT_EQ(-1, dec.decode(data.data(), parity.data(), rList.data()));
+    }
+
+    setNativeRs28Enabled(nativeEnabled);
+}
+
+TEST(TestFec, TestBenchmarkRs28Encode)
+{
+    // 720p key frame (~120KB) and delta frame (~8KB) in 1000-byte segments
+    // with 50% parity
+    unsigned int layouts[][3] = {{120, 60, 1000}, {8, 4, 1000}};
+    int nRuns = 200;
+    bool nativeEnabled = isNativeRs28Enabled();
+    rs28::SimdLevel simdLevel = rs28::getSimdLevel();
+
+    for (auto &l : layouts)
+    {
+        unsigned int k = l[0], r = l[1], symbolLength = l[2];
+        std::vector<uint8_t> data = randomData(k * symbolLength);
+        std::vector<uint8_t> parity(r * symbolLength);
+
+        auto run = [&]() {
+            boost::chrono::high_resolution_clock::time_point start = boost::chrono::high_resolution_clock::now();
+            for (int i = 0; i < nRuns; ++i)
+            {
+                Rs28Encoder enc(k, r, symbolLength);
+                enc.encode(data.data(), parity.data());
+            }
+            boost::chrono::duration<double> d = boost::chrono::high_resolution_clock::now() - start;
+            return d.count();
+        };
+
+        setNativeRs28Enabled(false);
+        double openFecTime = run();
+        GT_PRINTF("k %d r %d: openfec %.2fus per frame (%.1f MB/s)\n", k, r,
+                  openFecTime / nRuns * 1E6, (double)data.size() * nRuns / openFecTime / 1E6);
+
+        setNativeRs28Enabled(true);
+        for (auto level : supportedSimdLevels())
+        {
+            rs28::setSimdLevel(level);
+            double nativeTime = run();
+            GT_PRINTF("k %d r %d: native (%s) %.2fus per frame (%.1f MB/s), x%.1f\n", k, r,
+                      rs28::toString(level), nativeTime / nRuns * 1E6,
+                      (double)data.size() * nRuns / nativeTime / 1E6, openFecTime / nativeTime);
+        }
+    }
+
+    rs28::setSimdLevel(simdLevel);
+    setNativeRs28Enabled(nativeEnabled);
+}
+
+int main(int argc, char **argv)
+{
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
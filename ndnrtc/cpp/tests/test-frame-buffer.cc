@@ -860,6 +860,123 @@ TEST(TestBuffer, TestRequestAndReceive)
     EXPECT_EQ(poolSize, (*storage)[Indicator::AssembledNum]);
 }
 
+TEST(TestBuffer, TestOutOfOrderAndInvalidatePrevious)
+{
+	std::string streamPrefix = "/ndn/edu/ucla/remap/peter/ndncon/instance1/ndnrtc/%FD%03/video/camera";
+	std::string threadPrefix = streamPrefix+"/%FC%00%00%01c_%27%DE%D6/hi";
+	Name keyPrefix = Name(threadPrefix).append("k");
+	Name deltaPrefix = Name(threadPrefix).append("d");
+    boost::shared_ptr<StatisticsStorage> storage(StatisticsStorage::createConsumerStatistics());
+	boost::shared_ptr<SlotPool> pool(boost::make_shared<SlotPool>(10));
+	boost::shared_ptr<Buffer> buffer(boost::make_shared<Buffer>(storage, pool));
+	boost::shared_ptr<PlaybackQueue> pqueue(boost::make_shared<PlaybackQueue>(Name(streamPrefix), buffer));
+
+	// key and delta samples share sample numbers, but not slots; playback
+	// numbers follow key 0, delta 0..3, key 1
+	typedef struct _Sample {
+		Name name_;
+		PacketNumber playNo_;
+		std::vector<boost::shared_ptr<ndn::Data>> data_;
+	} Sample;
+	std::map<std::string, Sample> samples;
+	samples["k0"] = {Name(keyPrefix).appendSequenceNumber(0), 0};
+	samples["d0"] = {Name(deltaPrefix).appendSequenceNumber(0), 1};
+	samples["d1"] = {Name(deltaPrefix).appendSequenceNumber(1), 2};
+	samples["d2"] = {Name(deltaPrefix).appendSequenceNumber(2), 3};
+	samples["d3"] = {Name(deltaPrefix).appendSequenceNumber(3), 4};
+	samples["k1"] = {Name(keyPrefix).appendSequenceNumber(1), 5};
+
+	boost::function<boost::shared_ptr<WireSegment>(const boost::shared_ptr<ndn::Data>&)> wire =
+		[](const boost::shared_ptr<ndn::Data>& d){
+			boost::shared_ptr<ndn::Interest> interest(boost::make_shared<ndn::Interest>(d->getName(),1000));
+			int nonce = 0;
+			interest->setNonce(Blob((uint8_t*)&(nonce), sizeof(int)));
+			return boost::make_shared<WireData<VideoFrameSegmentHeader>>(d, interest);
+		};
+
+	int nonce = 0x1234;
+	for (auto& it:samples)
+	{
+		VideoFramePacket vp = getVideoFramePacket();
+		std::vector<VideoFrameSegment> segments = sliceFrame(vp, it.second.playNo_, 0);
+		it.second.data_ = dataFromSegments(it.second.name_.toUri(), segments);
+	}
+
+	// request out of order
+	for (auto s:{"d3", "k0", "d1", "d0", "d2", "k1"})
+	{
+		std::vector<boost::shared_ptr<const Interest>> interests;
+		for (int j = 0; j < samples[s].data_.size(); ++j)
+		{
+			boost::shared_ptr<Interest> interest(boost::make_shared<Interest>(Name(samples[s].name_).appendSegment(j), 1000));
+			nonce++;
+			interest->setNonce(Blob((uint8_t*)&nonce, sizeof(int)));
+			interests.push_back(interest);
+		}
+		EXPECT_TRUE(buffer->requested(interests));
+		EXPECT_TRUE(buffer->isRequested(wire(samples[s].data_.front())));
+	}
+
+	EXPECT_EQ(4, buffer->getSlotsNum(deltaPrefix, BufferSlot::New));
+	EXPECT_EQ(2, buffer->getSlotsNum(keyPrefix, BufferSlot::New));
+
+	// segments of several samples arrive interleaved
+	std::vector<boost::shared_ptr<ndn::Data>> dataObjects;
+	for (auto s:{"k0", "d1", "d3"})
+		dataObjects.insert(dataObjects.end(), samples[s].data_.begin(), samples[s].data_.end());
+	std::random_shuffle(dataObjects.begin(), dataObjects.end());
+
+	for (auto d:dataObjects)
+	{
+		BufferReceipt rcpt = buffer->received(wire(d));
+		EXPECT_TRUE(rcpt.slot_->getPrefix().isPrefixOf(d->getName()));
+	}
+
+	// assembled samples are reserved by playback queue
+	EXPECT_EQ(3, (*storage)[Indicator::AssembledNum]);
+	EXPECT_EQ(2, buffer->getSlotsNum(deltaPrefix, BufferSlot::New));
+	EXPECT_EQ(1, buffer->getSlotsNum(keyPrefix, BufferSlot::New));
+	EXPECT_EQ(0, buffer->getSlotsNum(Name(threadPrefix), BufferSlot::Ready));
+
+	std::vector<std::string> playbackOrder;
+	PlaybackQueue::ExtractSlot extract = [&playbackOrder](const boost::shared_ptr<const BufferSlot>& slot, double playTimeMs){
+		playbackOrder.push_back(slot->getPrefix().toUri());
+	};
+
+	// key sample does not invalidate anything
+	pqueue->pop(extract);
+	EXPECT_EQ(0, (*storage)[Indicator::DroppedNum]);
+	EXPECT_EQ(2, buffer->getSlotsNum(deltaPrefix, BufferSlot::New));
+
+	// delta 1 invalidates delta 0, but not key 1
+	pqueue->pop(extract);
+	EXPECT_EQ(1, (*storage)[Indicator::DroppedNum]);
+	EXPECT_EQ(1, (*storage)[Indicator::IncompleteNum]);
+	EXPECT_EQ(0, (*storage)[Indicator::DroppedKeyNum]);
+	EXPECT_EQ(1, buffer->getSlotsNum(deltaPrefix, BufferSlot::New));
+	EXPECT_EQ(1, buffer->getSlotsNum(keyPrefix, BufferSlot::New));
+	EXPECT_FALSE(buffer->isRequested(wire(samples["d0"].data_.front())));
+	EXPECT_TRUE(buffer->isRequested(wire(samples["d2"].data_.front())));
+	EXPECT_TRUE(buffer->isRequested(wire(samples["k1"].data_.front())));
+
+	// delta 3 invalidates delta 2, key 1 is still pending
+	pqueue->pop(extract);
+	EXPECT_EQ(2, (*storage)[Indicator::DroppedNum]);
+	EXPECT_EQ(0, (*storage)[Indicator::DroppedKeyNum]);
+	EXPECT_EQ(0, buffer->getSlotsNum(deltaPrefix, BufferSlot::New));
+	EXPECT_EQ(1, buffer->getSlotsNum(keyPrefix, BufferSlot::New));
+	EXPECT_FALSE(buffer->isRequested(wire(samples["d2"].data_.front())));
+	EXPECT_TRUE(buffer->isRequested(wire(samples["k1"].data_.front())));
+
+	ASSERT_EQ(3, playbackOrder.size());
+	EXPECT_EQ(samples["k0"].name_.toUri(), playbackOrder[0]);
+	EXPECT_EQ(samples["d1"].name_.toUri(), playbackOrder[1]);
+	EXPECT_EQ(samples["d3"].name_.toUri(), playbackOrder[2]);
+
+	// slots of invalidated and played samples are back in the pool
+	EXPECT_EQ(9, pool->size());
+}
+
 //******************************************************************************
 int main(int argc, char **argv) {
 	::testing::InitGoogleTest(&argc, argv);
@@ -6,9 +6,11 @@
 //
 
 #include <stdlib.h>
+#include <vector>
 
 #include "gtest/gtest.h"
 #include "frame-converter.hpp"
+#include "frame-pool.hpp"
 
 using namespace ndnrtc;
 
@@ -42,6 +44,160 @@ TEST(TestFrameConverter, TestI420Frame)
 	EXPECT_EQ(h, frame.height());
 }
 
+TEST(TestFrameConverter, TestExternalI420Frame)
+{
+	unsigned int w = 16, h = 16, strideY = 32, strideUV = 16;
+	std::vector<uint8_t> y(strideY*h), u(strideUV*h/2), v(strideUV*h/2);
+	int nReleased = 0;
+
+	RawFrameConverter conv;
+	{
+		WebRtcVideoFrame frame = conv << ExternalI420FrameWrapper({
+			I420RawFrameWrapper({w, h, strideY, strideUV, strideUV, y.data(), u.data(), v.data()}),
+			[&nReleased](){ nReleased++; }});
+
+		// planes are not copied
+		EXPECT_EQ(w, frame.width());
+		EXPECT_EQ(h, frame.height());
+		EXPECT_EQ(y.data(), frame.video_frame_buffer()->DataY());
+		EXPECT_EQ(u.data(), frame.video_frame_buffer()->DataU());
+		EXPECT_EQ(v.data(), frame.video_frame_buffer()->DataV());
+		EXPECT_EQ(strideY, frame.video_frame_buffer()->StrideY());
+
+		WebRtcVideoFrame frameCopy(frame);
+		EXPECT_EQ(0, nReleased);
+	}
+
+	// released with the last frame referencing it
+	EXPECT_EQ(1, nReleased);
+}
+
+TEST(TestFrameConverter, TestNV12Frame)
+{
+	unsigned int w = 4, h = 2, strideY = 8, strideUV = 8;
+	std::vector<uint8_t> y(strideY*h, 1), uv(strideUV*h/2, 0);
+	// interleaved U and V
+	for (int i = 0; i < w; i += 2)
+	{
+		uv[i] = 2;
+		uv[i+1] = 3;
+	}
+
+	RawFrameConverter conv;
+	WebRtcVideoFrame nv12 = conv << YUV_NV12FrameWrapper({w, h, strideY, strideUV, y.data(), uv.data()});
+	WebRtcVideoFrame nv21 = conv << YUV_NV21FrameWrapper({w, h, strideY, strideUV, y.data(), uv.data()});
+
+	EXPECT_EQ(w, nv12.width());
+	EXPECT_EQ(h, nv12.height());
+	EXPECT_EQ(1, nv12.video_frame_buffer()->DataY()[w-1]);
+	EXPECT_EQ(1, nv12.video_frame_buffer()->DataY()[nv12.video_frame_buffer()->StrideY()+w-1]);
+	for (int i = 0; i < w/2; ++i)
+	{
+		EXPECT_EQ(2, nv12.video_frame_buffer()->DataU()[i]);
+		EXPECT_EQ(3, nv12.video_frame_buffer()->DataV()[i]);
+		EXPECT_EQ(3, nv21.video_frame_buffer()->DataU()[i]);
+		EXPECT_EQ(2, nv21.video_frame_buffer()->DataV()[i]);
+	}
+}
+
+TEST(TestFrameBufferPool, TestRecycle)
+{
+	FrameBufferPool pool(4);
+
+	WebRtcVideoFrameBuffer *b1 = nullptr;
+	{
+		WebRtcSmartPtr<WebRtcVideoFrameBuffer> b = pool.getBuffer(640, 480);
+		b1 = b.get();
+		EXPECT_EQ(640, b->width());
+		EXPECT_EQ(480, b->height());
+		EXPECT_EQ(0, pool.getHitNum());
+		EXPECT_EQ(1, pool.getMissNum());
+	}
+
+	{ // released buffer is recycled
+		WebRtcSmartPtr<WebRtcVideoFrameBuffer> b = pool.getBuffer(640, 480);
+		EXPECT_EQ(b1, b.get());
+		EXPECT_EQ(1, pool.getHitNum());
+
+		// buffer in use is not given away
+		WebRtcVideoFrame frame(b, webrtc::kVideoRotation_0, 0);
+		b = nullptr;
+		EXPECT_NE(b1, pool.getBuffer(640, 480).get());
+		EXPECT_EQ(2, pool.getMissNum());
+	}
+
+	{ // different resolution or strides
+		EXPECT_NE(b1, pool.getBuffer(320, 240).get());
+		EXPECT_NE(b1, pool.getBuffer(640, 480, 704, 352, 352).get());
+		EXPECT_EQ(4, pool.getMissNum());
+		EXPECT_EQ(704, pool.getBuffer(640, 480, 704, 352, 352)->StrideY());
+		EXPECT_EQ(2, pool.getHitNum());
+		EXPECT_EQ(4, pool.size());
+	}
+
+	{ // pool is full, idle buffer of the least recently requested
+	  // resolution is released
+		WebRtcSmartPtr<WebRtcVideoFrameBuffer> b = pool.getBuffer(1280, 720);
+		EXPECT_EQ(4, pool.size());
+		EXPECT_EQ(1, pool.getEvictedNum());
+		b = nullptr;
+		pool.getBuffer(1280, 720);
+		EXPECT_EQ(5, pool.getMissNum());
+		EXPECT_EQ(3, pool.getHitNum());
+	}
+}
+
+TEST(TestFrameBufferPool, TestEviction)
+{
+	FrameBufferPool pool(2);
+
+	{ // buffers of previous resolution give room to the new one
+		pool.getBuffer(640, 480);
+		pool.getBuffer(640, 480, 704, 352, 352);
+		EXPECT_EQ(2, pool.size());
+
+		for (int i = 0; i < 10; ++i)
+			pool.getBuffer(1280, 720);
+		EXPECT_EQ(2, pool.size());
+		EXPECT_EQ(1, pool.getEvictedNum());
+		EXPECT_EQ(3, pool.getMissNum());
+		EXPECT_EQ(9, pool.getHitNum());
+	}
+
+	{ // buffers in use are not evicted, new ones are not pooled
+		WebRtcSmartPtr<WebRtcVideoFrameBuffer> b1 = pool.getBuffer(1280, 720);
+		WebRtcSmartPtr<WebRtcVideoFrameBuffer> b2 = pool.getBuffer(640, 480, 704, 352, 352);
+		WebRtcSmartPtr<WebRtcVideoFrameBuffer> b3 = pool.getBuffer(320, 240);
+		EXPECT_EQ(2, pool.size());
+		EXPECT_EQ(1, pool.getEvictedNum());
+
+		b3 = nullptr;
+		EXPECT_EQ(320, pool.getBuffer(320, 240)->width());
+		EXPECT_EQ(5, pool.getMissNum());
+	}
+}
+
+TEST(TestFrameBufferPool, TestConverter)
+{
+	// resolution, not used by other tests
+	unsigned int w = 648, h = 486, size = w*h*4;
+	uint8_t* data = (uint8_t*)malloc(size);
+	RawFrameConverter conv;
+	uint64_t nMiss = FrameBufferPool::getSharedInstance().getMissNum();
+	uint64_t nHit = FrameBufferPool::getSharedInstance().getHitNum();
+
+	for (int i = 0; i < 10; ++i)
+	{
+		WebRtcVideoFrame frame = conv << ArgbRawFrameWrapper({w,h,data,size});
+		EXPECT_EQ(w, frame.width());
+	}
+
+	EXPECT_EQ(nMiss + 1, FrameBufferPool::getSharedInstance().getMissNum());
+	EXPECT_EQ(nHit + 9, FrameBufferPool::getSharedInstance().getHitNum());
+
+	free(data);
+}
+
 int main(int argc, char **argv) {
 	::testing::InitGoogleTest(&argc, argv);
 	return RUN_ALL_TESTS();
@@ -10,6 +10,7 @@
 #include <ctime>
 
 #include <ndn-cpp/face.hpp>
+#include <ndn-cpp/threadsafe-face.hpp>
 #include <ndn-cpp/security/key-chain.hpp>
 #include <ndn-cpp/security/identity/memory-private-key-storage.hpp>
 #include <ndn-cpp/security/identity/memory-identity-storage.hpp>
@@ -345,6 +346,208 @@ TEST(TestVideoStream, TestPublishInvokeOnMainThread)
     t.join();
 }
 
+TEST(TestVideoStream, TestPipelinedPublish)
+{
+#ifdef ENABLE_LOGGING
+    ndnlog::new_api::Logger::initAsyncLogging();
+    ndnlog::new_api::Logger::getLogger("").setLogLevel(ndnlog::NdnLoggerDetailLevelAll);
+#endif
+
+    int nFrames = 60;
+    int width = 1280, height = 720;
+    int frameSize = width * height * 4 * sizeof(uint8_t);
+    uint8_t *frameBuffer = (uint8_t *)malloc(frameSize);
+    for (int j = 0; j < height; ++j)
+        for (int i = 0; i < width; ++i)
+            frameBuffer[i * width + j] = std::rand() % 256; // random noise
+
+    boost::asio::io_service io;
+    boost::shared_ptr<boost::asio::io_service::work> work(boost::make_shared<boost::asio::io_service::work>(io));
+    boost::thread t([&io]() {
+        io.run();
+    });
+
+    ndn::Face face("aleph.ndn.ucla.edu");
+    std::string appPrefix = "/ndn/edu/ucla/remap/peter/app";
+    shared_ptr<KeyChain> keyChain = memoryKeyChain(appPrefix);
+
+    {
+        MediaStreamSettings settings(io, getSampleVideoParams());
+        settings.face_ = &face;
+        settings.keyChain_ = keyChain.get();
+        settings.params_.producerParams_.pipeline_ = {5, true};
+        LocalVideoStream s(appPrefix, settings);
+
+#ifdef ENABLE_LOGGING
+        s.setLogger(ndnlog::new_api::Logger::getLoggerPtr(""));
+#endif
+
+        // frames are captured faster than they can be encoded and published
+        high_resolution_clock::time_point captureStart = high_resolution_clock::now();
+        for (int i = 0; i < nFrames; ++i)
+            EXPECT_NO_THROW(s.incomingArgbFrame(width, height, frameBuffer, frameSize));
+        int captureDurationMs = duration_cast<milliseconds>(high_resolution_clock::now() - captureStart).count();
+
+        boost::this_thread::sleep_for(boost::chrono::milliseconds(3000));
+
+        statistics::StatisticsStorage stat = s.getStatistics();
+        int nQueued = nFrames - (int)stat[statistics::Indicator::PipelineDroppedNum];
+        int nThreads = settings.params_.getThreadNum();
+
+        GT_PRINTF("Captured %d frames in %d ms, queue dropped %d, encoded %d (per thread), "
+                  "queueing %.2fms encoding %.2fms publishing %.2fms\n",
+                  nFrames, captureDurationMs, nFrames - nQueued,
+                  (int)stat[statistics::Indicator::EncodedNum] / nThreads,
+                  stat[statistics::Indicator::PipelineQueueDelay],
+                  stat[statistics::Indicator::PipelineEncodeDelay],
+                  stat[statistics::Indicator::PipelinePublishDelay]);
+
+        EXPECT_EQ(nFrames, stat[statistics::Indicator::CapturedNum]);
+        EXPECT_LE(5, nQueued);
+        // every queued frame is either encoded or dropped by encoders
+        EXPECT_EQ(nQueued * nThreads, stat[statistics::Indicator::EncodedNum] +
+                                          stat[statistics::Indicator::DroppedNum]);
+        EXPECT_EQ(0, stat[statistics::Indicator::PipelineCaptureQueueSize]);
+        EXPECT_EQ(0, stat[statistics::Indicator::PipelinePublishQueueSize]);
+    }
+
+    work.reset();
+    t.join();
+    free(frameBuffer);
+}
+
+TEST(TestVideoStream, TestPublishEncoded)
+{
+#ifdef ENABLE_LOGGING
+    ndnlog::new_api::Logger::initAsyncLogging();
+    ndnlog::new_api::Logger::getLogger("").setLogLevel(ndnlog::NdnLoggerDetailLevelAll);
+#endif
+
+    int nFrames = 30, gop = 10;
+    int width = 640, height = 480;
+    // contents of encoded frames do not matter for publishing
+    std::vector<uint8_t> frame(3000);
+    for (auto &b : frame)
+        b = std::rand() % 256;
+
+    boost::asio::io_service io;
+    boost::shared_ptr<boost::asio::io_service::work> work(boost::make_shared<boost::asio::io_service::work>(io));
+    boost::thread t([&io]() {
+        io.run();
+    });
+
+    ndn::Face face("aleph.ndn.ucla.edu");
+    std::string appPrefix = "/ndn/edu/ucla/remap/peter/app";
+    shared_ptr<KeyChain> keyChain = memoryKeyChain(appPrefix);
+
+    {
+        MediaStreamSettings settings(io, getSampleVideoParams());
+        settings.face_ = &face;
+        settings.keyChain_ = keyChain.get();
+        LocalVideoStream s(appPrefix, settings);
+
+#ifdef ENABLE_LOGGING
+        s.setLogger(ndnlog::new_api::Logger::getLoggerPtr(""));
+#endif
+
+        EXPECT_ANY_THROW(s.incomingEncodedFrame("none", width, height, true, 0, 0, frame.data(), frame.size()));
+        EXPECT_ANY_THROW(s.incomingEncodedFrame("low", width * 2, height * 2, true, 0, 0, frame.data(), frame.size()));
+        // can't start with delta frame
+        EXPECT_EQ(-1, s.incomingEncodedFrame("low", width, height, false, 0, 0, frame.data(), frame.size()));
+
+        for (int i = 0; i < nFrames; ++i)
+        {
+            EXPECT_EQ(i, s.incomingEncodedFrame("low", width, height, (i % gop == 0),
+                                                i * 3000, i * 33, frame.data(), frame.size()));
+
+            FrameInfo fi = s.getLastPublishedInfo().at("low");
+            EXPECT_EQ(i, fi.playbackNo_);
+
+            ndn::Name frameName(fi.ndnName_);
+            bool isKey = (frameName[-2].toEscapedString() == NameComponents::NameComponentKey);
+            EXPECT_EQ((i % gop == 0), isKey);
+            EXPECT_EQ((isKey ? i / gop : i - i / gop - 1), frameName[-1].toSequenceNumber());
+        }
+
+        boost::this_thread::sleep_for(boost::chrono::milliseconds(500));
+
+        statistics::StatisticsStorage stat = s.getStatistics();
+        EXPECT_EQ(0, stat[statistics::Indicator::EncodedNum]);
+        EXPECT_EQ(nFrames, stat[statistics::Indicator::PublishedNum]);
+    }
+
+    work.reset();
+    t.join();
+}
+
+TEST(TestVideoStream, TestPublishEncodedLayers)
+{
+#ifdef ENABLE_LOGGING
+    ndnlog::new_api::Logger::initAsyncLogging();
+    ndnlog::new_api::Logger::getLogger("").setLogLevel(ndnlog::NdnLoggerDetailLevelAll);
+#endif
+
+    int width = 640, height = 480;
+    std::vector<uint8_t> frame(3000);
+    for (auto &b : frame)
+        b = std::rand() % 256;
+
+    boost::asio::io_service io;
+    boost::shared_ptr<boost::asio::io_service::work> work(boost::make_shared<boost::asio::io_service::work>(io));
+    boost::thread t([&io]() {
+        io.run();
+    });
+
+    ndn::Face face("aleph.ndn.ucla.edu");
+    std::string appPrefix = "/ndn/edu/ucla/remap/peter/app";
+    shared_ptr<KeyChain> keyChain = memoryKeyChain(appPrefix);
+
+    MediaStreamParams msp("camera");
+    msp.type_ = MediaStreamParams::MediaStreamTypeVideo;
+    msp.producerParams_.freshness_ = {10, 15, 900};
+    msp.producerParams_.segmentSize_ = 1000;
+
+    VideoThreadParams atp("low", sampleVideoCoderParams());
+    atp.coderParams_.encodeWidth_ = width;
+    atp.coderParams_.encodeHeight_ = height;
+    atp.coderParams_.temporalLayers_ = 3;
+    msp.addMediaThread(atp);
+
+    {
+        MediaStreamSettings settings(io, msp);
+        settings.face_ = &face;
+        settings.keyChain_ = keyChain.get();
+        LocalVideoStream s(appPrefix, settings);
+
+        EXPECT_EQ(0, s.incomingEncodedFrame("low", width, height, true, 0, 0, frame.data(), frame.size()));
+
+        // with 3 layers, GOP positions 1, 2, 3, 4 are in layers 2, 1, 2, 0
+        unsigned int layers[] = {2, 1, 2, 0};
+        for (int i = 0; i < 4; ++i)
+        {
+            unsigned int wrongLayer = (layers[i] + 1) % 3;
+            EXPECT_ANY_THROW(s.incomingEncodedFrame("low", width, height, false, 0, 0,
+                                                    frame.data(), frame.size(), wrongLayer));
+            EXPECT_EQ(i + 1, s.incomingEncodedFrame("low", width, height, false, 0, 0,
+                                                    frame.data(), frame.size(), layers[i]));
+
+            // delta frame name is <thread>/d/<layer>/<seq no>
+            ndn::Name frameName(s.getLastPublishedInfo().at("low").ndnName_);
+            EXPECT_EQ(NameComponents::NameComponentDelta, frameName[-3].toEscapedString());
+            EXPECT_EQ(layers[i], frameName[-2].toNumber());
+            EXPECT_EQ(i, frameName[-1].toSequenceNumber());
+        }
+
+        boost::this_thread::sleep_for(boost::chrono::milliseconds(500));
+
+        statistics::StatisticsStorage stat = s.getStatistics();
+        EXPECT_EQ(5, stat[statistics::Indicator::PublishedNum]);
+    }
+
+    work.reset();
+    t.join();
+}
+
 TEST(TestVideoStream, TestPublishInvokeOnFaceThread)
 {
 #ifdef ENABLE_LOGGING
@@ -517,6 +720,118 @@ TEST(TestVideoStream, TestRemoveThreadWhilePublishing)
     }
     t.join();
 }
+
+TEST(TestVideoStream, TestDemandDrivenEncoding)
+{
+#ifdef ENABLE_LOGGING
+    ndnlog::new_api::Logger::initAsyncLogging();
+    ndnlog::new_api::Logger::getLogger("").setLogLevel(ndnlog::NdnLoggerDetailLevelAll);
+#endif
+
+    int width = 640, height = 480;
+    int frameSize = width * height * 4 * sizeof(uint8_t);
+    uint8_t *frameBuffer = (uint8_t *)malloc(frameSize);
+    for (int j = 0; j < height; ++j)
+        for (int i = 0; i < width; ++i)
+            frameBuffer[i * width + j] = std::rand() % 256; // random noise
+
+    boost::asio::io_service io;
+    boost::shared_ptr<boost::asio::io_service::work> work(boost::make_shared<boost::asio::io_service::work>(io));
+    boost::thread t([&io]() {
+        io.run();
+    });
+
+    std::string appPrefix = "/ndn/edu/ucla/remap/peter/app";
+    boost::shared_ptr<Face> publisherFace(boost::make_shared<ThreadsafeFace>(io));
+    boost::shared_ptr<Face> consumerFace(boost::make_shared<ThreadsafeFace>(io));
+    shared_ptr<KeyChain> keyChain = memoryKeyChain(appPrefix);
+
+    publisherFace->setCommandSigningInfo(*keyChain, certName(keyName(appPrefix)));
+    publisherFace->registerPrefix(Name(appPrefix), OnInterestCallback(),
+                                  [](const boost::shared_ptr<const Name> &) {
+                                      ASSERT_FALSE(true);
+                                  });
+    // making sure that prefix registration gets through
+    boost::this_thread::sleep_for(boost::chrono::milliseconds(2000));
+
+    MediaStreamParams msp("camera");
+    msp.type_ = MediaStreamParams::MediaStreamTypeVideo;
+    msp.producerParams_.freshness_ = {10, 15, 900};
+    msp.producerParams_.segmentSize_ = 1000;
+    msp.producerParams_.demand_ = {true, 1000};
+
+    VideoThreadParams atp("low", sampleVideoCoderParams());
+    atp.coderParams_.encodeWidth_ = width;
+    atp.coderParams_.encodeHeight_ = height;
+    atp.coderParams_.startBitrate_ = 500;
+    atp.coderParams_.dropFramesOn_ = false;
+    msp.addMediaThread(atp);
+
+    {
+        MediaStreamSettings settings(io, msp);
+        settings.face_ = publisherFace.get();
+        settings.keyChain_ = keyChain.get();
+        LocalVideoStream s(appPrefix, settings);
+
+#ifdef ENABLE_LOGGING
+        s.setLogger(ndnlog::new_api::Logger::getLoggerPtr(""));
+#endif
+        boost::function<void(int)> feedFrames = [&s, width, height, frameBuffer, frameSize](int nFrames) {
+            for (int i = 0; i < nFrames; ++i)
+            {
+                EXPECT_NO_THROW(s.incomingArgbFrame(width, height, frameBuffer, frameSize));
+                // let frame be published before the next one is captured
+                boost::this_thread::sleep_for(boost::chrono::milliseconds(100));
+            }
+        };
+
+        // newly added thread is demanded until its' idle window passes
+        feedFrames(5);
+        statistics::StatisticsStorage stat = s.getStatistics();
+        EXPECT_EQ(5, stat[statistics::Indicator::EncodedNum]);
+        EXPECT_EQ(1, stat[statistics::Indicator::PublishedKeyNum]);
+
+        // no interests for the thread - nothing is encoded
+        boost::this_thread::sleep_for(boost::chrono::milliseconds(1100));
+        feedFrames(5);
+        stat = s.getStatistics();
+        EXPECT_EQ(10, stat[statistics::Indicator::CapturedNum]);
+        EXPECT_EQ(5, stat[statistics::Indicator::EncodedNum]);
+        EXPECT_EQ(1, stat[statistics::Indicator::PublishedKeyNum]);
+
+        // interest for the thread resumes encoding with a key frame, though
+        // thread's GOP is not over yet; interest is for a frame that is not
+        // published yet, so it becomes pending
+        Interest interest(Name(s.getPrefix())
+                              .append("low")
+                              .append(NameComponents::NameComponentDelta)
+                              .appendSequenceNumber(100),
+                          1000);
+        consumerFace->expressInterest(interest,
+                                      [](const boost::shared_ptr<const Interest> &,
+                                         const boost::shared_ptr<Data> &) {},
+                                      [](const boost::shared_ptr<const Interest> &) {});
+        boost::this_thread::sleep_for(boost::chrono::milliseconds(200));
+
+        feedFrames(1);
+        stat = s.getStatistics();
+        EXPECT_EQ(6, stat[statistics::Indicator::EncodedNum]);
+        EXPECT_EQ(2, stat[statistics::Indicator::PublishedKeyNum]);
+
+        feedFrames(1);
+        stat = s.getStatistics();
+        EXPECT_EQ(7, stat[statistics::Indicator::EncodedNum]);
+        EXPECT_EQ(2, stat[statistics::Indicator::PublishedKeyNum]);
+    }
+
+    io.dispatch([consumerFace, publisherFace] {
+        consumerFace->shutdown();
+        publisherFace->shutdown();
+    });
+    work.reset();
+    t.join();
+    free(frameBuffer);
+}
 #endif
 
 #if 1
@@ -102,6 +102,48 @@ TEST(TestVideoThread, TestEncodeAsync)
 	}
 }
 
+TEST(TestVideoThread, TestEncodeOnWorker)
+{
+	int nFrames = 30;
+	int width = 640, height = 480;
+	std::vector<WebRtcVideoFrame> frames = getFrameSequence(width, height, nFrames);
+
+	VideoCoderParams vcp(sampleVideoCoderParams());
+	vcp.startBitrate_ = 1000;
+	vcp.maxBitrate_ = 1000;
+	vcp.encodeWidth_ = width;
+	vcp.encodeHeight_ = height;
+
+	// pinned to the first core
+	VideoThread vt(vcp, 0);
+	boost::thread::id callerId = boost::this_thread::get_id();
+	int nEncoded = 0;
+
+	for (auto &f : frames)
+	{
+		boost::promise<boost::shared_ptr<VideoFramePacket>> promise;
+		boost::future<boost::shared_ptr<VideoFramePacket>> futurePacket = promise.get_future();
+		boost::thread::id workerId;
+
+		vt.encodeAsync(f, [&promise, &workerId](const boost::shared_ptr<VideoFramePacket> &fp) {
+			workerId = boost::this_thread::get_id();
+			promise.set_value(fp);
+		});
+
+		boost::shared_ptr<VideoFramePacket> vf(futurePacket.get());
+		EXPECT_NE(callerId, workerId);
+		if (vf.get())
+		{
+			nEncoded++;
+			EXPECT_EQ(width, vf->getFrame()._encodedWidth);
+			EXPECT_EQ(height, vf->getFrame()._encodedHeight);
+		}
+	}
+
+	EXPECT_EQ(nEncoded, vt.getEncodedNum());
+	EXPECT_LT(0, nEncoded);
+}
+
 TEST(TestVideoThread, TestEncodeMultipleThreads)
 {
 	bool dropEnabled = true;
@@ -475,6 +475,68 @@ TEST(TestNameComponents, TestSuffixFiltering)
 	}
 }
 #endif
+TEST(TestNameComponents, TestTemporalLayers)
+{
+	// single layer
+	for (int i = 0; i < 10; ++i)
+		EXPECT_EQ(0, NameComponents::temporalLayer(i, 1));
+	// two layers: 0-1-0-1...
+	{
+		unsigned int expected[] = {0, 1, 0, 1, 0, 1};
+		for (int i = 0; i < 6; ++i)
+			EXPECT_EQ(expected[i], NameComponents::temporalLayer(i, 2));
+	}
+	// three layers: 0-2-1-2-0-2-1-2...
+	{
+		unsigned int expected[] = {0, 2, 1, 2, 0, 2, 1, 2, 0};
+		for (int i = 0; i < 9; ++i)
+			EXPECT_EQ(expected[i], NameComponents::temporalLayer(i, 3));
+	}
+}
+
+TEST(TestNameComponents, TestTemporalLayerNames)
+{
+	Name threadPrefix("/ndn/edu/ucla/remap/peter/ndncon/instance1/ndnrtc/%FD%02/video/camera/%FC%00%00%01c_%27%DE%D6/hi");
+	{
+		NamespaceInfo info;
+		Name n(threadPrefix);
+		n.append(NameComponents::NameComponentDelta).append(Name::Component::fromNumber(2)).appendSequenceNumber(7).appendSegment(1);
+
+		ASSERT_TRUE(NameComponents::extractInfo(n, info));
+		EXPECT_TRUE(info.isDelta_);
+		EXPECT_TRUE(info.hasTemporalLayer_);
+		EXPECT_EQ(2, info.temporalLayer_);
+		EXPECT_EQ(7, info.sampleNo_);
+		EXPECT_EQ(1, info.segNo_);
+		EXPECT_EQ(n, info.getPrefix());
+		EXPECT_EQ(n.getPrefix(-1), info.getPrefix(prefix_filter::Sample));
+		EXPECT_EQ(n.getSubName(-3), info.getSuffix(suffix_filter::Sample));
+	}
+	{
+		NamespaceInfo info;
+		Name n(threadPrefix);
+		n.append(NameComponents::NameComponentDelta).append(Name::Component::fromNumber(1))
+			.appendSequenceNumber(7).append(NameComponents::NameComponentParity).appendSegment(0);
+
+		ASSERT_TRUE(NameComponents::extractInfo(n, info));
+		EXPECT_TRUE(info.hasTemporalLayer_);
+		EXPECT_EQ(1, info.temporalLayer_);
+		EXPECT_TRUE(info.isParity_);
+		EXPECT_EQ(n, info.getPrefix());
+	}
+	{
+		// delta frames of single-layer threads and key frames have no layer
+		NamespaceInfo info;
+		Name n(threadPrefix);
+		n.append(NameComponents::NameComponentDelta).appendSequenceNumber(7).appendSegment(0);
+
+		ASSERT_TRUE(NameComponents::extractInfo(n, info));
+		EXPECT_FALSE(info.hasTemporalLayer_);
+		EXPECT_EQ(7, info.sampleNo_);
+		EXPECT_EQ(n, info.getPrefix());
+	}
+}
+
 int main(int argc, char **argv) {
 	::testing::InitGoogleTest(&argc, argv);
 	return RUN_ALL_TESTS();
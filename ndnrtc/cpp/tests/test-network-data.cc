@@ -23,7 +23,7 @@ class DataPacketTest : public DataPacket
 {
   public:
     DataPacketTest(unsigned int dataLength, const uint8_t *payload) : DataPacket(dataLength, payload) {}
-    DataPacketTest(const std::vector<uint8_t> &payload) : DataPacket(payload) {}
+    DataPacketTest(const std::vector<uint8_t> &payload, size_t headroom = 0) : DataPacket(payload, headroom) {}
     DataPacketTest(const DataPacketTest &dataPacket) : DataPacket(dataPacket) {}
     DataPacketTest(NetworkData &&networkData) : DataPacket(boost::move(networkData)) {}
 
@@ -407,6 +407,77 @@ TEST(TestDataPacket, TestInvalidRawData)
     EXPECT_FALSE(dp.isValid());
 }
 
+// builds data packet the way it was done before packets had headroom:
+// every blob is inserted in front of the payload
+std::vector<uint8_t> buildWithInsert(const std::vector<uint8_t> &payload,
+                                     const std::vector<std::vector<uint8_t>> &blobs)
+{
+    std::vector<uint8_t> packet(payload);
+    packet.insert(packet.begin(), 0);
+    size_t payloadBegin = 1;
+
+    for (auto &b : blobs)
+    {
+        packet[0]++;
+        uint8_t size[] = {(uint8_t)(b.size() & 0x00ff), (uint8_t)((b.size() & 0xff00) >> 8)};
+        packet.insert(packet.begin() + payloadBegin, size, size + 2);
+        packet.insert(packet.begin() + payloadBegin + 2, b.begin(), b.end());
+        payloadBegin += 2 + b.size();
+    }
+
+    return packet;
+}
+
+TEST(TestDataPacket, TestHeadroom)
+{
+    std::vector<uint8_t> payload(1000);
+    for (int i = 0; i < payload.size(); ++i)
+        payload[i] = i % 255;
+
+    std::vector<std::vector<uint8_t>> blobs;
+    for (int i = 0; i < 30; ++i)
+        blobs.push_back(std::vector<uint8_t>(i + 1, i));
+
+    std::vector<uint8_t> expected = buildWithInsert(payload, blobs);
+
+    // no headroom, exact headroom, too little headroom (grown while adding blobs)
+    for (auto headroom : {0, 495, 10})
+    {
+        DataPacketTest dp(payload, headroom);
+        for (auto &b : blobs)
+            dp.addBlob(b.size(), b.data());
+
+        ASSERT_EQ(expected.size(), dp.getLength());
+        EXPECT_EQ(0, memcmp(expected.data(), dp.getData(), dp.getLength()));
+        EXPECT_TRUE(std::equal(dp.begin(), dp.end(), expected.begin()));
+        ASSERT_EQ(blobs.size(), dp.getBlobsNum());
+        for (int i = 0; i < blobs.size(); ++i)
+            EXPECT_TRUE(std::equal(blobs[i].begin(), blobs[i].end(), dp.getBlob(i).begin()));
+        EXPECT_EQ(payload.size(), dp.getPayload().size());
+        EXPECT_TRUE(std::equal(payload.begin(), payload.end(), dp.getPayload().begin()));
+
+        // copies and data() must see the same bytes
+        DataPacketTest dpCopy(dp);
+        EXPECT_EQ(0, memcmp(expected.data(), dpCopy.getData(), dpCopy.getLength()));
+        EXPECT_EQ(expected, dp.data());
+        ASSERT_EQ(blobs.size(), dp.getBlobsNum());
+        for (int i = 0; i < blobs.size(); ++i)
+            EXPECT_TRUE(std::equal(blobs[i].begin(), blobs[i].end(), dp.getBlob(i).begin()));
+    }
+    {
+        // packet without payload
+        DataPacketTest dp(std::vector<uint8_t>(), 100);
+        for (auto &b : blobs)
+            dp.addBlob(b.size(), b.data());
+
+        EXPECT_EQ(buildWithInsert(std::vector<uint8_t>(), blobs), dp.data());
+        EXPECT_EQ(0, dp.getPayload().size());
+        ASSERT_EQ(blobs.size(), dp.getBlobsNum());
+        for (int i = 0; i < blobs.size(); ++i)
+            EXPECT_TRUE(std::equal(blobs[i].begin(), blobs[i].end(), dp.getBlob(i).begin()));
+    }
+}
+
 TEST(TestSamplePacket, TestCreate)
 {
     {
@@ -787,9 +858,12 @@ TEST(TestVideoFramePacket, TestCreate)
     EXPECT_EQ(hdr.publishUnixTimestamp_, fp.getHeader().publishUnixTimestamp_);
 
     int length = fp.getLength();
+    size_t nParitySymbols = fp.getParitySymbolsNum(VideoFrameSegment::payloadLength(1000), 0.2);
     boost::shared_ptr<NetworkData> parityData = fp.getParityData(VideoFrameSegment::payloadLength(1000), 0.2);
     EXPECT_TRUE(parityData.get());
     EXPECT_EQ(length, fp.getLength());
+    EXPECT_EQ(nParitySymbols * VideoFrameSegment::payloadLength(1000), parityData->getLength());
+    EXPECT_EQ(nParitySymbols, VideoFrameSegment::numSlices(*parityData, 1000));
     EXPECT_EQ(hdr.sampleRate_, fp.getHeader().sampleRate_);
     EXPECT_EQ(hdr.publishTimestampMs_, fp.getHeader().publishTimestampMs_);
     EXPECT_EQ(hdr.publishUnixTimestamp_, fp.getHeader().publishUnixTimestamp_);
@@ -906,6 +980,62 @@ TEST(TestVideoFramePacket, TestFromNetworkData)
         EXPECT_EQ(buffer[i], fp.getFrame()._buffer[i]);
 }
 
+TEST(TestVideoFramePacket, TestLayerHeader)
+{
+    size_t frameLen = 4300;
+    int32_t size = webrtc::CalcBufferSize(webrtc::kI420, 640, 480);
+    uint8_t *buffer = (uint8_t *)malloc(frameLen);
+    for (int i = 0; i < frameLen; ++i)
+        buffer[i] = i % 255;
+
+    webrtc::EncodedImage frame(buffer, frameLen, size);
+    frame._encodedWidth = 640;
+    frame._encodedHeight = 480;
+    frame._timeStamp = 1460488589;
+    frame.capture_time_ms_ = 1460488569;
+    frame._frameType = webrtc::kVideoFrameDelta;
+    frame._completeFrame = true;
+
+    CommonHeader hdr;
+    hdr.sampleRate_ = 24.7;
+    hdr.publishTimestampMs_ = 488589553;
+    hdr.publishUnixTimestamp_ = 1460488589;
+
+    std::map<std::string, PacketNumber> syncList = boost::assign::map_list_of("hi", 341)("mid", 433);
+
+    // single-layer frames keep the frame header older consumers expect
+    VideoFramePacket single(frame);
+    single.setSyncList(syncList);
+    single.setHeader(hdr);
+    EXPECT_FALSE(single.hasLayerHeader());
+    EXPECT_EQ(0, single.getTemporalLayer());
+    EXPECT_EQ(-1, single.getRefPlaybackNo());
+    single.setRefPlaybackNo(7);
+    EXPECT_EQ(-1, single.getRefPlaybackNo());
+
+    VideoFramePacket layered(frame, true, 2);
+    layered.setSyncList(syncList);
+    layered.setHeader(hdr);
+    layered.setRefPlaybackNo(41);
+    EXPECT_EQ(single.getLength() + sizeof(uint8_t) + sizeof(PacketNumber), layered.getLength());
+
+    VideoFramePacket fp(boost::move((NetworkData &)layered));
+    ASSERT_TRUE(fp.isValid());
+    EXPECT_TRUE(fp.hasLayerHeader());
+    EXPECT_EQ(2, fp.getTemporalLayer());
+    EXPECT_EQ(41, fp.getRefPlaybackNo());
+    EXPECT_EQ(syncList, fp.getSyncList());
+    EXPECT_EQ(hdr.sampleRate_, fp.getHeader().sampleRate_);
+    EXPECT_EQ(frame._encodedWidth, fp.getFrame()._encodedWidth);
+    EXPECT_EQ(frame._timeStamp, fp.getFrame()._timeStamp);
+    EXPECT_EQ(frame._frameType, fp.getFrame()._frameType);
+    EXPECT_EQ(frameLen, fp.getFrame()._length);
+    for (int i = 0; i < frameLen; ++i)
+        EXPECT_EQ(buffer[i], fp.getFrame()._buffer[i]);
+
+    free(buffer);
+}
+
 TEST(TestVideoFramePacket, TestAddSyncListThrow)
 {
     size_t frameLen = 4300;
@@ -1014,6 +1144,55 @@ TEST(TestVideoFramePacket, TestGetParity)
     }
 }
 
+TEST(TestVideoFramePacket, TestParityCoderSessionsCached)
+{
+    // sessions are cached by OpenFEC encoder only
+    bool nativeEnabled = fec::isNativeRs28Enabled();
+    fec::setNativeRs28Enabled(false);
+    fec::CoderSessionCache::getSharedInstance()->clear();
+
+    unsigned int nSource = 10, nRepair = 2, symbolLength = 1000;
+    std::vector<uint8_t> data(nSource * symbolLength), parity1(nRepair * symbolLength), parity2(parity1);
+    for (int i = 0; i < data.size(); ++i)
+        data[i] = (uint8_t)(std::rand() % 256);
+
+    {
+        fec::Rs28Encoder enc(nSource, nRepair, symbolLength);
+        EXPECT_EQ(0, enc.encode(data.data(), parity1.data()));
+    }
+    EXPECT_EQ(1, fec::CoderSessionCache::getSharedInstance()->size());
+
+    // same layout re-uses cached session and produces the same parity
+    for (int i = 0; i < 10; ++i)
+    {
+        fec::Rs28Encoder enc(nSource, nRepair, symbolLength);
+        EXPECT_EQ(0, enc.encode(data.data(), parity2.data()));
+        EXPECT_EQ(0, fec::CoderSessionCache::getSharedInstance()->size());
+    }
+    EXPECT_EQ(1, fec::CoderSessionCache::getSharedInstance()->size());
+    EXPECT_EQ(parity1, parity2);
+
+    {
+        fec::Rs28Encoder enc(nSource + 1, nRepair, symbolLength);
+        std::vector<uint8_t> moreData(data);
+        moreData.resize((nSource + 1) * symbolLength);
+        EXPECT_EQ(0, enc.encode(moreData.data(), parity2.data()));
+    }
+    EXPECT_EQ(2, fec::CoderSessionCache::getSharedInstance()->size());
+
+    // parity from cached session recovers lost data
+    std::vector<uint8_t> received(data);
+    std::vector<uint8_t> rList(nSource + nRepair, FEC_RLIST_SYMREADY);
+    memset(received.data() + 3 * symbolLength, 0, symbolLength);
+    rList[3] = FEC_RLIST_SYMEMPTY;
+
+    fec::Rs28Decoder dec(nSource, nRepair, symbolLength);
+    EXPECT_LE(1, dec.decode(received.data(), parity1.data(), rList.data()));
+    EXPECT_EQ(data, received);
+
+    fec::setNativeRs28Enabled(nativeEnabled);
+}
+
 TEST(TestAudioThreadMeta, TestCreate)
 {
     AudioThreadMeta meta(50, 146, "opus");
@@ -1099,6 +1278,71 @@ TEST(TestVideoThreadMeta, TestCreate)
     }
 }
 
+TEST(TestVideoThreadMeta, TestParityRatio)
+{
+    FrameSegmentsInfo segInfo({5.6, 2.3, 54.3, 12.3});
+    VideoCoderParams coder = sampleVideoCoderParams();
+
+    {
+        VideoThreadMeta meta(27, 465, 15, 14, segInfo, coder, 0.15, 0.3);
+
+        EXPECT_TRUE(meta.isValid());
+        EXPECT_EQ(0.15, meta.getParityRatio().first);
+        EXPECT_EQ(0.3, meta.getParityRatio().second);
+
+        NetworkData nd(boost::move(meta));
+        VideoThreadMeta meta2(boost::move(nd));
+
+        EXPECT_TRUE(meta2.isValid());
+        EXPECT_EQ(465, meta2.getSeqNo().first);
+        EXPECT_EQ(segInfo, meta2.getSegInfo());
+        EXPECT_EQ(0.15, meta2.getParityRatio().first);
+        EXPECT_EQ(0.3, meta2.getParityRatio().second);
+    }
+    { // meta without parity ratios
+        VideoThreadMeta meta(27, 465, 15, 14, segInfo, coder);
+        NetworkData nd(boost::move(meta));
+        VideoThreadMeta meta2(boost::move(nd));
+
+        EXPECT_TRUE(meta2.isValid());
+        EXPECT_EQ(0, meta2.getParityRatio().first);
+        EXPECT_EQ(0, meta2.getParityRatio().second);
+        EXPECT_EQ(0, meta2.getFecGroupSize());
+    }
+    { // delta frames protected by FEC groups
+        VideoThreadMeta meta(27, 465, 15, 14, segInfo, coder, 0.25, 0.3, 4);
+        NetworkData nd(boost::move(meta));
+        VideoThreadMeta meta2(boost::move(nd));
+
+        EXPECT_TRUE(meta2.isValid());
+        EXPECT_EQ(0.25, meta2.getParityRatio().first);
+        EXPECT_EQ(0.3, meta2.getParityRatio().second);
+        EXPECT_EQ(4, meta2.getFecGroupSize());
+        EXPECT_EQ(0, meta2.getManifestWindow());
+    }
+    { // delta frames covered by aggregated manifests
+        VideoThreadMeta meta(27, 465, 15, 14, segInfo, coder, 0.25, 0.3, 4, 30);
+        NetworkData nd(boost::move(meta));
+        VideoThreadMeta meta2(boost::move(nd));
+
+        EXPECT_TRUE(meta2.isValid());
+        EXPECT_EQ(0.25, meta2.getParityRatio().first);
+        EXPECT_EQ(4, meta2.getFecGroupSize());
+        EXPECT_EQ(30, meta2.getManifestWindow());
+        EXPECT_FALSE(meta2.isDormant());
+    }
+    { // thread is not encoded due to lack of demand
+        VideoThreadMeta meta(27, 465, 15, 14, segInfo, coder, 0.25, 0.3, 0, 0, true);
+        NetworkData nd(boost::move(meta));
+        VideoThreadMeta meta2(boost::move(nd));
+
+        EXPECT_TRUE(meta2.isValid());
+        EXPECT_TRUE(meta2.isDormant());
+        EXPECT_EQ(465, meta2.getSeqNo().first);
+        EXPECT_EQ(coder.temporalLayers_, meta2.getTemporalLayers());
+    }
+}
+
 TEST(TestVideoThreadMeta, TestCreateFail)
 {
     uint8_t const data[] = {0x31, 0x32, 0x33, 0x34, 0x35, 0x36, 0x37, 0x38, 0x39,
@@ -1618,6 +1862,131 @@ TEST(TestManifest, TestWithDummySignature)
         EXPECT_TRUE(im.hasData(*o));
 }
 
+TEST(TestAggregatedManifest, TestCreate)
+{
+    std::string threadName = "/ndn/edu/ucla/remap/ndncon/instance1/ndnrtc/%FD%03/video/camera/%FC%00%00%01c_%27%DE%D6/hi";
+    std::vector<boost::shared_ptr<ndn::Data>> allObjects;
+    std::vector<boost::shared_ptr<const ndn::Data>> allSegments;
+
+    // more segments than a packet can have blobs
+    for (int seqNo = 30; seqNo < 60; ++seqNo)
+    {
+        VideoFramePacket vp = getVideoFramePacket(10000);
+        std::vector<VideoFrameSegment> segments = sliceFrame(vp);
+        std::stringstream frameName;
+        frameName << threadName << "/d/" << ndn::Name::Component::fromSequenceNumber(seqNo).toEscapedString();
+        std::vector<boost::shared_ptr<ndn::Data>> dataObjects = dataFromSegments(frameName.str(), segments);
+
+        std::copy(dataObjects.begin(), dataObjects.end(), std::back_inserter(allObjects));
+    }
+
+    for (auto &o : allObjects)
+    {
+        static uint8_t digest[ndn_SHA256_DIGEST_SIZE];
+        memset(digest, 0, ndn_SHA256_DIGEST_SIZE);
+        ndn::Blob signatureBits(digest, sizeof(digest));
+        o->setSignature(ndn::DigestSha256Signature());
+        ndn::DigestSha256Signature *sha256Signature = (ndn::DigestSha256Signature *)o->getSignature();
+        sha256Signature->setSignature(signatureBits);
+        allSegments.push_back(boost::shared_ptr<const ndn::Data>(o));
+    }
+    ASSERT_LT(255, allSegments.size());
+
+    AggregatedManifest m(1, allSegments);
+
+    EXPECT_TRUE(m.isValid());
+    EXPECT_EQ(1, m.getWindowNo());
+    EXPECT_EQ(allSegments.size(), m.size());
+
+    GT_PRINTF("Aggregated manifest packet of %d segments has total length of %d bytes\n",
+              m.size(), m.getLength());
+
+    NetworkData nd(m);
+    AggregatedManifest im(boost::move(nd));
+
+    EXPECT_TRUE(im.isValid());
+    EXPECT_EQ(1, im.getWindowNo());
+    EXPECT_EQ(allSegments.size(), im.size());
+
+    for (auto &o : allObjects)
+        EXPECT_TRUE(im.hasData(*o));
+
+    { // segment, which is not covered
+        ndn::Data d(*allObjects.front());
+        d.setContent(ndn::Blob(std::vector<uint8_t>(100, 1)));
+        EXPECT_FALSE(im.hasData(d));
+    }
+    { // per-frame manifest is not an aggregated one
+        // manifest of the first frame only, it doesn't cover the last segment
+        std::vector<boost::shared_ptr<const ndn::Data>> frameSegments;
+        for (auto &o : allSegments)
+            if (o->getName().getPrefix(-1) == allSegments.front()->getName().getPrefix(-1))
+                frameSegments.push_back(o);
+        ASSERT_GT(255, frameSegments.size());
+
+        Manifest pm(frameSegments);
+        EXPECT_TRUE(pm.isValid());
+        EXPECT_TRUE(pm.hasData(*allObjects.front()));
+        EXPECT_FALSE(pm.hasData(*allObjects.back()));
+
+        NetworkData nd(pm);
+        AggregatedManifest am(boost::move(nd));
+
+        EXPECT_FALSE(am.isValid());
+    }
+}
+
+TEST(TestAggregatedManifest, TestWindowName)
+{
+    ndn::Name threadPrefix("/ndn/edu/ucla/remap/ndnrtc/%FD%03/video/camera/%FC%00%00%01c_%27%DE%D6/hi");
+
+    EXPECT_EQ(0, AggregatedManifest::windowNo(29, 30));
+    EXPECT_EQ(1, AggregatedManifest::windowNo(30, 30));
+    EXPECT_EQ(ndn::Name(threadPrefix).append(NameComponents::NameComponentDelta)
+                  .append(NameComponents::NameComponentManifest)
+                  .appendSequenceNumber(5),
+              AggregatedManifest::windowName(threadPrefix, 5));
+}
+
+TEST(TestWireData, TestParsedOnce)
+{
+    std::string frameName = "/ndn/edu/ucla/remap/peter/ndncon/instance1/ndnrtc/%FD%03/video/camera/%FC%00%00%01c_%27%DE%D6/hi/d/%FE%07";
+    VideoFramePacket vp = getVideoFramePacket();
+    std::vector<VideoFrameSegment> segments = sliceFrame(vp, 734, 1249);
+    std::vector<boost::shared_ptr<ndn::Data>> dataObjects = dataFromSegments(frameName, segments);
+    std::vector<boost::shared_ptr<ndn::Interest>> interests = getInterests(frameName, 0, dataObjects.size());
+
+    for (int i = 0; i < dataObjects.size(); ++i)
+    {
+        boost::shared_ptr<WireData<VideoFrameSegmentHeader>> wd =
+            boost::make_shared<WireData<VideoFrameSegmentHeader>>(dataObjects[i], interests[i]);
+        WireSegment ws(dataObjects[i], interests[i]);
+        ImmutableHeaderPacket<VideoFrameSegmentHeader> parsed(dataObjects[i]->getContent());
+
+        // segment is not re-parsed on every access
+        EXPECT_EQ(&wd->segment(), &wd->segment());
+        EXPECT_EQ(&wd->segment().getHeader(), &wd->segment().getHeader());
+
+        EXPECT_TRUE(wd->segment().isValid());
+        EXPECT_EQ(734, wd->getPlaybackNo());
+        EXPECT_EQ(parsed.getHeader().interestNonce_, wd->header().interestNonce_);
+        EXPECT_EQ(parsed.getHeader().interestNonce_, ws.header().interestNonce_);
+        EXPECT_EQ(1249, wd->segment().getHeader().pairedSequenceNo_);
+        EXPECT_EQ(segments[i].getPayload().size(), wd->segment().getPayload().size());
+        EXPECT_TRUE(std::equal(segments[i].getPayload().begin(), segments[i].getPayload().end(),
+                               wd->segment().getPayload().begin()));
+
+        // copies share parsed data
+        WireData<VideoFrameSegmentHeader> wdCopy(*wd);
+        ImmutableHeaderPacket<VideoFrameSegmentHeader> segmentCopy = wd->segment();
+
+        EXPECT_EQ(&wd->segment(), &wdCopy.segment());
+        EXPECT_TRUE(segmentCopy.isValid());
+        EXPECT_EQ(734, segmentCopy.getHeader().playbackNo_);
+        EXPECT_EQ(wd->segment().getPayload().begin(), segmentCopy.getPayload().begin());
+    }
+}
+
 //******************************************************************************
 int main(int argc, char **argv)
 {
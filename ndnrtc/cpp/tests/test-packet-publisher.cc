@@ -14,6 +14,7 @@
 #include <ndn-cpp/security/identity/memory-identity-storage.hpp>
 #include <ndn-cpp/security/policy/no-verify-policy-manager.hpp>
 #include <ndn-cpp/security/policy/self-verify-policy-manager.hpp>
+#include <ndn-cpp/security/key-params.hpp>
 
 #include "gtest/gtest.h"
 #include "tests-helpers.hpp"
@@ -541,6 +542,90 @@ TEST(TestPacketPublisher, TestPublishAudioBundle)
     }
 }
 
+TEST(TestPacketPublisher, TestSingleCopyPublish)
+{
+    MockNdnKeyChain keyChain;
+    MockNdnMemoryCache memoryCache;
+    MockSettings settings;
+
+    int wireLength = 1000;
+    int freshness = 1000;
+    settings.keyChain_ = &keyChain;
+    settings.memoryCache_ = &memoryCache;
+    settings.segmentWireLength_ = wireLength;
+    settings.freshnessPeriodMs_ = freshness;
+    settings.statStorage_ = StatisticsStorage::createProducerStatistics();
+
+    Name packetName("/ndn/edu/wustl/jdd/clientA/ndnrtc/%FD%02/video/camera/tiny/d");
+    packetName.appendSequenceNumber(0);
+
+    std::vector<Data> dataObjects;
+    boost::function<void(const Data &)> mockAddData = [&dataObjects](const Data &data) {
+        dataObjects.push_back(data);
+    };
+
+    EXPECT_CALL(keyChain, sign(_))
+        .Times(AtLeast(1));
+    EXPECT_CALL(memoryCache, getPendingInterestsForName(_, _))
+        .Times(AtLeast(1));
+    EXPECT_CALL(memoryCache, getPendingInterestsWithPrefix(_, _))
+        .Times(AtLeast(1));
+    EXPECT_CALL(memoryCache, add(_))
+        .Times(AtLeast(1))
+        .WillRepeatedly(Invoke(mockAddData));
+
+    {
+        PacketPublisher<VideoFrameSegment, MockSettings> publisher(settings);
+
+        for (int frameLen : {0, 100, 956, 4321, 10000})
+        {
+            std::vector<uint8_t> frame;
+            for (int i = 0; i < frameLen; ++i)
+                frame.push_back((uint8_t)(i % 251));
+
+            NetworkData nd(frame);
+            VideoFrameSegmentHeader segHdr;
+            segHdr.totalSegmentsNum_ = VideoFrameSegment::numSlices(nd, wireLength);
+            segHdr.playbackNo_ = 100;
+            segHdr.pairedSequenceNo_ = 67;
+
+            dataObjects.clear();
+            PublishedDataPtrVector segments = publisher.publish(packetName, nd, segHdr, freshness);
+
+            // published content must be the same as the one prepared by segments
+            std::vector<VideoFrameSegment> slices = VideoFrameSegment::slice(nd, wireLength);
+            ASSERT_EQ(slices.size(), dataObjects.size());
+            for (int i = 0; i < slices.size(); ++i)
+            {
+                slices[i].setHeader(segHdr);
+                boost::shared_ptr<NetworkData> segmentData = slices[i].getNetworkData();
+
+                ASSERT_EQ(segmentData->getLength(), dataObjects[i].getContent().size());
+                EXPECT_EQ(0, memcmp(segmentData->getData(), dataObjects[i].getContent().buf(),
+                                    segmentData->getLength()));
+
+                ImmutableHeaderPacket<VideoFrameSegmentHeader> segment(dataObjects[i].getContent());
+                EXPECT_TRUE(segment.isValid());
+                EXPECT_EQ(100, segment.getHeader().playbackNo_);
+            }
+        }
+
+        // buffers are recycled, once published data is released
+        size_t nAllocated = publisher.getBufferPool()->allocated();
+        dataObjects.clear();
+        EXPECT_EQ(nAllocated, publisher.getBufferPool()->size());
+
+        std::vector<uint8_t> frame(5000, 0);
+        NetworkData nd(frame);
+        publisher.publish(packetName, nd);
+        EXPECT_EQ(nAllocated, publisher.getBufferPool()->allocated());
+    }
+
+    // published data may outlive the publisher
+    EXPECT_LT(0, dataObjects.size());
+    dataObjects.clear();
+}
+
 TEST(TestPacketPublisher, TestPitDeepClean)
 {
 #ifdef ENABLE_LOGGING
@@ -922,6 +1007,98 @@ TEST(TestPacketPublisher, TestBenchmarkNoSigning)
     }
 }
 
+TEST(TestPacketPublisher, TestBenchmarkSigningPool)
+{
+    Face face("aleph.ndn.ucla.edu");
+    std::string appPrefix = "/ndn/edu/ucla/remap/peter/app";
+    boost::shared_ptr<KeyChain> rsaKeyChain = memoryKeyChain(appPrefix);
+    boost::shared_ptr<KeyChain> ecdsaKeyChain;
+    {
+        boost::shared_ptr<MemoryIdentityStorage> identityStorage(boost::make_shared<MemoryIdentityStorage>());
+        ecdsaKeyChain = boost::make_shared<KeyChain>(boost::make_shared<IdentityManager>(identityStorage, boost::make_shared<MemoryPrivateKeyStorage>()),
+                                                     boost::make_shared<SelfVerifyPolicyManager>(identityStorage.get()));
+        ecdsaKeyChain->createIdentityAndCertificate(Name(appPrefix), EcKeyParams());
+        ecdsaKeyChain->getIdentityManager()->setDefaultIdentity(Name(appPrefix));
+    }
+
+    int wireLength = 1000;
+    int frameLen = 30000;
+    int nFrames = 100;
+    Name packetName("/test/1");
+
+    for (auto keyChain : {rsaKeyChain, ecdsaKeyChain})
+        for (unsigned int nThreads : {0, 1, 2, 4, 8})
+            for (bool ownKeyChains : {false, true})
+            {
+                if (ownKeyChains && (nThreads == 0 || keyChain != rsaKeyChain))
+                    continue;
+
+                // workers with own key chains sign in parallel, the rest share
+                // publisher's one
+                std::vector<boost::shared_ptr<KeyChain>> workerKeyChains;
+                std::vector<KeyChain *> workerKeyChainPtrs;
+                if (ownKeyChains)
+                    for (unsigned int t = 0; t < nThreads; ++t)
+                    {
+                        workerKeyChains.push_back(memoryKeyChain(appPrefix));
+                        workerKeyChainPtrs.push_back(workerKeyChains.back().get());
+                    }
+
+                boost::asio::io_service io;
+                boost::asio::io_service::work work(io);
+                boost::shared_ptr<MemoryContentCache> memCache = boost::make_shared<MemoryContentCache>(&face);
+                SigningPool signingPool(nThreads, keyChain.get(), workerKeyChainPtrs);
+                PublisherSettings settings;
+
+                settings.keyChain_ = keyChain.get();
+                settings.memoryCache_ = memCache.get();
+                settings.segmentWireLength_ = wireLength;
+                settings.freshnessPeriodMs_ = 1000;
+                settings.statStorage_ = StatisticsStorage::createProducerStatistics();
+                settings.signingPool_ = &signingPool;
+                settings.faceIo_ = &io;
+
+                boost::shared_ptr<VideoPacketPublisher> publisher(boost::make_shared<VideoPacketPublisher>(settings));
+                VideoFramePacket vp = getVideoFramePacket(frameLen);
+                int nPublished = 0;
+                unsigned int totalSlices = 0;
+
+                boost::chrono::high_resolution_clock::time_point t1 = boost::chrono::high_resolution_clock::now();
+                for (int i = 0; i < nFrames; ++i)
+                {
+                    VideoFrameSegmentHeader segHdr;
+                    segHdr.totalSegmentsNum_ = VideoFrameSegment::numSlices(vp, wireLength);
+
+                    // packets are published on face thread in order, all
+                    // segments are signed
+                    publisher->publishAsync(Name(packetName).appendSequenceNumber(i), vp, segHdr, 1000, false, false,
+                                            [&nPublished, &totalSlices, i](const PublishedDataPtrVector &segments) {
+                                                EXPECT_EQ(nPublished, i);
+                                                EXPECT_LT(0, segments.size());
+                                                for (int segNo = 0; segNo < segments.size(); ++segNo)
+                                                {
+                                                    EXPECT_EQ(i, segments[segNo]->getName()[-2].toSequenceNumber());
+                                                    EXPECT_EQ(segNo, segments[segNo]->getName()[-1].toSegment());
+                                                    EXPECT_LT(0, segments[segNo]->getSignature()->getSignature().size());
+                                                }
+                                                totalSlices += segments.size();
+                                                ++nPublished;
+                                            });
+                }
+                while (nPublished < nFrames)
+                    io.run_one();
+                boost::chrono::high_resolution_clock::time_point t2 = boost::chrono::high_resolution_clock::now();
+                unsigned int publishDuration = boost::chrono::duration_cast<boost::chrono::microseconds>(t2 - t1).count();
+
+                EXPECT_EQ(totalSlices, (*settings.statStorage_)[Indicator::SignNum]);
+                GT_PRINTF("%s key, %d signing threads%s: %.0f signed segments/sec (average publishing time %.2fms)\n",
+                          (keyChain == rsaKeyChain ? "RSA" : "ECDSA"), nThreads,
+                          (ownKeyChains ? " (own key chains)" : ""),
+                          (double)totalSlices / ((double)publishDuration / 1000000.),
+                          (double)publishDuration / 1000. / (double)nFrames);
+            }
+}
+
 int main(int argc, char **argv)
 {
     ::testing::InitGoogleTest(&argc, argv);
@@ -0,0 +1,86 @@
+//
+// test-parity-control.cc
+//
+//  Copyright 2013-2018 Regents of the University of California
+//
+
+#include "gtest/gtest.h"
+#include "src/parity-control.hpp"
+
+using namespace ndnrtc;
+
+TEST(TestParityControl, TestFixedRatio)
+{
+    GeneralProducerParams::FecParams fp({false, 0.1, 0.2, 1.});
+    ParityControl pc(fp);
+
+    EXPECT_FALSE(pc.isAdaptive());
+    EXPECT_EQ(0.1, pc.getParityRatio(SampleClass::Delta));
+    EXPECT_EQ(0.2, pc.getParityRatio(SampleClass::Key));
+
+    for (int i = 0; i < 100; ++i)
+        pc.interestsObserved(10, 5);
+
+    EXPECT_LT(0.4, pc.getLossEstimation());
+    EXPECT_EQ(0.1, pc.getParityRatio(SampleClass::Delta));
+    EXPECT_EQ(0.2, pc.getParityRatio(SampleClass::Key));
+}
+
+TEST(TestParityControl, TestAdaptiveRatio)
+{
+    GeneralProducerParams::FecParams fp({true, 0.1, 0.2, 1.});
+    ParityControl pc(fp);
+
+    EXPECT_TRUE(pc.isAdaptive());
+    // no loss
+    for (int i = 0; i < 100; ++i)
+        pc.interestsObserved(10, 10);
+
+    EXPECT_EQ(0, pc.getLossEstimation());
+    EXPECT_EQ(0.1, pc.getParityRatio(SampleClass::Delta));
+    EXPECT_EQ(0.2, pc.getParityRatio(SampleClass::Key));
+
+    // 10% loss
+    for (int i = 0; i < 200; ++i)
+        pc.interestsObserved(10, 9);
+
+    EXPECT_NEAR(0.1, pc.getLossEstimation(), 0.01);
+    double deltaRatio = pc.getParityRatio(SampleClass::Delta);
+    double keyRatio = pc.getParityRatio(SampleClass::Key);
+    // enough to recover average loss
+    EXPECT_LT(0.1 / 0.9, deltaRatio);
+    EXPECT_LT(deltaRatio, keyRatio);
+    EXPECT_GE(1., keyRatio);
+
+    // loss is gone, ratios go back to configured ones
+    for (int i = 0; i < 200; ++i)
+        pc.interestsObserved(10, 10);
+
+    EXPECT_GT(deltaRatio, pc.getParityRatio(SampleClass::Delta));
+    EXPECT_NEAR(0.1, pc.getParityRatio(SampleClass::Delta), 0.01);
+    EXPECT_NEAR(0.2, pc.getParityRatio(SampleClass::Key), 0.01);
+}
+
+TEST(TestParityControl, TestMaxRatio)
+{
+    GeneralProducerParams::FecParams fp({true, 0.1, 0.2, 0.5});
+    ParityControl pc(fp);
+
+    for (int i = 0; i < 200; ++i)
+        pc.interestsObserved(10, 1);
+
+    EXPECT_EQ(0.5, pc.getParityRatio(SampleClass::Delta));
+    EXPECT_EQ(0.5, pc.getParityRatio(SampleClass::Key));
+
+    // invalid observations are ignored
+    double loss = pc.getLossEstimation();
+    pc.interestsObserved(0, 0);
+    pc.interestsObserved(5, 10);
+    EXPECT_EQ(loss, pc.getLossEstimation());
+}
+
+int main(int argc, char **argv)
+{
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -352,6 +352,50 @@ TEST(TestPipeliner, TestSegmentsArrive)
     }
 }
 
+TEST(TestPipeliner, TestTemporalLayersNameScheme)
+{
+    Name threadPrefix("/ndn/edu/ucla/remap/peter/ndncon/instance1/ndnrtc/%FD%02/video/camera/hi");
+    Pipeliner::VideoNameScheme ns;
+
+    // single-layer thread: no layer component, all frames are needed
+    EXPECT_EQ(Name(threadPrefix).append(NameComponents::NameComponentDelta),
+              ns.samplePrefix(threadPrefix, SampleClass::Delta, 10));
+    EXPECT_TRUE(ns.needSample(SampleClass::Delta, 10));
+
+    // 3 layers, GOP of 9 frames (key + 8 delta), first delta frame of some
+    // GOP is 17: layers of delta frames follow 2-1-2-0-2-1-2-0 pattern
+    ns.setTemporalLayers(3, 9, 17);
+    unsigned int expected[] = {2, 1, 2, 0, 2, 1, 2, 0};
+    for (int i = 0; i < 24; ++i)
+    {
+        // works both ways from the GOP start
+        EXPECT_EQ(expected[i % 8], ns.getTemporalLayer(17 + i));
+        EXPECT_EQ(expected[i % 8], ns.getTemporalLayer(17 - 8 + i));
+
+        EXPECT_EQ(Name(threadPrefix).append(NameComponents::NameComponentDelta)
+                      .append(Name::Component::fromNumber(expected[i % 8])),
+                  ns.samplePrefix(threadPrefix, SampleClass::Delta, 17 + i));
+    }
+    // key frames are not layered
+    EXPECT_EQ(Name(threadPrefix).append(NameComponents::NameComponentKey),
+              ns.samplePrefix(threadPrefix, SampleClass::Key, 3));
+
+    // GOP re-anchors, e.g. producer restarted the encoder
+    ns.setGopStart(20);
+    EXPECT_EQ(2, ns.getTemporalLayer(20));
+    EXPECT_EQ(0, ns.getTemporalLayer(23));
+
+    // fetch base layer only
+    ns.setMaxTemporalLayer(0);
+    for (int i = 0; i < 8; ++i)
+        EXPECT_EQ(expected[i] == 0, ns.needSample(SampleClass::Delta, 20 + i));
+    EXPECT_TRUE(ns.needSample(SampleClass::Key, 3));
+
+    ns.setMaxTemporalLayer(1);
+    for (int i = 0; i < 8; ++i)
+        EXPECT_EQ(expected[i] <= 1, ns.needSample(SampleClass::Delta, 20 + i));
+}
+
 int main(int argc, char **argv)
 {
     ::testing::InitGoogleTest(&argc, argv);
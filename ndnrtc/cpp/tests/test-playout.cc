@@ -95,6 +95,73 @@ TEST(TestPlaybackQueue, TestAttach)
     EXPECT_NO_THROW(pqueue->detach(nullptr));
 }
 #endif
+TEST(TestPlaybackQueue, TestPlaybackOrder)
+{
+    int nSamples = 6;
+    double fps = 30;
+    int64_t ts = 488589553, uts = 1460488589;
+    std::string streamPrefix = "/ndn/edu/ucla/remap/peter/ndncon/instance1/ndnrtc/%FD%02/video/camera";
+    std::string threadPrefix = "/ndn/edu/ucla/remap/peter/ndncon/instance1/ndnrtc/%FD%02/video/camera/hi";
+
+    boost::shared_ptr<StatisticsStorage> storage(StatisticsStorage::createConsumerStatistics());
+    boost::shared_ptr<Buffer> buffer(boost::make_shared<Buffer>(storage, boost::make_shared<SlotPool>(20)));
+    boost::shared_ptr<PlaybackQueue> pqueue(boost::make_shared<PlaybackQueue>(Name(streamPrefix), buffer, 8));
+
+    std::map<int, std::vector<boost::shared_ptr<Interest>>> interests;
+    boost::function<Name(int)> frameName = [threadPrefix](int n){
+        Name frameName(threadPrefix);
+        frameName.append(NameComponents::NameComponentDelta).appendSequenceNumber(n);
+        return frameName;
+    };
+    boost::function<void(int, int)> receiveFrame = [&](int n, int playbackNo){
+        VideoFramePacket vp = getVideoFramePacket(8000, fps, ts+playbackNo*(int)(1000./fps), 
+            uts+playbackNo*(int)(1000./fps));
+        std::vector<VideoFrameSegment> segments = sliceFrame(vp, playbackNo);
+        std::vector<boost::shared_ptr<Data>> data = dataFromSegments(frameName(n).toUri(), segments);
+
+        int idx = 0;
+        for (auto d:data)
+            buffer->received(boost::make_shared<WireData<VideoFrameSegmentHeader>>(d, interests[n][idx++]));
+    };
+
+    for (int n = 0; n < nSamples+1; ++n)
+    {
+        interests[n] = getInterests(frameName(n).toUri(), 0, 10);
+        EXPECT_TRUE(buffer->requested(makeInterestsConst(interests[n])));
+    }
+    EXPECT_EQ((unsigned int)nSamples+1, buffer->getPendingSlotsNum());
+    EXPECT_EQ(0, pqueue->size());
+    EXPECT_EQ(0, pqueue->pendingSize());
+
+    // frames arrive out of order
+    std::vector<int> arrivalOrder = boost::assign::list_of(3)(5)(1)(4)(0)(2);
+    for (auto n:arrivalOrder)
+        receiveFrame(n, n);
+    
+    EXPECT_EQ(1u, buffer->getPendingSlotsNum());
+    EXPECT_EQ((nSamples-1)*(int)(1000./fps)+(int)(1000./fps), pqueue->size());
+    EXPECT_EQ((int64_t)(1000./fps), pqueue->pendingSize());
+
+    // frame, which does not fit in the ring, makes queue drop the oldest ones
+    receiveFrame(nSamples, 10);
+    EXPECT_EQ(0u, buffer->getPendingSlotsNum());
+
+    std::vector<int> playbackOrder;
+    int nPopped = 0;
+    while (pqueue->size())
+    {
+        pqueue->pop([&playbackOrder, fps](const boost::shared_ptr<const BufferSlot>& slot, double playTimeMs){
+            playbackOrder.push_back(slot->getNameInfo().sampleNo_);
+            EXPECT_LE(1000./fps-1, playTimeMs);
+        });
+        ASSERT_GT(10, ++nPopped);
+    }
+
+    std::vector<int> expectedOrder = boost::assign::list_of(3)(4)(5)(6);
+    EXPECT_EQ(expectedOrder, playbackOrder);
+    EXPECT_EQ(0, pqueue->size());
+}
+
 TEST(TestPlaybackQueue, TestPlay)
 {
 #ifdef ENABLE_LOGGING
@@ -169,7 +236,7 @@ TEST(TestPlaybackQueue, TestPlay)
 
 			VideoFramePacket vp = getVideoFramePacket((n%(int)fps == 0 ? 28000 : 8000),
 				fps, ts+n*(int)(1000./fps), uts+n*(int)(1000./fps));
-			std::vector<VideoFrameSegment> segments = sliceFrame(vp);
+			std::vector<VideoFrameSegment> segments = sliceFrame(vp, n);
 			std::vector<boost::shared_ptr<Interest>> interests = getInterests(frameName.toUri(), 0, segments.size());
 			std::vector<boost::shared_ptr<Data>> data = dataFromSegments(frameName.toUri(), segments);
 
@@ -321,7 +388,7 @@ TEST(TestPlayout, TestPlay)
 				fps, ts, uts);
 			timestamps.push_back(ts);
 
-			std::vector<VideoFrameSegment> segments = sliceFrame(vp);
+			std::vector<VideoFrameSegment> segments = sliceFrame(vp, n);
 			std::vector<boost::shared_ptr<Interest>> interests = getInterests(frameName.toUri(), 0, segments.size());
 			std::vector<boost::shared_ptr<Data>> data = dataFromSegments(frameName.toUri(), segments);
 
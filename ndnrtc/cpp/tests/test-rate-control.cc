@@ -0,0 +1,151 @@
+//
+// test-rate-control.cc
+//
+//  Copyright 2013-2018 Regents of the University of California
+//
+
+#include "gtest/gtest.h"
+#include "src/rate-control.hpp"
+
+using namespace ndnrtc;
+
+namespace
+{
+// 30 FPS, encoding and publishing keep up
+RateControl::Load normalLoad() { return RateControl::Load({10., 33., 0., 0}); }
+}
+
+TEST(TestRateControl, TestNoOveruse)
+{
+    RateControl rc({true, 0.3, 5., 1000}, 30.);
+
+    for (int i = 0; i < 20; ++i)
+    {
+        for (int j = 0; j < 30; ++j)
+            rc.interestsObserved(5, 5);
+        EXPECT_FALSE(rc.update(normalLoad()));
+    }
+
+    EXPECT_EQ(1., rc.getBitrateRatio());
+    EXPECT_EQ(1., rc.getFrameRateRatio());
+    EXPECT_EQ(30., rc.getTargetFrameRate());
+    EXPECT_ANY_THROW(RateControl({true, 0., 5., 1000}, 30.));
+}
+
+TEST(TestRateControl, TestEncodingOveruse)
+{
+    RateControl rc({true, 0.3, 5., 1000}, 30.);
+    RateControl::Load load({32., 33., 0., 0});
+
+    // encoding is too slow - frame rate goes down, bitrate stays
+    EXPECT_TRUE(rc.update(load));
+    EXPECT_GT(1., rc.getFrameRateRatio());
+    EXPECT_EQ(1., rc.getBitrateRatio());
+
+    for (int i = 0; i < 100; ++i)
+        rc.update(load);
+    EXPECT_DOUBLE_EQ(5., rc.getTargetFrameRate());
+    EXPECT_FALSE(rc.update(load));
+    EXPECT_EQ(1., rc.getBitrateRatio());
+}
+
+TEST(TestRateControl, TestPublishingOveruse)
+{
+    RateControl rc({true, 0.3, 5., 1000}, 30.);
+    RateControl::Load load({10., 33., 0.8, 0});
+
+    // publishing backlog - bitrate goes down first
+    EXPECT_TRUE(rc.update(load));
+    EXPECT_GT(1., rc.getBitrateRatio());
+    EXPECT_EQ(1., rc.getFrameRateRatio());
+
+    int n = 0;
+    while (rc.getBitrateRatio() > 0.3 && n++ < 100)
+        EXPECT_TRUE(rc.update(load));
+    EXPECT_DOUBLE_EQ(0.3, rc.getBitrateRatio());
+    EXPECT_EQ(1., rc.getFrameRateRatio());
+
+    // then frame rate
+    EXPECT_TRUE(rc.update(load));
+    EXPECT_DOUBLE_EQ(0.3, rc.getBitrateRatio());
+    EXPECT_GT(1., rc.getFrameRateRatio());
+}
+
+TEST(TestRateControl, TestDroppedFrames)
+{
+    RateControl rc({true, 0.3, 5., 1000}, 30.);
+
+    EXPECT_FALSE(rc.update(RateControl::Load({10., 33., 0., 0})));
+    EXPECT_TRUE(rc.update(RateControl::Load({10., 33., 0., 3})));
+    EXPECT_GT(1., rc.getBitrateRatio());
+
+    // no new drops
+    double ratio = rc.getBitrateRatio();
+    EXPECT_FALSE(rc.update(RateControl::Load({10., 33., 0., 3})));
+    EXPECT_EQ(ratio, rc.getBitrateRatio());
+}
+
+TEST(TestRateControl, TestConsumersLag)
+{
+    RateControl rc({true, 0.3, 5., 1000}, 30.);
+
+    // no consumers - no reaction
+    for (int j = 0; j < 30; ++j)
+        rc.interestsObserved(5, 0);
+    EXPECT_FALSE(rc.update(normalLoad()));
+    EXPECT_EQ(1., rc.getBitrateRatio());
+
+    // consumers request only few frames ahead
+    for (int j = 0; j < 30; ++j)
+        rc.interestsObserved(5, (j % 5 == 0 ? 5 : 0));
+    EXPECT_TRUE(rc.update(normalLoad()));
+    EXPECT_GT(1., rc.getBitrateRatio());
+
+    // consumers caught up
+    double ratio = rc.getBitrateRatio();
+    for (int j = 0; j < 30; ++j)
+        rc.interestsObserved(5, 4);
+    EXPECT_FALSE(rc.update(normalLoad()));
+    EXPECT_EQ(ratio, rc.getBitrateRatio());
+}
+
+TEST(TestRateControl, TestRecovery)
+{
+    RateControl rc({true, 0.3, 5., 1000}, 30.);
+
+    for (int i = 0; i < 100; ++i)
+        rc.update(RateControl::Load({10., 33., 0.8, 0}));
+    EXPECT_DOUBLE_EQ(0.3, rc.getBitrateRatio());
+    EXPECT_GT(1., rc.getFrameRateRatio());
+
+    // frame rate is restored before bitrate, gradually
+    double frameRateRatio = rc.getFrameRateRatio();
+    EXPECT_FALSE(rc.update(normalLoad()));
+    EXPECT_FALSE(rc.update(normalLoad()));
+    EXPECT_TRUE(rc.update(normalLoad()));
+    EXPECT_LT(frameRateRatio, rc.getFrameRateRatio());
+    EXPECT_DOUBLE_EQ(0.3, rc.getBitrateRatio());
+
+    int n = 0;
+    while ((rc.getFrameRateRatio() < 1. || rc.getBitrateRatio() < 1.) && n++ < 1000)
+    {
+        double bitrateRatio = rc.getBitrateRatio();
+        rc.update(normalLoad());
+        if (rc.getFrameRateRatio() < 1.)
+            EXPECT_EQ(bitrateRatio, rc.getBitrateRatio());
+    }
+    EXPECT_EQ(1., rc.getFrameRateRatio());
+    EXPECT_EQ(1., rc.getBitrateRatio());
+
+    // overuse interrupts recovery
+    EXPECT_TRUE(rc.update(RateControl::Load({10., 33., 0.8, 0})));
+    EXPECT_FALSE(rc.update(normalLoad()));
+    EXPECT_FALSE(rc.update(normalLoad()));
+    EXPECT_TRUE(rc.update(normalLoad()));
+}
+
+int main(int argc, char **argv)
+{
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,311 @@
+//
+// test-sample-cache.cc
+//
+//  Copyright 2013-2018 Regents of the University of California
+//
+
+#include <boost/thread.hpp>
+#include <ndn-cpp/face.hpp>
+
+#include "gtest/gtest.h"
+#include "src/sample-cache.hpp"
+
+using namespace ndnrtc;
+using namespace ndn;
+
+namespace
+{
+class TestFace : public Face
+{
+  public:
+    TestFace() : Face("localhost") {}
+
+    // cache sends segments' wire encoding directly
+    void send(const uint8_t *encoding, size_t encodingLength) override
+    {
+        Data data;
+        data.wireDecode(encoding, encodingLength);
+        names_.push_back(data.getName());
+    }
+
+    std::vector<Name> names_;
+};
+
+const Name StreamPrefix("/ndnrtc/%FD%03/video/camera/%FC%00%00%01c_%27%DE%D6");
+
+Name segmentName(const std::string &thread, bool key, PacketNumber sampleNo,
+                 unsigned int segNo, bool parity = false, int layer = -1)
+{
+    Name n(StreamPrefix);
+    n.append(thread).append(key ? NameComponents::NameComponentKey : NameComponents::NameComponentDelta);
+    if (layer >= 0)
+        n.append(Name::Component::fromNumber(layer));
+    n.appendSequenceNumber(sampleNo);
+    if (parity)
+        n.append(NameComponents::NameComponentParity);
+    n.appendSegment(segNo);
+    return n;
+}
+
+Data segment(const Name &name, size_t size = 1000)
+{
+    Data d(name);
+    d.setContent(std::vector<uint8_t>(size, 0));
+    d.getMetaInfo().setFreshnessPeriod(1000);
+    return d;
+}
+}
+
+TEST(TestSampleCache, TestSampleNames)
+{
+    SampleCache cache(StreamPrefix, 1000, 1024 * 1024);
+
+    EXPECT_TRUE(cache.isSampleName(segmentName("hi", true, 0, 0)));
+    EXPECT_TRUE(cache.isSampleName(segmentName("hi", false, 10, 3)));
+    EXPECT_TRUE(cache.isSampleName(segmentName("hi", false, 10, 0, true)));
+    EXPECT_TRUE(cache.isSampleName(segmentName("hi", false, 10, 0, false, 1)));
+    EXPECT_TRUE(cache.isSampleName(segmentName("hi", true, 10, 0, true)));
+    // audio bundles
+    EXPECT_TRUE(cache.isSampleName(Name(StreamPrefix).append("mic").appendSequenceNumber(10).appendSegment(0)));
+    EXPECT_FALSE(cache.isSampleName(Name(StreamPrefix).append("mic").appendSequenceNumber(10)));
+
+    // metadata, manifests and FEC groups are not samples
+    EXPECT_FALSE(cache.isSampleName(Name(StreamPrefix).append(NameComponents::NameComponentMeta)));
+    EXPECT_FALSE(cache.isSampleName(Name(StreamPrefix).append("hi").append(NameComponents::NameComponentMeta)));
+    EXPECT_FALSE(cache.isSampleName(Name(StreamPrefix).append("hi").append(NameComponents::NameComponentDelta).appendSequenceNumber(10).append(NameComponents::NameComponentManifest)));
+    EXPECT_FALSE(cache.isSampleName(Name(StreamPrefix).append("hi").append(NameComponents::NameComponentDelta).append(NameComponents::NameComponentParity).appendSequenceNumber(10)));
+    EXPECT_FALSE(cache.isSampleName(Name(StreamPrefix).append("hi").append(NameComponents::NameComponentDelta).appendSequenceNumber(10)));
+    EXPECT_FALSE(cache.isSampleName(Name("/other/prefix/hi/d").appendSequenceNumber(10).appendSegment(0)));
+
+    EXPECT_ANY_THROW(cache.add(segment(Name(StreamPrefix).append(NameComponents::NameComponentMeta))));
+}
+
+TEST(TestSampleCache, TestAddAndSatisfy)
+{
+    SampleCache cache(StreamPrefix, 1000, 1024 * 1024);
+    TestFace face;
+
+    for (int i = 0; i < 3; ++i)
+    {
+        cache.add(segment(segmentName("hi", false, 10, i)));
+        cache.add(segment(segmentName("hi", false, 10, i, true)));
+    }
+    cache.add(segment(segmentName("hi", true, 2, 0)));
+    cache.add(segment(segmentName("lo", false, 12, 0, false, 1)));
+    EXPECT_EQ(8000, cache.getSize());
+
+    EXPECT_TRUE(cache.satisfy(Interest(segmentName("hi", false, 10, 2)), face));
+    EXPECT_TRUE(cache.satisfy(Interest(segmentName("hi", false, 10, 1, true)), face));
+    EXPECT_TRUE(cache.satisfy(Interest(segmentName("hi", true, 2, 0)), face));
+    EXPECT_TRUE(cache.satisfy(Interest(segmentName("lo", false, 12, 0, false, 1)), face));
+    ASSERT_EQ(4, face.names_.size());
+    EXPECT_EQ(segmentName("hi", false, 10, 2), face.names_[0]);
+    EXPECT_EQ(segmentName("hi", false, 10, 1, true), face.names_[1]);
+    EXPECT_EQ(segmentName("lo", false, 12, 0, false, 1), face.names_[3]);
+
+    EXPECT_FALSE(cache.satisfy(Interest(segmentName("hi", false, 10, 3)), face));
+    EXPECT_FALSE(cache.satisfy(Interest(segmentName("hi", false, 11, 0)), face));
+    EXPECT_FALSE(cache.satisfy(Interest(segmentName("hi", true, 10, 0)), face));
+    EXPECT_FALSE(cache.satisfy(Interest(segmentName("mid", false, 10, 0)), face));
+    EXPECT_FALSE(cache.satisfy(Interest(Name(StreamPrefix).append(NameComponents::NameComponentMeta)), face));
+    EXPECT_EQ(4, face.names_.size());
+}
+
+TEST(TestSampleCache, TestPendingInterests)
+{
+    SampleCache cache(StreamPrefix, 1000, 1024 * 1024);
+    TestFace face;
+
+    EXPECT_FALSE(cache.storePendingInterest(boost::make_shared<Interest>(Name(StreamPrefix).append(NameComponents::NameComponentMeta)), face));
+
+    for (int i = 0; i < 3; ++i)
+        EXPECT_TRUE(cache.storePendingInterest(boost::make_shared<Interest>(segmentName("hi", false, 10, i)), face));
+    EXPECT_TRUE(cache.storePendingInterest(boost::make_shared<Interest>(segmentName("hi", false, 10, 0)), face));
+    EXPECT_TRUE(cache.storePendingInterest(boost::make_shared<Interest>(segmentName("hi", false, 11, 0)), face));
+    EXPECT_TRUE(cache.storePendingInterest(boost::make_shared<Interest>(segmentName("hi", true, 10, 0)), face));
+    EXPECT_EQ(6, cache.getPendingInterestsNum());
+
+    std::vector<boost::shared_ptr<const SampleCache::PendingInterest>> pis;
+    cache.getPendingInterestsForName(segmentName("hi", false, 10, 0), pis);
+    EXPECT_EQ(2, pis.size());
+
+    Name sampleName = segmentName("hi", false, 10, 0).getPrefix(-1);
+    EXPECT_TRUE(cache.hasPendingInterests(sampleName));
+    EXPECT_FALSE(cache.hasPendingInterests(Name(sampleName).append(NameComponents::NameComponentParity)));
+    EXPECT_FALSE(cache.hasPendingInterests(segmentName("hi", false, 12, 0).getPrefix(-1)));
+
+    // data is sent to all interests for it
+    cache.add(segment(segmentName("hi", false, 10, 0)));
+    EXPECT_EQ(2, face.names_.size());
+    EXPECT_EQ(4, cache.getPendingInterestsNum());
+
+    cache.getPendingInterestsForName(segmentName("hi", false, 10, 0), pis);
+    EXPECT_EQ(0, pis.size());
+
+    cache.extractPendingInterestsWithPrefix(sampleName, pis);
+    EXPECT_EQ(2, pis.size());
+    EXPECT_EQ(2, cache.getPendingInterestsNum());
+    EXPECT_FALSE(cache.hasPendingInterests(sampleName));
+    EXPECT_TRUE(cache.hasPendingInterests(segmentName("hi", false, 11, 0).getPrefix(-1)));
+}
+
+TEST(TestSampleCache, TestExtractPendingInterests)
+{
+    SampleCache cache(StreamPrefix, 1000, 1024 * 1024);
+    TestFace face;
+
+    for (int i = 0; i < 10; ++i)
+    {
+        cache.storePendingInterest(boost::make_shared<Interest>(segmentName("hi", false, i, 0)), face);
+        cache.storePendingInterest(boost::make_shared<Interest>(segmentName("hi", false, i, 0, true)), face);
+    }
+    cache.storePendingInterest(boost::make_shared<Interest>(segmentName("hi", true, 0, 0)), face);
+    cache.storePendingInterest(boost::make_shared<Interest>(segmentName("lo", false, 0, 0)), face);
+    EXPECT_EQ(22, cache.getPendingInterestsNum());
+
+    // parity prefix leaves data interests
+    std::vector<boost::shared_ptr<const SampleCache::PendingInterest>> pis;
+    Name parityName = segmentName("hi", false, 9, 0, true).getPrefix(-1);
+    cache.extractPendingInterestsWithPrefix(parityName, pis);
+    ASSERT_EQ(1, pis.size());
+    EXPECT_EQ(segmentName("hi", false, 9, 0, true), pis[0]->getInterest()->getName());
+    EXPECT_TRUE(cache.hasPendingInterests(parityName.getPrefix(-1)));
+
+    // samples of other threads and classes are not affected
+    cache.extractPendingInterestsBefore(parityName, pis);
+    EXPECT_EQ(18, pis.size());
+    EXPECT_EQ(3, cache.getPendingInterestsNum());
+    for (int i = 0; i < 9; ++i)
+        EXPECT_FALSE(cache.hasPendingInterests(segmentName("hi", false, i, 0).getPrefix(-1)));
+    EXPECT_TRUE(cache.hasPendingInterests(segmentName("hi", false, 9, 0).getPrefix(-1)));
+    EXPECT_TRUE(cache.hasPendingInterests(segmentName("hi", true, 0, 0).getPrefix(-1)));
+    EXPECT_TRUE(cache.hasPendingInterests(segmentName("lo", false, 0, 0).getPrefix(-1)));
+
+    cache.extractPendingInterestsBefore(segmentName("hi", false, 9, 0), pis);
+    EXPECT_EQ(0, pis.size());
+}
+
+TEST(TestSampleCache, TestTemporalLayers)
+{
+    SampleCache cache(StreamPrefix, 1000, 1024 * 1024);
+    TestFace face;
+
+    // layers share sequence numbers, but names must match exactly
+    cache.storePendingInterest(boost::make_shared<Interest>(segmentName("hi", false, 10, 0, false, 0)), face);
+    cache.storePendingInterest(boost::make_shared<Interest>(segmentName("hi", false, 10, 0, false, 1)), face);
+
+    cache.add(segment(segmentName("hi", false, 10, 0, false, 1)));
+    ASSERT_EQ(1, face.names_.size());
+    EXPECT_EQ(segmentName("hi", false, 10, 0, false, 1), face.names_[0]);
+    EXPECT_EQ(1, cache.getPendingInterestsNum());
+
+    EXPECT_FALSE(cache.satisfy(Interest(segmentName("hi", false, 10, 0, false, 0)), face));
+    EXPECT_TRUE(cache.satisfy(Interest(segmentName("hi", false, 10, 0, false, 1)), face));
+
+    std::vector<boost::shared_ptr<const SampleCache::PendingInterest>> pis;
+    cache.extractPendingInterestsWithPrefix(segmentName("hi", false, 10, 0, false, 1).getPrefix(-1), pis);
+    EXPECT_EQ(0, pis.size());
+    cache.extractPendingInterestsWithPrefix(segmentName("hi", false, 10, 0, false, 0).getPrefix(-1), pis);
+    EXPECT_EQ(1, pis.size());
+}
+
+TEST(TestSampleCache, TestPendingInterestsTimeout)
+{
+    SampleCache cache(StreamPrefix, 1000, 1024 * 1024);
+    TestFace face;
+
+    EXPECT_TRUE(cache.storePendingInterest(boost::make_shared<Interest>(segmentName("hi", false, 10, 0), 50), face));
+    EXPECT_TRUE(cache.storePendingInterest(boost::make_shared<Interest>(segmentName("hi", false, 10, 1), 50), face));
+    boost::this_thread::sleep_for(boost::chrono::milliseconds(100));
+    EXPECT_TRUE(cache.storePendingInterest(boost::make_shared<Interest>(segmentName("hi", false, 11, 0), 1000), face));
+
+    EXPECT_EQ(1, cache.getPendingInterestsNum());
+
+    EXPECT_FALSE(cache.hasPendingInterests(segmentName("hi", false, 10, 0).getPrefix(-1)));
+    EXPECT_TRUE(cache.hasPendingInterests(segmentName("hi", false, 11, 0).getPrefix(-1)));
+
+    cache.add(segment(segmentName("hi", false, 10, 0)));
+    EXPECT_EQ(0, face.names_.size());
+}
+
+TEST(TestSampleCache, TestBudget)
+{
+    // fits 5 samples of 2 segments
+    SampleCache cache(StreamPrefix, 10000, 10000);
+    TestFace face;
+
+    for (int i = 0; i < 10; ++i)
+    {
+        cache.add(segment(segmentName("hi", false, i, 0)));
+        cache.add(segment(segmentName("hi", false, i, 1)));
+        EXPECT_GE(10000, cache.getSize());
+    }
+
+    // oldest samples are evicted first
+    for (int i = 0; i < 5; ++i)
+        EXPECT_FALSE(cache.satisfy(Interest(segmentName("hi", false, i, 0)), face));
+    for (int i = 5; i < 10; ++i)
+        EXPECT_TRUE(cache.satisfy(Interest(segmentName("hi", false, i, 1)), face));
+    EXPECT_EQ(10000, cache.getSize());
+}
+
+TEST(TestSampleCache, TestRingWrap)
+{
+    SampleCache cache(StreamPrefix, 10000, 1024 * 1024, 4);
+    TestFace face;
+
+    for (int i = 0; i < 10; ++i)
+        cache.add(segment(segmentName("hi", false, i, 0)));
+    cache.add(segment(segmentName("hi", true, 0, 0)));
+    EXPECT_EQ(5000, cache.getSize());
+
+    for (int i = 0; i < 6; ++i)
+        EXPECT_FALSE(cache.satisfy(Interest(segmentName("hi", false, i, 0)), face));
+    for (int i = 6; i < 10; ++i)
+        EXPECT_TRUE(cache.satisfy(Interest(segmentName("hi", false, i, 0)), face));
+    // rings are per thread and sample class
+    EXPECT_TRUE(cache.satisfy(Interest(segmentName("hi", true, 0, 0)), face));
+
+    EXPECT_ANY_THROW(SampleCache(StreamPrefix, 1000, 1000, 0));
+}
+
+TEST(TestSampleCache, TestLifetime)
+{
+    SampleCache cache(StreamPrefix, 50, 1024 * 1024);
+    TestFace face;
+
+    cache.add(segment(segmentName("hi", false, 0, 0)));
+    EXPECT_TRUE(cache.satisfy(Interest(segmentName("hi", false, 0, 0)), face));
+
+    boost::this_thread::sleep_for(boost::chrono::milliseconds(100));
+    EXPECT_FALSE(cache.satisfy(Interest(segmentName("hi", false, 0, 0)), face));
+
+    // expired samples are evicted on add
+    cache.add(segment(segmentName("hi", false, 1, 0)));
+    EXPECT_EQ(1000, cache.getSize());
+}
+
+TEST(TestSampleCache, TestMustBeFresh)
+{
+    SampleCache cache(StreamPrefix, 1000, 1024 * 1024);
+    TestFace face;
+
+    Data d = segment(segmentName("hi", false, 0, 0));
+    d.getMetaInfo().setFreshnessPeriod(50);
+    cache.add(d);
+
+    Interest i(segmentName("hi", false, 0, 0));
+    i.setMustBeFresh(true);
+    EXPECT_TRUE(cache.satisfy(i, face));
+
+    boost::this_thread::sleep_for(boost::chrono::milliseconds(100));
+    EXPECT_FALSE(cache.satisfy(i, face));
+    i.setMustBeFresh(false);
+    EXPECT_TRUE(cache.satisfy(i, face));
+}
+
+int main(int argc, char **argv)
+{
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -89,6 +89,47 @@ TEST(TestSampleEstimator, TestTrivialEstimations)
 		estimator.getSegmentSizeEstimation(SampleClass::Key, SegmentClass::Parity));
 }
 
+TEST(TestSampleEstimator, TestParityRatio)
+{
+    boost::shared_ptr<StatisticsStorage> storage(StatisticsStorage::createConsumerStatistics());
+	SampleEstimator estimator(storage);
+
+	estimator.bootstrapSegmentNumber(10, SampleClass::Delta, SegmentClass::Data);
+	estimator.bootstrapSegmentNumber(3, SampleClass::Delta, SegmentClass::Parity);
+	estimator.bootstrapSegmentNumber(30, SampleClass::Key, SegmentClass::Data);
+	estimator.bootstrapSegmentNumber(6, SampleClass::Key, SegmentClass::Parity);
+
+	// producer doesn't announce parity ratio
+	estimator.bootstrapParityRatio(0, SampleClass::Delta);
+	EXPECT_EQ(3, estimator.getSegmentNumberEstimation(SampleClass::Delta, SegmentClass::Parity));
+
+	estimator.bootstrapParityRatio(0.1, SampleClass::Delta);
+	estimator.bootstrapParityRatio(0.5, SampleClass::Key);
+	EXPECT_EQ(1, estimator.getSegmentNumberEstimation(SampleClass::Delta, SegmentClass::Parity));
+	EXPECT_EQ(15, estimator.getSegmentNumberEstimation(SampleClass::Key, SegmentClass::Parity));
+
+	// number of parity segments is rounded up, as producer does
+	estimator.bootstrapParityRatio(0.12, SampleClass::Delta);
+	EXPECT_EQ(2, estimator.getSegmentNumberEstimation(SampleClass::Delta, SegmentClass::Parity));
+
+	// parity ratio is updated from data segments headers
+	for (int i = 0; i < 30; ++i)
+	{
+		std::vector<boost::shared_ptr<WireSegment>> wireSegments = getSegments(5000);
+		estimator.segmentArrived(wireSegments.front());
+	}
+
+	boost::shared_ptr<WireData<VideoFrameSegmentHeader>> segment =
+		boost::dynamic_pointer_cast<WireData<VideoFrameSegmentHeader>>(getSegments(5000).front());
+	const VideoFrameSegmentHeader &hdr = segment->segment().getHeader();
+	EXPECT_EQ(hdr.paritySegmentsNum_, estimator.getSegmentNumberEstimation(SampleClass::Delta, SegmentClass::Parity));
+	EXPECT_EQ(15, estimator.getSegmentNumberEstimation(SampleClass::Key, SegmentClass::Parity));
+
+	estimator.reset();
+	estimator.bootstrapSegmentNumber(3, SampleClass::Delta, SegmentClass::Parity);
+	EXPECT_EQ(3, estimator.getSegmentNumberEstimation(SampleClass::Delta, SegmentClass::Parity));
+}
+
 int main(int argc, char **argv) {
 	::testing::InitGoogleTest(&argc, argv);
 	return RUN_ALL_TESTS();
@@ -0,0 +1,113 @@
+//
+// test-stage-queue.cc
+//
+//  Copyright 2013-2018 Regents of the University of California
+//
+
+#include <stdlib.h>
+
+#include <gtest/gtest.h>
+#include <boost/thread.hpp>
+#include <boost/chrono.hpp>
+
+#include "src/stage-queue.hpp"
+
+using namespace ndnrtc;
+
+TEST(TestStageQueue, TestDropOldest)
+{
+    StageQueue<int> q(3, StageQueue<int>::DropOldest);
+
+    for (int i = 0; i < 5; ++i)
+        EXPECT_TRUE(q.push(i));
+
+    EXPECT_EQ(3, q.size());
+    EXPECT_EQ(2, q.getDroppedNum());
+
+    int el;
+    for (int i = 2; i < 5; ++i)
+    {
+        ASSERT_TRUE(q.pop(el));
+        EXPECT_EQ(i, el);
+    }
+    EXPECT_EQ(0, q.size());
+}
+
+TEST(TestStageQueue, TestDropNewest)
+{
+    StageQueue<int> q(3, StageQueue<int>::DropNewest);
+
+    for (int i = 0; i < 3; ++i)
+        EXPECT_TRUE(q.push(i));
+    EXPECT_FALSE(q.push(3));
+    EXPECT_FALSE(q.push(4));
+
+    EXPECT_EQ(3, q.size());
+    EXPECT_EQ(2, q.getDroppedNum());
+
+    int el;
+    for (int i = 0; i < 3; ++i)
+    {
+        ASSERT_TRUE(q.pop(el));
+        EXPECT_EQ(i, el);
+    }
+}
+
+TEST(TestStageQueue, TestStop)
+{
+    StageQueue<int> q(3);
+    bool popped = true;
+
+    boost::thread t([&q, &popped]() {
+        int el;
+        popped = q.pop(el);
+    });
+
+    boost::this_thread::sleep_for(boost::chrono::milliseconds(50));
+    q.stop();
+    t.join();
+
+    EXPECT_FALSE(popped);
+    EXPECT_FALSE(q.push(1));
+    EXPECT_EQ(0, q.size());
+    EXPECT_ANY_THROW(StageQueue<int>(0));
+}
+
+TEST(TestStageQueue, TestProducerConsumer)
+{
+    const int nElements = 100000;
+    StageQueue<int> q(16, StageQueue<int>::DropNewest);
+    std::vector<int> consumed;
+
+    boost::thread consumer([&q, &consumed]() {
+        int el;
+        while (q.pop(el) && el >= 0)
+            consumed.push_back(el);
+    });
+
+    int nPushed = 0;
+    for (int i = 0; i < nElements; ++i)
+        if (q.push(i))
+            nPushed++;
+        else
+            boost::this_thread::yield();
+    int nRetries = 0;
+    while (!q.push(-1))
+    {
+        nRetries++;
+        boost::this_thread::yield();
+    }
+    consumer.join();
+
+    // elements are consumed in order, none is lost unless dropped
+    EXPECT_EQ(nPushed, consumed.size());
+    EXPECT_EQ(nElements - nPushed + nRetries, q.getDroppedNum());
+    for (int i = 1; i < consumed.size(); ++i)
+        EXPECT_LT(consumed[i - 1], consumed[i]);
+}
+
+int main(int argc, char **argv)
+{
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -9,6 +9,7 @@
 #include <ctime>
 #include <stdlib.h>
 #include <boost/asio.hpp>
+#include <boost/thread.hpp>
 
 #include "gtest/gtest.h"
 #include "src/video-coder.hpp"
@@ -234,6 +235,66 @@ TEST(TestCoder, TestEncode)
         EXPECT_ANY_THROW(vc.onRawFrame(convertedFrame));
     }
 }
+TEST(TestScalingPyramid, TestLevels)
+{
+    int width = 1280, height = 720;
+    WebRtcVideoFrame frame(std::move(getFrame(width, height)));
+    ScalingPyramid pyramid;
+
+    pyramid.addLevel("hi", width, height);
+    pyramid.addLevel("mid", width / 2, height / 2);
+    pyramid.addLevel("mid2", width / 2, height / 2);
+    pyramid.addLevel("low", width / 4, height / 4);
+    EXPECT_ANY_THROW(pyramid.addLevel("low", width / 4, height / 4));
+    EXPECT_EQ(3, pyramid.getLevelsNum());
+
+    pyramid.setFrame(frame);
+
+    // levels are scaled in parallel
+    std::map<std::string, WebRtcVideoFrame> levels;
+    boost::mutex m;
+    boost::thread_group threads;
+    for (auto name : std::vector<std::string>({"low", "mid", "mid2", "hi"}))
+        threads.create_thread([name, &pyramid, &levels, &m]() {
+            WebRtcVideoFrame f = pyramid.getLevel(name);
+            boost::lock_guard<boost::mutex> scopedLock(m);
+            levels.insert(std::make_pair(name, f));
+        });
+    threads.join_all();
+
+    // same resolution level is not scaled
+    EXPECT_EQ(frame.video_frame_buffer().get(), levels.at("hi").video_frame_buffer().get());
+    // identical resolutions share buffer
+    EXPECT_EQ(levels.at("mid").video_frame_buffer().get(), levels.at("mid2").video_frame_buffer().get());
+    EXPECT_EQ(width / 2, levels.at("mid").width());
+    EXPECT_EQ(height / 2, levels.at("mid").height());
+    EXPECT_EQ(width / 4, levels.at("low").width());
+    EXPECT_EQ(height / 4, levels.at("low").height());
+    EXPECT_ANY_THROW(pyramid.getLevel("none"));
+
+    pyramid.removeLevel("mid");
+    EXPECT_EQ(3, pyramid.getLevelsNum());
+    pyramid.removeLevel("mid2");
+    EXPECT_EQ(2, pyramid.getLevelsNum());
+    EXPECT_EQ(width / 4, pyramid.getLevel("low").width());
+}
+
+TEST(TestScalingPyramid, TestUpscale)
+{
+    int width = 640, height = 480;
+    WebRtcVideoFrame frame(std::move(getFrame(width, height)));
+    ScalingPyramid pyramid;
+
+    pyramid.addLevel("up", width * 2, height * 2);
+    pyramid.addLevel("down", width / 2, height / 2);
+    pyramid.setFrame(frame);
+
+    // downscaled level is scaled from the captured frame, not from upscaled one
+    EXPECT_EQ(width / 2, pyramid.getLevel("down").width());
+    EXPECT_EQ(width * 2, pyramid.getLevel("up").width());
+    EXPECT_EQ(height * 2, pyramid.getLevel("up").height());
+}
+
 #if 0
 TEST(TestCoder, TestEncode700K)
 {